@@ -0,0 +1,84 @@
+import struct
+import sys
+
+
+# Converts a binary log from the rs2_odom_noise recorder nodes to the .csv file analysis.py reads:
+#   python3 odomlog_to_csv.py odometry_data.odomlog data/EKF_data.csv
+#
+# The log holds every message in the order it arrived, and the triples the recorder aligned by header
+# stamp. A row is written for each aligned triple. Logs without triples fall back to a row for each
+# filtered pose, with the latest original and noisy odometry before it. Without any filtered poses the
+# filtered columns are '-'.
+
+MAGIC = b'ODOMLOG\0'
+VERSION = 1
+ODOM, NOISY, FILTERED = 0, 1, 2
+ALIGNED_ODOM, ALIGNED_NOISY, ALIGNED_FILTERED = 3, 4, 5
+
+# stamp, x, y, z, source, padding
+RECORD = struct.Struct('<ddddII')
+
+HEADER = 'Original_X,Original_Y,Original_Z,Noisy_X,Noisy_Y,Noisy_Z,Filtered_X,Filtered_Y,Filtered_Z'
+
+
+def read_log(path):
+    with open(path, 'rb') as f:
+        magic = f.read(8)
+        version, record_size = struct.unpack('<II', f.read(8))
+        if magic != MAGIC or version != VERSION or record_size != RECORD.size:
+            raise ValueError(f'{path} is not a version {VERSION} odometry log')
+        data = f.read()
+    # A log cut short by a crash can end part way through a record
+    usable = len(data) - len(data) % RECORD.size
+    return list(RECORD.iter_unpack(data[:usable]))
+
+
+def aligned_rows(records, has_filtered):
+    # The three records of a triple are logged in a row, one cut short by a full ring is skipped
+    rows = []
+    triple = {}
+    for _, x, y, z, source, _ in records:
+        if source == ALIGNED_ODOM:
+            triple = {}
+        if source >= ALIGNED_ODOM:
+            triple[source] = (x, y, z)
+        if len(triple) == 3:
+            filtered = triple[ALIGNED_FILTERED] if has_filtered else ('-', '-', '-')
+            rows.append((*triple[ALIGNED_ODOM], *triple[ALIGNED_NOISY], *filtered))
+            triple = {}
+    return rows
+
+
+def to_rows(records):
+    has_filtered = any(record[4] == FILTERED for record in records)
+    if any(record[4] >= ALIGNED_ODOM for record in records):
+        return aligned_rows(records, has_filtered)
+
+    # Latest position of each source as each record arrives, carried forward from the one before
+    trigger = FILTERED if has_filtered else NOISY
+    latest = {}
+    rows = []
+    for _, x, y, z, source, _ in records:
+        latest[source] = (x, y, z)
+        if source != trigger or ODOM not in latest or NOISY not in latest:
+            continue
+        filtered = latest[FILTERED] if has_filtered else ('-', '-', '-')
+        rows.append((*latest[ODOM], *latest[NOISY], *filtered))
+    return rows
+
+
+def main():
+    if len(sys.argv) != 3:
+        print('usage: odomlog_to_csv.py <log file> <csv file>')
+        sys.exit(1)
+    records = read_log(sys.argv[1])
+    rows = to_rows(records)
+    with open(sys.argv[2], 'w') as f:
+        f.write(HEADER + '\n')
+        for row in rows:
+            f.write(','.join(v if isinstance(v, str) else f'{v:g}' for v in row) + '\n')
+    print(f'{len(records)} records, {len(rows)} rows written to {sys.argv[2]}')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cvfilter.h"
+#include "noiseengine.h"
+#include "odomlogger.h"
+
+// Replays the /odom of a recorder log through the noise engine and a constant velocity Kalman filter for many
+// configurations at once:
+//   rs2_odom_noise_cv_replay_eval <log file> <config file> [threads] > results.csv
+//
+// The filter is ConstantVelocityFilter, not robot_localization, so the results rank settings of this filter
+// and do not carry over to the EKF in rs_ekf.launch, which still has to be tuned on a live or rosbag run.
+//
+// Each line of the config file is one configuration, lines starting with # are skipped:
+//   name,seed,distribution,noise_scale,process_noise,covariance_scale
+// The seed must not be 0 so every run of a configuration sees the same noise.
+
+// Variance added to every measurement, keeps the covariance published by the noise nodes from being 0 at the origin
+const double VARIANCE_FLOOR = 1e-6;
+
+// Slowest speed the lag of the estimate is measured at [m/s]
+const double LAG_MIN_SPEED = 0.01;
+
+struct Config
+{
+    std::string name;
+    uint64_t seed;
+    NoiseEngine::Distribution distribution;
+    double noiseScale;
+    double processNoise;
+    double covarianceScale;
+};
+
+struct Result
+{
+    size_t samples = 0;
+    double rmseX = 0.0;
+    double rmseY = 0.0;
+    double lag = 0.0;
+    double meanUpdateUs = 0.0;
+    double maxUpdateUs = 0.0;
+    double realtimeFactor = 0.0;
+};
+
+bool readConfigs(const std::string &path, std::vector<Config> &configs);
+bool parseThreads(const std::string &text, unsigned int &threads);
+Result evaluate(const std::vector<OdomLogger::Record> &truth, const Config &config);
+
+int main(int argc, char **argv)
+{
+    unsigned int threads = std::thread::hardware_concurrency();
+    if (argc < 3 || argc > 4 || (argc == 4 && !parseThreads(argv[3], threads)))
+    {
+        std::cerr << "usage: " << argv[0] << " <log file> <config file> [threads]" << std::endl
+                  << "  threads must be a positive whole number, it defaults to the number of cores" << std::endl;
+        return 1;
+    }
+
+    std::vector<OdomLogger::Record> records;
+    if (!OdomLogger::read(argv[1], records))
+    {
+        std::cerr << "Failed to read the log " << argv[1] << std::endl;
+        return 1;
+    }
+    std::vector<Config> configs;
+    if (!readConfigs(argv[2], configs))
+    {
+        return 1;
+    }
+
+    // The original odometry is the ground truth, a stamp going backwards ends the replay
+    std::vector<OdomLogger::Record> truth;
+    for (const auto &record : records)
+    {
+        if (record.source != OdomLogger::ODOM) continue;
+        if (!truth.empty() && record.stamp < truth.back().stamp) break;
+        truth.push_back(record);
+    }
+    if (truth.size() < 2)
+    {
+        std::cerr << "The log has no /odom to replay" << std::endl;
+        return 1;
+    }
+
+    threads = std::max(1u, std::min<unsigned int>(threads, configs.size()));
+
+    // Configurations are independent, each thread takes the next one until none are left
+    std::vector<Result> results(configs.size());
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < configs.size(); i = next++) results[i] = evaluate(truth, configs[i]);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned int t = 1; t < threads; t++) pool.push_back(std::thread(worker));
+    worker();
+    for (auto &thread : pool) thread.join();
+
+    std::cout << "Name,Samples,RMSE_X,RMSE_Y,RMSE,Lag_s,Mean_Update_us,Max_Update_us,Realtime_Factor\n";
+    for (size_t i = 0; i < configs.size(); i++)
+    {
+        const Result &r = results[i];
+        std::cout << configs[i].name << "," << r.samples << "," << r.rmseX << "," << r.rmseY << ","
+                  << std::sqrt(r.rmseX * r.rmseX + r.rmseY * r.rmseY) << "," << r.lag << "," << r.meanUpdateUs << ","
+                  << r.maxUpdateUs << "," << r.realtimeFactor << "\n";
+    }
+    return 0;
+}
+
+bool readConfigs(const std::string &path, std::vector<Config> &configs)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open the config file " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); lineNumber++)
+    {
+        if (line.empty() || line[0] == '#') continue;
+        std::stringstream ss(line);
+        std::vector<std::string> fields;
+        std::string field;
+        while (std::getline(ss, field, ',')) fields.push_back(field);
+
+        Config config;
+        try
+        {
+            if (fields.size() != 6) throw std::invalid_argument("field count");
+            config.name = fields[0];
+            config.seed = std::stoull(fields[1]);
+            config.noiseScale = std::stod(fields[3]);
+            config.processNoise = std::stod(fields[4]);
+            config.covarianceScale = std::stod(fields[5]);
+        }
+        catch (const std::exception &)
+        {
+            std::cerr << path << ":" << lineNumber << ": expected name,seed,distribution,noise_scale,"
+                      << "process_noise,covariance_scale" << std::endl;
+            return false;
+        }
+        if (config.seed == 0 || !NoiseEngine::parseDistribution(fields[2], config.distribution))
+        {
+            std::cerr << path << ":" << lineNumber << ": the seed must not be 0 and the distribution must be "
+                      << "uniform or gaussian" << std::endl;
+            return false;
+        }
+        configs.push_back(config);
+    }
+    if (configs.empty())
+    {
+        std::cerr << "No configurations in " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool parseThreads(const std::string &text, unsigned int &threads)
+{
+    // std::stoul takes a leading minus sign and trailing junk, so the whole string is checked
+    if (text.empty() || !std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; }))
+    {
+        return false;
+    }
+    try
+    {
+        unsigned long value = std::stoul(text);
+        if (value == 0 || value > std::numeric_limits<unsigned int>::max()) return false;
+        threads = static_cast<unsigned int>(value);
+    }
+    catch (const std::out_of_range &)
+    {
+        return false;
+    }
+    return true;
+}
+
+Result evaluate(const std::vector<OdomLogger::Record> &truth, const Config &config)
+{
+    NoiseEngine engine(config.seed, config.distribution, config.noiseScale);
+    ConstantVelocityFilter filter(config.processNoise);
+    std::array<double, NoiseEngine::AXES> noise;
+
+    Result result;
+    double sumX = 0.0, sumY = 0.0, sumUpdate = 0.0, sumLag = 0.0;
+    size_t lagSamples = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < truth.size(); i++)
+    {
+        const OdomLogger::Record &odom = truth[i];
+
+        // The same noise and covariance the noise nodes publish on /noisy_odom
+        engine.sample(noise);
+        double x = odom.x * (1 + noise[0]);
+        double y = odom.y * (1 + noise[1]);
+        double varianceX = config.covarianceScale * std::pow(engine.scale(0) * odom.x, 2) + VARIANCE_FLOOR;
+        double varianceY = config.covarianceScale * std::pow(engine.scale(1) * odom.y, 2) + VARIANCE_FLOOR;
+
+        auto before = std::chrono::steady_clock::now();
+        filter.predict(odom.stamp);
+        filter.update(x, y, varianceX, varianceY);
+        double updateUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - before).count();
+        sumUpdate += updateUs;
+        result.maxUpdateUs = std::max(result.maxUpdateUs, updateUs);
+
+        double errorX = filter.x() - odom.x;
+        double errorY = filter.y() - odom.y;
+        sumX += errorX * errorX;
+        sumY += errorY * errorY;
+
+        // How long ago the truth was where the estimate is, from the error along the direction of travel
+        if (i > 0 && odom.stamp > truth[i - 1].stamp)
+        {
+            double dt = odom.stamp - truth[i - 1].stamp;
+            double vx = (odom.x - truth[i - 1].x) / dt;
+            double vy = (odom.y - truth[i - 1].y) / dt;
+            double speed2 = vx * vx + vy * vy;
+            if (speed2 > LAG_MIN_SPEED * LAG_MIN_SPEED)
+            {
+                sumLag -= (errorX * vx + errorY * vy) / speed2;
+                lagSamples++;
+            }
+        }
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    result.samples = truth.size();
+    result.rmseX = std::sqrt(sumX / truth.size());
+    result.rmseY = std::sqrt(sumY / truth.size());
+    result.lag = lagSamples > 0 ? sumLag / lagSamples : 0.0;
+    result.meanUpdateUs = sumUpdate / truth.size();
+    result.realtimeFactor = wall > 0.0 ? (truth.back().stamp - truth.front().stamp) / wall : 0.0;
+    return result;
+}
@@ -0,0 +1,66 @@
+#include "cvfilter.h"
+
+ConstantVelocityFilter::ConstantVelocityFilter(double processNoise) :
+    q_(processNoise), stamp_(0.0), timed_(false), initialised_(false)
+{
+}
+
+void ConstantVelocityFilter::predict(double stamp)
+{
+    if (timed_ && initialised_ && stamp > stamp_)
+    {
+        double dt = stamp - stamp_;
+        predict(x_, dt);
+        predict(y_, dt);
+    }
+    stamp_ = stamp;
+    timed_ = true;
+}
+
+void ConstantVelocityFilter::update(double x, double y, double varianceX, double varianceY)
+{
+    if (!initialised_)
+    {
+        x_.p = x;
+        x_.pp = varianceX;
+        y_.p = y;
+        y_.pp = varianceY;
+        initialised_ = true;
+        return;
+    }
+    update(x_, x, varianceX);
+    update(y_, y, varianceY);
+}
+
+double ConstantVelocityFilter::x() const
+{
+    return x_.p;
+}
+
+double ConstantVelocityFilter::y() const
+{
+    return y_.p;
+}
+
+void ConstantVelocityFilter::predict(Axis& axis, double dt) const
+{
+    // P = F P F' + Q with F = [1 dt; 0 1] and Q of a white acceleration
+    axis.p += axis.v * dt;
+    axis.pp += dt * (2.0 * axis.pv + dt * axis.vv) + q_ * dt * dt * dt / 3.0;
+    axis.pv += dt * axis.vv + q_ * dt * dt / 2.0;
+    axis.vv += q_ * dt;
+}
+
+void ConstantVelocityFilter::update(Axis& axis, double measured, double variance) const
+{
+    double s = axis.pp + variance;
+    if (s <= 0.0) return;
+    double kp = axis.pp / s;
+    double kv = axis.pv / s;
+    double innovation = measured - axis.p;
+    axis.p += kp * innovation;
+    axis.v += kv * innovation;
+    axis.vv -= kv * axis.pv;
+    axis.pv -= kp * axis.pv;
+    axis.pp -= kp * axis.pp;
+}
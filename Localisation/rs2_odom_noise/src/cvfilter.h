@@ -0,0 +1,66 @@
+#ifndef CVFILTER_H
+#define CVFILTER_H
+
+/*!
+ *  \brief     Constant Velocity Filter Class
+ *  \details
+ *  Kalman filter of a planar position under a constant velocity, white acceleration model.
+ *  The x and y axes are independent, so each keeps its own position, velocity and 2x2 covariance.
+ *  It is the filter cv_replay_eval tunes offline. It is a simpler model than the robot_localization
+ *  EKF, so settings found with it are a starting point for that filter, not a substitute for tuning it.
+ *  \version   1.00
+ */
+class ConstantVelocityFilter
+{
+public:
+  /// @brief Constructor for the filter
+  /// @param [in] processNoise - spectral density of the white acceleration [m^2/s^3]
+  ConstantVelocityFilter(double processNoise);
+
+  /// @brief Moves the estimate forward to a stamp, the first call only sets the time
+  /// @param [in] stamp - time of the next measurement [s]
+  void predict(double stamp);
+
+  /// @brief Corrects the estimate with a measured position, the first one sets the position
+  /// @param [in] x - measured x [m]
+  /// @param [in] y - measured y [m]
+  /// @param [in] varianceX - variance of the x measurement [m^2]
+  /// @param [in] varianceY - variance of the y measurement [m^2]
+  void update(double x, double y, double varianceX, double varianceY);
+
+  /// @brief Getter for the estimated x [m]
+  double x() const;
+
+  /// @brief Getter for the estimated y [m]
+  double y() const;
+
+private:
+  //! Estimate of one axis
+  struct Axis
+  {
+    double p = 0.0;   //!< position [m]
+    double v = 0.0;   //!< velocity [m/s]
+    double pp = 0.0;  //!< position variance
+    double pv = 0.0;  //!< position velocity covariance
+    double vv = 1.0;  //!< velocity variance
+  };
+
+  /// @brief Predicts one axis over a time step
+  void predict(Axis& axis, double dt) const;
+
+  /// @brief Corrects one axis with a measurement
+  void update(Axis& axis, double measured, double variance) const;
+
+  //! Spectral density of the acceleration
+  double q_;
+  //! Stamp of the estimate [s]
+  double stamp_;
+  //! Whether a stamp has been seen
+  bool timed_;
+  //! Whether a position has been measured
+  bool initialised_;
+  //! The x and y axes
+  Axis x_, y_;
+};
+
+#endif // CVFILTER_H
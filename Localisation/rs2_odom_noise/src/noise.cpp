@@ -12,15 +12,16 @@
 #include <cmath>
 #include <tf2/LinearMath/Quaternion.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+#include "noiseengine.h"
 
 // Global Variables
 std::string filtered_node_name_ = "/robot_pose_ekf/odom_combined";
 ros::Publisher noisy_odom_publisher;
 std::stringstream filteredData_, rawOdomData_, NoisyOdomData_;
 double noise_var = 0.05;
+NoiseEngine noise_engine_; // only used from the spinner thread, so it needs no locking
 
 // Function Prototypes
-double getRandomNoise();
 void odomCallback(const nav_msgs::Odometry::ConstPtr &odom_msg);
 
 int main(int argc, char **argv)
@@ -28,7 +29,9 @@ int main(int argc, char **argv)
     // ROS Initialization
     ros::init(argc, argv, "noisy_odometry_publisher");
     ros::NodeHandle nh;
-    
+    ros::NodeHandle pnh("~");
+    noise_engine_ = loadNoiseEngine(pnh, noise_var);
+
     // Subscribe to Odometry and Advertise Noisy Odometry
     ros::Subscriber odom_subscriber = nh.subscribe("/odom", 10, odomCallback);
     noisy_odom_publisher = nh.advertise<nav_msgs::Odometry>("/noisy_odom", 10);
@@ -38,27 +41,23 @@ int main(int argc, char **argv)
     return 0;
 }
 
-double getRandomNoise()
-{
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<double> dis(-noise_var, noise_var);
-    return dis(gen);
-}
-
 void odomCallback(const nav_msgs::Odometry::ConstPtr &odom_msg)
 {
     nav_msgs::Odometry noisy_odom;
 
     noisy_odom = *odom_msg; // copy across first
 
-    noisy_odom.pose.pose.position.x = odom_msg->pose.pose.position.x * (1 + getRandomNoise());
-    noisy_odom.pose.pose.position.y = odom_msg->pose.pose.position.y * (1 + getRandomNoise());
-    noisy_odom.pose.pose.position.z = odom_msg->pose.pose.position.z * (1 + getRandomNoise());
+    // One draw covers every axis of the message
+    std::array<double, NoiseEngine::AXES> noise;
+    noise_engine_.sample(noise);
+
+    noisy_odom.pose.pose.position.x = odom_msg->pose.pose.position.x * (1 + noise[0]);
+    noisy_odom.pose.pose.position.y = odom_msg->pose.pose.position.y * (1 + noise[1]);
+    noisy_odom.pose.pose.position.z = odom_msg->pose.pose.position.z * (1 + noise[2]);
 
-    noisy_odom.pose.pose.orientation.x = odom_msg->pose.pose.orientation.x * (1 + getRandomNoise());
-    noisy_odom.pose.pose.orientation.y = odom_msg->pose.pose.orientation.y * (1 + getRandomNoise());
-    noisy_odom.pose.pose.orientation.z = odom_msg->pose.pose.orientation.z * (1 + getRandomNoise());
+    noisy_odom.pose.pose.orientation.x = odom_msg->pose.pose.orientation.x * (1 + noise[3]);
+    noisy_odom.pose.pose.orientation.y = odom_msg->pose.pose.orientation.y * (1 + noise[4]);
+    noisy_odom.pose.pose.orientation.z = odom_msg->pose.pose.orientation.z * (1 + noise[5]);
 
 
     // converting quaternion to roll pitch yaw for covariance matrix
@@ -73,14 +72,14 @@ void odomCallback(const nav_msgs::Odometry::ConstPtr &odom_msg)
     m.getRPY(roll, pitch, yaw);
 
     // Assuming you have angular uncertainty in roll, pitch, yaw
-    float variance_roll = std::pow((noise_var) * roll, 2);
-    float variance_pitch = std::pow((noise_var) * pitch, 2);
-    float variance_yaw = std::pow((noise_var) * yaw, 2);
+    float variance_roll = std::pow(noise_engine_.scale(3) * roll, 2);
+    float variance_pitch = std::pow(noise_engine_.scale(4) * pitch, 2);
+    float variance_yaw = std::pow(noise_engine_.scale(5) * yaw, 2);
 
     // Calculate variances based on odom_msg mean measurements
-    float variance_x = std::pow((noise_var) * odom_msg->pose.pose.position.x, 2);
-    float variance_y = std::pow((noise_var) * odom_msg->pose.pose.position.y, 2);
-    float variance_z = std::pow((noise_var) * odom_msg->pose.pose.position.z, 2);
+    float variance_x = std::pow(noise_engine_.scale(0) * odom_msg->pose.pose.position.x, 2);
+    float variance_y = std::pow(noise_engine_.scale(1) * odom_msg->pose.pose.position.y, 2);
+    float variance_z = std::pow(noise_engine_.scale(2) * odom_msg->pose.pose.position.z, 2);
 
     // Set the covariance matrix
     noisy_odom.pose.covariance[0] = variance_x;      // Variance in x
@@ -12,129 +12,59 @@
 #include <cmath>
 #include <tf2/LinearMath/Quaternion.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+#include <unistd.h>
+#include "odomrecorder.h"
+#include "noiseengine.h"
 
 // Global Variables
-std::string logFilePath = "odometry_data.csv";
-std::string filtered_node_name_; //= "/robot_pose_ekf/odom_combined";
-std::float_t samplePeriod_ = 0.1; // time period between each sample saved to the csv file
 ros::Publisher noisy_odom_publisher;
-ros::Subscriber filtered_odom_subscriber;
-std::ofstream csv_file;
-std::stringstream filteredData_, rawOdomData_, NoisyOdomData_;
+OdomRecorder recorder_; // fed only from the spinner thread
+NoiseEngine noise_engine_; // only used from the spinner thread, so it needs no locking
 
 // Function Prototypes
-bool checkFilteredTopicAvailability();
-double getRandomNoise();
-void FilteredOdomCallback(const geometry_msgs::PoseWithCovarianceStamped::ConstPtr &filtered_odom_msg);
 void odomCallback(const nav_msgs::Odometry::ConstPtr &odom_msg);
-void writeDataToCSV(const ros::TimerEvent &);
-std::string getFilterTopic();
 
 int main(int argc, char **argv)
 {
     // ROS Initialization
     ros::init(argc, argv, "noisy_odometry_publisher");
     ros::NodeHandle nh;
+    ros::NodeHandle pnh("~");
+    noise_engine_ = loadNoiseEngine(pnh, 0.05);
 
-    // Open CSV File
-    csv_file.open(logFilePath);
-    if (!csv_file.is_open())
+    // Open the log and subscribe to the filter from ~filter_topic
+    if (!recorder_.open(nh, pnh))
     {
-        ROS_ERROR("Failed to open the CSV file for writing.");
         return 1;
     }
-    csv_file << "Original_X,Original_Y,Original_Z,Noisy_X,Noisy_Y,Noisy_Z,Filtered_X,Filtered_Y,Filtered_Z\n";
-
-    // ask for filter topic node name
-    filtered_node_name_ = getFilterTopic();
-
-    // Check Topic Availability and Subscribe
-    if (checkFilteredTopicAvailability())
-    {
-        filtered_odom_subscriber = nh.subscribe(filtered_node_name_, 10, FilteredOdomCallback);
-    }
 
     // Subscribe to Odometry and Advertise Noisy Odometry
     ros::Subscriber odom_subscriber = nh.subscribe("/odom", 10, odomCallback);
     noisy_odom_publisher = nh.advertise<nav_msgs::Odometry>("/noisy_odom", 10);
 
-    // Timer for Writing Data to CSV
-    ros::Timer timer = nh.createTimer(ros::Duration(samplePeriod_), writeDataToCSV);
-
     // ROS Spin
     ros::spin();
+    recorder_.close();
     return 0;
 }
 
-std::string getFilterTopic()
-{
-    std::string nodeName;
-    std::cout << "Please enter the filter topic node (eg: /odom): ";
-    std::cin >> nodeName;
-    return nodeName;
-}
-
-bool checkFilteredTopicAvailability()
-{
-    std::vector<ros::master::TopicInfo> topic_infos;
-    bool found_ = false;
-    if (ros::master::getTopics(topic_infos))
-    {
-        for (const auto &info : topic_infos)
-        {
-            if (info.name == filtered_node_name_)
-            {
-                found_ = true;
-                break;
-            }
-        }
-        if (!found_)
-        {
-            ROS_INFO("Topic /odom_filtered not found, writing to file anyway...");
-            filteredData_ << "-"
-                          << ","
-                          << "-"
-                          << ","
-                          << "-";
-        }
-        else
-        {
-            ROS_INFO("Writing to .csv file...");
-        }
-    }
-    return found_;
-}
-
-double getRandomNoise()
-{
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<double> dis(-0.05, 0.05);
-    return dis(gen);
-}
-
-void FilteredOdomCallback(const geometry_msgs::PoseWithCovarianceStamped::ConstPtr &filtered_odom_msg)
-{
-    filteredData_.str("");
-    filteredData_.clear();
-    filteredData_ << filtered_odom_msg->pose.pose.position.x << ","
-                  << filtered_odom_msg->pose.pose.position.y << ","
-                  << filtered_odom_msg->pose.pose.position.z;
-}
-
 void odomCallback(const nav_msgs::Odometry::ConstPtr &odom_msg)
 {
     nav_msgs::Odometry noisy_odom;
 
     noisy_odom = *odom_msg; // copy across first
 
-    noisy_odom.pose.pose.position.x = odom_msg->pose.pose.position.x * (1 + getRandomNoise());
-    noisy_odom.pose.pose.position.y = odom_msg->pose.pose.position.y * (1 + getRandomNoise());
-    noisy_odom.pose.pose.position.z = odom_msg->pose.pose.position.z * (1 + getRandomNoise());
+    // One draw covers every axis of the message
+    std::array<double, NoiseEngine::AXES> noise;
+    noise_engine_.sample(noise);
+
+    noisy_odom.pose.pose.position.x = odom_msg->pose.pose.position.x * (1 + noise[0]);
+    noisy_odom.pose.pose.position.y = odom_msg->pose.pose.position.y * (1 + noise[1]);
+    noisy_odom.pose.pose.position.z = odom_msg->pose.pose.position.z * (1 + noise[2]);
 
-    noisy_odom.pose.pose.orientation.x = odom_msg->pose.pose.orientation.x * (1 + getRandomNoise());
-    noisy_odom.pose.pose.orientation.y = odom_msg->pose.pose.orientation.y * (1 + getRandomNoise());
-    noisy_odom.pose.pose.orientation.z = odom_msg->pose.pose.orientation.z * (1 + getRandomNoise());
+    noisy_odom.pose.pose.orientation.x = odom_msg->pose.pose.orientation.x * (1 + noise[3]);
+    noisy_odom.pose.pose.orientation.y = odom_msg->pose.pose.orientation.y * (1 + noise[4]);
+    noisy_odom.pose.pose.orientation.z = odom_msg->pose.pose.orientation.z * (1 + noise[5]);
 
 
     // converting quaternion to roll pitch yaw for covariance matrix
@@ -149,14 +79,14 @@ void odomCallback(const nav_msgs::Odometry::ConstPtr &odom_msg)
     m.getRPY(roll, pitch, yaw);
 
     // Assuming you have angular uncertainty in roll, pitch, yaw
-    float variance_roll = std::pow((5.0 / 100.0) * roll, 2);
-    float variance_pitch = std::pow((5.0 / 100.0) * pitch, 2);
-    float variance_yaw = std::pow((5.0 / 100.0) * yaw, 2);
+    float variance_roll = std::pow(noise_engine_.scale(3) * roll, 2);
+    float variance_pitch = std::pow(noise_engine_.scale(4) * pitch, 2);
+    float variance_yaw = std::pow(noise_engine_.scale(5) * yaw, 2);
 
     // Calculate variances based on odom_msg mean measurements
-    float variance_x = std::pow((5.0 / 100.0) * odom_msg->pose.pose.position.x, 2);
-    float variance_y = std::pow((5.0 / 100.0) * odom_msg->pose.pose.position.y, 2);
-    float variance_z = std::pow((5.0 / 100.0) * odom_msg->pose.pose.position.z, 2);
+    float variance_x = std::pow(noise_engine_.scale(0) * odom_msg->pose.pose.position.x, 2);
+    float variance_y = std::pow(noise_engine_.scale(1) * odom_msg->pose.pose.position.y, 2);
+    float variance_z = std::pow(noise_engine_.scale(2) * odom_msg->pose.pose.position.z, 2);
 
     // Set the covariance matrix
     noisy_odom.pose.covariance[0] = variance_x;      // Variance in x
@@ -168,25 +98,6 @@ void odomCallback(const nav_msgs::Odometry::ConstPtr &odom_msg)
 
     noisy_odom_publisher.publish(noisy_odom);
 
-    rawOdomData_.str("");
-    rawOdomData_.clear();
-    NoisyOdomData_.str("");
-    NoisyOdomData_.clear();
-
-    rawOdomData_ << odom_msg->pose.pose.position.x << ","
-                 << odom_msg->pose.pose.position.y << ","
-                 << odom_msg->pose.pose.position.z;
-
-    NoisyOdomData_ << noisy_odom.pose.pose.position.x << ","
-                   << noisy_odom.pose.pose.position.y << ","
-                   << noisy_odom.pose.pose.position.z;
-}
-
-void writeDataToCSV(const ros::TimerEvent &)
-{
-    if (!rawOdomData_.str().empty() && !NoisyOdomData_.str().empty() && !filteredData_.str().empty())
-    {
-        csv_file << rawOdomData_.str() << "," << NoisyOdomData_.str() << "," << filteredData_.str() << "\n";
-        csv_file.flush();
-    }
+    recorder_.record(OdomLogger::ODOM, odom_msg->header.stamp.toSec(), odom_msg->pose.pose.position);
+    recorder_.record(OdomLogger::NOISY, noisy_odom.header.stamp.toSec(), noisy_odom.pose.pose.position);
 }
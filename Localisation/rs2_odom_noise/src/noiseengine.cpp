@@ -0,0 +1,129 @@
+#include "noiseengine.h"
+#include <cmath>
+#include <limits>
+
+NoiseEngine::NoiseEngine(uint64_t seed, Distribution distribution, double scale) :
+    seed_(seed), distribution_(distribution), raw_(BLOCK_MESSAGES * AXES), block_(BLOCK_MESSAGES * AXES),
+    next_(BLOCK_MESSAGES * AXES)
+{
+    if (seed_ == 0)
+    {
+        // The device is only read once, for a seed that is logged so the run can be repeated
+        std::random_device rd;
+        seed_ = (static_cast<uint64_t>(rd()) << 32) | rd();
+    }
+    gen_.seed(seed_);
+    scale_.fill(scale);
+}
+
+bool NoiseEngine::parseDistribution(const std::string& name, Distribution& distribution)
+{
+    if (name == "uniform") distribution = Distribution::Uniform;
+    else if (name == "gaussian") distribution = Distribution::Gaussian;
+    else return false;
+    return true;
+}
+
+void NoiseEngine::setDistribution(Distribution distribution)
+{
+    distribution_ = distribution;
+    next_ = block_.size();
+}
+
+void NoiseEngine::setScale(size_t axis, double scale)
+{
+    scale_.at(axis) = scale;
+}
+
+void NoiseEngine::setScale(double scale)
+{
+    scale_.fill(scale);
+}
+
+double NoiseEngine::scale(size_t axis) const
+{
+    return scale_.at(axis);
+}
+
+uint64_t NoiseEngine::seed() const
+{
+    return seed_;
+}
+
+NoiseEngine::Distribution NoiseEngine::distribution() const
+{
+    return distribution_;
+}
+
+void NoiseEngine::sample(std::array<double, AXES>& noise)
+{
+    if (next_ + AXES > block_.size()) refill();
+    const double* unit = block_.data() + next_;
+    for (size_t i = 0; i < AXES; i++) noise[i] = unit[i] * scale_[i];
+    next_ += AXES;
+}
+
+void NoiseEngine::refill()
+{
+    // The generator itself is sequential, everything after it runs over plain arrays
+    const size_t n = raw_.size();
+    for (size_t i = 0; i < n; i++) raw_[i] = gen_();
+
+    // The top 53 bits give a double in [0, 1)
+    double* unit = block_.data();
+    for (size_t i = 0; i < n; i++) unit[i] = static_cast<double>(raw_[i] >> 11) * 0x1.0p-53;
+
+    if (distribution_ == Distribution::Uniform)
+    {
+        for (size_t i = 0; i < n; i++) unit[i] = 2.0 * unit[i] - 1.0;
+    }
+    else
+    {
+        // Box-Muller on pairs, 1 - u keeps the logarithm away from zero
+        const double twoPi = 2.0 * M_PI;
+        for (size_t i = 0; i + 1 < n; i += 2)
+        {
+            const double r = std::sqrt(-2.0 * std::log(1.0 - unit[i]));
+            const double theta = twoPi * unit[i + 1];
+            unit[i] = r * std::cos(theta);
+            unit[i + 1] = r * std::sin(theta);
+        }
+    }
+    next_ = 0;
+}
+
+NoiseEngine loadNoiseEngine(const ros::NodeHandle& pnh, double defaultScale)
+{
+    int seed = 0;
+    std::string distributionName;
+    double scale = defaultScale;
+    std::vector<double> scales;
+    pnh.param("noise_seed", seed, 0);
+    pnh.param("noise_distribution", distributionName, std::string("uniform"));
+    pnh.param("noise_scale", scale, defaultScale);
+    pnh.param("noise_scales", scales, std::vector<double>());
+
+    NoiseEngine::Distribution distribution = NoiseEngine::Distribution::Uniform;
+    if (!NoiseEngine::parseDistribution(distributionName, distribution))
+    {
+        ROS_WARN("Unknown ~noise_distribution %s, using uniform noise", distributionName.c_str());
+    }
+    if (seed == 0)
+    {
+        // A seed that fits the int parameter, so the logged value can be passed back as ~noise_seed
+        std::random_device rd;
+        seed = std::uniform_int_distribution<int>(1, std::numeric_limits<int>::max())(rd);
+    }
+
+    NoiseEngine engine(static_cast<uint64_t>(seed), distribution, scale);
+    if (scales.size() == NoiseEngine::AXES)
+    {
+        for (size_t i = 0; i < NoiseEngine::AXES; i++) engine.setScale(i, scales[i]);
+    }
+    else if (!scales.empty())
+    {
+        ROS_WARN("~noise_scales needs %zu values, using ~noise_scale", NoiseEngine::AXES);
+    }
+    ROS_INFO("Noise seed %d, set ~noise_seed to repeat this run", seed);
+    return engine;
+}
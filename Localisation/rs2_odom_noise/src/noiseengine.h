@@ -0,0 +1,102 @@
+#ifndef NOISEENGINE_H
+#define NOISEENGINE_H
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+
+/*!
+ *  \brief     Noise Engine Class
+ *  \details
+ *  Persistent, seedable source of odometry noise.
+ *  The generator is seeded once, so a run can be repeated from the seed it logs.
+ *  Unit noise is generated a block of messages at a time in plain loops the compiler can vectorise,
+ *  and each sample scales one message worth of it per axis.
+ *  An engine is not shared between threads, a node spinning on several threads keeps one per thread.
+ *  \version   1.00
+ */
+class NoiseEngine
+{
+public:
+  //! The distribution of the unit noise
+  enum class Distribution
+  {
+    Uniform,  //!< uniform on [-1, 1), scaled to [-scale, scale)
+    Gaussian  //!< standard normal, scaled to a standard deviation of scale
+  };
+
+  //! The axes noise is drawn for per message: position x, y, z then orientation x, y, z
+  static constexpr size_t AXES = 6;
+
+  //! Messages of noise generated per block
+  static constexpr size_t BLOCK_MESSAGES = 256;
+
+  /// @brief Constructor for the noise engine
+  /// @param [in] seed - seed of the generator, 0 seeds from std::random_device
+  /// @param [in] distribution - distribution of the noise
+  /// @param [in] scale - scale of the noise on every axis
+  NoiseEngine(uint64_t seed = 0, Distribution distribution = Distribution::Uniform, double scale = 0.05);
+
+  /// @brief Parses a distribution name
+  /// @param [in] name - "uniform" or "gaussian"
+  /// @param [out] distribution - the distribution named
+  /// @return false if the name is not a distribution
+  static bool parseDistribution(const std::string& name, Distribution& distribution);
+
+  /// @brief Setter for the distribution, the noise left in the current block is discarded
+  void setDistribution(Distribution distribution);
+
+  /// @brief Setter for the scale of one axis
+  /// @param [in] axis - index of the axis, below AXES
+  /// @param [in] scale - half width of uniform noise or standard deviation of gaussian noise
+  void setScale(size_t axis, double scale);
+
+  /// @brief Setter for the scale of every axis
+  void setScale(double scale);
+
+  /// @brief Getter for the scale of one axis
+  double scale(size_t axis) const;
+
+  /// @brief Getter for the seed the generator was started from, including one drawn from std::random_device
+  uint64_t seed() const;
+
+  /// @brief Getter for the distribution
+  Distribution distribution() const;
+
+  /// @brief Draws the noise for one message
+  /// @param [out] noise - scaled noise for each axis
+  void sample(std::array<double, AXES>& noise);
+
+private:
+  /// @brief Regenerates the block of unit noise
+  void refill();
+
+  //! Seed the generator was started from
+  uint64_t seed_;
+  //! The generator, only advanced by refill()
+  std::mt19937_64 gen_;
+  //! Distribution of the noise
+  Distribution distribution_;
+  //! Scale of each axis
+  std::array<double, AXES> scale_;
+  //! Raw generator output for a block, kept to avoid reallocating
+  std::vector<uint64_t> raw_;
+  //! Unit noise for a block, message by message
+  std::vector<double> block_;
+  //! Index in block_ of the next message's noise
+  size_t next_;
+};
+
+/// @brief Creates the noise engine of a node from its private parameters
+///
+/// Reads ~noise_seed (default 0, which draws a seed and logs it so the run can be repeated),
+/// ~noise_distribution ("uniform" or "gaussian", default "uniform"), ~noise_scale (default defaultScale)
+/// and ~noise_scales (six scales for position x, y, z and orientation x, y, z, overriding ~noise_scale).
+/// @param [in] pnh - the private node handle
+/// @param [in] defaultScale - scale of every axis when no scale is set
+NoiseEngine loadNoiseEngine(const ros::NodeHandle& pnh, double defaultScale);
+
+#endif // NOISEENGINE_H
@@ -0,0 +1,168 @@
+#include "odomlogger.h"
+#include <ros/ros.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+static_assert(sizeof(OdomLogger::Record) == 40, "the record layout is part of the file format");
+static_assert(OdomSynchronizer::STREAMS == 3 && OdomLogger::ALIGNED_ODOM == OdomLogger::ODOM + 3,
+              "each ALIGNED source follows the raw source it aligns");
+
+namespace
+{
+    const char MAGIC[8] = {'O', 'D', 'O', 'M', 'L', 'O', 'G', '\0'};
+
+    //! Records written to the file per write call
+    const size_t WRITE_BATCH = 512;
+}
+
+OdomLogger::OdomLogger() :
+    fd_(-1), fsyncPeriod_(1.0), dropped_(0), running_(false)
+{
+}
+
+OdomLogger::~OdomLogger()
+{
+    close();
+}
+
+bool OdomLogger::open(const std::string& path, double fsyncPeriod)
+{
+    close();
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0)
+    {
+        ROS_ERROR("Failed to open %s for writing: %s", path.c_str(), std::strerror(errno));
+        return false;
+    }
+
+    uint32_t header[2] = {VERSION, sizeof(Record)};
+    if (!writeAll(MAGIC, sizeof(MAGIC)) || !writeAll(header, sizeof(header)))
+    {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    fsyncPeriod_ = fsyncPeriod;
+    dropped_ = 0;
+    running_ = true;
+    writer_ = std::thread(&OdomLogger::run, this);
+    return true;
+}
+
+void OdomLogger::close()
+{
+    running_ = false;
+    if (writer_.joinable()) writer_.join();
+    if (fd_ >= 0)
+    {
+        ::fsync(fd_);
+        ::close(fd_);
+        fd_ = -1;
+        if (dropped_ > 0)
+        {
+            ROS_WARN("%zu records were dropped because the writer fell behind", dropped_.load());
+        }
+    }
+}
+
+void OdomLogger::log(Source source, double stamp, double x, double y, double z)
+{
+    if (!running_) return;
+    Record record{stamp, x, y, z, source, 0};
+    if (!ring_.push(record)) dropped_++;
+}
+
+void OdomLogger::log(const OdomSynchronizer::Triple& triple)
+{
+    for (uint32_t s = 0; s < OdomSynchronizer::STREAMS; s++)
+    {
+        const OdomSynchronizer::Sample& sample = triple.samples[s];
+        log(static_cast<Source>(ALIGNED_ODOM + s), triple.stamp, sample.x, sample.y, sample.z);
+    }
+}
+
+size_t OdomLogger::dropped() const
+{
+    return dropped_;
+}
+
+bool OdomLogger::read(const std::string& path, std::vector<Record>& records)
+{
+    records.clear();
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    uint32_t header[2];
+    if (!file.read(magic, sizeof(magic)) || !file.read(reinterpret_cast<char*>(header), sizeof(header)))
+    {
+        return false;
+    }
+    if (std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || header[0] != VERSION || header[1] != sizeof(Record))
+    {
+        return false;
+    }
+
+    Record record;
+    while (file.read(reinterpret_cast<char*>(&record), sizeof(record))) records.push_back(record);
+    return true;
+}
+
+void OdomLogger::run()
+{
+    std::vector<Record> batch;
+    batch.reserve(WRITE_BATCH);
+    auto lastSync = std::chrono::steady_clock::now();
+    const auto syncPeriod = std::chrono::duration<double>(fsyncPeriod_);
+
+    // Keep draining after close() is called until the ring is empty
+    bool failed = false;
+    while (running_ || !ring_.empty())
+    {
+        Record record;
+        while (batch.size() < WRITE_BATCH && ring_.pop(record)) batch.push_back(record);
+
+        if (!batch.empty())
+        {
+            if (!failed && !writeAll(batch.data(), batch.size() * sizeof(Record)))
+            {
+                ROS_ERROR("Failed to write the log: %s", std::strerror(errno));
+                failed = true;
+            }
+            batch.clear();
+        }
+        else
+        {
+            // Nothing queued, the callbacks never wait on the writer so polling is the only option
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastSync >= syncPeriod)
+        {
+            ::fsync(fd_);
+            lastSync = now;
+        }
+    }
+}
+
+bool OdomLogger::writeAll(const void* data, size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        ssize_t written = ::write(fd_, bytes, size);
+        if (written < 0)
+        {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += written;
+        size -= written;
+    }
+    return true;
+}
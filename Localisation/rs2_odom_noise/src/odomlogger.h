@@ -0,0 +1,119 @@
+#ifndef ODOMLOGGER_H
+#define ODOMLOGGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "odomsynchronizer.h"
+#include "spscring.h"
+
+/*!
+ *  \brief     Odometry Logger Class
+ *  \details
+ *  Logs every odometry, noisy odometry and filtered pose message to a compact binary file.
+ *  Timestamp aligned triples from an OdomSynchronizer are logged alongside as the ALIGNED sources.
+ *  The subscriber callbacks only copy a record into a lock-free ring, a writer thread drains the ring
+ *  into the file and calls fsync periodically, so no file I/O happens on the callback thread.
+ *  All callbacks must run on the same thread, which is the one producer of the ring.
+ *
+ *  The file starts with the 8 byte magic "ODOMLOG\0", then the version and the record size as little
+ *  endian uint32, followed by the records: stamp, x, y, z as doubles then the source as uint32 and 4
+ *  bytes of padding. filter_analysis/odomlog_to_csv.py converts it to the CSV analysis.py reads.
+ *  @sa SpscRing, OdomSynchronizer
+ *  \version   1.00
+ */
+class OdomLogger
+{
+public:
+  //! The topic a record came from
+  enum Source : uint32_t
+  {
+    ODOM = 0,             //!< /odom
+    NOISY = 1,            //!< /noisy_odom
+    FILTERED = 2,         //!< the filtered pose
+    ALIGNED_ODOM = 3,     //!< /odom at the stamp of an aligned triple
+    ALIGNED_NOISY = 4,    //!< /noisy_odom at the stamp of an aligned triple
+    ALIGNED_FILTERED = 5  //!< the filtered pose at the stamp of an aligned triple
+  };
+
+  //! One logged position
+  struct Record
+  {
+    double stamp;    //!< header stamp of the message [s]
+    double x;        //!< position x [m]
+    double y;        //!< position y [m]
+    double z;        //!< position z [m]
+    uint32_t source; //!< the Source of the message
+    uint32_t pad;    //!< keeps the record a multiple of 8 bytes
+  };
+
+  //! Version of the file format
+  static constexpr uint32_t VERSION = 1;
+
+  //! Records the ring holds before the callbacks start dropping them
+  static constexpr size_t RING_RECORDS = 8192;
+
+  /// @brief Constructor for the logger, nothing is logged until open() succeeds
+  OdomLogger();
+
+  /// @brief Destructor, writes the records left in the ring and closes the file
+  ~OdomLogger();
+
+  OdomLogger(const OdomLogger&) = delete;
+  OdomLogger& operator=(const OdomLogger&) = delete;
+
+  /// @brief Creates the file, writes its header and starts the writer thread
+  /// @param [in] path - file to write, replaced if it exists
+  /// @param [in] fsyncPeriod - seconds between each fsync of the file
+  /// @return false if the file could not be created
+  bool open(const std::string& path, double fsyncPeriod);
+
+  /// @brief Stops the writer thread once the ring is drained and closes the file
+  void close();
+
+  /// @brief Queues a position for the writer thread, called from the callback thread
+  /// @param [in] source - the topic of the message
+  /// @param [in] stamp - header stamp of the message [s]
+  /// @param [in] x - position x [m]
+  /// @param [in] y - position y [m]
+  /// @param [in] z - position z [m]
+  void log(Source source, double stamp, double x, double y, double z);
+
+  /// @brief Queues an aligned triple as three consecutive ALIGNED records, called from the callback thread
+  /// @param [in] triple - the streams at one stamp, indexed by Source
+  void log(const OdomSynchronizer::Triple& triple);
+
+  /// @brief Getter for the records dropped because the ring was full
+  size_t dropped() const;
+
+  /// @brief Reads every whole record of a log, a record cut short at the end is ignored
+  /// @param [in] path - the log file
+  /// @param [out] records - the records in the order they were logged
+  /// @return false if the file is missing or is not a log of this version
+  static bool read(const std::string& path, std::vector<Record>& records);
+
+private:
+  /// @brief Drains the ring into the file until close() is called, run on the writer thread
+  void run();
+
+  /// @brief Writes a buffer to the file, retrying partial writes
+  /// @return false if the write failed
+  bool writeAll(const void* data, size_t size);
+
+  //! Records waiting for the writer thread
+  SpscRing<Record, RING_RECORDS> ring_;
+  //! File descriptor of the log, -1 when closed
+  int fd_;
+  //! Seconds between each fsync
+  double fsyncPeriod_;
+  //! Records dropped because the ring was full
+  std::atomic<size_t> dropped_;
+  //! Set by close() to stop the writer thread
+  std::atomic<bool> running_;
+  //! The writer thread
+  std::thread writer_;
+};
+
+#endif // ODOMLOGGER_H
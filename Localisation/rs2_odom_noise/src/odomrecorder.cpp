@@ -0,0 +1,110 @@
+#include "odomrecorder.h"
+#include <iostream>
+#include <unistd.h>
+
+OdomRecorder::OdomRecorder() :
+    synchronizer_(OdomLogger::FILTERED, 0.2)
+{
+}
+
+bool OdomRecorder::open(ros::NodeHandle& nh, const ros::NodeHandle& pnh)
+{
+    // Every message is logged and filter_analysis/odomlog_to_csv.py makes the .csv file
+    std::string logFilePath;
+    double fsyncPeriod;
+    pnh.param("log_file", logFilePath, std::string("odometry_data.odomlog"));
+    pnh.param("log_fsync_period", fsyncPeriod, 1.0);
+    if (!logger_.open(logFilePath, fsyncPeriod))
+    {
+        return false;
+    }
+
+    filterTopic_ = getFilterTopic(pnh);
+
+    // Subscribe straight away, the subscription attaches whenever the filter starts publishing
+    if (filtered())
+    {
+        // robot_pose_ekf publishes a pose, robot_localization (rs_ekf.launch) publishes odometry
+        std::string filterType;
+        double pollPeriod;
+        pnh.param("filter_type", filterType, std::string("pose"));
+        pnh.param("topic_poll_period", pollPeriod, 1.0);
+        if (filterType == "odometry")
+        {
+            filteredSub_ = nh.subscribe(filterTopic_, 10, &OdomRecorder::filteredOdometryCallback, this);
+        }
+        else
+        {
+            filteredSub_ = nh.subscribe(filterTopic_, 10, &OdomRecorder::filteredPoseCallback, this);
+        }
+        watchTimer_ = nh.createTimer(ros::Duration(pollPeriod), &OdomRecorder::watchFilteredTopic, this);
+        ROS_INFO("Waiting for filter topic %s, writing to log file anyway...", filterTopic_.c_str());
+    }
+
+    // Align the streams at the filter's rate, or at the noisy odometry's rate without a filter
+    double maxGap;
+    pnh.param("sync_max_gap", maxGap, 0.2);
+    synchronizer_ = OdomSynchronizer(filtered() ? OdomLogger::FILTERED : OdomLogger::NOISY, maxGap,
+                                     {true, true, filtered()});
+    return true;
+}
+
+void OdomRecorder::record(OdomLogger::Source source, double stamp, const geometry_msgs::Point& position)
+{
+    logger_.log(source, stamp, position.x, position.y, position.z);
+
+    triples_.clear();
+    synchronizer_.add(source, {stamp, position.x, position.y, position.z}, triples_);
+    for (const auto& triple : triples_)
+    {
+        logger_.log(triple);
+    }
+}
+
+void OdomRecorder::close()
+{
+    watchTimer_.stop();
+    filteredSub_.shutdown();
+    logger_.close();
+}
+
+bool OdomRecorder::filtered() const
+{
+    return !filterTopic_.empty();
+}
+
+std::string OdomRecorder::getFilterTopic(const ros::NodeHandle& pnh)
+{
+    // A parameter always wins, so the node can be started from a launch file or a script
+    std::string nodeName;
+    if (pnh.getParam("filter_topic", nodeName))
+    {
+        return nodeName;
+    }
+    if (!isatty(STDIN_FILENO))
+    {
+        return "/robot_pose_ekf/odom_combined";
+    }
+    std::cout << "Please enter the filter topic node (eg: /odom): ";
+    std::cin >> nodeName;
+    return nodeName;
+}
+
+void OdomRecorder::watchFilteredTopic(const ros::TimerEvent&)
+{
+    if (filteredSub_.getNumPublishers() > 0)
+    {
+        ROS_INFO("Filter topic %s is up, writing to log file...", filterTopic_.c_str());
+        watchTimer_.stop();
+    }
+}
+
+void OdomRecorder::filteredPoseCallback(const geometry_msgs::PoseWithCovarianceStamped::ConstPtr& msg)
+{
+    record(OdomLogger::FILTERED, msg->header.stamp.toSec(), msg->pose.pose.position);
+}
+
+void OdomRecorder::filteredOdometryCallback(const nav_msgs::Odometry::ConstPtr& msg)
+{
+    record(OdomLogger::FILTERED, msg->header.stamp.toSec(), msg->pose.pose.position);
+}
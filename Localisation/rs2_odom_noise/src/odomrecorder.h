@@ -0,0 +1,80 @@
+#ifndef ODOMRECORDER_H
+#define ODOMRECORDER_H
+
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include <nav_msgs/Odometry.h>
+#include <geometry_msgs/Point.h>
+#include <geometry_msgs/PoseWithCovarianceStamped.h>
+#include "odomlogger.h"
+#include "odomsynchronizer.h"
+
+/*!
+ *  \brief     Odometry Recorder Class
+ *  \details
+ *  The recording side shared by the record and create_noise_and_record nodes.
+ *  Opens the log, subscribes to the filter topic and watches for it to come up, and passes every
+ *  position it is given to the logger and the synchroniser, logging each aligned triple.
+ *  The node subscribes to /odom and /noisy_odom itself and calls record() from its callbacks.
+ *  Every callback must run on the spinner thread, the single producer of the logger's ring.
+ *  @sa OdomLogger, OdomSynchronizer
+ *  \version   1.00
+ */
+class OdomRecorder
+{
+public:
+  /// @brief Constructor for the recorder, nothing is opened until open()
+  OdomRecorder();
+
+  /// @brief Opens the log and subscribes to the filter from the private parameters
+  ///
+  /// Reads ~log_file, ~log_fsync_period, ~filter_topic (asked for on a terminal when unset, an empty
+  /// topic records without a filter), ~filter_type ("pose" for robot_pose_ekf or "odometry" for
+  /// robot_localization), ~topic_poll_period and ~sync_max_gap.
+  /// @param [in] nh - the node handle the filter is subscribed on
+  /// @param [in] pnh - the private node handle
+  /// @return false if the log could not be opened
+  bool open(ros::NodeHandle& nh, const ros::NodeHandle& pnh);
+
+  /// @brief Logs a position and any triple it completes
+  /// @param [in] source - the topic the position came from
+  /// @param [in] stamp - header stamp of the message in seconds
+  /// @param [in] position - the position in the message
+  void record(OdomLogger::Source source, double stamp, const geometry_msgs::Point& position);
+
+  /// @brief Flushes and closes the log
+  void close();
+
+  /// @brief Getter for whether a filter topic is recorded
+  bool filtered() const;
+
+private:
+  /// @brief Reads the filter topic from ~filter_topic or the terminal
+  /// @param [in] pnh - the private node handle
+  static std::string getFilterTopic(const ros::NodeHandle& pnh);
+
+  /// @brief Reports when the filter topic gets a publisher and stops polling for it
+  void watchFilteredTopic(const ros::TimerEvent&);
+
+  /// @brief Callback for a filter publishing a pose, such as robot_pose_ekf
+  void filteredPoseCallback(const geometry_msgs::PoseWithCovarianceStamped::ConstPtr& msg);
+
+  /// @brief Callback for a filter publishing odometry, such as robot_localization
+  void filteredOdometryCallback(const nav_msgs::Odometry::ConstPtr& msg);
+
+  //! The filter topic, empty without a filter
+  std::string filterTopic_;
+  //! Subscriber to the filter topic
+  ros::Subscriber filteredSub_;
+  //! Polls until the filter topic has a publisher
+  ros::Timer watchTimer_;
+  //! Log of every message, fed only from the spinner thread
+  OdomLogger logger_;
+  //! Aligns the streams for the triples in the log
+  OdomSynchronizer synchronizer_;
+  //! Triples completed by the last record, kept to avoid reallocating
+  std::vector<OdomSynchronizer::Triple> triples_;
+};
+
+#endif // ODOMRECORDER_H
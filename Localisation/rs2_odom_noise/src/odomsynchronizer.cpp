@@ -0,0 +1,123 @@
+#include "odomsynchronizer.h"
+#include <limits>
+
+void OdomSynchronizer::Ring::push(const Sample& sample)
+{
+    samples[(first + size) % CAPACITY] = sample;
+    size++;
+}
+
+void OdomSynchronizer::Ring::pop(size_t count)
+{
+    first = (first + count) % CAPACITY;
+    size -= count;
+}
+
+OdomSynchronizer::OdomSynchronizer(size_t reference, double maxGap, std::array<bool, STREAMS> used) :
+    reference_(reference), maxGap_(maxGap), used_(used), dropped_(0)
+{
+    used_.at(reference_) = true;
+    reset();
+}
+
+void OdomSynchronizer::add(size_t stream, const Sample& sample, std::vector<Triple>& triples)
+{
+    if (!used_.at(stream)) return;
+
+    // Time went backwards, eg a rosbag was restarted, nothing buffered can be matched any more
+    if (sample.stamp < last_[stream]) reset();
+    last_[stream] = sample.stamp;
+
+    Ring& ring = streams_[stream];
+    if (ring.size == CAPACITY)
+    {
+        // A full reference ring means its oldest message has waited too long for the other streams
+        if (stream == reference_) dropped_++;
+        ring.pop(1);
+    }
+    ring.push(sample);
+    resolve(triples);
+}
+
+size_t OdomSynchronizer::reference() const
+{
+    return reference_;
+}
+
+size_t OdomSynchronizer::dropped() const
+{
+    return dropped_;
+}
+
+OdomSynchronizer::Match OdomSynchronizer::match(const Ring& ring, double stamp, Sample& sample) const
+{
+    if (ring.size == 0 || ring.back().stamp < stamp) return Match::Wait;
+
+    size_t i = 0;
+    while (ring.at(i).stamp < stamp) i++;
+    const Sample& after = ring.at(i);
+    if (after.stamp == stamp)
+    {
+        sample = after;
+        return Match::Found;
+    }
+    // Nothing at or before the stamp is buffered, it came before this stream started or was pruned
+    if (i == 0) return Match::Miss;
+
+    const Sample& before = ring.at(i - 1);
+    if (after.stamp - before.stamp > maxGap_) return Match::Miss;
+
+    double w = (stamp - before.stamp) / (after.stamp - before.stamp);
+    sample.stamp = stamp;
+    sample.x = before.x + w * (after.x - before.x);
+    sample.y = before.y + w * (after.y - before.y);
+    sample.z = before.z + w * (after.z - before.z);
+    return Match::Found;
+}
+
+void OdomSynchronizer::resolve(std::vector<Triple>& triples)
+{
+    Ring& references = streams_[reference_];
+    while (references.size > 0)
+    {
+        Triple triple{};
+        triple.stamp = references.at(0).stamp;
+        triple.samples[reference_] = references.at(0);
+
+        bool wait = false;
+        bool miss = false;
+        for (size_t s = 0; s < STREAMS; s++)
+        {
+            if (s == reference_ || !used_[s]) continue;
+            Match m = match(streams_[s], triple.stamp, triple.samples[s]);
+            wait = wait || m == Match::Wait;
+            miss = miss || m == Match::Miss;
+        }
+
+        // A miss never turns into a match, so it is dropped without waiting on the other streams
+        if (miss) dropped_++;
+        else if (wait) break;
+        else triples.push_back(triple);
+        references.pop(1);
+
+        // Later references are later in time, only the last message at or before this one is still needed
+        for (size_t s = 0; s < STREAMS; s++)
+        {
+            if (s == reference_) continue;
+            Ring& ring = streams_[s];
+            size_t stale = 0;
+            while (stale + 1 < ring.size && ring.at(stale + 1).stamp <= triple.stamp) stale++;
+            ring.pop(stale);
+        }
+    }
+}
+
+void OdomSynchronizer::reset()
+{
+    for (size_t s = 0; s < STREAMS; s++)
+    {
+        streams_[s].first = 0;
+        streams_[s].size = 0;
+        last_[s] = -std::numeric_limits<double>::infinity();
+    }
+}
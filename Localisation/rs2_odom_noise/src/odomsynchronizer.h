@@ -0,0 +1,112 @@
+#ifndef ODOMSYNCHRONIZER_H
+#define ODOMSYNCHRONIZER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*!
+ *  \brief     Odometry Synchronizer Class
+ *  \details
+ *  Aligns the original odometry, noisy odometry and filtered pose streams by header stamp.
+ *  One stream is the reference, for every reference message the other streams are linearly interpolated
+ *  at its stamp between the two messages either side of it. A triple is emitted once every stream has a
+ *  message at or after the reference stamp, so triples come out at the reference rate.
+ *  Each stream keeps at most CAPACITY messages, a reference that cannot be matched before its buffer
+ *  fills, or that falls in a gap longer than the maximum gap, is dropped.
+ *  Not thread safe, all messages are added from the callback thread.
+ *  \version   1.00
+ */
+class OdomSynchronizer
+{
+public:
+  //! Number of streams aligned, indexed as OdomLogger::Source
+  static constexpr size_t STREAMS = 3;
+
+  //! Messages kept per stream
+  static constexpr size_t CAPACITY = 64;
+
+  //! A position at a stamp
+  struct Sample
+  {
+    double stamp; //!< header stamp [s]
+    double x;     //!< position x [m]
+    double y;     //!< position y [m]
+    double z;     //!< position z [m]
+  };
+
+  //! Every stream at the stamp of one reference message
+  struct Triple
+  {
+    double stamp;                        //!< stamp of the reference message [s]
+    std::array<Sample, STREAMS> samples; //!< each stream at that stamp
+  };
+
+  /// @brief Constructor for the synchronizer
+  /// @param [in] reference - index of the stream triples are emitted for
+  /// @param [in] maxGap - longest time between two messages that is interpolated across [s]
+  /// @param [in] used - the streams that are aligned, the samples of the others are left zero
+  OdomSynchronizer(size_t reference, double maxGap, std::array<bool, STREAMS> used = {true, true, true});
+
+  /// @brief Adds a message of a stream, a stamp older than the stream's last one resets every stream
+  /// @param [in] stream - index of the stream
+  /// @param [in] sample - the message
+  /// @param [out] triples - triples that became complete are appended
+  void add(size_t stream, const Sample& sample, std::vector<Triple>& triples);
+
+  /// @brief Getter for the reference index
+  size_t reference() const;
+
+  /// @brief Getter for the reference messages dropped without a triple
+  size_t dropped() const;
+
+private:
+  //! Fixed size ring of messages, oldest first
+  struct Ring
+  {
+    std::array<Sample, CAPACITY> samples;
+    size_t first = 0;
+    size_t size = 0;
+
+    const Sample& at(size_t i) const { return samples[(first + i) % CAPACITY]; }
+    const Sample& back() const { return at(size - 1); }
+    void push(const Sample& sample);
+    void pop(size_t count);
+  };
+
+  //! The result of matching a stamp in a stream
+  enum class Match
+  {
+    Found, //!< interpolated
+    Wait,  //!< no message at or after the stamp yet
+    Miss   //!< the stamp cannot be interpolated in this stream
+  };
+
+  /// @brief Interpolates a stream at a stamp
+  /// @param [in] ring - the stream
+  /// @param [in] stamp - the stamp [s]
+  /// @param [out] sample - the stream at the stamp when found
+  Match match(const Ring& ring, double stamp, Sample& sample) const;
+
+  /// @brief Emits or drops the pending reference messages that can be decided
+  void resolve(std::vector<Triple>& triples);
+
+  /// @brief Forgets every message
+  void reset();
+
+  //! Index of the reference stream
+  size_t reference_;
+  //! Longest gap interpolated across [s]
+  double maxGap_;
+  //! The streams that are aligned
+  std::array<bool, STREAMS> used_;
+  //! Messages of each stream, the reference ring holds those still waiting for a triple
+  std::array<Ring, STREAMS> streams_;
+  //! Stamp of the last message of each stream [s]
+  std::array<double, STREAMS> last_;
+  //! Reference messages dropped
+  size_t dropped_;
+};
+
+#endif // ODOMSYNCHRONIZER_H
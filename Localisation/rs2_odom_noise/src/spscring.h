@@ -0,0 +1,61 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/*!
+ *  \brief     Single Producer Single Consumer Ring Class
+ *  \details
+ *  Fixed size lock-free queue between exactly one producing thread and one consuming thread.
+ *  Neither side ever blocks: push() fails when the ring is full and pop() fails when it is empty.
+ *  The head and tail live on separate cache lines so the two threads do not false share.
+ *  \version   1.00
+ */
+template <typename T, size_t Capacity>
+class SpscRing
+{
+  static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  /// @brief Adds an item, only called from the producing thread
+  /// @param [in] item - the item to add
+  /// @return false if the ring is full and the item was not added
+  bool push(const T& item)
+  {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == Capacity) return false;
+    items_[head & (Capacity - 1)] = item;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief Removes the oldest item, only called from the consuming thread
+  /// @param [out] item - the item removed
+  /// @return false if the ring is empty
+  bool pop(T& item)
+  {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) return false;
+    item = items_[tail & (Capacity - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief Checks if the ring is empty, exact only on the consuming thread
+  bool empty() const
+  {
+    return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+  }
+
+private:
+  //! Number of items ever pushed, written by the producer
+  alignas(64) std::atomic<size_t> head_{0};
+  //! Number of items ever popped, written by the consumer
+  alignas(64) std::atomic<size_t> tail_{0};
+  //! Storage of the items
+  alignas(64) std::array<T, Capacity> items_;
+};
+
+#endif // SPSCRING_H
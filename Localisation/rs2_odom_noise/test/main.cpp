@@ -0,0 +1,8 @@
+#include <gtest/gtest.h>
+
+// Runs every test of the ROS-free classes, none of them needs a master
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include "noiseengine.h"
+
+namespace
+{
+    //! Messages drawn by the statistical tests, several blocks worth
+    const size_t MESSAGES = 20 * NoiseEngine::BLOCK_MESSAGES;
+}
+
+TEST(NoiseEngine, RepeatsFromItsSeed)
+{
+    NoiseEngine first(42, NoiseEngine::Distribution::Gaussian, 0.1);
+    NoiseEngine second(first.seed(), NoiseEngine::Distribution::Gaussian, 0.1);
+    NoiseEngine other(43, NoiseEngine::Distribution::Gaussian, 0.1);
+
+    std::array<double, NoiseEngine::AXES> a, b, c;
+    bool differs = false;
+    for (size_t m = 0; m < MESSAGES; m++)
+    {
+        first.sample(a);
+        second.sample(b);
+        other.sample(c);
+        ASSERT_EQ(a, b);
+        differs = differs || a != c;
+    }
+    EXPECT_TRUE(differs);
+
+    // A seed of 0 is drawn once and reported, so the run can still be repeated
+    NoiseEngine drawn(0);
+    EXPECT_NE(drawn.seed(), 0u);
+}
+
+TEST(NoiseEngine, ScalesUniformNoisePerAxis)
+{
+    NoiseEngine engine(7, NoiseEngine::Distribution::Uniform, 0.05);
+    engine.setScale(2, 0.0);
+    engine.setScale(5, 0.5);
+
+    std::array<double, NoiseEngine::AXES> noise;
+    std::array<double, NoiseEngine::AXES> largest{};
+    for (size_t m = 0; m < MESSAGES; m++)
+    {
+        engine.sample(noise);
+        for (size_t axis = 0; axis < NoiseEngine::AXES; axis++)
+        {
+            ASSERT_GE(noise[axis], -engine.scale(axis));
+            ASSERT_LT(noise[axis], engine.scale(axis) + 1e-12);
+            largest[axis] = std::max(largest[axis], std::fabs(noise[axis]));
+        }
+    }
+    EXPECT_EQ(largest[2], 0.0);
+    EXPECT_GT(largest[0], 0.9 * 0.05);
+    EXPECT_GT(largest[5], 0.9 * 0.5);
+}
+
+TEST(NoiseEngine, GaussianNoiseHasTheScaleAsDeviation)
+{
+    NoiseEngine engine(11, NoiseEngine::Distribution::Gaussian, 0.2);
+
+    std::array<double, NoiseEngine::AXES> noise;
+    double sum = 0.0, sumSquares = 0.0;
+    for (size_t m = 0; m < MESSAGES; m++)
+    {
+        engine.sample(noise);
+        for (double n : noise)
+        {
+            sum += n;
+            sumSquares += n * n;
+        }
+    }
+    const double count = MESSAGES * NoiseEngine::AXES;
+    const double mean = sum / count;
+    EXPECT_NEAR(mean, 0.0, 0.01);
+    EXPECT_NEAR(std::sqrt(sumSquares / count - mean * mean), 0.2, 0.01);
+}
+
+TEST(NoiseEngine, ParsesDistributionNames)
+{
+    NoiseEngine::Distribution distribution = NoiseEngine::Distribution::Uniform;
+    EXPECT_TRUE(NoiseEngine::parseDistribution("gaussian", distribution));
+    EXPECT_EQ(distribution, NoiseEngine::Distribution::Gaussian);
+    EXPECT_TRUE(NoiseEngine::parseDistribution("uniform", distribution));
+    EXPECT_EQ(distribution, NoiseEngine::Distribution::Uniform);
+    EXPECT_FALSE(NoiseEngine::parseDistribution("laplace", distribution));
+    EXPECT_EQ(distribution, NoiseEngine::Distribution::Uniform);
+}
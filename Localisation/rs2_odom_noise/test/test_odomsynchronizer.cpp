@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include "odomsynchronizer.h"
+
+namespace
+{
+    const size_t ODOM = 0, NOISY = 1, FILTERED = 2;
+
+    //! A sample moving along x at 1 m/s
+    OdomSynchronizer::Sample at(double stamp)
+    {
+        return {stamp, stamp, 0.0, 0.0};
+    }
+}
+
+TEST(OdomSynchronizer, InterpolatesAtTheReferenceStamp)
+{
+    OdomSynchronizer synchronizer(FILTERED, 0.2);
+    std::vector<OdomSynchronizer::Triple> triples;
+
+    synchronizer.add(ODOM, at(0.0), triples);
+    synchronizer.add(NOISY, at(0.0), triples);
+    synchronizer.add(FILTERED, at(0.05), triples);
+    // The filtered pose waits until both other streams have a message after it
+    synchronizer.add(ODOM, at(0.1), triples);
+    EXPECT_TRUE(triples.empty());
+    synchronizer.add(NOISY, at(0.1), triples);
+
+    ASSERT_EQ(triples.size(), 1u);
+    EXPECT_DOUBLE_EQ(triples[0].stamp, 0.05);
+    for (const auto& sample : triples[0].samples)
+    {
+        EXPECT_DOUBLE_EQ(sample.stamp, 0.05);
+        EXPECT_DOUBLE_EQ(sample.x, 0.05);
+    }
+    EXPECT_EQ(synchronizer.dropped(), 0u);
+}
+
+TEST(OdomSynchronizer, DropsReferencesItCannotInterpolate)
+{
+    OdomSynchronizer synchronizer(FILTERED, 0.2);
+    std::vector<OdomSynchronizer::Triple> triples;
+
+    // Before the other streams start
+    synchronizer.add(ODOM, at(1.0), triples);
+    synchronizer.add(NOISY, at(1.0), triples);
+    synchronizer.add(FILTERED, at(0.5), triples);
+    EXPECT_TRUE(triples.empty());
+    EXPECT_EQ(synchronizer.dropped(), 1u);
+
+    // Inside a gap longer than the maximum gap
+    synchronizer.add(FILTERED, at(1.5), triples);
+    synchronizer.add(ODOM, at(2.0), triples);
+    synchronizer.add(NOISY, at(2.0), triples);
+    EXPECT_TRUE(triples.empty());
+    EXPECT_EQ(synchronizer.dropped(), 2u);
+}
+
+TEST(OdomSynchronizer, LeavesUnusedStreamsOut)
+{
+    // Recording without a filter aligns /odom at the rate of /noisy_odom
+    OdomSynchronizer synchronizer(NOISY, 0.2, {true, true, false});
+    std::vector<OdomSynchronizer::Triple> triples;
+
+    synchronizer.add(FILTERED, at(0.0), triples);
+    synchronizer.add(ODOM, at(0.0), triples);
+    synchronizer.add(NOISY, at(0.05), triples);
+    synchronizer.add(ODOM, at(0.1), triples);
+
+    ASSERT_EQ(triples.size(), 1u);
+    EXPECT_DOUBLE_EQ(triples[0].samples[ODOM].x, 0.05);
+    EXPECT_DOUBLE_EQ(triples[0].samples[NOISY].x, 0.05);
+    EXPECT_EQ(triples[0].samples[FILTERED].stamp, 0.0);
+}
+
+TEST(OdomSynchronizer, ResetsWhenTimeGoesBackwards)
+{
+    OdomSynchronizer synchronizer(FILTERED, 0.2);
+    std::vector<OdomSynchronizer::Triple> triples;
+
+    synchronizer.add(ODOM, at(10.0), triples);
+    synchronizer.add(NOISY, at(10.0), triples);
+    synchronizer.add(FILTERED, at(10.05), triples);
+
+    // A rosbag restarted from the beginning, the reference waiting at 10.05 s is forgotten
+    synchronizer.add(ODOM, at(0.0), triples);
+    synchronizer.add(NOISY, at(0.0), triples);
+    synchronizer.add(FILTERED, at(0.05), triples);
+    synchronizer.add(NOISY, at(0.1), triples);
+    EXPECT_TRUE(triples.empty());
+    synchronizer.add(ODOM, at(0.1), triples);
+
+    ASSERT_EQ(triples.size(), 1u);
+    EXPECT_DOUBLE_EQ(triples[0].stamp, 0.05);
+}
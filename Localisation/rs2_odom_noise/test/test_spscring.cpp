@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "spscring.h"
+
+TEST(SpscRing, KeepsOrderAndCapacity)
+{
+    SpscRing<int, 4> ring;
+    int item = -1;
+    EXPECT_TRUE(ring.empty());
+    EXPECT_FALSE(ring.pop(item));
+
+    for (int i = 0; i < 4; i++) EXPECT_TRUE(ring.push(i));
+    EXPECT_FALSE(ring.push(4));
+
+    // Popping one makes room for one more, and the indices wrap past the end of the storage
+    ASSERT_TRUE(ring.pop(item));
+    EXPECT_EQ(item, 0);
+    EXPECT_TRUE(ring.push(4));
+    for (int i = 1; i <= 4; i++)
+    {
+        ASSERT_TRUE(ring.pop(item));
+        EXPECT_EQ(item, i);
+    }
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRing, PassesEveryItemBetweenThreads)
+{
+    const int ITEMS = 200000;
+    SpscRing<int, 64> ring;
+
+    std::thread producer([&ring, ITEMS]() {
+        for (int i = 0; i < ITEMS; i++)
+        {
+            while (!ring.push(i)) std::this_thread::yield();
+        }
+    });
+
+    // Every item arrives once and in order, however the two threads interleave
+    int expected = 0;
+    int item;
+    while (expected < ITEMS)
+    {
+        if (!ring.pop(item))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_EQ(item, expected);
+        expected++;
+    }
+    producer.join();
+    EXPECT_TRUE(ring.empty());
+}
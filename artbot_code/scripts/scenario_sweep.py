@@ -0,0 +1,251 @@
+#!/usr/bin/env python3
+"""Runs the tour headless on every world of rs2_gazebo_world for several goal seeds and reports how it went.
+
+Each run is launch/artbot_scenario.launch under its own ROS master and Gazebo master port, so several run at
+once without seeing each other. A run starts the mission once /mission is advertised and ends when the
+artbot_code node logs the last goal, or at the timeout. Its output and logs go to <output>/<world>_seed<n>/ and
+one row per run is written to <output>/report.csv:
+
+  mission_s    simulated time from the mission request to the last goal, empty if it timed out
+  wall_s       wall time of the whole run, including the start of Gazebo
+  tour_ms      time to plan the tour, as logged by the node when it plans through the exhibits
+  map          the map the run was localised and planned on
+  goals_max_ms longest goals stage of the control loop over the whole run, where the tour is planned, from
+               /loop_profile
+  tick_max_ms  longest control loop tick over the whole run
+  tick_p99_ms  p99 of the control loop tick over the last profile period
+  missed       control loop ticks that missed the 10 Hz deadline over the whole run
+  cpu_s        CPU time of every process of the run, cpu_cores is that over wall_s
+
+Every world is toured on the same --map-file, examples/rs2_V3_map.yaml by default, not on a map of that world.
+On a world the map was not made from the robot plans and localises on the wrong walls, so those rows measure
+how the tour copes with a wrong map rather than how it does on that world.
+
+Usage: scenario_sweep.py --seeds 1 2 3 --jobs 3 --rtf 2 --output /tmp/sweep
+"""
+
+import argparse
+import csv
+import glob
+import os
+import queue
+import re
+import signal
+import subprocess
+import sys
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(os.path.realpath(__file__)), '..', '..'))
+# The worlds step the physics every 1 ms
+MAX_STEP_SIZE = 0.001
+
+ANSI = re.compile(r'\x1b\[[0-9;]*m')
+# [ INFO] [wall, sim]: message, the sim stamp is only there with use_sim_time
+LOG_LINE = re.compile(r'^\[ *(\w+)\] \[([\d.]+)(?:, ([\d.]+))?\]: (.*)$')
+TOUR_PLANNED = re.compile(r'^Tour of \d+ exhibits .* in ([\d.]+) ms')
+PROFILE_ENTRY = re.compile(r'key: "?([^"\n]*)"?\s*\n\s*value: "?([^"\n]*)"?')
+
+FIELDS = ['world', 'seed', 'rtf', 'status', 'map', 'mission_s', 'wall_s', 'tour_ms', 'goals_max_ms', 'tick_max_ms',
+          'tick_p99_ms', 'missed', 'cpu_s', 'cpu_cores']
+
+
+def find_worlds(directory, names):
+    worlds = sorted(os.path.splitext(os.path.basename(path))[0]
+                    for path in glob.glob(os.path.join(directory, '*.world')) if os.path.isfile(path))
+    if names:
+        missing = set(names) - set(worlds)
+        if missing:
+            sys.exit('No such world in %s: %s' % (directory, ', '.join(sorted(missing))))
+        worlds = [world for world in worlds if world in names]
+    return worlds
+
+
+def session_cpu(sid):
+    """CPU time in seconds of every live process of a session, read from /proc."""
+    ticks = os.sysconf('SC_CLK_TCK')
+    total = 0
+    for pid in os.listdir('/proc'):
+        if not pid.isdigit():
+            continue
+        try:
+            with open('/proc/%s/stat' % pid) as f:
+                # The command name is in brackets and may hold spaces, the fields after it are fixed
+                fields = f.read().rsplit(')', 1)[1].split()
+        except (IOError, IndexError):
+            continue
+        if int(fields[3]) == sid:
+            total += int(fields[11]) + int(fields[12])
+    return total / float(ticks)
+
+
+class Run(object):
+    def __init__(self, args, world, seed, slot):
+        self.args = args
+        self.world = world
+        self.seed = seed
+        self.directory = os.path.join(args.output, '%s_seed%d' % (world, seed))
+        self.env = dict(os.environ)
+        self.env['ROS_MASTER_URI'] = 'http://localhost:%d' % (args.ros_port + slot)
+        self.env['GAZEBO_MASTER_URI'] = 'http://localhost:%d' % (args.gazebo_port + slot)
+        self.env['ROS_LOG_DIR'] = os.path.join(self.directory, 'log')
+        self.env.setdefault('TURTLEBOT3_MODEL', 'waffle')
+        self.port = args.ros_port + slot
+        self.start_sim = None
+        self.end_sim = None
+        self.tour_ms = None
+        self.complete = threading.Event()
+
+    def launch_command(self):
+        return ['roslaunch', '-p', str(self.port), 'artbot_code', 'artbot_scenario.launch',
+                'world:=%s' % self.world, 'map_file:=%s' % self.args.map_file, 'goal_seed:=%d' % self.seed,
+                'num_goals:=%d' % self.args.num_goals, 'traj_mode:=%d' % self.args.traj_mode]
+
+    def command(self, *words):
+        return subprocess.run(list(words), env=self.env, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                              universal_newlines=True, timeout=30)
+
+    def read_output(self, stream, log):
+        for raw in stream:
+            log.write(raw)
+            match = LOG_LINE.match(ANSI.sub('', raw).strip())
+            if not match:
+                continue
+            stamp = float(match.group(3) or match.group(2))
+            message = match.group(4)
+            if message.startswith('Requested: Start mission') and self.start_sim is None:
+                self.start_sim = stamp
+            elif message.startswith('***MISSION COMPLETE***'):
+                self.end_sim = stamp
+                self.complete.set()
+            else:
+                tour = TOUR_PLANNED.match(message)
+                if tour:
+                    self.tour_ms = float(tour.group(1))
+
+    def retry(self, deadline, *words):
+        while time.time() < deadline:
+            try:
+                if self.command(*words).returncode == 0:
+                    return True
+            except subprocess.TimeoutExpired:
+                pass
+            time.sleep(1.0)
+        return False
+
+    def loop_profile(self):
+        try:
+            out = self.command('rostopic', 'echo', '-n', '1', '/loop_profile').stdout
+        except subprocess.TimeoutExpired:
+            return {}
+        return dict(PROFILE_ENTRY.findall(out))
+
+    def execute(self):
+        os.makedirs(self.env['ROS_LOG_DIR'], exist_ok=True)
+        row = {'world': self.world, 'seed': self.seed, 'rtf': self.args.rtf,
+               'map': os.path.basename(self.args.map_file)}
+        began = time.time()
+        with open(os.path.join(self.directory, 'launch.log'), 'w') as log:
+            proc = subprocess.Popen(self.launch_command(), env=self.env, stdout=subprocess.PIPE,
+                                    stderr=subprocess.STDOUT, universal_newlines=True, start_new_session=True)
+            reader = threading.Thread(target=self.read_output, args=(proc.stdout, log))
+            reader.start()
+            try:
+                deadline = began + self.args.startup_timeout
+                rate = '%g' % (self.args.rtf / MAX_STEP_SIZE)
+                started = (self.retry(deadline, 'gz', 'physics', '-u', rate) and
+                           self.retry(deadline, 'rosservice', 'call', '/mission', 'data: true'))
+                if not started:
+                    row['status'] = 'failed to start'
+                else:
+                    finished = began + self.args.timeout
+                    while not self.complete.wait(1.0) and proc.poll() is None and time.time() < finished:
+                        pass
+                    row['status'] = 'complete' if self.complete.is_set() else (
+                        'exited' if proc.poll() is not None else 'timeout')
+                    # The totals cover the whole run, the goals stage only runs when the tour is planned
+                    profile = self.loop_profile()
+                    row['goals_max_ms'] = profile.get('goals max ms total', '')
+                    row['tick_max_ms'] = profile.get('tick max ms total', '')
+                    row['tick_p99_ms'] = profile.get('tick p99 ms', '')
+                    row['missed'] = profile.get('missed deadlines total', '')
+                cpu = session_cpu(proc.pid)
+            finally:
+                if proc.poll() is None:
+                    os.killpg(proc.pid, signal.SIGINT)
+                    try:
+                        proc.wait(timeout=20)
+                    except subprocess.TimeoutExpired:
+                        os.killpg(proc.pid, signal.SIGKILL)
+                        proc.wait()
+                reader.join()
+        wall = time.time() - began
+        if self.complete.is_set() and self.start_sim is not None:
+            row['mission_s'] = '%.1f' % (self.end_sim - self.start_sim)
+        row['wall_s'] = '%.1f' % wall
+        row['tour_ms'] = '' if self.tour_ms is None else '%.2f' % self.tour_ms
+        row['cpu_s'] = '%.1f' % cpu
+        row['cpu_cores'] = '%.2f' % (cpu / wall)
+        return row
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--worlds', nargs='*', default=[],
+                        help='world names without .world, default every world of rs2_gazebo_world')
+    parser.add_argument('--worlds-dir', default=os.path.join(ROOT, 'rs2_gazebo_world', 'world'))
+    parser.add_argument('--map-file', default=os.path.join(ROOT, 'examples', 'rs2_V3_map.yaml'))
+    parser.add_argument('--seeds', nargs='+', type=int, default=[1, 2, 3], help='goal seeds, each a run per world')
+    parser.add_argument('--num-goals', type=int, default=5)
+    parser.add_argument('--traj-mode', type=int, default=1)
+    parser.add_argument('--rtf', type=float, default=1.0, help='real time factor of Gazebo, 0 runs unthrottled')
+    parser.add_argument('--jobs', type=int, default=max(1, (os.cpu_count() or 4) // 4), help='runs at once')
+    parser.add_argument('--ros-port', type=int, default=11411, help='master port of the first run slot')
+    parser.add_argument('--gazebo-port', type=int, default=11545, help='Gazebo port of the first run slot')
+    parser.add_argument('--startup-timeout', type=float, default=120.0, help='[s] wall for /mission to appear')
+    parser.add_argument('--timeout', type=float, default=900.0, help='[s] wall for a whole run')
+    parser.add_argument('--output', default='scenario_sweep')
+    parser.add_argument('--dry-run', action='store_true', help='print the runs without starting them')
+    args = parser.parse_args()
+    args.output = os.path.abspath(args.output)
+
+    runs = [(world, seed) for world in find_worlds(args.worlds_dir, args.worlds) for seed in args.seeds]
+    if args.dry_run:
+        for i, (world, seed) in enumerate(runs):
+            run = Run(args, world, seed, i % args.jobs)
+            print('%s %s' % (run.env['ROS_MASTER_URI'], ' '.join(run.launch_command())))
+        return
+
+    # Each slot owns a pair of ports, a run takes a free slot and gives it back when it ends
+    slots = queue.Queue()
+    for slot in range(args.jobs):
+        slots.put(slot)
+
+    def work(world, seed):
+        slot = slots.get()
+        try:
+            row = Run(args, world, seed, slot).execute()
+        finally:
+            slots.put(slot)
+        print('%-20s seed %-4d %-16s mission %6s s  wall %6s s  missed %s' % (
+            world, seed, row['status'], row.get('mission_s', '-'), row['wall_s'], row.get('missed', '-')))
+        sys.stdout.flush()
+        return row
+
+    os.makedirs(args.output, exist_ok=True)
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        rows = list(pool.map(lambda run: work(*run), runs))
+
+    report = os.path.join(args.output, 'report.csv')
+    with open(report, 'w') as f:
+        writer = csv.DictWriter(f, fieldnames=FIELDS)
+        writer.writeheader()
+        writer.writerows(rows)
+    complete = sum(1 for row in rows if row['status'] == 'complete')
+    print('%d of %d runs completed the tour, report in %s' % (complete, len(rows), report))
+    print('Every world was toured on %s' % os.path.basename(args.map_file))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,245 @@
+#include "clearancemap.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    //! Stands in for infinity in the squared transform, large enough to never win and small enough to not overflow
+    const float FAR = 1e20f;
+    //! Steps of the stored clearance up to the cap
+    const float STEPS = 65535.0f;
+}
+
+ClearanceMap::ClearanceMap(double maxDistance):
+    maxDistance_(maxDistance), quantum_(static_cast<float>(maxDistance) / STEPS), width_(0), height_(0), resolution_(0.0), originX_(0.0), originY_(0.0)
+{
+}
+
+bool ClearanceMap::update(const nav_msgs::OccupancyGrid& map)
+{
+    const int width = map.info.width;
+    const int height = map.info.height;
+    if (width <= 0 || height <= 0 || map.data.size() < static_cast<size_t>(width) * height) return false;
+
+    bool sameGeometry = !empty() && width == width_ && height == height_ &&
+                        map.info.resolution == resolution_ &&
+                        map.info.origin.position.x == originX_ && map.info.origin.position.y == originY_;
+
+    if (!sameGeometry) {
+        width_ = width;
+        height_ = height;
+        resolution_ = map.info.resolution;
+        originX_ = map.info.origin.position.x;
+        originY_ = map.info.origin.position.y;
+        distance_.reset(width, height);
+        transform(map, 0, 0, width - 1, height - 1, 0, 0, width - 1, height - 1);
+        return true;
+    }
+
+    return updateRegion(map, MapRegion{0, 0, width - 1, height - 1});
+}
+
+bool ClearanceMap::update(const nav_msgs::OccupancyGrid& map, const MapRegion& region)
+{
+    // Without the same geometry every cell is recomputed anyway
+    if (empty() || static_cast<int>(map.info.width) != width_ || static_cast<int>(map.info.height) != height_ ||
+        map.info.resolution != resolution_ || map.info.origin.position.x != originX_ ||
+        map.info.origin.position.y != originY_ || map.data.size() < static_cast<size_t>(width_) * height_) return update(map);
+    MapRegion clipped = region.grown(0, width_, height_);
+    if (clipped.empty()) return false;
+    return updateRegion(map, clipped);
+}
+
+bool ClearanceMap::updateRegion(const nav_msgs::OccupancyGrid& map, const MapRegion& region)
+{
+    const int width = width_;
+    const int height = height_;
+
+    // Finds the bounding box of the cells that changed between free and not free
+    int minX = width, minY = height, maxX = -1, maxY = -1;
+    for (int y = region.y0; y <= region.y1; y++) {
+        const size_t row = static_cast<size_t>(y) * width;
+        for (int x = region.x0; x <= region.x1; x++) {
+            if ((map.data[row + x] != 0) == (at(x, y) == 0.0f)) continue;
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+        }
+    }
+    if (maxX < 0) return false;
+
+    // Only cells within the cap of a change can change, and their nearest obstacle within the cap
+    // lies within twice the cap, so that is the region the transform has to see
+    const int cap = static_cast<int>(std::ceil(maxDistance_ / resolution_)) + 1;
+    int wx0 = std::max(0, minX - cap), wy0 = std::max(0, minY - cap);
+    int wx1 = std::min(width - 1, maxX + cap), wy1 = std::min(height - 1, maxY + cap);
+    int x0 = std::max(0, minX - 2 * cap), y0 = std::max(0, minY - 2 * cap);
+    int x1 = std::min(width - 1, maxX + 2 * cap), y1 = std::min(height - 1, maxY + 2 * cap);
+    transform(map, x0, y0, x1, y1, wx0, wy0, wx1, wy1);
+    return true;
+}
+
+void ClearanceMap::transform(const nav_msgs::OccupancyGrid& map, int x0, int y0, int x1, int y1,
+                             int wx0, int wy0, int wx1, int wy1)
+{
+    const int w = x1 - x0 + 1;
+    const int h = y1 - y0 + 1;
+    const int n = std::max(w, h);
+    // Only live for the transform, so a copy of the clearance holds no scratch of its own
+    std::vector<float> squared(static_cast<size_t>(w) * h);
+    std::vector<float> f(n), d(n), z(n + 1);
+    std::vector<int> v(n);
+
+    // Columns first, seeded with 0 on obstacles
+    for (int x = 0; x < w; x++) {
+        for (int y = 0; y < h; y++) {
+            f[y] = map.data[static_cast<size_t>(y + y0) * width_ + x + x0] != 0 ? 0.0f : FAR;
+        }
+        transform1D(f.data(), d.data(), h, v.data(), z.data());
+        for (int y = 0; y < h; y++) squared[static_cast<size_t>(y) * w + x] = d[y];
+    }
+
+    // Then rows, over the column distances
+    for (int y = 0; y < h; y++) {
+        float* row = &squared[static_cast<size_t>(y) * w];
+        transform1D(row, d.data(), w, v.data(), z.data());
+        std::copy(d.begin(), d.begin() + w, row);
+    }
+
+    // Written a tile at a time, so only the tiles under the window are cloned from other copies.
+    // Rounded down to whole steps, free cells are kept at least one step so they stay apart from obstacles
+    const float steps = static_cast<float>(resolution_) / quantum_;
+    for (int ty = wy0 >> tiles::SHIFT; ty <= wy1 >> tiles::SHIFT; ty++) {
+        for (int tx = wx0 >> tiles::SHIFT; tx <= wx1 >> tiles::SHIFT; tx++) {
+            Tile& tile = distance_.writable(tx, ty);
+            const int ty0 = std::max(wy0, ty << tiles::SHIFT), ty1 = std::min(wy1, (ty << tiles::SHIFT) + tiles::MASK);
+            const int tx0 = std::max(wx0, tx << tiles::SHIFT), tx1 = std::min(wx1, (tx << tiles::SHIFT) + tiles::MASK);
+            for (int y = ty0; y <= ty1; y++) {
+                for (int x = tx0; x <= tx1; x++) {
+                    const float dist = squared[static_cast<size_t>(y - y0) * w + x - x0];
+                    const float step = dist > 0.0f ? std::max(1.0f, std::min(std::floor(std::sqrt(dist) * steps), STEPS)) : 0.0f;
+                    tile[((y & tiles::MASK) << tiles::SHIFT) | (x & tiles::MASK)] = static_cast<uint16_t>(step);
+                }
+            }
+        }
+    }
+}
+
+void ClearanceMap::transform1D(const float* f, float* d, int n, int* v, float* z)
+{
+    // Lower envelope of the parabolas rooted at each sample
+    int k = 0;
+    v[0] = 0;
+    z[0] = -FAR;
+    z[1] = FAR;
+    for (int q = 1; q < n; q++) {
+        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * (q - v[k]));
+        while (s <= z[k]) {
+            k--;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * (q - v[k]));
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = FAR;
+    }
+
+    k = 0;
+    for (int q = 0; q < n; q++) {
+        while (z[k + 1] < q) k++;
+        float dq = static_cast<float>(q - v[k]);
+        d[q] = dq * dq + f[v[k]];
+    }
+}
+
+float ClearanceMap::at(int x, int y) const
+{
+    return distance_.tileOf(x, y)[((y & tiles::MASK) << tiles::SHIFT) | (x & tiles::MASK)] * quantum_;
+}
+
+double ClearanceMap::clearance(double x, double y) const
+{
+    if (empty()) return 0.0;
+    int cx = static_cast<int>(std::floor((x - originX_) / resolution_));
+    int cy = static_cast<int>(std::floor((y - originY_) / resolution_));
+    if (cx < 0 || cy < 0 || cx >= width_ || cy >= height_) return 0.0;
+    return at(cx, cy);
+}
+
+double ClearanceMap::clearanceAt(uint32_t idx) const
+{
+    if (empty() || idx >= static_cast<uint32_t>(width_) * height_) return 0.0;
+    return at(idx % width_, idx / width_);
+}
+
+void ClearanceMap::clearances(const double* x, const double* y, size_t n, float* out) const
+{
+    if (empty()) {
+        std::fill(out, out + n, 0.0f);
+        return;
+    }
+    // Branch free so the cell arithmetic vectorises, positions outside the map read cell 0 and are masked out
+    const double scale = 1.0 / resolution_;
+    const int tilesX = distance_.tilesX();
+    const float quantum = quantum_;
+    #pragma omp simd
+    for (size_t i = 0; i < n; i++) {
+        const int cx = static_cast<int>(std::floor((x[i] - originX_) * scale));
+        const int cy = static_cast<int>(std::floor((y[i] - originY_) * scale));
+        const bool inside = cx >= 0 && cy >= 0 && cx < width_ && cy < height_;
+        const size_t tile = inside ? static_cast<size_t>(cy >> tiles::SHIFT) * tilesX + (cx >> tiles::SHIFT) : 0;
+        const int cell = inside ? ((cy & tiles::MASK) << tiles::SHIFT) | (cx & tiles::MASK) : 0;
+        out[i] = inside ? distance_[tile][cell] * quantum : 0.0f;
+    }
+}
+
+bool ClearanceMap::isClear(double x, double y, double threshold) const
+{
+    return clearance(x, y) >= threshold;
+}
+
+bool ClearanceMap::empty() const
+{
+    return distance_.empty();
+}
+
+double ClearanceMap::maxDistance() const
+{
+    return maxDistance_;
+}
+
+double ClearanceMap::quantum() const
+{
+    return quantum_;
+}
+
+size_t ClearanceMap::bytes() const
+{
+    return distance_.size() * sizeof(Tile);
+}
+
+int ClearanceMap::width() const
+{
+    return width_;
+}
+
+int ClearanceMap::height() const
+{
+    return height_;
+}
+
+double ClearanceMap::resolution() const
+{
+    return resolution_;
+}
+
+double ClearanceMap::originX() const
+{
+    return originX_;
+}
+
+double ClearanceMap::originY() const
+{
+    return originY_;
+}
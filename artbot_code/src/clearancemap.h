@@ -0,0 +1,121 @@
+#ifndef CLEARANCEMAP_H
+#define CLEARANCEMAP_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "nav_msgs/OccupancyGrid.h"
+#include "cowtiles.h"
+#include "mapregion.h"
+
+/*!
+ *  \brief     Clearance Map Class
+ *  \details
+ *  Holds the Euclidean distance from every cell of an occupancy grid to the nearest cell which is not known free,
+ *  computed with the exact two pass distance transform of Felzenszwalb and Huttenlocher.
+ *  Distances are capped at a maximum, so when a new map only differs in a region the transform
+ *  is recomputed over that region grown by twice the cap rather than over the whole grid.
+ *  Any "is this point at least d from an obstacle" query is then a single lookup.
+ *  The distances are held in copy on write tiles, so a copy brought up to date with a patched map only owns
+ *  the tiles the patch changed. Each distance is stored in 16 bits as a whole number of steps of the cap over
+ *  65535, rounded down so a clearance is never overstated, which halves the memory of a float per cell.
+ *  Only obstacles are 0 from an obstacle, every free cell is at least one step, so no separate copy of them is kept.
+ *  @sa PathPlanning
+ *  \version   1.00
+ */
+class ClearanceMap
+{
+public:
+  /// @brief Constructor for an empty clearance map
+  /// @param [in] maxDistance - distances are capped at this [m]
+  ClearanceMap(double maxDistance = 2.0);
+
+  /// @brief Brings the clearance up to date with a map
+  ///
+  /// If the map has the same geometry as the last one, only the region around the changed cells is recomputed.
+  /// @param [in] map - the occupancy grid
+  /// @return true if any clearance changed
+  bool update(const nav_msgs::OccupancyGrid& map);
+
+  /// @brief Brings the clearance up to date with a map which only differs from the last one inside a region
+  ///
+  /// Only the cells of the region are compared, so a patch costs its own size rather than the whole grid.
+  /// A map of another geometry is recomputed in full.
+  /// @param [in] map - the occupancy grid
+  /// @param [in] region - the cells which may have changed
+  /// @return true if any clearance changed
+  bool update(const nav_msgs::OccupancyGrid& map, const MapRegion& region);
+
+  /// @brief Getter for the clearance at a world position
+  /// @param [in] x - world x [m]
+  /// @param [in] y - world y [m]
+  /// @return the distance to the nearest obstacle [m], 0 outside the map
+  double clearance(double x, double y) const;
+
+  /// @brief Getter for the clearance of a cell
+  /// @param [in] idx - linear index of the cell
+  /// @return the distance to the nearest obstacle [m], 0 outside the map
+  double clearanceAt(uint32_t idx) const;
+
+  /// @brief Looks up the clearance of many world positions in one pass
+  /// @param [in] x - world x of each position [m]
+  /// @param [in] y - world y of each position [m]
+  /// @param [in] n - number of positions
+  /// @param [out] out - the clearance of each position, 0 outside the map [m]
+  void clearances(const double* x, const double* y, size_t n, float* out) const;
+
+  /// @brief Checks if a world position is at least a distance from every obstacle
+  /// @param [in] x - world x [m]
+  /// @param [in] y - world y [m]
+  /// @param [in] threshold - the required clearance [m]
+  bool isClear(double x, double y, double threshold) const;
+
+  /// @brief Checks if the map has been built
+  bool empty() const;
+
+  /// @brief Getter for the distance cap [m]
+  double maxDistance() const;
+
+  /// @brief Getter for the most a stored clearance is below the exact distance [m]
+  double quantum() const;
+
+  /// @brief Getter for the memory held by the tiles [bytes]
+  size_t bytes() const;
+
+  int width() const;
+  int height() const;
+  double resolution() const;
+  double originX() const;
+  double originY() const;
+
+private:
+  //! Clearance of a tile of cells, row major [quantum]
+  typedef std::array<uint16_t, tiles::CELLS> Tile;
+
+  /// @brief Getter for the clearance of a cell inside the map [m]
+  float at(int x, int y) const;
+
+  /// @brief Compares the cells of a region with the last map and recomputes the clearance around those which changed
+  bool updateRegion(const nav_msgs::OccupancyGrid& map, const MapRegion& region);
+
+  /// @brief Recomputes the clearance over a rectangle of cells of a map and writes back an inner rectangle
+  void transform(const nav_msgs::OccupancyGrid& map, int x0, int y0, int x1, int y1, int wx0, int wy0, int wx1, int wy1);
+
+  /// @brief One dimensional squared distance transform of f into d, with v and z as the envelope scratch
+  static void transform1D(const float* f, float* d, int n, int* v, float* z);
+
+  //! Distances are capped at this [m]
+  double maxDistance_;
+  //! Distance of one step of the stored clearance [m]
+  float quantum_;
+  int width_;
+  int height_;
+  double resolution_;
+  double originX_;
+  double originY_;
+  //! Clearance of every cell, 0 exactly on the cells which are not known free [quantum]
+  CowTiles<Tile> distance_;
+};
+
+#endif // CLEARANCEMAP_H
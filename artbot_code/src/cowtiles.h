@@ -0,0 +1,101 @@
+#ifndef COWTILES_H
+#define COWTILES_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/// @brief Size of the tiles grids are split into
+namespace tiles
+{
+  //! Cells along each side of a tile
+  constexpr int SIZE = 64;
+  //! Shift from a cell coordinate to its tile coordinate
+  constexpr int SHIFT = 6;
+  //! Mask from a cell coordinate to its coordinate in the tile
+  constexpr int MASK = SIZE - 1;
+  //! Cells in a tile
+  constexpr int CELLS = SIZE * SIZE;
+}
+
+/*!
+ *  \brief     Copy On Write Tiles Class
+ *  \details
+ *  Per cell data of a grid split into square tiles of tiles::SIZE cells a side, each held by shared pointer.
+ *  Copying the tiles only copies the pointers, and a tile held by more than one copy is cloned the first time
+ *  it is written, so a copy which is then patched in a region only owns the tiles over the region.
+ *  A tile is only written by the one copy holding it, so tiles read by other copies on other threads never change.
+ *  @sa ClearanceMap MapPyramid FreeSpaceIndex
+ *  \version   1.00
+ */
+template <class Tile>
+class CowTiles
+{
+public:
+  /// @brief Replaces every tile with a new one for a grid of a size
+  /// @param [in] width - width of the grid [cells]
+  /// @param [in] height - height of the grid [cells]
+  /// @param [in] value - every tile starts as a copy of this
+  void reset(int width, int height, const Tile& value = Tile())
+  {
+    tilesX_ = width > 0 ? ((width - 1) >> tiles::SHIFT) + 1 : 0;
+    tilesY_ = height > 0 ? ((height - 1) >> tiles::SHIFT) + 1 : 0;
+    tiles_.clear();
+    tiles_.reserve(static_cast<size_t>(tilesX_) * tilesY_);
+    for (int i = 0; i < tilesX_ * tilesY_; i++) tiles_.push_back(std::make_shared<Tile>(value));
+  }
+
+  /// @brief Getter for a tile by its tile coordinates
+  const Tile& tile(int tx, int ty) const
+  {
+    return *tiles_[static_cast<size_t>(ty) * tilesX_ + tx];
+  }
+
+  /// @brief Getter for a tile by its row major index
+  const Tile& operator[](size_t i) const
+  {
+    return *tiles_[i];
+  }
+
+  /// @brief Getter for the tile holding a cell
+  const Tile& tileOf(int x, int y) const
+  {
+    return tile(x >> tiles::SHIFT, y >> tiles::SHIFT);
+  }
+
+  /// @brief Getter for a tile to be written, cloned first if another copy holds it
+  Tile& writable(int tx, int ty)
+  {
+    std::shared_ptr<Tile>& held = tiles_[static_cast<size_t>(ty) * tilesX_ + tx];
+    if (held.use_count() > 1) held = std::make_shared<Tile>(*held);
+    return *held;
+  }
+
+  /// @brief Getter for the number of tiles no other copy holds
+  size_t owned() const
+  {
+    size_t count = 0;
+    for (const auto& held : tiles_) count += held.use_count() == 1;
+    return count;
+  }
+
+  /// @brief Getter for the tiles across the grid
+  int tilesX() const { return tilesX_; }
+
+  /// @brief Getter for the tiles down the grid
+  int tilesY() const { return tilesY_; }
+
+  /// @brief Getter for the number of tiles
+  size_t size() const { return tiles_.size(); }
+
+  /// @brief Checks if there are no tiles
+  bool empty() const { return tiles_.empty(); }
+
+private:
+  int tilesX_ = 0;
+  int tilesY_ = 0;
+  //! Row major, a tile may be shared with other copies
+  std::vector<std::shared_ptr<Tile> > tiles_;
+};
+
+#endif // COWTILES_H
@@ -0,0 +1,161 @@
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include "ros/ros.h"
+#include "geometry_msgs/PoseWithCovarianceStamped.h"
+#include "nav_msgs/OccupancyGrid.h"
+#include "nav_msgs/Path.h"
+#include "fleetplanner.h"
+#include "pathplanning.h"
+
+namespace artbot_code
+{
+/*!
+ *  \brief     Fleet Nodelet Class
+ *  \details
+ *  Plans the tour of a fleet of robots centrally. Once /map and the amcl_pose of every robot have arrived, the
+ *  exhibits are split across the robots by a FleetPlanner and each robot's tour is published, latched, on its
+ *  thepath for a Sample following /thepath in that robot's namespace. The tour is stamped with the time the robot
+ *  may set off, which keeps it out of the way of the robots ahead of it. A new map before the first robot sets off
+ *  plans the fleet again, a later one is left to each robot, which replans its own legs on it.
+ *  Loaded into the manager of the robots' Sample nodelets, the map, its clearance and its free space index are
+ *  built once for the planner and every robot.
+ *  Reads the private parameters ~robots (the namespace of each robot), ~exhibits (a flat list x0, y0, x1, y1, ...),
+ *  ~threshold_distance (default 0.15 m, must match the robots), ~speed (default 0.26 m/s, the speed tours are timed
+ *  at) and ~start_delay (default 2.0 s, from the plan to when the first robots set off).
+ *  @sa FleetPlanner Sample
+ *  \version   1.00
+ */
+class FleetNodelet : public nodelet::Nodelet
+{
+private:
+  /// @brief Reads the parameters and subscribes to the map and every robot's pose, called once the nodelet is loaded
+  void onInit() override
+  {
+      ros::NodeHandle& nh = getNodeHandle();
+      ros::NodeHandle& pnh = getPrivateNodeHandle();
+      std::vector<double> flat;
+      double speed;
+      pnh.param("robots", robots_, std::vector<std::string>());
+      pnh.param("exhibits", flat, std::vector<double>());
+      pnh.param("threshold_distance", threshold_, 0.15);
+      pnh.param("speed", speed, 0.26);
+      pnh.param("start_delay", startDelay_, 2.0);
+      if (robots_.empty() || flat.size() < 2 || flat.size() % 2 != 0) {
+          NODELET_ERROR("~robots and at least one of ~exhibits as an x, y pair are required");
+          return;
+      }
+      for (size_t i = 0; i + 1 < flat.size(); i += 2) {
+          geometry_msgs::Point exhibit;
+          exhibit.x = flat[i];
+          exhibit.y = flat[i + 1];
+          exhibits_.push_back(exhibit);
+      }
+      planner_ = std::make_shared<FleetPlanner>(threshold_, speed);
+
+      poses_.resize(robots_.size());
+      posed_.assign(robots_.size(), false);
+      for (size_t i = 0; i < robots_.size(); i++) {
+          boost::function<void(const geometry_msgs::PoseWithCovarianceStampedConstPtr&)> callback =
+              [this, i](const geometry_msgs::PoseWithCovarianceStampedConstPtr& msg) { poseCallback(msg, i); };
+          poseSubs_.push_back(nh.subscribe<geometry_msgs::PoseWithCovarianceStamped>(robots_[i] + "/amcl_pose", 1, callback));
+          pathPubs_.push_back(nh.advertise<nav_msgs::Path>(robots_[i] + "/thepath", 1, true));
+      }
+      mapSub_ = nh.subscribe("/map", 1, &FleetNodelet::mapCallback, this);
+  }
+
+  /// @brief Keeps a robot's pose, the fleet is planned once every robot has one
+  void poseCallback(const geometry_msgs::PoseWithCovarianceStampedConstPtr& msg, size_t robot)
+  {
+      std::unique_lock<std::mutex> lck(mtx_);
+      poses_[robot].x = msg->pose.pose.position.x;
+      poses_[robot].y = msg->pose.pose.position.y;
+      posed_[robot] = true;
+      if (!planned_) plan();
+  }
+
+  /// @brief Keeps the map and plans the fleet on it
+  void mapCallback(const nav_msgs::OccupancyGrid::ConstPtr& msg)
+  {
+      std::unique_lock<std::mutex> lck(mtx_);
+      map_ = msg;
+      // New tours and set-off stamps once the robots are driving would send them back to the start
+      if (planned_ && ros::Time::now() >= setOff_) {
+          NODELET_INFO("New map after the fleet set off, each robot replans on it");
+          return;
+      }
+      plan();
+  }
+
+  /// @brief Splits the exhibits across the robots and publishes every tour, once the map and every pose are in
+  void plan()
+  {
+      if (!map_ || std::find(posed_.begin(), posed_.end(), false) != posed_.end()) return;
+      auto begin = std::chrono::steady_clock::now();
+      // The same products the robots' path planning takes, held so a robot in this manager builds none of its own
+      if (!pathPlanning_ || pathPlanning_->sharedMap()->map() != map_)
+          pathPlanning_ = std::make_shared<PathPlanning>(map_, threshold_, 0.0, 0.0, 1);
+      if (!planner_->plan(pathPlanning_->sharedMap(), poses_, exhibits_)) {
+          NODELET_WARN("No robot can reach any exhibit, no tour is published");
+          return;
+      }
+      double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+      setOff_ = ros::Time::now() + ros::Duration(startDelay_);
+      size_t toured = 0;
+      for (size_t i = 0; i < robots_.size(); i++) {
+          // Published as a shared pointer, so a Sample in this manager gets the tour without serialising it
+          nav_msgs::PathPtr path = boost::make_shared<nav_msgs::Path>();
+          path->header.frame_id = "map";
+          path->header.stamp = setOff_ + ros::Duration(planner_->delays()[i]);
+          path->poses.reserve(planner_->waypoints()[i].size());
+          for (const auto& point : planner_->waypoints()[i]) {
+              geometry_msgs::PoseStamped pose;
+              pose.header = path->header;
+              pose.pose.position = point;
+              pose.pose.orientation.w = 1.0;
+              path->poses.push_back(pose);
+          }
+          pathPubs_[i].publish(nav_msgs::PathConstPtr(path));
+          toured += planner_->orders()[i].size();
+          NODELET_INFO("%s tours %zu exhibits, setting off after %.1f s", robots_[i].c_str(),
+                       planner_->orders()[i].size(), planner_->delays()[i]);
+      }
+      NODELET_INFO("Fleet of %zu robots tours %zu of %zu exhibits in %.1f s, planned in %.2f ms, %u conflicts left",
+                   robots_.size(), toured, exhibits_.size(), planner_->makespan(), elapsed, planner_->unresolved());
+      planned_ = true;
+  }
+
+  //! Namespace of each robot
+  std::vector<std::string> robots_;
+  //! Exhibits toured by the fleet [m]
+  std::vector<geometry_msgs::Point> exhibits_;
+  //! Paths keep at least this clearance [m]
+  double threshold_ = 0.15;
+  //! Time from a plan to when the first robots set off [s]
+  double startDelay_ = 2.0;
+  //! The planner, kept so its buffers are reused
+  std::shared_ptr<FleetPlanner> planner_;
+  //! Holds the shared products of map_
+  std::shared_ptr<PathPlanning> pathPlanning_;
+  //! Guards the map, the poses and the planner between callbacks
+  std::mutex mtx_;
+  nav_msgs::OccupancyGrid::ConstPtr map_;
+  //! Latest pose of each robot [m]
+  std::vector<geometry_msgs::Point> poses_;
+  //! Set once a robot's pose has arrived
+  std::vector<bool> posed_;
+  //! Set once the fleet has been planned, later poses do not plan it again
+  bool planned_ = false;
+  //! When the first robots set off, a map after it is not planned for the fleet
+  ros::Time setOff_;
+  ros::Subscriber mapSub_;
+  std::vector<ros::Subscriber> poseSubs_;
+  std::vector<ros::Publisher> pathPubs_;
+};
+} // namespace artbot_code
+
+PLUGINLIB_EXPORT_CLASS(artbot_code::FleetNodelet, nodelet::Nodelet)
@@ -0,0 +1,285 @@
+#include "fleetplanner.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include "tourplanner.h"
+
+namespace {
+    const double INF = std::numeric_limits<double>::infinity();
+    const double EPS = 1e-9;
+
+    double longest(const std::vector<double>& lengths)
+    {
+        return lengths.empty() ? 0.0 : *std::max_element(lengths.begin(), lengths.end());
+    }
+}
+
+FleetPlanner::FleetPlanner(double robotRadius, double speed, unsigned int threads):
+    robotRadius_(robotRadius), speed_(speed), threads_(threads), n_(0), makespan_(0.0), unresolved_(0)
+{
+    if (threads_ == 0) threads_ = std::max(1u, std::thread::hardware_concurrency());
+}
+
+bool FleetPlanner::plan(const std::shared_ptr<const SharedMap>& shared, const std::vector<geometry_msgs::Point>& starts,
+                        const std::vector<geometry_msgs::Point>& goals)
+{
+    const unsigned int robots = starts.size();
+    orders_.assign(robots, std::vector<unsigned int>());
+    waypoints_.assign(robots, std::vector<geometry_msgs::Point>());
+    delays_.assign(robots, 0.0);
+    makespan_ = 0.0;
+    unresolved_ = 0;
+    if (robots == 0 || goals.empty()) return false;
+
+    nodes_ = starts;
+    nodes_.insert(nodes_.end(), goals.begin(), goals.end());
+    n_ = nodes_.size();
+    cost_.assign(static_cast<size_t>(n_) * n_, INF);
+    legs_.assign(cost_.size(), std::vector<geometry_msgs::Point>());
+    for (unsigned int i = 0; i < n_; i++) cost_[i * n_ + i] = 0.0;
+
+    // Robots never drive to each other's start, so only the legs from a start to a goal and between goals are planned
+    std::vector<std::pair<unsigned int, unsigned int> > pairs;
+    for (unsigned int i = 0; i < n_; i++) {
+        for (unsigned int j = std::max(i + 1, robots); j < n_; j++) pairs.push_back(std::make_pair(i, j));
+    }
+
+    unsigned int threads = std::min<unsigned int>(threads_, std::max<size_t>(1, pairs.size()));
+    while (planners_.size() < threads) planners_.push_back(GridPlanner(robotRadius_));
+    std::atomic<size_t> next(0);
+    auto worker = [&](unsigned int t) {
+        GridPlanner& planner = planners_[t];
+        planner.setMap(shared->clearanceMap(), shared->pyramid());
+        for (size_t k = next++; k < pairs.size(); k = next++) {
+            unsigned int i = pairs[k].first, j = pairs[k].second;
+            if (!planner.plan(nodes_[i], nodes_[j], legs_[i * n_ + j])) continue;
+            cost_[i * n_ + j] = planner.pathLength();
+            cost_[j * n_ + i] = planner.pathLength();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned int t = 1; t < threads; t++) pool.push_back(std::thread(worker, t));
+    worker(0);
+    for (auto& thread : pool) thread.join();
+
+    // Goals farthest from every robot are handed out first, so they anchor the tours the nearer goals join
+    std::vector<unsigned int> pending;
+    std::vector<double> nearest(n_, INF);
+    for (unsigned int g = robots; g < n_; g++) {
+        for (unsigned int r = 0; r < robots; r++) nearest[g] = std::min(nearest[g], cost_[r * n_ + g]);
+        if (nearest[g] < INF) pending.push_back(g);
+    }
+    if (pending.empty()) return false;
+    std::sort(pending.begin(), pending.end(), [&](unsigned int a, unsigned int b) { return nearest[a] > nearest[b]; });
+
+    std::vector<std::vector<unsigned int> > sets(robots);
+    std::vector<double> lengths(robots, 0.0);
+    for (unsigned int g : pending) {
+        unsigned int best = robots;
+        double bestLongest = INF, bestGrowth = INF, bestLength = INF;
+        for (unsigned int r = 0; r < robots; r++) {
+            if (cost_[r * n_ + g] == INF) continue;
+            std::vector<unsigned int> trial = sets[r];
+            trial.push_back(g);
+            double length;
+            orderTour(r, trial, length);
+            if (length == INF) continue;
+            std::vector<double> after = lengths;
+            after[r] = length;
+            double fleet = longest(after);
+            double growth = length - lengths[r];
+            if (fleet + EPS < bestLongest || (fleet < bestLongest + EPS && growth < bestGrowth)) {
+                best = r;
+                bestLongest = fleet;
+                bestGrowth = growth;
+                bestLength = length;
+            }
+        }
+        if (best == robots) continue;
+        sets[best].push_back(g);
+        lengths[best] = bestLength;
+    }
+
+    // Goals are moved off the longest tour while that shortens it, each move strictly shortens it so this ends
+    bool improved = true;
+    while (improved) {
+        improved = false;
+        unsigned int worst = std::max_element(lengths.begin(), lengths.end()) - lengths.begin();
+        const double current = lengths[worst];
+        for (size_t k = 0; k < sets[worst].size() && !improved; k++) {
+            std::vector<unsigned int> remaining = sets[worst];
+            unsigned int g = remaining[k];
+            remaining.erase(remaining.begin() + k);
+            double shortened;
+            orderTour(worst, remaining, shortened);
+            for (unsigned int r = 0; r < robots && !improved; r++) {
+                if (r == worst || cost_[r * n_ + g] == INF) continue;
+                std::vector<unsigned int> grown = sets[r];
+                grown.push_back(g);
+                double length;
+                orderTour(r, grown, length);
+                std::vector<double> after = lengths;
+                after[worst] = shortened;
+                after[r] = length;
+                if (longest(after) + EPS >= current) continue;
+                sets[worst] = remaining;
+                sets[r] = grown;
+                lengths = after;
+                improved = true;
+            }
+        }
+    }
+
+    for (unsigned int r = 0; r < robots; r++) {
+        double length;
+        std::vector<unsigned int> tour = orderTour(r, sets[r], length);
+        unsigned int prev = r;
+        for (unsigned int node : tour) {
+            orders_[r].push_back(node - robots);
+            appendLeg(prev, node, waypoints_[r]);
+            prev = node;
+        }
+    }
+    reserve(starts, lengths);
+    return true;
+}
+
+std::vector<unsigned int> FleetPlanner::orderTour(unsigned int robot, const std::vector<unsigned int>& goals, double& length) const
+{
+    // The robot is node 0 of the sub matrix, its goals follow
+    const unsigned int m = goals.size() + 1;
+    std::vector<unsigned int> local(1, robot);
+    local.insert(local.end(), goals.begin(), goals.end());
+    std::vector<double> sub(static_cast<size_t>(m) * m);
+    for (unsigned int i = 0; i < m; i++) {
+        for (unsigned int j = 0; j < m; j++) sub[i * m + j] = cost_[static_cast<size_t>(local[i]) * n_ + local[j]];
+    }
+    std::vector<unsigned int> visit(m - 1);
+    std::iota(visit.begin(), visit.end(), 1);
+    std::vector<unsigned int> tour = TourPlanner::orderTour(sub, m, visit);
+    length = TourPlanner::tourLength(sub, m, tour);
+    for (unsigned int& node : tour) node = local[node];
+    return tour;
+}
+
+void FleetPlanner::appendLeg(unsigned int from, unsigned int to, std::vector<geometry_msgs::Point>& out) const
+{
+    if (from < to) {
+        const std::vector<geometry_msgs::Point>& leg = legs_[from * n_ + to];
+        out.insert(out.end(), leg.begin(), leg.end());
+    }
+    else {
+        // The leg was planned the other way, so it is walked backwards, ending at this node
+        const std::vector<geometry_msgs::Point>& leg = legs_[to * n_ + from];
+        if (leg.size() > 1) out.insert(out.end(), leg.rbegin() + 1, leg.rend());
+        out.push_back(nodes_[to]);
+    }
+}
+
+int64_t FleetPlanner::cellOf(double x, double y) const
+{
+    int64_t cx = static_cast<int64_t>(std::floor(x / RESERVATION_CELL_));
+    int64_t cy = static_cast<int64_t>(std::floor(y / RESERVATION_CELL_));
+    return (cx << 32) ^ (cy & 0xFFFFFFFFLL);
+}
+
+std::vector<FleetPlanner::Visit> FleetPlanner::timeVisits(const geometry_msgs::Point& start,
+                                                           const std::vector<geometry_msgs::Point>& path) const
+{
+    // Sampled at half a cell, so no cell on the way is stepped over
+    std::vector<Visit> visits;
+    const double step = 0.5 * RESERVATION_CELL_;
+    auto mark = [&](double x, double y, double t) {
+        int64_t cell = cellOf(x, y);
+        if (!visits.empty() && visits.back().cell == cell) visits.back().exit = t;
+        else visits.push_back({cell, t, t});
+    };
+    double t = 0.0;
+    geometry_msgs::Point prev = start;
+    mark(prev.x, prev.y, t);
+    for (const auto& point : path) {
+        double length = std::hypot(point.x - prev.x, point.y - prev.y);
+        unsigned int samples = std::max(1u, static_cast<unsigned int>(std::ceil(length / step)));
+        for (unsigned int s = 1; s <= samples; s++) {
+            double f = static_cast<double>(s) / samples;
+            mark(prev.x + f * (point.x - prev.x), prev.y + f * (point.y - prev.y), t + f * length / speed_);
+        }
+        t += length / speed_;
+        prev = point;
+    }
+    return visits;
+}
+
+void FleetPlanner::reserve(const std::vector<geometry_msgs::Point>& starts, const std::vector<double>& lengths)
+{
+    const unsigned int robots = starts.size();
+    std::vector<unsigned int> priority(robots);
+    std::iota(priority.begin(), priority.end(), 0);
+    std::stable_sort(priority.begin(), priority.end(), [&](unsigned int a, unsigned int b) { return lengths[a] > lengths[b]; });
+
+    std::unordered_map<int64_t, std::vector<Window> > table;
+    for (unsigned int r : priority) {
+        std::vector<Visit> visits = timeVisits(starts[r], waypoints_[r]);
+        double delay = 0.0;
+        for (unsigned int tries = 0; ; tries++) {
+            // The robot waits at its start before setting off, so it holds the first cell from 0
+            double later = delay;
+            for (size_t v = 1; v < visits.size() && later == delay; v++) {
+                const double enter = visits[v].enter + delay, exit = visits[v].exit + delay;
+                const int64_t cx = visits[v].cell >> 32, cy = static_cast<int32_t>(visits[v].cell & 0xFFFFFFFFLL);
+                for (int64_t dx = -1; dx <= 1; dx++) {
+                    for (int64_t dy = -1; dy <= 1; dy++) {
+                        auto held = table.find(((cx + dx) << 32) ^ ((cy + dy) & 0xFFFFFFFFLL));
+                        if (held == table.end()) continue;
+                        for (const Window& w : held->second) {
+                            if (enter < w.exit + RESERVATION_MARGIN_ && w.enter < exit + RESERVATION_MARGIN_) {
+                                later = std::max(later, w.exit + RESERVATION_MARGIN_ - visits[v].enter);
+                            }
+                        }
+                    }
+                }
+            }
+            if (later == delay) break;
+            if (tries + 1 >= MAX_RESERVATION_TRIES_) {
+                unresolved_++;
+                break;
+            }
+            delay = later;
+        }
+
+        delays_[r] = delay;
+        for (size_t v = 0; v < visits.size(); v++) {
+            table[visits[v].cell].push_back({v == 0 ? 0.0 : visits[v].enter + delay, visits[v].exit + delay});
+        }
+        makespan_ = std::max(makespan_, delay + (visits.empty() ? 0.0 : visits.back().exit));
+    }
+}
+
+const std::vector<std::vector<unsigned int> >& FleetPlanner::orders() const
+{
+    return orders_;
+}
+
+const std::vector<std::vector<geometry_msgs::Point> >& FleetPlanner::waypoints() const
+{
+    return waypoints_;
+}
+
+const std::vector<double>& FleetPlanner::delays() const
+{
+    return delays_;
+}
+
+double FleetPlanner::makespan() const
+{
+    return makespan_;
+}
+
+unsigned int FleetPlanner::unresolved() const
+{
+    return unresolved_;
+}
@@ -0,0 +1,133 @@
+#ifndef FLEETPLANNER_H
+#define FLEETPLANNER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <geometry_msgs/Point.h>
+#include "gridplanner.h"
+#include "sharedmap.h"
+
+/*!
+ *  \brief     Fleet Planner Class
+ *  \details
+ *  Splits a set of goals across several robots and plans a tour for each, so the last robot finishes early.
+ *  Every leg from a robot to a goal and between two goals is planned once, split across threads which each own a
+ *  GridPlanner, the same as TourPlanner. Goals are handed out farthest first to the robot whose tour grows the
+ *  longest tour least, then moved off the longest tour while that shortens it, each tour ordered by
+ *  TourPlanner::orderTour.
+ *  Paths are kept apart with time window reservations on a coarse grid: robots are timed along their tours at a
+ *  constant speed, longest tour first, and a robot which would be near a cell while another holds it sets off
+ *  later. A robot parked at its last goal holds nothing, the local planner drives the others round it.
+ *  @sa TourPlanner SharedMap
+ *  \version   1.00
+ */
+class FleetPlanner
+{
+public:
+  /// @brief Constructor for the fleet planner
+  /// @param [in] robotRadius - paths keep at least this clearance [m]
+  /// @param [in] speed - speed the tours are timed at [m/s]
+  /// @param [in] threads - number of threads planning legs, 0 uses every core
+  FleetPlanner(double robotRadius, double speed, unsigned int threads = 0);
+
+  /// @brief Plans every leg, splits the goals across the robots and sets when each robot leaves
+  ///
+  /// Goals which no robot can reach are left out.
+  /// @param [in] shared - the map and its products
+  /// @param [in] starts - where each robot starts [m]
+  /// @param [in] goals - the goals to visit [m]
+  /// @return false if no goal can be reached
+  bool plan(const std::shared_ptr<const SharedMap>& shared, const std::vector<geometry_msgs::Point>& starts,
+            const std::vector<geometry_msgs::Point>& goals);
+
+  /// @brief Getter for the goals of each robot in the last plan
+  /// @return for each robot, indices into the goals given to plan() in the order they are visited
+  const std::vector<std::vector<unsigned int> >& orders() const;
+
+  /// @brief Getter for the waypoints of each robot's tour, every leg joined in order
+  const std::vector<std::vector<geometry_msgs::Point> >& waypoints() const;
+
+  /// @brief Getter for how long each robot waits before setting off [s]
+  const std::vector<double>& delays() const;
+
+  /// @brief Getter for the time the last robot reaches its last goal, from when the fleet sets off [s]
+  double makespan() const;
+
+  /// @brief Getter for the reservation conflicts a later start could not clear in the last plan
+  unsigned int unresolved() const;
+
+private:
+  struct Visit
+  {
+    //! Reservation cell
+    int64_t cell;
+    //! Time the robot is first near the cell, from when it sets off [s]
+    double enter;
+    //! Time it is last near the cell [s]
+    double exit;
+  };
+
+  struct Window
+  {
+    //! Time a robot set off earlier is first near the cell [s]
+    double enter;
+    //! Time it is last near the cell [s]
+    double exit;
+  };
+
+  /// @brief Orders goals into a tour from a robot's start
+  /// @param [in] robot - the robot, its node is its index
+  /// @param [in] goals - nodes of the goals
+  /// @param [out] length - length of the tour, infinite if a leg has no path [m]
+  /// @return the goal nodes in tour order
+  std::vector<unsigned int> orderTour(unsigned int robot, const std::vector<unsigned int>& goals, double& length) const;
+
+  /// @brief Appends the planned leg between two nodes, walked from the first, ending at the second
+  void appendLeg(unsigned int from, unsigned int to, std::vector<geometry_msgs::Point>& out) const;
+
+  /// @brief Times the cells a path passes near at speed_
+  std::vector<Visit> timeVisits(const geometry_msgs::Point& start, const std::vector<geometry_msgs::Point>& path) const;
+
+  /// @brief Sets off each robot late enough to keep out of the cells held before it, longest tour first
+  void reserve(const std::vector<geometry_msgs::Point>& starts, const std::vector<double>& lengths);
+
+  /// @brief Reservation cell of a world position
+  int64_t cellOf(double x, double y) const;
+
+  //! Paths keep at least this clearance [m]
+  double robotRadius_;
+  //! Speed the tours are timed at [m/s]
+  double speed_;
+  //! Threads to plan legs on
+  unsigned int threads_;
+  //! One planner per thread, kept so their buffers are reused
+  std::vector<GridPlanner> planners_;
+  //! Node count of the last plan, every robot then every goal
+  unsigned int n_;
+  //! Path length of every leg, infinite if there is no path or it was not planned
+  std::vector<double> cost_;
+  //! Waypoints of the leg from the lower to the higher node of each pair
+  std::vector<std::vector<geometry_msgs::Point> > legs_;
+  //! Nodes of the last plan
+  std::vector<geometry_msgs::Point> nodes_;
+  //! Goal order of each robot
+  std::vector<std::vector<unsigned int> > orders_;
+  //! Waypoints of each robot's tour
+  std::vector<std::vector<geometry_msgs::Point> > waypoints_;
+  //! Start delay of each robot [s]
+  std::vector<double> delays_;
+  //! Time the last robot finishes [s]
+  double makespan_;
+  //! Conflicts left by the last plan
+  unsigned int unresolved_;
+
+  //! Side of a reservation cell, a robot holds the cells round the one it is in [m]
+  const double RESERVATION_CELL_ = 0.5;
+  //! Windows of two robots in neighbouring cells are kept at least this far apart [s]
+  const double RESERVATION_MARGIN_ = 2.0;
+  //! Later starts tried for each robot before its conflicts are left unresolved
+  const unsigned int MAX_RESERVATION_TRIES_ = 100;
+};
+
+#endif // FLEETPLANNER_H
@@ -0,0 +1,116 @@
+#include "freespaceindex.h"
+#include <algorithm>
+#include <cmath>
+
+FreeSpaceIndex::FreeSpaceIndex():
+    width_(0), height_(0)
+{
+}
+
+void FreeSpaceIndex::build(const nav_msgs::OccupancyGrid& map, const ClearanceMap& clearanceMap, const Bounds& bounds,
+                           unsigned int marginCells, double clearance)
+{
+    width_ = map.info.width;
+    height_ = map.info.height;
+    tiles_.reset(map.data.size() >= static_cast<size_t>(width_) * height_ ? width_ : 0, height_);
+    MapRegion box = scanBox(map, bounds, marginCells);
+    if (!box.empty()) scan(map, clearanceMap, box, clearance);
+    count();
+}
+
+void FreeSpaceIndex::update(const nav_msgs::OccupancyGrid& map, const ClearanceMap& clearanceMap, const Bounds& bounds,
+                            unsigned int marginCells, double clearance, const MapRegion& region)
+{
+    if (tiles_.empty() || static_cast<int>(map.info.width) != width_ || static_cast<int>(map.info.height) != height_) {
+        build(map, clearanceMap, bounds, marginCells, clearance);
+        return;
+    }
+
+    // Cells of the region leave the index and those still able to hold a goal are scanned back in
+    MapRegion box = scanBox(map, bounds, marginCells);
+    box = MapRegion(std::max(box.x0, region.x0), std::max(box.y0, region.y0), std::min(box.x1, region.x1), std::min(box.y1, region.y1));
+    if (box.empty()) return;
+    scan(map, clearanceMap, box, clearance);
+    count();
+}
+MapRegion FreeSpaceIndex::scanBox(const nav_msgs::OccupancyGrid& map, const Bounds& bounds, unsigned int marginCells) const
+{
+    const int width = map.info.width;
+    const int height = map.info.height;
+    const double resolution = map.info.resolution;
+    const double originX = map.info.origin.position.x;
+    const double originY = map.info.origin.position.y;
+    if (width <= 0 || height <= 0 || resolution <= 0.0 || map.data.size() < static_cast<size_t>(width) * height) return MapRegion();
+
+    // Only cells whose centre is inside both the bounds box and the margin are visited
+    const int margin = static_cast<int>(marginCells);
+    MapRegion box;
+    box.x0 = std::max(margin, static_cast<int>(std::ceil((bounds.minX - originX) / resolution - 0.5)));
+    box.x1 = std::min(width - margin - 1, static_cast<int>(std::floor((bounds.maxX - originX) / resolution - 0.5)));
+    box.y0 = std::max(margin, static_cast<int>(std::ceil((bounds.minY - originY) / resolution - 0.5)));
+    box.y1 = std::min(height - margin - 1, static_cast<int>(std::floor((bounds.maxY - originY) / resolution - 0.5)));
+    return box;
+}
+
+void FreeSpaceIndex::scan(const nav_msgs::OccupancyGrid& map, const ClearanceMap& clearanceMap, const MapRegion& box,
+                          double clearance)
+{
+    const int width = map.info.width;
+    for (int ty = box.y0 >> tiles::SHIFT; ty <= box.y1 >> tiles::SHIFT; ty++) {
+        for (int tx = box.x0 >> tiles::SHIFT; tx <= box.x1 >> tiles::SHIFT; tx++) {
+            const int x0 = std::max(box.x0, tx << tiles::SHIFT), x1 = std::min(box.x1, (tx << tiles::SHIFT) + tiles::MASK);
+            const int y0 = std::max(box.y0, ty << tiles::SHIFT), y1 = std::min(box.y1, (ty << tiles::SHIFT) + tiles::MASK);
+            Tile& tile = tiles_.writable(tx, ty);
+            // The cells of the tile inside the box are scanned again, the others keep their bits
+            for (int y = y0; y <= y1; y++) {
+                uint64_t& valid = tile.valid[y & tiles::MASK];
+                for (int x = x0; x <= x1; x++) {
+                    const uint32_t idx = x + y * width;
+                    const uint64_t bit = 1ULL << (x & tiles::MASK);
+                    if (map.data[idx] == 0 && clearanceMap.clearanceAt(idx) >= clearance) valid |= bit;
+                    else valid &= ~bit;
+                }
+            }
+            // Then the list is made again from the bits, in row order
+            tile.cells.clear();
+            for (int row = 0; row < tiles::SIZE; row++) {
+                const uint64_t valid = tile.valid[row];
+                for (int col = 0; col < tiles::SIZE && valid >> col != 0; col++) {
+                    if ((valid >> col) & 1) tile.cells.push_back(((tx << tiles::SHIFT) + col) + ((ty << tiles::SHIFT) + row) * width);
+                }
+            }
+        }
+    }
+}
+
+void FreeSpaceIndex::count()
+{
+    offsets_.assign(tiles_.size() + 1, 0);
+    for (size_t i = 0; i < tiles_.size(); i++) offsets_[i + 1] = offsets_[i] + tiles_[i].cells.size();
+}
+
+bool FreeSpaceIndex::contains(uint32_t idx) const
+{
+    if (tiles_.empty() || idx >= static_cast<uint32_t>(width_) * height_) return false;
+    const int x = idx % width_, y = idx / width_;
+    return (tiles_.tileOf(x, y).valid[y & tiles::MASK] >> (x & tiles::MASK)) & 1;
+}
+
+uint32_t FreeSpaceIndex::sample(std::mt19937& gen) const
+{
+    // The tile holding the drawn cell is the last one with no more cells before it than the draw
+    std::uniform_int_distribution<size_t> pick(0, size() - 1);
+    const size_t draw = pick(gen);
+    const size_t tile = std::upper_bound(offsets_.begin(), offsets_.end(), draw) - offsets_.begin() - 1;
+    return tiles_[tile].cells[draw - offsets_[tile]];
+}
+
+size_t FreeSpaceIndex::size() const
+{
+    return offsets_.empty() ? 0 : offsets_.back();
+}
+
+bool FreeSpaceIndex::empty() const
+{
+    return size() == 0;
+}
@@ -0,0 +1,102 @@
+#ifndef FREESPACEINDEX_H
+#define FREESPACEINDEX_H
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "nav_msgs/OccupancyGrid.h"
+#include "clearancemap.h"
+#include "cowtiles.h"
+
+/*!
+ *  \brief     Free Space Index Class
+ *  \details
+ *  Lists the cells of an occupancy grid which can hold a goal, built once per map so a
+ *  random goal is one draw from the list instead of rejection sampling the whole grid.
+ *  A cell qualifies when its centre is inside the world bounds box, it is at least the
+ *  margin away from the grid edge, and it is free with at least the required clearance to any obstacle.
+ *  The cells are listed per copy on write tile, so an update only rescans, and a copy only owns, the tiles over
+ *  the changed region, and a draw picks the tile from a running count of the cells before each one.
+ *  @sa PathPlanning
+ *  \version   1.00
+ */
+class FreeSpaceIndex
+{
+public:
+  /// @brief World aligned box the goals have to lie in [m]
+  struct Bounds
+  {
+    double minX;
+    double maxX;
+    double minY;
+    double maxY;
+  };
+
+  /// @brief Constructor for an empty index
+  FreeSpaceIndex();
+
+  /// @brief Rebuilds the index for a map
+  /// @param [in] map - the occupancy grid
+  /// @param [in] clearanceMap - clearance of map
+  /// @param [in] bounds - box the cell centres have to lie in [m]
+  /// @param [in] marginCells - cells closer than this to the grid edge are skipped
+  /// @param [in] clearance - the distance to the nearest obstacle has to be at least this [m]
+  void build(const nav_msgs::OccupancyGrid& map, const ClearanceMap& clearanceMap, const Bounds& bounds,
+             unsigned int marginCells, double clearance);
+
+  /// @brief Brings the index up to date with a map which only differs from the last one inside a region
+  ///
+  /// The region has to hold every cell whose clearance may have crossed the goal clearance, not only the cells
+  /// patched. An index of another size is rebuilt in full.
+  /// @param [in] map - the occupancy grid
+  /// @param [in] clearanceMap - clearance of map, already updated
+  /// @param [in] bounds - box the cell centres have to lie in [m]
+  /// @param [in] marginCells - cells closer than this to the grid edge are skipped
+  /// @param [in] clearance - the distance to the nearest obstacle has to be at least this [m]
+  /// @param [in] region - the cells which may have changed
+  void update(const nav_msgs::OccupancyGrid& map, const ClearanceMap& clearanceMap, const Bounds& bounds,
+              unsigned int marginCells, double clearance, const MapRegion& region);
+
+  /// @brief Checks if a cell is in the index
+  /// @param [in] idx - linear index of the cell in the grid
+  bool contains(uint32_t idx) const;
+
+  /// @brief Draws a cell uniformly from the index
+  /// @param [in|out] gen - the random number generator
+  /// @return linear index of the cell, only valid when the index is not empty
+  uint32_t sample(std::mt19937& gen) const;
+
+  /// @brief Getter for the number of cells in the index
+  size_t size() const;
+
+  /// @brief Checks if the index has no cells
+  bool empty() const;
+
+private:
+  /// @brief Cells whose centre is inside both the bounds box and the margin, empty for an invalid map
+  MapRegion scanBox(const nav_msgs::OccupancyGrid& map, const Bounds& bounds, unsigned int marginCells) const;
+
+  /// @brief Replaces the cells of a box which can hold a goal, tile by tile
+  void scan(const nav_msgs::OccupancyGrid& map, const ClearanceMap& clearanceMap, const MapRegion& box, double clearance);
+
+  /// @brief Recounts the cells before each tile
+  void count();
+
+  struct Tile
+  {
+    //! Linear indices of the cells of the tile that can hold a goal
+    std::vector<uint32_t> cells;
+    //! Bit x % 64 of row y % 64 is set when the cell is in cells
+    std::array<uint64_t, tiles::SIZE> valid{};
+  };
+
+  int width_;
+  int height_;
+  //! The indexed cells of each tile
+  CowTiles<Tile> tiles_;
+  //! Cells in the tiles before each tile, followed by the total
+  std::vector<size_t> offsets_;
+};
+
+#endif // FREESPACEINDEX_H
@@ -0,0 +1,261 @@
+#include "gridplanner.h"
+#include <algorithm>
+#include <cmath>
+
+GridPlanner::GridPlanner(double robotRadius, double preferredClearance, double maxTolerance):
+    robotRadius_(robotRadius), preferredClearance_(preferredClearance), width_(0), height_(0),
+    simplifier_(robotRadius, std::min(0.02, maxTolerance), maxTolerance), generation_(0), coarseGeneration_(0), coarseWidth_(0),
+    expanded_(0), pathLength_(0.0)
+{
+}
+
+void GridPlanner::setMap(const std::shared_ptr<const ClearanceMap>& clearanceMap,
+                         const std::shared_ptr<const MapPyramid>& pyramid)
+{
+    clearanceMap_ = clearanceMap;
+    pyramid_ = pyramid;
+    width_ = clearanceMap ? clearanceMap->width() : 0;
+    height_ = clearanceMap ? clearanceMap->height() : 0;
+    size_t cells = static_cast<size_t>(width_) * height_;
+    if (g_.size() != cells) {
+        g_.assign(cells, 0.0f);
+        parent_.assign(cells, 0);
+        openStamp_.assign(cells, 0);
+        closedStamp_.assign(cells, 0);
+        generation_ = 0;
+    }
+    // The coarse search is only used on a pyramid of this map which has the coarse layer
+    if (pyramid_ && (pyramid_->width(0) != width_ || pyramid_->height(0) != height_ || pyramid_->levels() <= COARSE_LEVEL_)) {
+        pyramid_.reset();
+    }
+    coarseWidth_ = pyramid_ ? pyramid_->width(COARSE_LEVEL_) : 0;
+    size_t coarseCells = pyramid_ ? static_cast<size_t>(coarseWidth_) * pyramid_->height(COARSE_LEVEL_) : 0;
+    if (coarseG_.size() != coarseCells) {
+        coarseG_.assign(coarseCells, 0.0f);
+        coarseParent_.assign(coarseCells, 0);
+        coarseOpenStamp_.assign(coarseCells, 0);
+        coarseClosedStamp_.assign(coarseCells, 0);
+        corridor_.assign(coarseCells, 0);
+        coarseGeneration_ = 0;
+    }
+}
+
+bool GridPlanner::worldToCell(const geometry_msgs::Point& p, int& x, int& y) const
+{
+    x = static_cast<int>(std::floor((p.x - clearanceMap_->originX()) / clearanceMap_->resolution()));
+    y = static_cast<int>(std::floor((p.y - clearanceMap_->originY()) / clearanceMap_->resolution()));
+    return x >= 0 && y >= 0 && x < width_ && y < height_;
+}
+
+bool GridPlanner::admissible(uint32_t to, uint32_t from) const
+{
+    double clearance = clearanceMap_->clearanceAt(to);
+    if (clearance >= robotRadius_) return true;
+    // A robot starting too close to an obstacle may still move away from it
+    double fromClearance = clearanceMap_->clearanceAt(from);
+    const bool known = pyramid_ ? !pyramid_->blockedAt(to) : clearance > 0.0;
+    return known && fromClearance < robotRadius_ && clearance >= fromClearance;
+}
+
+float GridPlanner::cellCost(uint32_t idx) const
+{
+    double clearance = clearanceMap_->clearanceAt(idx);
+    if (clearance >= preferredClearance_) return 1.0f;
+    return static_cast<float>(1.0 + 2.0 * (preferredClearance_ - clearance) / preferredClearance_);
+}
+
+bool GridPlanner::plan(const geometry_msgs::Point& start, const geometry_msgs::Point& goal, std::vector<geometry_msgs::Point>& waypoints)
+{
+    waypoints.clear();
+    expanded_ = 0;
+    pathLength_ = 0.0;
+    if (!clearanceMap_ || clearanceMap_->empty() || clearanceMap_->width() != width_ || clearanceMap_->height() != height_) return false;
+
+    int sx, sy, gx, gy;
+    if (!worldToCell(start, sx, sy) || !worldToCell(goal, gx, gy)) return false;
+    const uint32_t startIdx = sx + sy * width_;
+    const uint32_t goalIdx = gx + gy * width_;
+    if (clearanceMap_->clearanceAt(goalIdx) < robotRadius_) return false;
+
+    // Coarse to fine, the whole grid is only searched when the corridor does not hold a path
+    const bool corridor = searchCoarse(sx, sy, gx, gy);
+    if (!search(sx, sy, gx, gy, corridor) && (!corridor || !search(sx, sy, gx, gy, false))) return false;
+
+    cells_.clear();
+    for (uint32_t idx = goalIdx; idx != startIdx; idx = parent_[idx]) cells_.push_back(idx);
+
+    // The raw path runs from the start through the cell centres to the goal itself
+    const double resolution = clearanceMap_->resolution();
+    const double originX = clearanceMap_->originX();
+    const double originY = clearanceMap_->originY();
+    rawPath_.clear();
+    rawPath_.push_back(start);
+    for (size_t i = cells_.size(); i-- > 1;) {
+        geometry_msgs::Point p;
+        p.x = originX + (cells_[i] % width_ + 0.5) * resolution;
+        p.y = originY + (cells_[i] / width_ + 0.5) * resolution;
+        rawPath_.push_back(p);
+    }
+    rawPath_.push_back(goal);
+    for (size_t i = 1; i < rawPath_.size(); i++) {
+        pathLength_ += std::hypot(rawPath_[i].x - rawPath_[i - 1].x, rawPath_[i].y - rawPath_[i - 1].y);
+    }
+
+    // The start is where the robot already is, so it is not a waypoint
+    simplifier_.simplify(rawPath_, clearanceMap_.get(), waypoints);
+    waypoints.erase(waypoints.begin());
+    return true;
+}
+
+bool GridPlanner::searchCoarse(int sx, int sy, int gx, int gy)
+{
+    if (!pyramid_) return false;
+    const int csx = sx >> COARSE_LEVEL_, csy = sy >> COARSE_LEVEL_;
+    const int cgx = gx >> COARSE_LEVEL_, cgy = gy >> COARSE_LEVEL_;
+    if (std::max(std::abs(cgx - csx), std::abs(cgy - csy)) < COARSE_MIN_CELLS_) return false;
+    const int coarseHeight = pyramid_->height(COARSE_LEVEL_);
+
+    if (++coarseGeneration_ == 0) {
+        std::fill(coarseOpenStamp_.begin(), coarseOpenStamp_.end(), 0);
+        std::fill(coarseClosedStamp_.begin(), coarseClosedStamp_.end(), 0);
+        std::fill(corridor_.begin(), corridor_.end(), 0);
+        coarseGeneration_ = 1;
+    }
+
+    const int dx[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+    const int dy[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+    const float step[8] = {1.0f, 1.0f, 1.0f, 1.0f, float(M_SQRT2), float(M_SQRT2), float(M_SQRT2), float(M_SQRT2)};
+    auto heuristic = [&](int x, int y) {
+        float ax = static_cast<float>(std::abs(x - cgx));
+        float ay = static_cast<float>(std::abs(y - cgy));
+        return std::max(ax, ay) + (float(M_SQRT2) - 1.0f) * std::min(ax, ay);
+    };
+    const uint32_t startIdx = csx + csy * coarseWidth_;
+    const uint32_t goalIdx = cgx + cgy * coarseWidth_;
+    // The start and goal sit in cells that may hold a wall, every other cell has to be free
+    auto enterable = [&](int x, int y) {
+        const uint32_t idx = x + y * coarseWidth_;
+        return idx == goalIdx || !pyramid_->blocked(COARSE_LEVEL_, x, y);
+    };
+
+    open_.clear();
+    coarseG_[startIdx] = 0.0f;
+    coarseParent_[startIdx] = startIdx;
+    coarseOpenStamp_[startIdx] = coarseGeneration_;
+    open_.push_back({heuristic(csx, csy), startIdx});
+    bool found = false;
+    while (!open_.empty()) {
+        std::pop_heap(open_.begin(), open_.end());
+        OpenNode node = open_.back();
+        open_.pop_back();
+        if (coarseClosedStamp_[node.idx] == coarseGeneration_) continue;
+        coarseClosedStamp_[node.idx] = coarseGeneration_;
+        if (node.idx == goalIdx) {
+            found = true;
+            break;
+        }
+        const int x = node.idx % coarseWidth_;
+        const int y = node.idx / coarseWidth_;
+        for (int k = 0; k < 8; k++) {
+            const int nx = x + dx[k];
+            const int ny = y + dy[k];
+            if (nx < 0 || ny < 0 || nx >= coarseWidth_ || ny >= coarseHeight || !enterable(nx, ny)) continue;
+            const uint32_t nIdx = nx + ny * coarseWidth_;
+            if (coarseClosedStamp_[nIdx] == coarseGeneration_) continue;
+            if (k >= 4 && (!enterable(nx, y) || !enterable(x, ny))) continue;
+            const float g = coarseG_[node.idx] + step[k];
+            if (coarseOpenStamp_[nIdx] == coarseGeneration_ && g >= coarseG_[nIdx]) continue;
+            coarseG_[nIdx] = g;
+            coarseParent_[nIdx] = node.idx;
+            coarseOpenStamp_[nIdx] = coarseGeneration_;
+            open_.push_back({g + heuristic(nx, ny), nIdx});
+            std::push_heap(open_.begin(), open_.end());
+        }
+    }
+    if (!found) return false;
+
+    // The corridor is the coarse path grown by the margin, so the fine path can round its corners
+    for (uint32_t idx = goalIdx;; idx = coarseParent_[idx]) {
+        const int x = idx % coarseWidth_;
+        const int y = idx / coarseWidth_;
+        for (int cy = std::max(0, y - CORRIDOR_MARGIN_); cy <= std::min(coarseHeight - 1, y + CORRIDOR_MARGIN_); cy++) {
+            for (int cx = std::max(0, x - CORRIDOR_MARGIN_); cx <= std::min(coarseWidth_ - 1, x + CORRIDOR_MARGIN_); cx++) {
+                corridor_[cx + cy * coarseWidth_] = coarseGeneration_;
+            }
+        }
+        if (idx == startIdx) break;
+    }
+    return true;
+}
+
+bool GridPlanner::search(int sx, int sy, int gx, int gy, bool corridor)
+{
+    const uint32_t startIdx = sx + sy * width_;
+    const uint32_t goalIdx = gx + gy * width_;
+
+    // A new generation invalidates every cost and stamp of the last search
+    if (++generation_ == 0) {
+        std::fill(openStamp_.begin(), openStamp_.end(), 0);
+        std::fill(closedStamp_.begin(), closedStamp_.end(), 0);
+        generation_ = 1;
+    }
+
+    const int dx[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+    const int dy[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+    const float step[8] = {1.0f, 1.0f, 1.0f, 1.0f, float(M_SQRT2), float(M_SQRT2), float(M_SQRT2), float(M_SQRT2)};
+
+    // Octile distance, admissible on an 8-connected grid with costs of at least 1
+    auto heuristic = [&](int x, int y) {
+        float ax = static_cast<float>(std::abs(x - gx));
+        float ay = static_cast<float>(std::abs(y - gy));
+        return std::max(ax, ay) + (float(M_SQRT2) - 1.0f) * std::min(ax, ay);
+    };
+
+    open_.clear();
+    g_[startIdx] = 0.0f;
+    parent_[startIdx] = startIdx;
+    openStamp_[startIdx] = generation_;
+    open_.push_back({heuristic(sx, sy), startIdx});
+
+    while (!open_.empty()) {
+        std::pop_heap(open_.begin(), open_.end());
+        OpenNode node = open_.back();
+        open_.pop_back();
+        if (closedStamp_[node.idx] == generation_) continue;
+        closedStamp_[node.idx] = generation_;
+        expanded_++;
+        if (node.idx == goalIdx) return true;
+
+        const int x = node.idx % width_;
+        const int y = node.idx / width_;
+        for (int k = 0; k < 8; k++) {
+            const int nx = x + dx[k];
+            const int ny = y + dy[k];
+            if (nx < 0 || ny < 0 || nx >= width_ || ny >= height_) continue;
+            if (corridor && corridor_[(nx >> COARSE_LEVEL_) + (ny >> COARSE_LEVEL_) * coarseWidth_] != coarseGeneration_) continue;
+            const uint32_t nIdx = nx + ny * width_;
+            if (closedStamp_[nIdx] == generation_ || !admissible(nIdx, node.idx)) continue;
+            // Diagonals may not cut the corner of a cell that cannot be entered
+            if (k >= 4 && (!admissible(x + dx[k] + y * width_, node.idx) || !admissible(x + (y + dy[k]) * width_, node.idx))) continue;
+
+            const float g = g_[node.idx] + step[k] * cellCost(nIdx);
+            if (openStamp_[nIdx] == generation_ && g >= g_[nIdx]) continue;
+            g_[nIdx] = g;
+            parent_[nIdx] = node.idx;
+            openStamp_[nIdx] = generation_;
+            open_.push_back({g + heuristic(nx, ny), nIdx});
+            std::push_heap(open_.begin(), open_.end());
+        }
+    }
+    return false;
+}
+
+unsigned int GridPlanner::expanded() const
+{
+    return expanded_;
+}
+
+double GridPlanner::pathLength() const
+{
+    return pathLength_;
+}
@@ -0,0 +1,133 @@
+#ifndef GRIDPLANNER_H
+#define GRIDPLANNER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <geometry_msgs/Point.h>
+#include "clearancemap.h"
+#include "mappyramid.h"
+#include "pathsimplifier.h"
+
+/*!
+ *  \brief     Grid Planner Class
+ *  \details
+ *  8-connected A* over the cells of a clearance map, run in process on the shared map products.
+ *  The grid itself is not needed, a cell is known free when its clearance is above 0.
+ *  Cells closer to an obstacle than the robot radius are not entered, and cells within the
+ *  preferred clearance cost more so paths keep to the middle of corridors.
+ *  The open list, costs, parents and visited stamps are sized to the grid once and reused,
+ *  each search bumps a generation stamp instead of clearing them.
+ *  With a map pyramid, long paths are first searched over a coarse layer, where a cell can be entered
+ *  when every cell under it is free, and the full resolution search is kept to a corridor around the
+ *  coarse path. The search is repeated over the whole grid when the corridor holds no path.
+ *  The path is returned simplified to the fewest waypoints within a clearance aware error bound.
+ *  @sa PathPlanning
+ *  \version   1.00
+ */
+class GridPlanner
+{
+public:
+  /// @brief Constructor for the grid planner
+  /// @param [in] robotRadius - cells with less clearance than this are not entered [m]
+  /// @param [in] preferredClearance - cells with less clearance than this cost more [m]
+  /// @param [in] maxTolerance - the waypoints never cut the path by more than this [m]
+  GridPlanner(double robotRadius = 0.15, double preferredClearance = 0.5, double maxTolerance = 0.1);
+
+  /// @brief Sets the map to plan on, the buffers are only resized when the grid size changes
+  /// @param [in] clearanceMap - clearance of the map, which also gives its size and origin
+  /// @param [in] pyramid - pyramid of the map, nullptr searches the full grid only
+  void setMap(const std::shared_ptr<const ClearanceMap>& clearanceMap,
+              const std::shared_ptr<const MapPyramid>& pyramid = nullptr);
+
+  /// @brief Plans between two world positions
+  ///
+  /// The start may be closer to an obstacle than the robot radius, the path then climbs out of it.
+  /// @param [in] start - start position [m]
+  /// @param [in] goal - goal position [m]
+  /// @param [out] waypoints - simplified waypoints along the path after the start, always ending at the goal
+  /// @return false if there is no path, waypoints is then empty
+  bool plan(const geometry_msgs::Point& start, const geometry_msgs::Point& goal, std::vector<geometry_msgs::Point>& waypoints);
+
+  /// @brief Getter for the number of cells expanded by the last search
+  unsigned int expanded() const;
+
+  /// @brief Getter for the length of the last path found [m]
+  double pathLength() const;
+
+private:
+  struct OpenNode
+  {
+    float f;
+    uint32_t idx;
+    bool operator<(const OpenNode& other) const { return f > other.f; }
+  };
+
+  /// @brief Converts a world position to a cell, returns false outside the grid
+  bool worldToCell(const geometry_msgs::Point& p, int& x, int& y) const;
+
+  /// @brief Checks if a cell can be entered from another
+  bool admissible(uint32_t to, uint32_t from) const;
+
+  /// @brief Cost multiplier of entering a cell
+  float cellCost(uint32_t idx) const;
+
+  /// @brief Searches the coarse layer and marks the corridor around its path
+  /// @return false if the cells are too close for a coarse search to pay off, or it found no path
+  bool searchCoarse(int sx, int sy, int gx, int gy);
+
+  /// @brief A* over the full grid, within the corridor when it is set
+  /// @return true if the goal was reached, parent_ then leads back to the start
+  bool search(int sx, int sy, int gx, int gy, bool corridor);
+
+  double robotRadius_;
+  double preferredClearance_;
+
+  std::shared_ptr<const ClearanceMap> clearanceMap_;
+  std::shared_ptr<const MapPyramid> pyramid_;
+  int width_;
+  int height_;
+
+  //! Cost from the start, valid where openStamp_ matches generation_
+  std::vector<float> g_;
+  //! Cell each cell was reached from
+  std::vector<uint32_t> parent_;
+  //! Generation each cell was last opened in
+  std::vector<uint32_t> openStamp_;
+  //! Generation each cell was last closed in
+  std::vector<uint32_t> closedStamp_;
+  //! Binary heap of open cells
+  std::vector<OpenNode> open_;
+  //! Cells of the last path, goal first
+  std::vector<uint32_t> cells_;
+  //! Every point of the last path, start first
+  std::vector<geometry_msgs::Point> rawPath_;
+  //! Reduces the raw path to waypoints
+  PathSimplifier simplifier_;
+  //! Current search generation
+  uint32_t generation_;
+  //! Cost, parent and stamps of the coarse search, as for the full grid
+  std::vector<float> coarseG_;
+  std::vector<uint32_t> coarseParent_;
+  std::vector<uint32_t> coarseOpenStamp_;
+  std::vector<uint32_t> coarseClosedStamp_;
+  //! Coarse generation each coarse cell was last in the corridor in
+  std::vector<uint32_t> corridor_;
+  //! Current coarse search generation
+  uint32_t coarseGeneration_;
+  //! Width of the coarse layer [cells]
+  int coarseWidth_;
+  //! Cells expanded by the last search
+  unsigned int expanded_;
+  //! Length of the last path found [m]
+  double pathLength_;
+
+  //! Layer of the pyramid searched first, 8 cells to a side
+  const unsigned int COARSE_LEVEL_ = 3;
+  //! Paths shorter than this many coarse cells are only searched at full resolution
+  const int COARSE_MIN_CELLS_ = 4;
+  //! Coarse cells either side of the coarse path in the corridor
+  const int CORRIDOR_MARGIN_ = 1;
+};
+
+#endif // GRIDPLANNER_H
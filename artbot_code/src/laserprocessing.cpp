@@ -2,11 +2,12 @@
 #include <algorithm>
 #include <numeric>
 #include <math.h>
+#include <limits>
 
 using namespace std;
 
 //Default constructor of Laserprocessing, needs an initial set of laser data to be initialised
-LaserProcessing::LaserProcessing(sensor_msgs::LaserScan laserScan):
+LaserProcessing::LaserProcessing(const sensor_msgs::LaserScanConstPtr& laserScan):
     laserScan_(laserScan)
     {
         
@@ -18,78 +19,48 @@ std::pair<double, double> LaserProcessing::MinDistAngle() {
     // This pair will hold the distance and angle to the nearest obstacle
     std::pair<double, double> distAngle;
 
-    // This will hold the minimum element in the ranges
-    double minElement = laserScan_.ranges[0];
-
-    // This will hold the index of the minimum element
+    const std::vector<float>& ranges = laserScan_->ranges;
+    // With no readings there is nothing to clear the robot, so report an invalid distance
+    if (ranges.empty()) return std::make_pair(std::numeric_limits<double>::infinity(), 0.0);
 
+    // The first reading is taken as is, the rest are only used when greater than 1mm
+    double minElement = ranges[0];
     int minIndex = 0;
-
-// Iterate through the ranges to find the minimum element
-    for (int i = 1; i < laserScan_.ranges.size(); i++) {
-        if (laserScan_.ranges[i] < minElement && laserScan_.ranges[i] > 0.001) {
-            minElement = laserScan_.ranges[i];
-            minIndex = i;
-        }
+    scankernels::MinResult rest = scankernels::maskedMin(ranges.data() + 1, ranges.size() - 1, 0.001f);
+    if (rest.index >= 0 && rest.value < minElement) {
+        minElement = rest.value;
+        minIndex = rest.index + 1;
     }
 
 // Assign the minimum distance and angle to the pair
     distAngle.first = minElement * 1000; // To convert to mm
-    distAngle.second = (minIndex * laserScan_.angle_increment + laserScan_.angle_min) * (180.0 / M_PI); // To convert to degrees
+    distAngle.second = (minIndex * laserScan_->angle_increment + laserScan_->angle_min) * (180.0 / M_PI); // To convert to degrees
     return distAngle;
 }
 
 unsigned int LaserProcessing::countObjectReadings()
 {
-    // This count will hold the number of object readings
-  unsigned int count=0;
-    // iterate through the ranges
-      for (const auto& range : laserScan_.ranges)
-    {
-        // if the range is not infinity, not nan, and not the max range
-        if (!std::isinf(range) && !std::isnan(range) && range != laserScan_.range_max)
-        {
-            // increment the count
-            count++;
-        }
-    }
-    // return the count
-  return count;
+    // Counts the ranges that are not infinity, not nan, and not the max range
+    return scankernels::countFinite(laserScan_->ranges.data(), laserScan_->ranges.size(), laserScan_->range_max);
 }
 
 unsigned int LaserProcessing::countSegments()
 {
-    // This count will hold the number of segments
-    unsigned int count=0;
-    // Check if we are in a segment - initialised to false.
-    bool inSegment = false;
-    // Iterating over all ranges
-    for (const auto& range : laserScan_.ranges)
+    ScanSegmenter segmenter;
+    segmentScan(segmenter);
+    // A lone reading is not counted as a segment
+    unsigned int count = 0;
+    for (const auto& segment : segmenter.segments())
     {
-        std::pair<double, double> p1 = polarToCart(range - 1); //Previous point
-        std::pair<double, double> p2 = polarToCart(range); // Current point
-
-        // Calculate the Euclidean distance between the two points
-        double distance = sqrt(pow(p2.first - p1.first, 2) + pow(p2.second - p1.second, 2));
-        
-        // If the distance is less than 0.3, we are in the same segment
-        if (distance < 0.3)
-        {
-            // Change initialised inSegment to true since we're in the same segment (i.e., the distance is less than 0.3).
-            if (!inSegment)
-            {
-                inSegment = true;
-                count++;
-            }
-        }
-        // If the distance is greater than 0.3, we are not in the same segment
-        else
-        {
-            inSegment = false;
-        }
-    // return the number of segments.
-    return count;
+        if (segment.count >= 2) count++;
     }
+    return count;
+}
+
+void LaserProcessing::segmentScan(ScanSegmenter& segmenter)
+{
+    segmenter.process(laserScan_->ranges.data(), laserScan_->ranges.size(), trigTable(),
+                      laserScan_->range_min, laserScan_->range_max);
 }
 
 std::pair<double, double> LaserProcessing::polarToCart(int index)
@@ -98,11 +69,26 @@ std::pair<double, double> LaserProcessing::polarToCart(int index)
     std::pair<double, double> point;
     // Calculate the x and y coordinates of the laser reading at the specific index
 
-    point.first = laserScan_.ranges[index] * cos(index * laserScan_.angle_increment + laserScan_.angle_min);
-    point.second = laserScan_.ranges[index] * sin(index * laserScan_.angle_increment + laserScan_.angle_min);
+    const scankernels::TrigTable& trig = trigTable();
+    point.first = laserScan_->ranges[index] * trig.cos[index];
+    point.second = laserScan_->ranges[index] * trig.sin[index];
     return point;
 }
 
+void LaserProcessing::cartesianPoints(std::vector<float>& x, std::vector<float>& y)
+{
+    size_t n = laserScan_->ranges.size();
+    x.resize(n);
+    y.resize(n);
+    scankernels::polarToCart(laserScan_->ranges.data(), trigTable(), n, x.data(), y.data());
+}
+
+const scankernels::TrigTable& LaserProcessing::trigTable()
+{
+    if (!trig_) trig_ = scankernels::trigTableFor(laserScan_->angle_min, laserScan_->angle_increment, laserScan_->ranges.size());
+    return *trig_;
+}
+
 double LaserProcessing::angleConnectingPoints(std::pair<double, double> p1, std::pair<double, double> p2)
 {
     // Return the angle between the two points
@@ -6,6 +6,8 @@
 #include <iostream>
 #include "ros/ros.h"
 #include <geometry_msgs/Twist.h>
+#include "scankernels.h"
+#include "scansegmenter.h"
 
 /*!
  *  \brief     Laser Processing Class
@@ -25,8 +27,8 @@ class LaserProcessing
 {
 public:
   /// @brief Constructor for laser processing
-  /// @param [in] laserScan - laserScan to be processed
-  LaserProcessing(sensor_msgs::LaserScan laserScan);
+  /// @param [in] laserScan - laserScan to be processed, shared with the subscriber rather than copied
+  LaserProcessing(const sensor_msgs::LaserScanConstPtr& laserScan);
 
 // 'Pass' test declarations
 
@@ -42,23 +44,30 @@ public:
   unsigned int countObjectReadings();
 
 
-  /// @brief Count number of high intensity segments
-  /// @return the number of segments in the current laser scan
+  /// @brief Count number of segments
+  /// @return the number of segments of at least two readings in the current laser scan
   unsigned int countSegments();
 
-/* Added 11/05/2024 */
-
-  /// @brief Count number of readings belonging to objects
-  /// @return the number of laser readings that are NOT at infinity, nan or max range
-  unsigned int countObjectReadings();
+  /// @brief Segments the laser scan
+  ///
+  /// Readings outside the scanner's range_min/range_max are invalid.
+  /// The segmenter should be kept between scans so its buffers are reused.
+  /// @param [in|out] segmenter - the segmenter, holds the result
+  void segmentScan(ScanSegmenter& segmenter);
 
-  /// @brief Count number of high intensity segments
-  /// @return the number of segments in the current laser scan
-  unsigned int countSegments();
+  /// @brief Converts every reading to a cartesian point in the laser frame
+  /// @param [out] x - x of each reading, resized to the number of readings
+  /// @param [out] y - y of each reading, resized to the number of readings
+  void cartesianPoints(std::vector<float>& x, std::vector<float>& y);
 
 private:
-    //! Stores the laser scan data
-    sensor_msgs::LaserScan laserScan_;
+    //! Stores the laser scan data (immutable, shared with the callback that received it)
+    sensor_msgs::LaserScanConstPtr laserScan_;
+    //! sin/cos of every beam angle, shared between scans with the same geometry
+    std::shared_ptr<const scankernels::TrigTable> trig_;
+
+    /// @brief Getter for the trig table of the scan, looked up on first use
+    const scankernels::TrigTable& trigTable();
 
     /* Added 11/05/2024 */
 
@@ -0,0 +1,52 @@
+#include "latencyhistogram.h"
+#include <algorithm>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram(double binWidth, unsigned int numBins):
+    binWidth_(binWidth), counts_(std::max(numBins, 1u), 0), total_(0)
+{
+}
+
+void LatencyHistogram::record(double latency)
+{
+    // Anything past the last bin lands in the overflow bin
+    size_t bin = 0;
+    if(latency > 0.0) bin = std::min(static_cast<size_t>(latency / binWidth_), counts_.size() - 1);
+    counts_[bin]++;
+    total_++;
+}
+
+double LatencyHistogram::percentile(double p) const
+{
+    if(total_ == 0) return 0.0;
+    // Number of samples at or below the requested percentile
+    uint32_t target = static_cast<uint32_t>(std::ceil(std::min(std::max(p, 0.0), 1.0) * total_));
+    if(target == 0) target = 1;
+    uint32_t cumulative = 0;
+    for(size_t i = 0; i < counts_.size(); i++){
+        cumulative += counts_[i];
+        if(cumulative >= target) return (i + 1) * binWidth_;
+    }
+    return counts_.size() * binWidth_;
+}
+
+void LatencyHistogram::clear()
+{
+    std::fill(counts_.begin(), counts_.end(), 0);
+    total_ = 0;
+}
+
+const std::vector<uint32_t>& LatencyHistogram::counts() const
+{
+    return counts_;
+}
+
+uint32_t LatencyHistogram::total() const
+{
+    return total_;
+}
+
+double LatencyHistogram::binWidth() const
+{
+    return binWidth_;
+}
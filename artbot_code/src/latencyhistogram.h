@@ -0,0 +1,55 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <vector>
+#include <cstdint>
+
+/*!
+ *  \brief     Latency Histogram Class
+ *  \details
+ *  Accumulates latency samples into fixed width bins so the distribution can be
+ *  published and percentiles estimated without storing every sample.
+ *  The last bin collects every sample at or above the histogram range.
+ *  @sa Sample
+ *  \version   1.00
+ */
+class LatencyHistogram
+{
+public:
+  /// @brief Constructor for the latency histogram
+  /// @param [in] binWidth - width of each bin [s]
+  /// @param [in] numBins - number of bins, including the overflow bin
+  LatencyHistogram(double binWidth, unsigned int numBins);
+
+  /// @brief Adds a latency sample to the histogram, negative samples are counted in the first bin
+  /// @param [in] latency - the latency [s]
+  void record(double latency);
+
+  /// @brief Estimates a percentile from the bin counts
+  /// @param [in] p - the percentile in the range 0-1
+  /// @return the upper edge of the bin containing the percentile [s], 0 if no samples were recorded
+  double percentile(double p) const;
+
+  /// @brief Removes all samples
+  void clear();
+
+  /// @brief Getter for the bin counts
+  /// @return the number of samples in each bin
+  const std::vector<uint32_t>& counts() const;
+
+  /// @brief Getter for the total number of samples
+  uint32_t total() const;
+
+  /// @brief Getter for the bin width
+  double binWidth() const;
+
+private:
+  //! Width of each bin [s]
+  double binWidth_;
+  //! Number of samples per bin
+  std::vector<uint32_t> counts_;
+  //! Total number of samples
+  uint32_t total_;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,109 @@
+#include "localcostmap.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+    //Modulo that stays positive for negative cells
+    int wrap(int value, int size)
+    {
+        int r = value % size;
+        return r < 0 ? r + size : r;
+    }
+}
+
+LocalCostmap::LocalCostmap(double size, double resolution, double collisionRadius, unsigned int persistence):
+    cells_(std::max(1, static_cast<int>(std::ceil(size / resolution)))), resolution_(resolution),
+    persistence_(persistence), originX_(0), originY_(0), placed_(false), scan_(0),
+    hits_(static_cast<size_t>(cells_) * cells_, 0)
+{
+    const int reach = static_cast<int>(std::ceil(collisionRadius / resolution_));
+    for (int dx = -reach; dx <= reach; dx++) {
+        for (int dy = -reach; dy <= reach; dy++) {
+            if (std::hypot(dx, dy) * resolution_ <= collisionRadius) footprint_.push_back({dx, dy});
+        }
+    }
+}
+
+void LocalCostmap::update(double x, double y, double yaw, const std::vector<float>& pointsX,
+                          const std::vector<float>& pointsY, double minRange)
+{
+    recentre(static_cast<int>(std::floor(x / resolution_)), static_cast<int>(std::floor(y / resolution_)));
+    scan_++;
+
+    const double c = std::cos(yaw), s = std::sin(yaw);
+    const double minRange2 = minRange * minRange;
+    const size_t n = std::min(pointsX.size(), pointsY.size());
+    for (size_t i = 0; i < n; i++) {
+        const double px = pointsX[i], py = pointsY[i];
+        if (!std::isfinite(px) || !std::isfinite(py) || px * px + py * py < minRange2) continue;
+        const int cx = static_cast<int>(std::floor((x + c * px - s * py) / resolution_));
+        const int cy = static_cast<int>(std::floor((y + s * px + c * py) / resolution_));
+        if (cx < originX_ || cx >= originX_ + cells_ || cy < originY_ || cy >= originY_ + cells_) continue;
+        hits_[slot(cx, cy)] = scan_;
+    }
+}
+
+bool LocalCostmap::free(double x, double y) const
+{
+    const int cx = static_cast<int>(std::floor(x / resolution_));
+    const int cy = static_cast<int>(std::floor(y / resolution_));
+    for (const auto& offset : footprint_) {
+        if (occupied(cx + offset.first, cy + offset.second)) return false;
+    }
+    return true;
+}
+
+bool LocalCostmap::segmentFree(double x0, double y0, double x1, double y1) const
+{
+    const double length = std::hypot(x1 - x0, y1 - y0);
+    const int steps = std::max(1, static_cast<int>(std::ceil(length / resolution_)));
+    for (int i = 0; i <= steps; i++) {
+        const double t = static_cast<double>(i) / steps;
+        if (!free(x0 + t * (x1 - x0), y0 + t * (y1 - y0))) return false;
+    }
+    return true;
+}
+
+bool LocalCostmap::occupied(int cx, int cy) const
+{
+    if (!placed_ || cx < originX_ || cx >= originX_ + cells_ || cy < originY_ || cy >= originY_ + cells_) return false;
+    const uint32_t hit = hits_[slot(cx, cy)];
+    return hit != 0 && scan_ - hit < persistence_;
+}
+
+double LocalCostmap::resolution() const
+{
+    return resolution_;
+}
+
+void LocalCostmap::recentre(int cx, int cy)
+{
+    const int originX = cx - cells_ / 2, originY = cy - cells_ / 2;
+    if (!placed_ || std::abs(originX - originX_) >= cells_ || std::abs(originY - originY_) >= cells_) {
+        std::fill(hits_.begin(), hits_.end(), 0);
+    }
+    else {
+        // The columns and rows coming into view share their slots with the ones going out of view
+        for (int i = originX_ + cells_; i < originX + cells_; i++) clearLine(i, true);
+        for (int i = originX; i < originX_; i++) clearLine(i, true);
+        for (int i = originY_ + cells_; i < originY + cells_; i++) clearLine(i, false);
+        for (int i = originY; i < originY_; i++) clearLine(i, false);
+    }
+    originX_ = originX;
+    originY_ = originY;
+    placed_ = true;
+}
+
+void LocalCostmap::clearLine(int index, bool column)
+{
+    const int line = wrap(index, cells_);
+    for (int i = 0; i < cells_; i++) {
+        hits_[column ? static_cast<size_t>(line) * cells_ + i : static_cast<size_t>(i) * cells_ + line] = 0;
+    }
+}
+
+size_t LocalCostmap::slot(int cx, int cy) const
+{
+    return static_cast<size_t>(wrap(cx, cells_)) * cells_ + wrap(cy, cells_);
+}
@@ -0,0 +1,84 @@
+#ifndef LOCALCOSTMAP_H
+#define LOCALCOSTMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/*!
+ *  \brief     Local Costmap Class
+ *  \details
+ *  A square grid of the obstacles seen by the laser around the robot, in the map frame.
+ *  The grid rolls with the robot: cells are addressed by their map cell modulo the grid size, so moving
+ *  only clears the rows and columns that come into view. Each scan marks the cells its readings fall in
+ *  with the scan number, and a cell is occupied until it has not been seen for a few scans, so people
+ *  walking away are forgotten without tracing the free space of every beam.
+ *  A position is free when no occupied cell is within the collision radius of it.
+ *  @sa LocalPlanner Sample
+ *  \version   1.00
+ */
+class LocalCostmap
+{
+public:
+  /// @brief Constructor for the local costmap
+  /// @param [in] size - width of the grid [m]
+  /// @param [in] resolution - width of a cell [m]
+  /// @param [in] collisionRadius - distance a position is kept from occupied cells [m]
+  /// @param [in] persistence - number of scans a cell stays occupied after it was last seen
+  LocalCostmap(double size = 4.0, double resolution = 0.05, double collisionRadius = 0.14, unsigned int persistence = 5);
+
+  /// @brief Centres the grid on the robot and marks the readings of a scan
+  /// @param [in] x - x of the laser in the map frame [m]
+  /// @param [in] y - y of the laser in the map frame [m]
+  /// @param [in] yaw - heading of the laser in the map frame [rad]
+  /// @param [in] pointsX - x of each reading in the laser frame, NaN and infinite readings are skipped [m]
+  /// @param [in] pointsY - y of each reading in the laser frame [m]
+  /// @param [in] minRange - readings closer than this are skipped, the scanner reports them as 0 [m]
+  void update(double x, double y, double yaw, const std::vector<float>& pointsX, const std::vector<float>& pointsY,
+              double minRange);
+
+  /// @brief Checks if a position in the map frame is at least the collision radius from every occupied cell
+  /// @note Positions outside the grid are unknown and treated as free
+  bool free(double x, double y) const;
+
+  /// @brief Checks if every position along a segment is free
+  bool segmentFree(double x0, double y0, double x1, double y1) const;
+
+  /// @brief Checks if a cell is occupied
+  /// @param [in] cx - map cell column, floor(x / resolution)
+  /// @param [in] cy - map cell row, floor(y / resolution)
+  bool occupied(int cx, int cy) const;
+
+  /// @brief Getter for the width of a cell [m]
+  double resolution() const;
+
+private:
+  /// @brief Moves the grid so the robot is in its centre cell, clearing the cells that come into view
+  void recentre(int cx, int cy);
+
+  /// @brief Clears the cells of a map column or row, whichever the axis says
+  void clearLine(int index, bool column);
+
+  /// @brief Index in hits_ of a map cell inside the grid
+  size_t slot(int cx, int cy) const;
+
+  //! Number of cells along each side
+  int cells_;
+  //! Width of a cell [m]
+  double resolution_;
+  //! Scans a cell stays occupied for
+  unsigned int persistence_;
+  //! Map cell of the grid's lowest corner
+  int originX_, originY_;
+  //! Set once the grid has been centred
+  bool placed_;
+  //! Number of the current scan, starts at 1 so 0 means never seen
+  uint32_t scan_;
+  //! Scan each cell was last seen in, indexed by slot()
+  std::vector<uint32_t> hits_;
+  //! Cell offsets within the collision radius
+  std::vector<std::pair<int, int>> footprint_;
+};
+
+#endif // LOCALCOSTMAP_H
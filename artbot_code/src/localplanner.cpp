@@ -0,0 +1,131 @@
+#include "localplanner.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <memory>
+#include "tf/transform_datatypes.h"
+
+namespace {
+    //Rejoin points tried, as multiples of the lookahead
+    const double REJOIN_SCALES[] = {1.0, 1.5, 2.0};
+    //Offsets of the bend from the chord tried, in order [m]
+    const double OFFSETS[] = {0.0, 0.25, -0.25, 0.5, -0.5, 0.75, -0.75};
+}
+
+LocalPlanner::LocalPlanner(const squiggles::Constraints& constraints, double robotWidth, double lookahead, double budget,
+                           unsigned int maxCandidates):
+    generator_(new squiggles::BasicSplineGenerator<squiggles::TankModel>(
+        constraints, std::make_shared<squiggles::TankModel>(robotWidth, constraints), 0.01, 1)),
+    cruise_(constraints.max_vel), lookahead_(lookahead), budget_(budget), maxCandidates_(maxCandidates), lastPlanTime_(0.0)
+{
+}
+
+bool LocalPlanner::blocked(const std::vector<geometry_msgs::Point>& path, size_t segment, double x, double y,
+                           const LocalCostmap& costmap) const
+{
+    // From the robot to the end of its segment, then along the path until the lookahead is covered
+    double fromX = x, fromY = y, covered = 0.0;
+    for (size_t i = segment + 1; i < path.size() && covered < lookahead_; i++) {
+        if (!costmap.segmentFree(fromX, fromY, path[i].x, path[i].y)) return true;
+        covered += std::hypot(path[i].x - fromX, path[i].y - fromY);
+        fromX = path[i].x;
+        fromY = path[i].y;
+    }
+    return false;
+}
+
+bool LocalPlanner::replan(const geometry_msgs::Pose& robot, const std::vector<geometry_msgs::Point>& path, size_t segment,
+                          const LocalCostmap& costmap, squiggles::Trajectory& detour, size_t& rejoin)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::duration<double>(budget_);
+    const double x = robot.position.x, y = robot.position.y;
+    const double yaw = tf::getYaw(robot.orientation);
+    bool found = false;
+    // A candidate limit stands in for the clock, so the detour does not depend on how fast the machine is
+    unsigned int candidates = 0;
+    auto spent = [&]() {
+        return maxCandidates_ > 0 ? candidates >= maxCandidates_ : std::chrono::steady_clock::now() > deadline;
+    };
+
+    for (double scale : REJOIN_SCALES) {
+        geometry_msgs::Point end;
+        double heading;
+        size_t index;
+        if (!pointAhead(path, segment, x, y, scale * lookahead_, end, heading, index) || !costmap.free(end.x, end.y)) continue;
+
+        // Normal to the chord from the robot to the rejoin point, the bend is moved along it
+        const double chord = std::atan2(end.y - y, end.x - x);
+        const double nx = -std::sin(chord), ny = std::cos(chord);
+        for (double offset : OFFSETS) {
+            if (spent()) break;
+            const double viaX = 0.5 * (x + end.x) + offset * nx, viaY = 0.5 * (y + end.y) + offset * ny;
+            if (offset != 0.0 && !costmap.free(viaX, viaY)) continue;
+
+            waypoints_.clear();
+            waypoints_.push_back(squiggles::ControlVector(squiggles::Pose(x, y, yaw), cruise_));
+            if (offset != 0.0) waypoints_.push_back(squiggles::ControlVector(squiggles::Pose(viaX, viaY, chord), cruise_));
+            waypoints_.push_back(squiggles::ControlVector(squiggles::Pose(end.x, end.y, heading), cruise_));
+            candidates++;
+            try {
+                generator_->generate(waypoints_, candidate_);
+            }
+            catch (const std::exception&) {
+                continue;
+            }
+            if (candidate_.empty() || !free(candidate_.view(), 0, costmap)) continue;
+
+            std::swap(detour, candidate_);
+            rejoin = index;
+            found = true;
+            break;
+        }
+        if (found || spent()) break;
+    }
+    lastPlanTime_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return found;
+}
+
+bool LocalPlanner::free(const squiggles::TrajectoryView& trajectory, size_t from, const LocalCostmap& costmap) const
+{
+    // Samples closer together than a cell are only checked once the trajectory has moved a cell
+    const double step2 = costmap.resolution() * costmap.resolution();
+    double lastX = 0.0, lastY = 0.0;
+    for (size_t i = from; i < trajectory.size; i++) {
+        const double dx = trajectory.x[i] - lastX, dy = trajectory.y[i] - lastY;
+        if (i > from && i + 1 < trajectory.size && dx * dx + dy * dy < step2) continue;
+        if (!costmap.free(trajectory.x[i], trajectory.y[i])) return false;
+        lastX = trajectory.x[i];
+        lastY = trajectory.y[i];
+    }
+    return true;
+}
+
+double LocalPlanner::lastPlanTime() const
+{
+    return lastPlanTime_;
+}
+
+bool LocalPlanner::pointAhead(const std::vector<geometry_msgs::Point>& path, size_t segment, double x, double y,
+                              double distance, geometry_msgs::Point& point, double& heading, size_t& index) const
+{
+    double fromX = x, fromY = y, covered = 0.0;
+    for (size_t i = segment + 1; i < path.size(); i++) {
+        const double length = std::hypot(path[i].x - fromX, path[i].y - fromY);
+        // The end of the path is the rejoin point when the path is shorter than the distance
+        if ((covered + length >= distance || i + 1 == path.size()) && length > 0.0) {
+            const double t = std::min((distance - covered) / length, 1.0);
+            point.x = fromX + t * (path[i].x - fromX);
+            point.y = fromY + t * (path[i].y - fromY);
+            point.z = 0.0;
+            heading = std::atan2(path[i].y - fromY, path[i].x - fromX);
+            index = i;
+            return true;
+        }
+        covered += length;
+        fromX = path[i].x;
+        fromY = path[i].y;
+    }
+    return false;
+}
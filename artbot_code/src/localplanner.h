@@ -0,0 +1,91 @@
+#ifndef LOCALPLANNER_H
+#define LOCALPLANNER_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <geometry_msgs/Point.h>
+#include <geometry_msgs/Pose.h>
+#include "squiggles.hpp"
+#include "localcostmap.h"
+
+/*!
+ *  \brief     Local Planner Class
+ *  \details
+ *  Reroutes the robot around obstacles the laser sees on the path it is following.
+ *  A detour is a short spline from the robot to a rejoin point further along the path, either straight
+ *  or bent through a point to one side of the chord between them. Candidates are tried from the nearest
+ *  rejoin point and smallest offset outwards, and the first whose samples are all free in the local costmap
+ *  is taken. Every waypoint is passed at the cruise velocity, which keeps the profiled spline on the shape
+ *  the optimiser checked instead of looping past the waypoints. Generation stops once the time budget is spent, so a replan fits in one control period,
+ *  or with a candidate limit after that many candidates, so a replan gives the same detour however fast the machine is.
+ *  @sa LocalCostmap Sample
+ *  \version   1.00
+ */
+class LocalPlanner
+{
+public:
+  /// @brief Constructor for the local planner
+  /// @param [in] constraints - limits of the detour splines
+  /// @param [in] robotWidth - distance between the wheels [m]
+  /// @param [in] lookahead - length of path ahead of the robot checked for obstacles, and the nearest rejoin point [m]
+  /// @param [in] budget - most time spent generating candidates in one replan [s]
+  /// @param [in] maxCandidates - most candidates generated in one replan, 0 to only stop on the time budget
+  LocalPlanner(const squiggles::Constraints& constraints, double robotWidth, double lookahead = 1.0, double budget = 0.05,
+               unsigned int maxCandidates = 0);
+
+  /// @brief Checks if an obstacle in the costmap is on the path ahead of the robot
+  /// @param [in] path - the points of the path, in order
+  /// @param [in] segment - index of the path segment the robot is on
+  /// @param [in] x - x of the robot [m]
+  /// @param [in] y - y of the robot [m]
+  /// @param [in] costmap - obstacles around the robot
+  /// @return true if the path within the lookahead is not free
+  bool blocked(const std::vector<geometry_msgs::Point>& path, size_t segment, double x, double y,
+               const LocalCostmap& costmap) const;
+
+  /// @brief Plans a detour from the robot back to the path
+  /// @param [in] robot - pose of the robot
+  /// @param [in] path - the points of the path, in order
+  /// @param [in] segment - index of the path segment the robot is on
+  /// @param [in] costmap - obstacles around the robot
+  /// @param [out] detour - the detour, ends on the path
+  /// @param [out] rejoin - index of the path point ending the segment the detour ends on
+  /// @return true if a free detour was found within the budget, or the candidate limit when it is set
+  bool replan(const geometry_msgs::Pose& robot, const std::vector<geometry_msgs::Point>& path, size_t segment,
+              const LocalCostmap& costmap, squiggles::Trajectory& detour, size_t& rejoin);
+
+  /// @brief Checks if the samples of a trajectory from an index on are free
+  bool free(const squiggles::TrajectoryView& trajectory, size_t from, const LocalCostmap& costmap) const;
+
+  /// @brief Getter for the time the last replan took [ms]
+  double lastPlanTime() const;
+
+private:
+  /// @brief Finds the point a distance along the path ahead of the robot
+  /// @param [out] point - the point
+  /// @param [out] heading - heading of the path at the point [rad]
+  /// @param [out] index - index of the path point ending the segment holding the point
+  /// @return false if there is no path ahead of the robot, the end of the path is taken when the path is shorter
+  bool pointAhead(const std::vector<geometry_msgs::Point>& path, size_t segment, double x, double y, double distance,
+                  geometry_msgs::Point& point, double& heading, size_t& index) const;
+
+  //! Generates the candidate splines, its buffers are kept between replans, held by pointer as it cannot be assigned
+  std::unique_ptr<squiggles::BasicSplineGenerator<squiggles::TankModel>> generator_;
+  //! Waypoints of the candidate being generated
+  std::vector<squiggles::ControlVector> waypoints_;
+  //! Velocity every waypoint is passed at [m/s]
+  double cruise_;
+  //! The candidate being checked
+  squiggles::Trajectory candidate_;
+  //! Length of path checked, and distance to the nearest rejoin point [m]
+  double lookahead_;
+  //! Most time spent generating candidates in one replan [s]
+  double budget_;
+  //! Most candidates generated in one replan, replaces the time budget when not 0
+  unsigned int maxCandidates_;
+  //! Time the last replan took [ms]
+  double lastPlanTime_;
+};
+
+#endif // LOCALPLANNER_H
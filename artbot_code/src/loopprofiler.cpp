@@ -0,0 +1,150 @@
+#include "loopprofiler.h"
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+
+namespace {
+    //Histogram bins of 0.1 ms up to 200 ms, longer durations are only seen in the max
+    const double BIN_WIDTH = 0.0001;
+    const unsigned int NUM_BINS = 2000;
+}
+
+std::atomic<bool> LoopProfiler::dumpRequested_(false);
+
+LoopProfiler::Scope::Scope(LoopProfiler& profiler, Stage stage):
+    profiler_(profiler), stage_(stage), start_(std::chrono::steady_clock::now())
+{
+}
+
+LoopProfiler::Scope::~Scope()
+{
+    profiler_.record(stage_, std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count());
+}
+
+LoopProfiler::LoopProfiler():
+    histograms_(STAGES, LatencyHistogram(BIN_WIDTH, NUM_BINS)), ring_(RING_ENTRIES), recorded_(0),
+    ticks_(0), missed_(0), missedTotal_(0), period_(0.0), publishPeriod_(0.0),
+    tickStart_(std::chrono::steady_clock::now())
+{
+    max_.fill(0.0);
+    maxTotal_.fill(0.0);
+}
+
+LoopProfiler::LoopProfiler(ros::NodeHandle nh, double period, double publishPeriod, const std::string& dumpFile):
+    LoopProfiler()
+{
+    period_ = period;
+    publishPeriod_ = publishPeriod;
+    dumpFile_ = dumpFile;
+    pub_ = nh.advertise<diagnostic_msgs::DiagnosticArray>("loop_profile", 1, false);
+    if(!dumpFile_.empty()){
+        std::signal(SIGUSR1, &LoopProfiler::requestDump);
+        ROS_INFO("Loop profile is dumped to %s on SIGUSR1", dumpFile_.c_str());
+    }
+}
+
+void LoopProfiler::record(Stage stage, double duration)
+{
+    histograms_[stage].record(duration);
+    max_[stage] = std::max(max_[stage], duration);
+    maxTotal_[stage] = std::max(maxTotal_[stage], duration);
+
+    Entry& entry = ring_[recorded_ % RING_ENTRIES];
+    entry.stamp = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    entry.duration = static_cast<float>(duration);
+    entry.stage = stage;
+    recorded_++;
+}
+
+void LoopProfiler::beginTick()
+{
+    tickStart_ = std::chrono::steady_clock::now();
+}
+
+void LoopProfiler::endTick()
+{
+    double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - tickStart_).count();
+    record(TICK, duration);
+    ticks_++;
+    if(period_ > 0.0 && duration > period_){
+        missed_++;
+        missedTotal_++;
+    }
+
+    if(dumpRequested_.exchange(false) && !dumpFile_.empty()){
+        if(dump(dumpFile_)) ROS_INFO("Loop profile dumped to %s", dumpFile_.c_str());
+        else ROS_ERROR("Failed to dump the loop profile to %s", dumpFile_.c_str());
+    }
+
+    if(publishPeriod_ <= 0.0) return;
+    ros::Time now = ros::Time::now();
+    if(lastPublish_.isZero()) lastPublish_ = now;
+    if((now - lastPublish_).toSec() < publishPeriod_) return;
+    publish();
+    lastPublish_ = now;
+}
+
+bool LoopProfiler::dump(const std::string& path) const
+{
+    FILE* file = std::fopen(path.c_str(), "w");
+    if(file == nullptr) return false;
+    std::fprintf(file, "stamp,stage,duration_ms\n");
+    size_t first = recorded_ > RING_ENTRIES ? recorded_ - RING_ENTRIES : 0;
+    for(size_t i = first; i < recorded_; i++){
+        const Entry& entry = ring_[i % RING_ENTRIES];
+        std::fprintf(file, "%.6f,%s,%.4f\n", entry.stamp, stageName(static_cast<Stage>(entry.stage)),
+                     entry.duration * 1000.0);
+    }
+    return std::fclose(file) == 0;
+}
+
+const char* LoopProfiler::stageName(Stage stage)
+{
+    static const char* NAMES[STAGES] = {"snapshot", "map", "scan", "goals", "spline", "markers", "local", "control", "publish", "tick"};
+    return stage < STAGES ? NAMES[stage] : "unknown";
+}
+
+void LoopProfiler::publish()
+{
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = "artbot control loop";
+    status.level = missed_ > 0 ? diagnostic_msgs::DiagnosticStatus::WARN : diagnostic_msgs::DiagnosticStatus::OK;
+    status.message = std::to_string(missed_) + " of " + std::to_string(ticks_) + " ticks missed the deadline";
+
+    char value[32];
+    for(unsigned int i = 0; i < STAGES; i++){
+        const std::string name = stageName(static_cast<Stage>(i));
+        diagnostic_msgs::KeyValue kv;
+        if(maxTotal_[i] > 0.0){
+            std::snprintf(value, sizeof(value), "%.2f", maxTotal_[i] * 1000.0);
+            kv.key = name + " max ms total"; kv.value = value; status.values.push_back(kv);
+        }
+        const LatencyHistogram& histogram = histograms_[i];
+        if(histogram.total() == 0) continue;
+        std::snprintf(value, sizeof(value), "%.2f", histogram.percentile(0.5) * 1000.0);
+        kv.key = name + " p50 ms"; kv.value = value; status.values.push_back(kv);
+        std::snprintf(value, sizeof(value), "%.2f", histogram.percentile(0.99) * 1000.0);
+        kv.key = name + " p99 ms"; kv.value = value; status.values.push_back(kv);
+        std::snprintf(value, sizeof(value), "%.2f", max_[i] * 1000.0);
+        kv.key = name + " max ms"; kv.value = value; status.values.push_back(kv);
+    }
+    diagnostic_msgs::KeyValue kv;
+    kv.key = "missed deadlines total";
+    kv.value = std::to_string(missedTotal_);
+    status.values.push_back(kv);
+
+    diagnostic_msgs::DiagnosticArray msg;
+    msg.header.stamp = ros::Time::now();
+    msg.status.push_back(status);
+    pub_.publish(msg);
+
+    for(auto& histogram : histograms_) histogram.clear();
+    max_.fill(0.0);
+    ticks_ = 0;
+    missed_ = 0;
+}
+
+void LoopProfiler::requestDump(int)
+{
+    dumpRequested_ = true;
+}
@@ -0,0 +1,140 @@
+#ifndef LOOPPROFILER_H
+#define LOOPPROFILER_H
+
+#include "ros/ros.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include "diagnostic_msgs/DiagnosticArray.h"
+#include "latencyhistogram.h"
+
+/*!
+ *  \brief     Loop Profiler Class
+ *  \details
+ *  Times the stages of the control loop with scoped timers.
+ *  Every duration goes into a histogram per stage, published as p50, p99 and max on loop_profile with the
+ *  number of ticks that missed the loop period. The longest duration and the missed ticks since the profiler
+ *  was created are published alongside, so a stage that only runs once, such as planning the tour, is still
+ *  seen after the period it ran in. Every duration also goes into a ring of the latest durations which can be
+ *  dumped to a file on SIGUSR1 for a look at what happened before an incident.
+ *  Only the control thread records, so nothing here is locked.
+ *  The PROFILE_ macros compile to nothing unless ARTBOT_PROFILE is defined.
+ *  @sa Sample
+ *  \version   1.00
+ */
+class LoopProfiler
+{
+public:
+  //! Timed stages of the control loop, TICK is a whole cycle without the wait for the next one
+  enum Stage {SNAPSHOT = 0, MAP, SCAN, GOALS, SPLINE, MARKERS, LOCAL, CONTROL, PUBLISH, TICK, STAGES};
+
+  //! A duration kept in the ring
+  struct Entry
+  {
+    //! Wall time the stage ended [s]
+    double stamp;
+    //! Duration of the stage [s]
+    float duration;
+    //! The Stage timed
+    uint32_t stage;
+  };
+
+  //! Number of entries in the ring, at 10 Hz this is about a minute of the loop
+  static const size_t RING_ENTRIES = 8192;
+
+  /// @brief Times a stage from construction to destruction
+  class Scope
+  {
+  public:
+    Scope(LoopProfiler& profiler, Stage stage);
+    ~Scope();
+  private:
+    LoopProfiler& profiler_;
+    Stage stage_;
+    std::chrono::steady_clock::time_point start_;
+  };
+
+  /// @brief Default constructor, records but publishes nothing until constructed with a node handle
+  LoopProfiler();
+
+  /// @brief Constructor for the loop profiler
+  /// @param [in] nh - node handle loop_profile is advertised on
+  /// @param [in] period - the loop period, longer ticks are counted as missed deadlines [s]
+  /// @param [in] publishPeriod - period between loop_profile publishes [s]
+  /// @param [in] dumpFile - file the ring is written to on SIGUSR1, empty leaves SIGUSR1 alone
+  LoopProfiler(ros::NodeHandle nh, double period, double publishPeriod, const std::string& dumpFile);
+
+  /// @brief Records the duration of a stage
+  /// @param [in] stage - the stage
+  /// @param [in] duration - its duration [s]
+  void record(Stage stage, double duration);
+
+  /// @brief Starts timing a tick, called when the loop wakes
+  void beginTick();
+
+  /// @brief Ends the tick, called before the loop waits. Publishes and dumps when they are due
+  void endTick();
+
+  /// @brief Writes the ring to a file, oldest first, as stamp,stage,duration_ms
+  /// @param [in] path - the file
+  /// @return false if the file could not be written
+  bool dump(const std::string& path) const;
+
+  /// @brief Name of a stage
+  static const char* stageName(Stage stage);
+
+private:
+  /// @brief Publishes the histograms on loop_profile and clears them
+  void publish();
+
+  /// @brief SIGUSR1 handler, only sets dumpRequested_ as the ring is written by the control thread
+  static void requestDump(int signal);
+
+  //! Set by the signal handler, shared by every profiler in the process
+  static std::atomic<bool> dumpRequested_;
+
+  //! loop_profile publisher
+  ros::Publisher pub_;
+  //! Durations of each stage since the last publish
+  std::vector<LatencyHistogram> histograms_;
+  //! Longest duration of each stage since the last publish [s]
+  std::array<double, STAGES> max_;
+  //! Longest duration of each stage since the profiler was created [s]
+  std::array<double, STAGES> maxTotal_;
+  //! The latest durations, overwritten oldest first
+  std::vector<Entry> ring_;
+  //! Number of durations ever recorded, the next one goes to ring_[recorded_ % RING_ENTRIES]
+  size_t recorded_;
+  //! Ticks since the last publish
+  uint32_t ticks_;
+  //! Ticks longer than period_ since the last publish
+  uint32_t missed_;
+  //! Ticks longer than period_ since the profiler was created
+  uint64_t missedTotal_;
+  //! The loop period [s]
+  double period_;
+  //! Period between loop_profile publishes [s]
+  double publishPeriod_;
+  //! File the ring is dumped to
+  std::string dumpFile_;
+  //! Time the last loop_profile was published
+  ros::Time lastPublish_;
+  //! Start of the current tick
+  std::chrono::steady_clock::time_point tickStart_;
+};
+
+#ifdef ARTBOT_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+//! Times the rest of the enclosing block as a stage of the loop
+#define PROFILE_SCOPE(profiler, stage) LoopProfiler::Scope PROFILE_CONCAT(profileScope_, __LINE__)(profiler, LoopProfiler::stage)
+#define PROFILE_BEGIN_TICK(profiler) (profiler).beginTick()
+#define PROFILE_END_TICK(profiler) (profiler).endTick()
+#else
+#define PROFILE_SCOPE(profiler, stage) do {} while (0)
+#define PROFILE_BEGIN_TICK(profiler) do {} while (0)
+#define PROFILE_END_TICK(profiler) do {} while (0)
+#endif
+
+#endif // LOOPPROFILER_H
@@ -0,0 +1,136 @@
+#include "mappyramid.h"
+#include <algorithm>
+
+namespace {
+    //Ors each pair of neighbouring bits of a word and packs the 32 results into its low half
+    uint64_t compress(uint64_t word)
+    {
+        uint64_t v = (word | (word >> 1)) & 0x5555555555555555ULL;
+        v = (v | (v >> 1)) & 0x3333333333333333ULL;
+        v = (v | (v >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+        v = (v | (v >> 4)) & 0x00FF00FF00FF00FFULL;
+        v = (v | (v >> 8)) & 0x0000FFFF0000FFFFULL;
+        v = (v | (v >> 16)) & 0x00000000FFFFFFFFULL;
+        return v;
+    }
+}
+
+MapPyramid::MapPyramid(unsigned int levels):
+    maxLevels_(std::max(1u, levels))
+{
+}
+
+void MapPyramid::build(const nav_msgs::OccupancyGrid& map)
+{
+    layers_.clear();
+    const int width = map.info.width;
+    const int height = map.info.height;
+    if (width <= 0 || height <= 0 || map.data.size() < static_cast<size_t>(width) * height) return;
+
+    // The base is packed 64 cells to a word, the bits past the end of a row stay clear
+    Layer base;
+    base.width = width;
+    base.height = height;
+    base.bits.reset(width, height, Tile());
+    pack(map, base, 0, height - 1, 0, base.bits.tilesX() - 1);
+    layers_.push_back(base);
+
+    while (layers_.size() < maxLevels_ && (layers_.back().width > 1 || layers_.back().height > 1)) {
+        Layer coarse;
+        coarse.width = (layers_.back().width + 1) / 2;
+        coarse.height = (layers_.back().height + 1) / 2;
+        coarse.bits.reset(coarse.width, coarse.height, Tile());
+        pool(layers_.back(), coarse, 0, coarse.height - 1, 0, coarse.bits.tilesX() - 1);
+        layers_.push_back(coarse);
+    }
+}
+
+void MapPyramid::update(const nav_msgs::OccupancyGrid& map, const MapRegion& region)
+{
+    if (layers_.empty() || static_cast<int>(map.info.width) != layers_[0].width ||
+        static_cast<int>(map.info.height) != layers_[0].height) {
+        build(map);
+        return;
+    }
+    MapRegion cells = region.grown(0, layers_[0].width, layers_[0].height);
+    if (cells.empty()) return;
+
+    // Each layer only changes over the words under the region, which halves going up
+    pack(map, layers_[0], cells.y0, cells.y1, cells.x0 / 64, cells.x1 / 64);
+    for (size_t level = 1; level < layers_.size(); level++) {
+        cells.x0 /= 2; cells.y0 /= 2; cells.x1 /= 2; cells.y1 /= 2;
+        pool(layers_[level - 1], layers_[level], cells.y0, cells.y1, cells.x0 / 64, cells.x1 / 64);
+    }
+}
+
+void MapPyramid::pack(const nav_msgs::OccupancyGrid& map, Layer& base, int y0, int y1, int w0, int w1) const
+{
+    for (int y = y0; y <= y1; y++) {
+        const int8_t* row = &map.data[static_cast<size_t>(y) * base.width];
+        for (int w = w0; w <= w1; w++) {
+            const int first = w * 64;
+            const int count = std::min(64, base.width - first);
+            uint64_t word = 0;
+            for (int i = 0; i < count; i++) word |= static_cast<uint64_t>(row[first + i] != 0) << i;
+            base.bits.writable(w, y >> tiles::SHIFT)[y & tiles::MASK] = word;
+        }
+    }
+}
+
+void MapPyramid::pool(const Layer& fine, Layer& coarse, int y0, int y1, int w0, int w1) const
+{
+    const int stride = fine.bits.tilesX();
+    for (int y = y0; y <= y1; y++) {
+        const int row0 = 2 * y;
+        const int row1 = 2 * y + 1 < fine.height ? row0 + 1 : row0;
+        // Two fine words hold the columns of one coarse word
+        for (int w = w0; w <= w1; w++) {
+            const int low = 2 * w, high = 2 * w + 1;
+            const uint64_t a = fine.word(low, row0) | fine.word(low, row1);
+            const uint64_t b = high < stride ? fine.word(high, row0) | fine.word(high, row1) : 0;
+            coarse.bits.writable(w, y >> tiles::SHIFT)[y & tiles::MASK] = compress(a) | (compress(b) << 32);
+        }
+    }
+}
+
+bool MapPyramid::blocked(unsigned int level, int x, int y) const
+{
+    if (level >= layers_.size()) return true;
+    const Layer& layer = layers_[level];
+    if (x < 0 || y < 0 || x >= layer.width || y >= layer.height) return true;
+    return (layer.word(x >> tiles::SHIFT, y) >> (x & tiles::MASK)) & 1;
+}
+
+bool MapPyramid::blockedAt(uint32_t idx) const
+{
+    if (layers_.empty()) return true;
+    const int width = layers_[0].width;
+    return blocked(0, static_cast<int>(idx % width), static_cast<int>(idx / width));
+}
+
+unsigned int MapPyramid::levels() const
+{
+    return layers_.size();
+}
+
+int MapPyramid::width(unsigned int level) const
+{
+    return level < layers_.size() ? layers_[level].width : 0;
+}
+
+int MapPyramid::height(unsigned int level) const
+{
+    return level < layers_.size() ? layers_[level].height : 0;
+}
+
+size_t MapPyramid::bytes() const
+{
+    size_t total = 0;
+    for (const auto& layer : layers_) total += layer.bits.size() * sizeof(Tile);
+    return total;
+}
+
+bool MapPyramid::empty() const
+{
+    return layers_.empty();
+}
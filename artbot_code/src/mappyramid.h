@@ -0,0 +1,98 @@
+#ifndef MAPPYRAMID_H
+#define MAPPYRAMID_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "nav_msgs/OccupancyGrid.h"
+#include "cowtiles.h"
+#include "mapregion.h"
+
+/*!
+ *  \brief     Map Pyramid Class
+ *  \details
+ *  Holds an occupancy grid as a stack of bit-packed layers, built once per map.
+ *  The base layer keeps one bit per cell, set when the cell is not known free, so it takes an
+ *  eighth of the memory of the grid itself. Each coarser layer halves the width and height and is
+ *  max-pooled from the one below: a coarse cell is blocked if any cell under it is, so a free coarse
+ *  cell is a block of base cells that are all free, and planners can search a coarse layer before refining.
+ *  Each layer is held in copy on write tiles, one 64 bit word per row of a tile, so a copy updated for a
+ *  patched map only owns the tiles under the patch.
+ *  @sa GridPlanner PathPlanning
+ *  \version   1.00
+ */
+class MapPyramid
+{
+public:
+  /// @brief Constructor for an empty pyramid
+  /// @param [in] levels - most layers built, including the base
+  MapPyramid(unsigned int levels = 6);
+
+  /// @brief Rebuilds every layer from a map
+  /// @param [in] map - the occupancy grid
+  void build(const nav_msgs::OccupancyGrid& map);
+
+  /// @brief Brings every layer up to date with a map which only differs from the last one inside a region
+  ///
+  /// Only the words over the region are packed and pooled again. A map of another size is built in full.
+  /// @param [in] map - the occupancy grid
+  /// @param [in] region - the cells which may have changed
+  void update(const nav_msgs::OccupancyGrid& map, const MapRegion& region);
+
+  /// @brief Checks if a cell of a layer is blocked
+  /// @param [in] level - the layer, 0 is the base
+  /// @param [in] x - column of the cell in the layer
+  /// @param [in] y - row of the cell in the layer
+  /// @return true if any base cell under it is not known free, or it is outside the layer
+  bool blocked(unsigned int level, int x, int y) const;
+
+  /// @brief Checks if a base cell is blocked by its linear index
+  bool blockedAt(uint32_t idx) const;
+
+  /// @brief Getter for the number of layers built
+  unsigned int levels() const;
+
+  /// @brief Getter for the width of a layer [cells]
+  int width(unsigned int level) const;
+
+  /// @brief Getter for the height of a layer [cells]
+  int height(unsigned int level) const;
+
+  /// @brief Getter for the memory held by the layers [bytes]
+  size_t bytes() const;
+
+  /// @brief Checks if the pyramid has been built
+  bool empty() const;
+
+private:
+  //! Row y % 64 of a tile, bit x % 64 is set when the cell is blocked
+  typedef std::array<uint64_t, tiles::SIZE> Tile;
+
+  struct Layer
+  {
+    int width;
+    int height;
+    //! Tile column w holds the word of columns 64 w to 64 w + 63 of each row
+    CowTiles<Tile> bits;
+
+    /// @brief Getter for the word holding columns 64 w to 64 w + 63 of row y
+    uint64_t word(int w, int y) const
+    {
+      return bits.tile(w, y >> tiles::SHIFT)[y & tiles::MASK];
+    }
+  };
+
+  /// @brief Packs rows y0 to y1 of the map into words w0 to w1 of the base layer
+  void pack(const nav_msgs::OccupancyGrid& map, Layer& base, int y0, int y1, int w0, int w1) const;
+
+  /// @brief Sets words w0 to w1 of rows y0 to y1 of a layer from the 2x2 cells under each cell in the layer below
+  void pool(const Layer& fine, Layer& coarse, int y0, int y1, int w0, int w1) const;
+
+  //! Most layers built
+  unsigned int maxLevels_;
+  //! The layers, base first
+  std::vector<Layer> layers_;
+};
+
+#endif // MAPPYRAMID_H
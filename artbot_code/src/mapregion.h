@@ -0,0 +1,50 @@
+#ifndef MAPREGION_H
+#define MAPREGION_H
+
+#include <algorithm>
+
+/*!
+ *  \brief     Map Region Struct
+ *  \details
+ *  Rectangle of cells of an occupancy grid, both corners included, as patched by a map update.
+ *  A default region is empty, and the union with an empty region is the other region.
+ *  @sa ClearanceMap MapPyramid FreeSpaceIndex SharedMap
+ *  \version   1.00
+ */
+struct MapRegion
+{
+  /// @brief Constructor for an empty region
+  MapRegion() : x0(0), y0(0), x1(-1), y1(-1) {}
+
+  /// @brief Constructor for the region between two corners, both included
+  MapRegion(int ix0, int iy0, int ix1, int iy1) : x0(ix0), y0(iy0), x1(ix1), y1(iy1) {}
+
+  int x0;
+  int y0;
+  int x1;
+  int y1;
+
+  /// @brief Checks if the region holds no cell
+  bool empty() const
+  {
+    return x1 < x0 || y1 < y0;
+  }
+
+  /// @brief Smallest region holding both regions
+  MapRegion united(const MapRegion& other) const
+  {
+    if (empty()) return other;
+    if (other.empty()) return *this;
+    return MapRegion(std::min(x0, other.x0), std::min(y0, other.y0), std::max(x1, other.x1), std::max(y1, other.y1));
+  }
+
+  /// @brief The region grown by a number of cells on every side and clipped to a grid
+  MapRegion grown(int cells, int width, int height) const
+  {
+    if (empty()) return *this;
+    return MapRegion(std::max(0, x0 - cells), std::max(0, y0 - cells), std::min(width - 1, x1 + cells),
+                     std::min(height - 1, y1 + cells));
+  }
+};
+
+#endif // MAPREGION_H
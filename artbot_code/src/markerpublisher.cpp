@@ -0,0 +1,104 @@
+#include "markerpublisher.h"
+
+namespace {
+    //Checks if two point lists hold the same points in the same order
+    bool samePoints(const std::vector<geometry_msgs::Point>& a, const std::vector<geometry_msgs::Point>& b)
+    {
+        if(a.size() != b.size()) return false;
+        for(size_t i = 0; i < a.size(); i++){
+            if(a[i].x != b[i].x || a[i].y != b[i].y || a[i].z != b[i].z) return false;
+        }
+        return true;
+    }
+}
+
+MarkerPublisher::MarkerPublisher():
+    lookaheadPeriod_(0.0)
+{
+}
+
+MarkerPublisher::MarkerPublisher(ros::NodeHandle nh, double lookaheadRate):
+    lookaheadPeriod_(lookaheadRate > 0.0 ? 1.0 / lookaheadRate : 0.0)
+{
+    pubShapes_ = nh.advertise<visualization_msgs::MarkerArray>("visualization_marker", 3, true);
+    pubLookahead_ = nh.advertise<visualization_msgs::Marker>("lookahead_marker", 3, false);
+}
+
+void MarkerPublisher::setGoals(const std::vector<geometry_msgs::Point>& goals)
+{
+    if(samePoints(goals, goals_)) return;
+    goals_ = goals;
+    publishShapes();
+}
+
+void MarkerPublisher::setPath(const squiggles::TrajectoryView& path)
+{
+    // Compared in place so an unchanged path costs no copy
+    bool same = path.size == path_.size();
+    for(size_t i = 0; same && i < path.size; i++){
+        same = path.x[i] == path_[i].x && path.y[i] == path_[i].y;
+    }
+    if(same) return;
+
+    path_.resize(path.size);
+    for(size_t i = 0; i < path.size; i++){
+        path_[i].x = path.x[i];
+        path_[i].y = path.y[i];
+        path_[i].z = 0.0;
+    }
+    publishShapes();
+}
+
+void MarkerPublisher::setLookahead(const geometry_msgs::Point& point)
+{
+    ros::Time now = ros::Time::now();
+    if(!lastLookahead_.isZero() && (now - lastLookahead_).toSec() < lookaheadPeriod_) return;
+    lastLookahead_ = now;
+
+    visualization_msgs::Marker marker;
+    fillMarker(marker, LOOKAHEAD, visualization_msgs::Marker::CYLINDER, 0.0, 1.0, 0.0);
+    marker.pose.position = point;
+    pubLookahead_.publish(marker);
+}
+
+void MarkerPublisher::publishShapes()
+{
+    visualization_msgs::MarkerArray markerArray;
+
+    visualization_msgs::Marker goals;
+    fillMarker(goals, GOALS, visualization_msgs::Marker::SPHERE_LIST, 1.0, 0.0, 0.0);
+    goals.points = goals_;
+    if(goals_.empty()) goals.action = visualization_msgs::Marker::DELETE;
+    markerArray.markers.push_back(goals);
+
+    // A line strip needs two points to be drawn
+    visualization_msgs::Marker path;
+    fillMarker(path, PATH, visualization_msgs::Marker::LINE_STRIP, 1.0, 0.0, 0.0);
+    path.scale.x = 0.03;
+    path.points = path_;
+    if(path_.size() < 2) path.action = visualization_msgs::Marker::DELETE;
+    markerArray.markers.push_back(path);
+
+    pubShapes_.publish(markerArray);
+}
+
+void MarkerPublisher::fillMarker(visualization_msgs::Marker& marker, MarkerId id, int type, double r, double g, double b) const
+{
+    marker.header.frame_id = "map";
+    marker.header.stamp = ros::Time::now();
+    marker.ns = "artbot";
+    marker.id = id;
+    marker.type = type;
+    marker.action = visualization_msgs::Marker::ADD;
+    //Zero lifetime keeps the marker until it is replaced
+    marker.lifetime = ros::Duration(0.0);
+    marker.scale.x = 0.1;
+    marker.scale.y = 0.1;
+    marker.scale.z = 0.1;
+    marker.pose.orientation.w = 1.0;
+    //Colour is r,g,b where each channel of colour is 0-1, 50% transparent
+    marker.color.r = r;
+    marker.color.g = g;
+    marker.color.b = b;
+    marker.color.a = 0.5f;
+}
@@ -0,0 +1,67 @@
+#ifndef MARKERPUBLISHER_H
+#define MARKERPUBLISHER_H
+
+#include "ros/ros.h"
+#include <vector>
+#include "geometry_msgs/Point.h"
+#include "visualization_msgs/MarkerArray.h"
+#include "squiggles.hpp"
+
+/*!
+ *  \brief     Marker Publisher Class
+ *  \details
+ *  Publishes the goals, path and lookahead point to RViz with a fixed id for each, so a marker is
+ *  replaced in place rather than re-sent with a short lifetime every cycle.
+ *  The goals and spline path are one marker each, published latched on visualization_marker only when
+ *  they change. The lookahead point moves every cycle, so it has its own topic and is rate limited.
+ *  @sa Sample
+ *  \version   1.00
+ */
+class MarkerPublisher
+{
+public:
+  /// @brief Default constructor, nothing is published until constructed with a node handle
+  MarkerPublisher();
+
+  /// @brief Constructor for the marker publisher
+  /// @param [in] nh - node handle the topics are advertised on
+  /// @param [in] lookaheadRate - most lookahead markers published per second
+  MarkerPublisher(ros::NodeHandle nh, double lookaheadRate);
+
+  /// @brief Shows the goals, publishes only if they differ from those shown
+  /// @param [in] goals - the goals, none removes the marker
+  void setGoals(const std::vector<geometry_msgs::Point>& goals);
+
+  /// @brief Shows the spline path as a line, publishes only if it differs from the one shown
+  /// @param [in] path - the path, an empty path removes the marker
+  void setPath(const squiggles::TrajectoryView& path);
+
+  /// @brief Moves the lookahead marker, skipped if the last one was published too recently
+  /// @param [in] point - the lookahead point
+  void setLookahead(const geometry_msgs::Point& point);
+
+private:
+  //! Ids of the markers, each is replaced in place
+  enum MarkerId {GOALS = 0, PATH = 1, LOOKAHEAD = 2};
+
+  /// @brief Publishes the goals and path markers together so the latched message holds both
+  void publishShapes();
+
+  /// @brief Fills a marker shared by every shape
+  void fillMarker(visualization_msgs::Marker& marker, MarkerId id, int type, double r, double g, double b) const;
+
+  //! Goals and path publisher, latched
+  ros::Publisher pubShapes_;
+  //! Lookahead publisher
+  ros::Publisher pubLookahead_;
+  //! Goals shown
+  std::vector<geometry_msgs::Point> goals_;
+  //! Path shown
+  std::vector<geometry_msgs::Point> path_;
+  //! Shortest time between lookahead markers [s]
+  double lookaheadPeriod_;
+  //! Time the last lookahead marker was published
+  ros::Time lastLookahead_;
+};
+
+#endif // MARKERPUBLISHER_H
@@ -0,0 +1,47 @@
+#include "navfnplanner.h"
+
+NavfnPlanner::NavfnPlanner()
+{
+}
+
+NavfnPlanner::NavfnPlanner(ros::NodeHandle nh, double robotRadius):
+    pathSimplifier_(robotRadius)
+{
+    makePlan_ = nh.serviceClient<nav_msgs::GetPlan>("move_base/NavfnROS/make_plan");
+}
+
+bool NavfnPlanner::plan(const geometry_msgs::Point& st, const geometry_msgs::Point& en, const ClearanceMap* clearanceMap,
+                        std::vector<geometry_msgs::Point>& waypoints)
+{
+    waypoints.clear();
+
+    // Create a request message for the service
+    nav_msgs::GetPlan srv;
+    srv.request.start.header.frame_id = "map";
+    srv.request.start.pose.position.x = st.x;
+    srv.request.start.pose.position.y = st.y;
+    srv.request.start.pose.orientation.w = 1.0;
+
+    srv.request.goal.header.frame_id = "map";
+    srv.request.goal.pose.position.x = en.x;
+    srv.request.goal.pose.position.y = en.y;
+    srv.request.goal.pose.orientation.w = 1.0;
+
+    if(!makePlan_.isValid() || !makePlan_.call(srv)){
+        ROS_ERROR("Failed to call service make_plan");
+        return false;
+    }
+    if(srv.response.plan.poses.empty()){
+        ROS_WARN("Received an empty plan from make_plan");
+        return false;
+    }
+    ROS_INFO("Plan received with %ld poses", srv.response.plan.poses.size());
+
+    raw_.clear();
+    for(const auto& pose : srv.response.plan.poses) raw_.push_back(pose.pose.position);
+    // keeps the fewest points that stay within the error bound of the plan
+    pathSimplifier_.simplify(raw_, clearanceMap, waypoints);
+    // the leg always ends at the goal
+    if(!(waypoints.back() == en)) waypoints.push_back(en);
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef NAVFNPLANNER_H
+#define NAVFNPLANNER_H
+
+#include <vector>
+#include "ros/ros.h"
+#include <geometry_msgs/Point.h>
+#include <nav_msgs/GetPlan.h>
+#include "clearancemap.h"
+#include "pathsimplifier.h"
+
+/*!
+ *  \brief     Navfn Planner Class
+ *  \details
+ *  Asks move_base for a plan on /move_base/NavfnROS/make_plan, for the legs the grid planner finds no path for.
+ *  The dense plan is simplified to the fewest waypoints within the error bound of PathSimplifier.
+ *  @sa PathPlanning
+ *  \version   1.00
+ */
+class NavfnPlanner
+{
+public:
+  /// @brief Default constructor, plan() fails until constructed with a node handle
+  NavfnPlanner();
+
+  /// @brief Constructor for the navfn planner
+  /// @param [in] nh - node handle the service client is created on
+  /// @param [in] robotRadius - simplified segments keep at least this clearance [m]
+  NavfnPlanner(ros::NodeHandle nh, double robotRadius);
+
+  /// @brief Plans a path between two points with the make_plan service
+  /// @param [in] st - the start [m]
+  /// @param [in] en - the end [m]
+  /// @param [in] clearanceMap - clearance of the map for the simplifier, nullptr when there is none
+  /// @param [out] waypoints - waypoints along the path, ending at en
+  /// @return false if the service could not be called or returned an empty plan
+  bool plan(const geometry_msgs::Point& st, const geometry_msgs::Point& en, const ClearanceMap* clearanceMap,
+            std::vector<geometry_msgs::Point>& waypoints);
+
+private:
+  //! Make Plan
+  ros::ServiceClient makePlan_;
+  //! Simplifies the plans returned by NavfnROS
+  PathSimplifier pathSimplifier_;
+  //! Poses of the last plan, kept between calls
+  std::vector<geometry_msgs::Point> raw_;
+};
+
+#endif // NAVFNPLANNER_H
@@ -7,41 +7,61 @@
 #include <chrono>
 #include <time.h>
 #include <random>
+#include <utility>
 
 using namespace std;
 
-//Default constructor of Laserprocessing, needs an initial set of laser data to be initialised
-PathPlanning::PathPlanning(int map_width, int map_height, double map_resolution,
-                           double map_origin_x, double map_origin_y, std::vector<int8_t> map_data, double world_x, double world_y):
-                           map_width_(map_width), map_height_(map_height), map_resolution_(map_resolution),
-                           map_origin_x_(map_origin_x), map_origin_y_(map_origin_y), map_data_(map_data), world_x_(world_x),world_y_(world_y)
+//Constructor of PathPlanning, needs the occupancy grid it will plan on
+PathPlanning::PathPlanning(const nav_msgs::OccupancyGrid::ConstPtr& map, double goalClearance, double world_x, double world_y,
+                           unsigned int seed):
+                           map_width_(map->info.width), map_height_(map->info.height), map_resolution_(map->info.resolution),
+                           map_origin_x_(map->info.origin.position.x), map_origin_y_(map->info.origin.position.y),
+                           goalClearance_(goalClearance),
+                           gridPlanner_(goalClearance), tourPlanner_(goalClearance), gen_(seed), world_x_(world_x),world_y_(world_y)
     {
+        // Built by the first planner in the process to ask for this map, every other one shares it
+        shared_ = SharedMap::acquire(map, goalClearance_, GOAL_BOUNDS_, GOAL_MARGIN_CELLS_);
+        clearanceMap_ = shared_->clearanceMap();
+        pyramid_ = shared_->pyramid();
+        gridPlanner_.setMap(clearanceMap_, pyramid_);
+    }
 
+PathPlanning::PathPlanning(PathPlanning& previous, const nav_msgs::OccupancyGrid::ConstPtr& map, const MapRegion& region):
+                           map_width_(map->info.width), map_height_(map->info.height), map_resolution_(map->info.resolution),
+                           map_origin_x_(map->info.origin.position.x), map_origin_y_(map->info.origin.position.y),
+                           goalClearance_(previous.goalClearance_),
+                           gridPlanner_(std::move(previous.gridPlanner_)), tourPlanner_(std::move(previous.tourPlanner_)),
+                           gen_(previous.gen_),
+                           world_x_(previous.world_x_), world_y_(previous.world_y_)
+    {
+        shared_ = SharedMap::patch(previous.shared_, map, region);
+        clearanceMap_ = shared_->clearanceMap();
+        pyramid_ = shared_->pyramid();
+        gridPlanner_.setMap(clearanceMap_, pyramid_);
     }
 
 PathPlanning::~PathPlanning(){
 
 }
 
-void PathPlanning::generateRandomGoal(std::vector<geometry_msgs::PoseStamped>& unordered_goals, geometry_msgs::Pose robotPose)
+bool PathPlanning::generateRandomGoal(std::vector<geometry_msgs::PoseStamped>& unordered_goals, geometry_msgs::Pose robotPose)
 {
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    // uint32_t idx;
-
-    while (true) {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<> grid_x(10, map_width_-10); // 5
-        std::uniform_real_distribution<> grid_y(10, map_height_-10);
-        double map_x = grid_x(gen);
-        double map_y = grid_y(gen);
-
-        if (isGoalValid(map_x, map_y, unordered_goals, robotPose))
-        {   
-            //std::cout << "map_x: " << map_x << ", map_y: " << map_y << "} is a valid goal." << std::endl;
-            //std::cout << " Random Goal { " << world_x << " , " << world_y << " } is valid." << std::endl;
-            break;
-        }
+    if (shared_->freeSpace().empty())
+    {
+        ROS_WARN("No free cell on the map can hold a goal");
+        return false;
+    }
+
+    // Every indexed cell is already valid, only the distance to the robot can reject a draw
+    bool found = false;
+    for (unsigned int i = 0; i < GOAL_MAX_DRAWS_ && !found; i++) {
+        uint32_t idx = shared_->freeSpace().sample(gen_);
+        found = isGoalValid(idx % map_width_, idx / map_width_, unordered_goals, robotPose);
+    }
+    if (!found)
+    {
+        ROS_WARN("No free cell is far enough from the robot to hold a goal");
+        return false;
     }
 
     // Put the goal point in PoseStamped format
@@ -57,70 +77,84 @@ void PathPlanning::generateRandomGoal(std::vector<geometry_msgs::PoseStamped>& u
     unordered_goals.push_back(currentgoal);
     // unordered_goals = unordered_goals_;
     std::cout << "Goal {" << world_x_ << " , " << world_y_ << " } has been pushed into unordered vector." << std::endl;
+    return true;
 }
 
-bool PathPlanning::isGoalValid(double x, double y, std::vector<geometry_msgs::PoseStamped>& unordered_goals, geometry_msgs::Pose robotPose)
+bool PathPlanning::planPath(const geometry_msgs::Point& st, const geometry_msgs::Point& en, std::vector<geometry_msgs::Point>& waypoints)
 {
-    world_x_ = map_origin_x_ + (x) * map_resolution_; // (x+ 0.5)
-    world_y_ = map_origin_y_ + (y) * map_resolution_;
-    // Check if the goal point is a threshold distance away from obstacles
-        //int map_x = (x - map_origin_x_) / map_resolution_;
-        //int map_y = (y - map_origin_y_) / map_resolution_;
-
-    // // Convert world coordinates to map indices
-    // int map_x = (x - map_origin_x_) / map_resolution_;
-    // int map_y = (y - map_origin_y_) / map_resolution_;
-    
-    // // Check if the map indices are within the map boundaries
-    // if (map_x < 0 || map_x >= map_width_ || map_y < 0 || map_y >= map_height_)
-    // {
-    //     return false;
-    // }
-
-    uint32_t idx = x + y * map_width_;
-    // std::cout << "Index is: " << idx << std::endl;
-    //int index = map_y * map_width_ + map_x;
-    if (idx >= 0 && idx < map_data_.size()) 
+    return gridPlanner_.plan(st, en, waypoints);
+}
+
+bool PathPlanning::planTour(const geometry_msgs::Point& st, const std::vector<geometry_msgs::PoseStamped>& goals,
+                            std::vector<unsigned int>& order, std::vector<geometry_msgs::Point>& waypoints)
+{
+    std::vector<geometry_msgs::Point> points;
+    for (const auto& goal : goals) points.push_back(goal.pose.position);
+    bool planned = tourPlanner_.plan(clearanceMap_, st, points, pyramid_);
+    order = tourPlanner_.order();
+    waypoints = tourPlanner_.waypoints();
+    return planned;
+}
+
+bool PathPlanning::planRandomTour(const geometry_msgs::Pose& robotPose, int numGoals, NavfnPlanner* fallback,
+                                  std::vector<geometry_msgs::Point>& goals, std::vector<geometry_msgs::Point>& waypoints)
+{
+    goals.clear();
+    waypoints.clear();
+    std::vector<geometry_msgs::PoseStamped> unordered_goals;
+    for (int i = 0; i < numGoals; i++)
     {
-        bool withinBounds = false;
-        bool freeSpace = false;
-        bool neighboursUnoccupied = true; // assume unoccupied 
-        bool withinThreshold = false; // TO ADD
-        if(world_x_ >= 0 && world_x_ <= 7 && world_y_ >= -2.5 && world_y_ <= 0)
-        {
-            withinBounds = true;
-        }
-        if (map_data_[idx] == 0)
-        {
-            freeSpace = true;
-        }
-        for (int i = idx-100; i <= idx+100; ++i) // for data 100 to right and 100 to left
-        {
-            if(!(map_data_[idx] == 0))
-            {
-                neighboursUnoccupied = false;
-                break;
-            }
-        }
-        if(DistanceToGoal(world_x_, world_y_, robotPose) > 0.75)
-        {
-            withinThreshold = true;
-        }
+        if (!generateRandomGoal(unordered_goals, robotPose)) break;
+    }
+    if (unordered_goals.empty()) return false;
 
+    geometry_msgs::Point start;
+    start.x = robotPose.position.x; start.y = robotPose.position.y; // the tour starts at the robot
 
-        if(withinBounds && freeSpace && neighboursUnoccupied && withinThreshold)
-        {
-            //std::cout <<  "If 0, free space: " << map_data_[idx] << std::endl; 
-            //std::cout << "Goal VALID as free space, within bounds and distance threshold and neighbours cells are unoccupied." << std::endl;
-            return true;
-        }
-        else
+    // Orders the goals into a short tour, with every leg planned in process
+    std::vector<unsigned int> order;
+    if (planTour(start, unordered_goals, order, waypoints))
+    {
+        for (unsigned int i : order) goals.push_back(unordered_goals[i].pose.position);
+        ROS_INFO("Tour of %ld goals planned with %ld waypoints", goals.size(), waypoints.size());
+        return true;
+    }
+    if (fallback == nullptr)
+    {
+        ROS_WARN("No tour could be planned in process");
+        return false;
+    }
+
+    // Otherwise the goals are visited in the order they were drawn, one leg at a time
+    ROS_WARN("No tour could be planned in process, planning each leg in turn");
+    std::vector<geometry_msgs::Point> leg;
+    for (const auto& goal : unordered_goals)
+    {
+        const geometry_msgs::Point& end = goal.pose.position;
+        if (!fallback->plan(start, end, clearanceMap_->empty() ? nullptr : clearanceMap_.get(), leg))
         {
-            //std::cout << "Goal inside obstacle, out of bounds or distance threshold, unknown, or neigbouring cells occupied." << std::endl;
-            return false; // Goal point is inside an obstacle
-            generateRandomGoal(unordered_goals, robotPose); // generate another random goal
+            ROS_WARN("Goal {%f , %f} cannot be reached, leaving it out of the tour", end.x, end.y);
+            continue;
         }
+        waypoints.insert(waypoints.end(), leg.begin(), leg.end());
+        goals.push_back(end);
+        start = end;
     }
+    return !goals.empty();
+}
+
+bool PathPlanning::isGoalValid(double x, double y, std::vector<geometry_msgs::PoseStamped>& unordered_goals, geometry_msgs::Pose robotPose)
+{
+    // Goals are placed at the centre of their cell
+    world_x_ = map_origin_x_ + (x + 0.5) * map_resolution_;
+    world_y_ = map_origin_y_ + (y + 0.5) * map_resolution_;
+
+    if (x < 0 || y < 0 || x >= map_width_ || y >= map_height_) return false;
+    uint32_t idx = static_cast<uint32_t>(x) + static_cast<uint32_t>(y) * map_width_;
+
+    // The index holds the cells inside the bounds, free and clear of obstacles
+    if (!shared_->freeSpace().contains(idx)) return false;
+    return DistanceToGoal(world_x_, world_y_, robotPose) > GOAL_MIN_DISTANCE_;
 }
 
 // void PathPlanning::generateRandomGoals()
@@ -185,4 +219,13 @@ double PathPlanning::DistanceToGoal(double goal_x, double goal_y, geometry_msgs:
     //finds the difference in x and y and get the hypotenuse between the two points
     double dist = sqrt(pow(goal_x-robot.position.x,2)+pow(goal_y-robot.position.y,2));
     return dist;
-}
\ No newline at end of file
+}
+const std::shared_ptr<const SharedMap>& PathPlanning::sharedMap() const
+{
+    return shared_;
+}
+
+const std::shared_ptr<const ClearanceMap>& PathPlanning::clearanceMap() const
+{
+    return clearanceMap_;
+}
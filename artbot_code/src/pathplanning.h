@@ -6,6 +6,13 @@
 #include "ros/ros.h"
 #include "std_msgs/Header.h"
 #include <geometry_msgs/PoseStamped.h>
+#include "nav_msgs/OccupancyGrid.h"
+#include <random>
+#include <memory>
+#include "sharedmap.h"
+#include "gridplanner.h"
+#include "tourplanner.h"
+#include "navfnplanner.h"
 // #include <geometry_msgs/Twist.h>
 
 /*!
@@ -22,28 +29,111 @@ class PathPlanning
 {
 public:
   /// @brief Constructor for path planning
-  PathPlanning(int map_width, int map_height, double map_resolution,
-                           double map_origin_x, double map_origin_y, std::vector<int8_t> map_data, double world_x, double world_y);
+  ///
+  /// The occupancy grid is only read while its products are built and is not held afterwards. Its clearance map,
+  /// the map pyramid the grid planners search coarse to fine and the index of the cells that can hold a goal are
+  /// taken from SharedMap, so they are built once per map for every planner in the process.
+  /// @param [in] map - the occupancy grid received on /map
+  /// @param [in] goalClearance - goals are at least this far from any obstacle [m]
+  /// @param [in] seed - seed of the goal sampler, the same seed and map give the same goals
+  PathPlanning(const nav_msgs::OccupancyGrid::ConstPtr& map, double goalClearance, double world_x, double world_y,
+               unsigned int seed);
+
+  /// @brief Constructor for path planning on a map patched by a map update
+  ///
+  /// The products of the earlier planner's map are brought up to date over the patch rather than rebuilt, see
+  /// SharedMap::patch. The goal settings and the state of the goal sampler carry over, and the search buffers of
+  /// the earlier planner are taken over rather than allocated again for every cell, so it can only be destroyed.
+  /// @param [in|out] previous - the planner of the map the patch was applied to
+  /// @param [in] map - the patched occupancy grid
+  /// @param [in] region - the cells the patch covers
+  PathPlanning(PathPlanning& previous, const nav_msgs::OccupancyGrid::ConstPtr& map, const MapRegion& region);
 
   ~PathPlanning();
 
-  void generateRandomGoal(std::vector<geometry_msgs::PoseStamped>& unordered_goals, geometry_msgs::Pose robotPose);
+  /// @brief Draws a random valid goal and pushes it into unordered_goals
+  ///
+  /// @param [in|out] unordered_goals - the goals generated so far
+  /// @param [in] robotPose - the robot pose, goals are kept away from it
+  /// @return false if no valid goal could be found on the map, in which case nothing is pushed
+  bool generateRandomGoal(std::vector<geometry_msgs::PoseStamped>& unordered_goals, geometry_msgs::Pose robotPose);
+
+  /// @brief Plans a path between two points on the map with the in process grid planner
+  ///
+  /// @param [in] st - the start [m]
+  /// @param [in] en - the end [m]
+  /// @param [out] waypoints - waypoints along the path, ending at en
+  /// @return false if there is no path
+  bool planPath(const geometry_msgs::Point& st, const geometry_msgs::Point& en, std::vector<geometry_msgs::Point>& waypoints);
+
+  /// @brief Orders goals into a short tour from a start and plans every leg of it
+  ///
+  /// Goals which cannot be reached are left out.
+  /// @param [in] st - the start [m]
+  /// @param [in] goals - the goals to visit
+  /// @param [out] order - indices into goals in the order they are visited
+  /// @param [out] waypoints - waypoints of the whole tour, each leg ending at its goal
+  /// @return false if no goal can be reached
+  bool planTour(const geometry_msgs::Point& st, const std::vector<geometry_msgs::PoseStamped>& goals,
+                std::vector<unsigned int>& order, std::vector<geometry_msgs::Point>& waypoints);
+
+  /// @brief Draws random goals and plans a tour of them starting at the robot
+  ///
+  /// The goals are ordered into a short tour by planTour(). When the grid planner reaches none of them, they are
+  /// visited in the order drawn and each leg is asked of fallback instead.
+  /// Goals which cannot be reached are left out.
+  /// @param [in] robotPose - the robot pose, the tour starts here and goals are kept away from it
+  /// @param [in] numGoals - the number of goals drawn
+  /// @param [in] fallback - plans the legs the grid planner cannot, nullptr leaves those goals out
+  /// @param [out] goals - the goals reached, in the order they are visited
+  /// @param [out] waypoints - waypoints of the whole tour, each leg ending at its goal
+  /// @return false if no goal can be reached
+  bool planRandomTour(const geometry_msgs::Pose& robotPose, int numGoals, NavfnPlanner* fallback,
+                      std::vector<geometry_msgs::Point>& goals, std::vector<geometry_msgs::Point>& waypoints);
 
   bool isGoalValid(double x, double y, std::vector<geometry_msgs::PoseStamped>& unordered_goals, geometry_msgs::Pose robotPose);
 
   double DistanceToGoal(double goal_x, double goal_y, geometry_msgs::Pose robot);
 
+  /// @brief Getter for the map products shared with every planner of the map in the process
+  const std::shared_ptr<const SharedMap>& sharedMap() const;
+
+  /// @brief Getter for the clearance of the map
+  const std::shared_ptr<const ClearanceMap>& clearanceMap() const;
+
 private:
   int map_width_;
   int map_height_;
   double map_resolution_;
   double map_origin_x_;
   double map_origin_y_;
-  std::vector<int8_t> map_data_;
+  //! Clearance, pyramid and free space of the map, shared with every planner of the map in the process
+  std::shared_ptr<const SharedMap> shared_;
+  //! Clearance of the map
+  std::shared_ptr<const ClearanceMap> clearanceMap_;
+  //! Bit-packed layers of the map, shared with every grid planner
+  std::shared_ptr<const MapPyramid> pyramid_;
+  //! Goals are at least this far from any obstacle [m]
+  double goalClearance_;
+  //! Planner for the path between goals
+  GridPlanner gridPlanner_;
+  //! Planner ordering the goals
+  TourPlanner tourPlanner_;
+  //! Goal sampler, kept for the lifetime of the planner
+  std::mt19937 gen_;
   double world_x_;
   double world_y_;
   // std::vector<geometry_msgs::PoseStamped> unordered_goals_;
   std::vector<geometry_msgs::PoseStamped> ordered_goals_;
+
+  //! Box the goals have to lie in [m]
+  const FreeSpaceIndex::Bounds GOAL_BOUNDS_ = {0.0, 7.0, -2.5, 0.0};
+  //! Cells closer than this to the map edge never hold a goal
+  const unsigned int GOAL_MARGIN_CELLS_ = 10;
+  //! Goals closer than this to the robot are rejected [m]
+  const double GOAL_MIN_DISTANCE_ = 0.75;
+  //! Draws before giving up when every indexed cell is too close to the robot
+  const unsigned int GOAL_MAX_DRAWS_ = 1000;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "pathsimplifier.h"
+#include <algorithm>
+#include <cmath>
+
+PathSimplifier::PathSimplifier(double robotRadius, double minTolerance, double maxTolerance):
+    robotRadius_(robotRadius), minTolerance_(minTolerance), maxTolerance_(maxTolerance)
+{
+}
+
+void PathSimplifier::simplify(const std::vector<geometry_msgs::Point>& raw, const ClearanceMap* clearanceMap,
+                              std::vector<geometry_msgs::Point>& simplified)
+{
+    simplified.clear();
+    const size_t n = raw.size();
+    if (n <= 2) {
+        simplified = raw;
+        return;
+    }
+
+    keep_.assign(n, 0);
+    tolerance_.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        double tolerance = minTolerance_;
+        if (clearanceMap != nullptr) {
+            tolerance = clearanceMap->clearance(raw[i].x, raw[i].y) - robotRadius_;
+        }
+        tolerance_[i] = static_cast<float>(std::min(std::max(tolerance, minTolerance_), maxTolerance_));
+    }
+
+    keep_[0] = 1;
+    keep_[n - 1] = 1;
+    stack_.clear();
+    stack_.push_back(std::make_pair(size_t(0), n - 1));
+    while (!stack_.empty()) {
+        const size_t first = stack_.back().first;
+        const size_t last = stack_.back().second;
+        stack_.pop_back();
+        if (last <= first + 1) continue;
+
+        // Finds the point exceeding its tolerance by the most, measured from the chord
+        const double ax = raw[first].x, ay = raw[first].y;
+        const double dx = raw[last].x - ax, dy = raw[last].y - ay;
+        const double length2 = dx * dx + dy * dy;
+        size_t worst = first + 1;
+        double worstExcess = -1.0;
+        double farthest = -1.0;
+        size_t farthestIdx = first + 1;
+        for (size_t i = first + 1; i < last; i++) {
+            const double px = raw[i].x - ax, py = raw[i].y - ay;
+            double distance;
+            if (length2 <= 0.0) {
+                distance = std::sqrt(px * px + py * py);
+            }
+            else {
+                // Distance to the segment, not the infinite line, so points beyond either end count
+                double t = std::min(std::max((px * dx + py * dy) / length2, 0.0), 1.0);
+                distance = std::hypot(px - t * dx, py - t * dy);
+            }
+            double excess = distance - tolerance_[i];
+            if (excess > worstExcess) {
+                worstExcess = excess;
+                worst = i;
+            }
+            if (distance > farthest) {
+                farthest = distance;
+                farthestIdx = i;
+            }
+        }
+
+        // Splits where the bound is broken most, or at the farthest point if the chord would hit an obstacle
+        size_t split = 0;
+        if (worstExcess > 0.0) split = worst;
+        else if (clearanceMap != nullptr && !segmentClear(raw[first], raw[last], *clearanceMap)) split = farthestIdx;
+        if (split == 0) continue;
+
+        keep_[split] = 1;
+        stack_.push_back(std::make_pair(first, split));
+        stack_.push_back(std::make_pair(split, last));
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (keep_[i]) simplified.push_back(raw[i]);
+    }
+}
+
+bool PathSimplifier::segmentClear(const geometry_msgs::Point& a, const geometry_msgs::Point& b, const ClearanceMap& clearanceMap) const
+{
+    // Sampled at half a cell so no cell along the segment is skipped
+    const double length = std::hypot(b.x - a.x, b.y - a.y);
+    const double step = std::max(clearanceMap.resolution() * 0.5, 1e-3);
+    const int samples = static_cast<int>(std::ceil(length / step));
+    for (int i = 1; i < samples; i++) {
+        double t = static_cast<double>(i) / samples;
+        if (!clearanceMap.isClear(a.x + t * (b.x - a.x), a.y + t * (b.y - a.y), robotRadius_)) return false;
+    }
+    return true;
+}
@@ -0,0 +1,51 @@
+#ifndef PATHSIMPLIFIER_H
+#define PATHSIMPLIFIER_H
+
+#include <cstdint>
+#include <vector>
+#include <geometry_msgs/Point.h>
+#include "clearancemap.h"
+
+/*!
+ *  \brief     Path Simplifier Class
+ *  \details
+ *  Reduces a dense path to the fewest waypoints within an error bound, using Ramer-Douglas-Peucker.
+ *  The bound is clearance aware: a point may be cut by at most its clearance beyond the robot radius,
+ *  clamped between a minimum and maximum tolerance, so open space is straightened while detail is kept
+ *  in tight gaps. A straightened segment is also checked to keep the robot radius from every obstacle.
+ *  The working buffers are kept between calls.
+ *  @sa GridPlanner
+ *  \version   1.00
+ */
+class PathSimplifier
+{
+public:
+  /// @brief Constructor for the path simplifier
+  /// @param [in] robotRadius - straightened segments keep at least this clearance [m]
+  /// @param [in] minTolerance - points may always be cut by this much [m]
+  /// @param [in] maxTolerance - points are never cut by more than this [m]
+  PathSimplifier(double robotRadius = 0.15, double minTolerance = 0.02, double maxTolerance = 0.1);
+
+  /// @brief Simplifies a path, the first and last points are always kept
+  /// @param [in] raw - the dense path
+  /// @param [in] clearanceMap - clearance of the map, nullptr uses the minimum tolerance and skips the segment check
+  /// @param [out] simplified - the kept points, in order
+  void simplify(const std::vector<geometry_msgs::Point>& raw, const ClearanceMap* clearanceMap,
+                std::vector<geometry_msgs::Point>& simplified);
+
+private:
+  /// @brief Checks if the straight segment between two points keeps the robot radius from obstacles
+  bool segmentClear(const geometry_msgs::Point& a, const geometry_msgs::Point& b, const ClearanceMap& clearanceMap) const;
+
+  double robotRadius_;
+  double minTolerance_;
+  double maxTolerance_;
+  //! Non zero for the points kept
+  std::vector<uint8_t> keep_;
+  //! Allowed deviation of every point
+  std::vector<float> tolerance_;
+  //! Ranges still to be simplified
+  std::vector<std::pair<size_t, size_t> > stack_;
+};
+
+#endif // PATHSIMPLIFIER_H
@@ -0,0 +1,113 @@
+#include "pathtracker.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+PathTracker::PathTracker(double searchWindow):
+    searchWindow_(searchWindow), segment_(0), progress_(0.0), lookSegment_(0)
+{
+}
+
+void PathTracker::setPath(const std::vector<geometry_msgs::Point>& path)
+{
+    points_ = path;
+    s_.resize(points_.size());
+    double s = 0.0;
+    for (size_t i = 0; i < points_.size(); i++) {
+        if (i > 0) s += std::hypot(points_[i].x - points_[i - 1].x, points_[i].y - points_[i - 1].y);
+        s_[i] = s;
+    }
+    reset();
+}
+
+void PathTracker::reset()
+{
+    segment_ = 0;
+    progress_ = 0.0;
+    lookSegment_ = 0;
+}
+
+double PathTracker::update(double x, double y)
+{
+    if (points_.size() < 2) return 0.0;
+
+    // Only segments starting within the window ahead of the last projection are searched
+    const double limit = progress_ + searchWindow_;
+    double bestDistance2 = std::numeric_limits<double>::infinity();
+    size_t bestSegment = segment_;
+    double bestS = progress_;
+    for (size_t k = segment_; k + 1 < points_.size() && s_[k] <= limit; k++) {
+        const double ax = points_[k].x, ay = points_[k].y;
+        const double dx = points_[k + 1].x - ax, dy = points_[k + 1].y - ay;
+        const double length2 = dx * dx + dy * dy;
+        double t = 0.0;
+        if (length2 > 0.0) t = std::min(std::max(((x - ax) * dx + (y - ay) * dy) / length2, 0.0), 1.0);
+        // The projection never moves back along the segment it was last on
+        double s = s_[k] + t * (s_[k + 1] - s_[k]);
+        if (k == segment_ && s < progress_) {
+            s = progress_;
+            t = s_[k + 1] > s_[k] ? (s - s_[k]) / (s_[k + 1] - s_[k]) : 0.0;
+        }
+        const double px = ax + t * dx - x, py = ay + t * dy - y;
+        const double distance2 = px * px + py * py;
+        if (distance2 < bestDistance2) {
+            bestDistance2 = distance2;
+            bestSegment = k;
+            bestS = s;
+        }
+    }
+    segment_ = bestSegment;
+    progress_ = bestS;
+    if (lookSegment_ < segment_) lookSegment_ = segment_;
+    return progress_;
+}
+
+geometry_msgs::Point PathTracker::lookahead(double distance)
+{
+    if (points_.empty()) return geometry_msgs::Point();
+    if (points_.size() == 1) return points_.front();
+
+    // The target only moves forward, so the cursor resumes from where it was
+    const double target = progress_ + distance;
+    if (target >= s_.back()) {
+        lookSegment_ = points_.size() - 2;
+        return points_.back();
+    }
+    while (lookSegment_ + 2 < points_.size() && s_[lookSegment_ + 1] < target) lookSegment_++;
+
+    const geometry_msgs::Point& a = points_[lookSegment_];
+    const geometry_msgs::Point& b = points_[lookSegment_ + 1];
+    const double span = s_[lookSegment_ + 1] - s_[lookSegment_];
+    const double t = span > 0.0 ? (target - s_[lookSegment_]) / span : 1.0;
+    geometry_msgs::Point point;
+    point.x = a.x + t * (b.x - a.x);
+    point.y = a.y + t * (b.y - a.y);
+    point.z = a.z + t * (b.z - a.z);
+    return point;
+}
+
+size_t PathTracker::lookaheadIndex() const
+{
+    if (points_.size() < 2) return 0;
+    return lookSegment_ + 1;
+}
+
+size_t PathTracker::segment() const
+{
+    return segment_;
+}
+
+double PathTracker::progress() const
+{
+    return progress_;
+}
+
+double PathTracker::length() const
+{
+    return s_.empty() ? 0.0 : s_.back();
+}
+
+bool PathTracker::empty() const
+{
+    return points_.empty();
+}
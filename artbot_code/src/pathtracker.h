@@ -0,0 +1,74 @@
+#ifndef PATHTRACKER_H
+#define PATHTRACKER_H
+
+#include <cstddef>
+#include <vector>
+#include <geometry_msgs/Point.h>
+
+/*!
+ *  \brief     Path Tracker Class
+ *  \details
+ *  Follows the robot's progress along a polyline path for pure pursuit.
+ *  The cumulative arc length of the path is computed once, then every update projects the robot
+ *  onto the segments just ahead of where it was last, using squared distances, and the lookahead
+ *  point is found by moving a second cursor forward along the arc length.
+ *  Progress only moves forward, so an update costs O(1) amortised however long the path is.
+ *  @sa Sample
+ *  \version   1.00
+ */
+class PathTracker
+{
+public:
+  /// @brief Constructor for the path tracker
+  /// @param [in] searchWindow - arc length ahead of the last projection searched for the new one [m]
+  PathTracker(double searchWindow = 1.5);
+
+  /// @brief Sets the path to follow and resets the progress to its start
+  /// @param [in] path - the points of the path, in order
+  void setPath(const std::vector<geometry_msgs::Point>& path);
+
+  /// @brief Resets the progress to the start of the path
+  void reset();
+
+  /// @brief Projects a position on to the path, ahead of the last projection
+  /// @param [in] x - x of the position [m]
+  /// @param [in] y - y of the position [m]
+  /// @return the arc length of the projection [m]
+  double update(double x, double y);
+
+  /// @brief Getter for the point a distance along the path from the last projection
+  /// @param [in] distance - the lookahead distance [m]
+  /// @return the point, the end of the path if it is closer than the distance
+  geometry_msgs::Point lookahead(double distance);
+
+  /// @brief Getter for the index of the path point ending the segment holding the last lookahead point
+  size_t lookaheadIndex() const;
+
+  /// @brief Getter for the index of the segment holding the last projection
+  size_t segment() const;
+
+  /// @brief Getter for the arc length of the last projection [m]
+  double progress() const;
+
+  /// @brief Getter for the length of the path [m]
+  double length() const;
+
+  /// @brief Checks if there is no path
+  bool empty() const;
+
+private:
+  //! Arc length ahead of the last projection searched [m]
+  double searchWindow_;
+  //! Points of the path
+  std::vector<geometry_msgs::Point> points_;
+  //! Arc length at each point [m]
+  std::vector<double> s_;
+  //! Segment holding the last projection
+  size_t segment_;
+  //! Arc length of the last projection [m]
+  double progress_;
+  //! Segment holding the last lookahead point
+  size_t lookSegment_;
+};
+
+#endif // PATHTRACKER_H
@@ -0,0 +1,111 @@
+#include "posepredictor.h"
+#include <algorithm>
+#include <cmath>
+#include "tf/transform_datatypes.h"
+
+namespace {
+    double wrap(double angle)
+    {
+        return std::atan2(std::sin(angle), std::cos(angle));
+    }
+}
+
+PosePredictor::PosePredictor(double maxExtrapolation, size_t historySize):
+    maxExtrapolation_(maxExtrapolation), history_(std::max<size_t>(historySize, 2)), head_(0), count_(0), state_()
+{
+    publish();
+}
+
+void PosePredictor::addOdometry(double stamp, const geometry_msgs::Pose& pose, double linear, double angular)
+{
+    std::unique_lock<std::mutex> lck(mtx_);
+    Odometry odometry{stamp, {pose.position.x, pose.position.y, tf::getYaw(pose.orientation)}, linear, angular};
+    // Messages out of order would break the interpolation, they are older than what is kept anyway
+    if (count_ > 0 && stamp < state_.latest.stamp) return;
+    if (count_ < history_.size()) {
+        history_[(head_ + count_) % history_.size()] = odometry;
+        count_++;
+    }
+    else {
+        history_[head_] = odometry;
+        head_ = (head_ + 1) % history_.size();
+    }
+    if (!state_.odometry) {
+        // A fix before any odometry is placed at the first message
+        state_.anchor = odometry.pose;
+        state_.odometry = true;
+    }
+    state_.latest = odometry;
+    publish();
+}
+
+void PosePredictor::addFix(double stamp, const geometry_msgs::Pose& pose)
+{
+    std::unique_lock<std::mutex> lck(mtx_);
+    state_.fix = {pose.position.x, pose.position.y, tf::getYaw(pose.orientation)};
+    state_.fixPose = pose;
+    if (state_.odometry) state_.anchor = stamp > 0.0 ? odometryAt(stamp) : state_.latest.pose;
+    state_.fixes++;
+    publish();
+}
+
+geometry_msgs::Pose PosePredictor::predict(double now) const
+{
+    const Prediction p = prediction_.load();
+    geometry_msgs::Pose pose = p.fixPose;
+    if (p.fixes == 0 || !p.odometry) return pose;
+
+    // The odometry driven since the fix, in the frame of the robot at the fix
+    const double dx = p.latest.pose.x - p.anchor.x;
+    const double dy = p.latest.pose.y - p.anchor.y;
+    const double c = std::cos(p.anchor.yaw), s = std::sin(p.anchor.yaw);
+    const double forward = c * dx + s * dy;
+    const double left = -s * dx + c * dy;
+    double x = p.fix.x + std::cos(p.fix.yaw) * forward - std::sin(p.fix.yaw) * left;
+    double y = p.fix.y + std::sin(p.fix.yaw) * forward + std::cos(p.fix.yaw) * left;
+    double yaw = p.fix.yaw + wrap(p.latest.pose.yaw - p.anchor.yaw);
+
+    // Carried on along the arc the robot was driving, for a short time so a lost odometry stream is not run away with
+    const double dt = std::min(std::max(now - p.latest.stamp, 0.0), maxExtrapolation_);
+    if (dt > 0.0) {
+        const double heading = yaw + 0.5 * p.latest.angular * dt;
+        x += p.latest.linear * dt * std::cos(heading);
+        y += p.latest.linear * dt * std::sin(heading);
+        yaw += p.latest.angular * dt;
+    }
+    pose.position.x = x;
+    pose.position.y = y;
+    if (yaw != p.fix.yaw) pose.orientation = tf::createQuaternionMsgFromYaw(wrap(yaw));
+    return pose;
+}
+
+unsigned int PosePredictor::fixes() const
+{
+    return prediction_.load().fixes;
+}
+
+PosePredictor::Planar PosePredictor::odometryAt(double stamp) const
+{
+    const Odometry& oldest = history_[head_];
+    const Odometry& newest = history_[(head_ + count_ - 1) % history_.size()];
+    if (stamp <= oldest.stamp) return oldest.pose;
+    if (stamp >= newest.stamp) return newest.pose;
+
+    // The stamps only increase round the ring, so the pair either side of the fix is found by bisection
+    size_t lo = 0, hi = count_ - 1;
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        if (history_[(head_ + mid) % history_.size()].stamp <= stamp) lo = mid;
+        else hi = mid;
+    }
+    const Odometry& a = history_[(head_ + lo) % history_.size()];
+    const Odometry& b = history_[(head_ + hi) % history_.size()];
+    const double f = b.stamp > a.stamp ? (stamp - a.stamp) / (b.stamp - a.stamp) : 0.0;
+    return {a.pose.x + f * (b.pose.x - a.pose.x), a.pose.y + f * (b.pose.y - a.pose.y),
+            a.pose.yaw + f * wrap(b.pose.yaw - a.pose.yaw)};
+}
+
+void PosePredictor::publish()
+{
+    prediction_.store(state_);
+}
@@ -0,0 +1,107 @@
+#ifndef POSEPREDICTOR_H
+#define POSEPREDICTOR_H
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include "geometry_msgs/Pose.h"
+#include "seqlock.h"
+
+/*!
+ *  \brief     Pose Predictor Class
+ *  \details
+ *  Predicts the robot's pose between localisation fixes from the odometry driven since.
+ *  The odometry of the last couple of seconds is kept, so when a fix arrives late the odometry pose at the
+ *  fix's timestamp is interpolated from it. The prediction is the fix moved by the odometry from that pose to
+ *  the latest one, then carried forward with the latest velocity for at most a short time.
+ *  The callbacks feeding it take a mutex between themselves, while predict() only reads the last prediction
+ *  through a SeqLock, so the control loop never blocks on them.
+ *  Without odometry the prediction is the last fix.
+ *  @sa Sample SeqLock
+ *  \version   1.00
+ */
+class PosePredictor
+{
+public:
+  /// @brief Constructor for the pose predictor
+  /// @param [in] maxExtrapolation - the latest odometry is carried forward for at most this long [s]
+  /// @param [in] historySize - odometry messages kept to place late fixes on
+  PosePredictor(double maxExtrapolation = 0.2, size_t historySize = 256);
+
+  /// @brief Adds an odometry message
+  /// @param [in] stamp - time of the message [s]
+  /// @param [in] pose - pose in the odometry frame
+  /// @param [in] linear - forward velocity [m/s]
+  /// @param [in] angular - yaw rate [rad/s]
+  void addOdometry(double stamp, const geometry_msgs::Pose& pose, double linear, double angular);
+
+  /// @brief Adds a localisation fix
+  /// @param [in] stamp - time the fix is valid at, 0 takes it as valid at the latest odometry [s]
+  /// @param [in] pose - pose in the map frame
+  void addFix(double stamp, const geometry_msgs::Pose& pose);
+
+  /// @brief Predicts the pose at a time, without blocking
+  /// @param [in] now - the time [s]
+  /// @return the pose in the map frame, the default pose before the first fix
+  geometry_msgs::Pose predict(double now) const;
+
+  /// @brief Getter for the number of fixes added, so a reader can tell when a new one arrived
+  unsigned int fixes() const;
+
+private:
+  struct Planar
+  {
+    double x;
+    double y;
+    double yaw;
+  };
+
+  struct Odometry
+  {
+    //! Time of the message [s]
+    double stamp;
+    Planar pose;
+    //! Forward velocity [m/s]
+    double linear;
+    //! Yaw rate [rad/s]
+    double angular;
+  };
+
+  //! Everything predict() needs, published whole through the SeqLock
+  struct Prediction
+  {
+    //! The last fix in the map frame
+    Planar fix;
+    //! Odometry pose at the time of the fix
+    Planar anchor;
+    //! The latest odometry
+    Odometry latest;
+    //! Full pose of the last fix, so roll, pitch and z carry through
+    geometry_msgs::Pose fixPose;
+    //! Number of fixes added
+    unsigned int fixes;
+    //! Set once an odometry message has been added
+    bool odometry;
+  };
+
+  /// @brief Interpolates the odometry pose at a time from history_, clamped to the messages kept
+  Planar odometryAt(double stamp) const;
+
+  /// @brief Publishes prediction_ for the readers
+  void publish();
+
+  //! Carries the latest odometry forward for at most this long [s]
+  const double maxExtrapolation_;
+  //! Guards the writers' state below between the callbacks
+  std::mutex mtx_;
+  //! Ring of the latest odometry messages, oldest at head_ once full
+  std::vector<Odometry> history_;
+  size_t head_;
+  size_t count_;
+  //! The writers' copy of the prediction
+  Prediction state_;
+  //! The readers' copy of the prediction
+  SeqLock<Prediction> prediction_;
+};
+
+#endif // POSEPREDICTOR_H
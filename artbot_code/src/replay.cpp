@@ -0,0 +1,165 @@
+#include "ros/ros.h"
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <tf/transform_datatypes.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include "latencyhistogram.h"
+#include "sample.h"
+
+// Replays a recorded run through the Sample control loop as fast as it can go and exits.
+// Reads the private parameters ~bag (a recording of /scan, /amcl_pose, /map and optionally /thepath and /odom,
+// which moves the pose on between the recorded fixes),
+// ~output (default none, a CSV of time since the start of the bag, linear and angular velocity per cycle),
+// ~duration (default 0, the whole bag) [s], ~start_mission (default true, requests the mission as the first
+// scan arrives) and ~simulate_pose (default false, after the first recorded pose the pose is integrated from
+// the commands with a unicycle model instead of read from /amcl_pose). Every other private parameter of the
+// artbot_code node is read from the same namespace; ~goal_seed defaults to 1 so the random goals repeat.
+// The clock is simulated: each cycle hands Sample every message recorded up to its time, sets ros::Time to it
+// and runs one Sample::step(). The local replan and spline repair stop on wall clock budgets in the node, so
+// ~local_replan_candidates and ~spline_repair_candidates default to every candidate here (21 and 3) and the
+// budgets are not used. With both set a bag gives the same commands however fast the machine is, matching a
+// machine fast enough never to hit the budgets; setting either to 0 brings its budget back and the commands
+// may then differ between runs. A master is still needed for the node handle, nothing is spun and no simulator
+// has to run.
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "artbot_replay");
+    ros::NodeHandle nh;
+    ros::NodeHandle pnh("~");
+
+    std::string bagFile, outputFile;
+    double duration = 0.0;
+    bool startMission = true, simulatePose = false;
+    pnh.param("bag", bagFile, std::string(""));
+    pnh.param("output", outputFile, std::string(""));
+    pnh.param("duration", duration, 0.0);
+    pnh.param("start_mission", startMission, true);
+    pnh.param("simulate_pose", simulatePose, false);
+    if (bagFile.empty()) {
+        ROS_ERROR("~bag is required");
+        return 1;
+    }
+    if (!pnh.hasParam("goal_seed")) pnh.setParam("goal_seed", 1);
+    if (!pnh.hasParam("local_replan_candidates")) pnh.setParam("local_replan_candidates", 21);
+    if (!pnh.hasParam("spline_repair_candidates")) pnh.setParam("spline_repair_candidates", 3);
+
+    rosbag::Bag bag;
+    try {
+        bag.open(bagFile, rosbag::bagmode::Read);
+    }
+    catch (const rosbag::BagException& e) {
+        ROS_ERROR_STREAM("Cannot open " << bagFile << ": " << e.what());
+        return 1;
+    }
+    rosbag::View view(bag, rosbag::TopicQuery({"/scan", "/amcl_pose", "/odom", "/map", "/thepath"}));
+    if (view.size() == 0) {
+        ROS_ERROR_STREAM(bagFile << " has none of /scan, /amcl_pose, /map or /thepath");
+        return 1;
+    }
+    std::ofstream csv;
+    if (!outputFile.empty()) {
+        csv.open(outputFile);
+        if (!csv) {
+            ROS_ERROR_STREAM("Cannot write " << outputFile);
+            return 1;
+        }
+        csv << "time,linear,angular\n";
+    }
+
+    // The simulated clock starts before Sample exists so every time it reads is on the bag's clock
+    const ros::Time begin = view.getBeginTime();
+    ros::Time end = view.getEndTime();
+    if (duration > 0.0) end = std::min(end, begin + ros::Duration(duration));
+    ros::Time::setNow(begin);
+    Sample sample(nh, pnh);
+    const ros::Duration period(sample.loopPeriod());
+
+    // Pose integrated from the commands when ~simulate_pose is set
+    geometry_msgs::PoseWithCovarianceStamped pose;
+    bool havePose = false, started = false;
+    LatencyHistogram stepTimes(0.0001, 1000);
+    double stepTotal = 0.0;
+    unsigned int cycles = 0, published = 0;
+
+    auto wallStart = std::chrono::steady_clock::now();
+    rosbag::View::iterator next = view.begin();
+    for (ros::Time now = begin; now <= end && ros::ok(); now += period) {
+        for (; next != view.end() && next->getTime() <= now; ++next) {
+            const std::string& topic = next->getTopic();
+            if (topic == "/scan") {
+                sensor_msgs::LaserScan::ConstPtr scan = next->instantiate<sensor_msgs::LaserScan>();
+                if (!scan) continue;
+                sample.laserCallback(scan);
+                if (startMission && !started) {
+                    std_srvs::SetBool::Request req;
+                    std_srvs::SetBool::Response res;
+                    req.data = true;
+                    sample.request(req, res);
+                    started = true;
+                }
+            }
+            else if (topic == "/amcl_pose") {
+                auto msg = next->instantiate<geometry_msgs::PoseWithCovarianceStamped>();
+                if (!msg || (simulatePose && havePose)) continue;
+                pose = *msg;
+                havePose = true;
+                sample.amclCallback(msg);
+            }
+            else if (topic == "/odom") {
+                // The integrated pose already follows the commands, recorded odometry would move it twice
+                if (simulatePose) continue;
+                nav_msgs::Odometry::ConstPtr odom = next->instantiate<nav_msgs::Odometry>();
+                if (odom) sample.odomCallback(odom);
+            }
+            else if (topic == "/map") {
+                nav_msgs::OccupancyGrid::ConstPtr map = next->instantiate<nav_msgs::OccupancyGrid>();
+                if (map) sample.mapCallback(map);
+            }
+            else if (topic == "/thepath") {
+                nav_msgs::Path::ConstPtr path = next->instantiate<nav_msgs::Path>();
+                if (path) sample.pathCallback(path);
+            }
+        }
+
+        ros::Time::setNow(now);
+        geometry_msgs::Twist twist;
+        auto stepStart = std::chrono::steady_clock::now();
+        bool sent = sample.step(twist);
+        double stepTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - stepStart).count();
+        stepTimes.record(stepTime);
+        stepTotal += stepTime;
+        cycles++;
+        if (sent) published++;
+        if (csv.is_open()) csv << (now - begin).toSec() << "," << twist.linear.x << "," << twist.angular.z << "\n";
+
+        // The command is held for one period, the same as the robot would between cycles
+        if (simulatePose && havePose) {
+            double yaw = tf::getYaw(pose.pose.pose.orientation);
+            const double dt = period.toSec();
+            pose.pose.pose.position.x += twist.linear.x * std::cos(yaw) * dt;
+            pose.pose.pose.position.y += twist.linear.x * std::sin(yaw) * dt;
+            yaw += twist.angular.z * dt;
+            pose.pose.pose.orientation = tf::createQuaternionMsgFromYaw(yaw);
+            pose.header.stamp = now + period;
+            sample.amclCallback(boost::make_shared<geometry_msgs::PoseWithCovarianceStamped>(pose));
+        }
+    }
+    double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    sample.stop();
+    bag.close();
+
+    if (cycles == 0) {
+        ROS_ERROR("The bag ends before the first cycle");
+        return 1;
+    }
+    const double simTime = cycles * period.toSec();
+    ROS_INFO_STREAM("Replayed " << cycles << " cycles (" << simTime << " s) in " << wallTime << " s, "
+                    << simTime / std::max(wallTime, 1e-9) << "x real time, " << published << " commands published");
+    ROS_INFO_STREAM("Step time mean " << 1000.0 * stepTotal / cycles << " ms, p99 "
+                    << 1000.0 * stepTimes.percentile(0.99) << " ms against a " << 1000.0 * period.toSec()
+                    << " ms period");
+    return 0;
+}
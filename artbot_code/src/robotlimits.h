@@ -0,0 +1,25 @@
+#ifndef ROBOTLIMITS_H
+#define ROBOTLIMITS_H
+
+/*!
+ *  \brief     Robot Limits
+ *  \details
+ *  Motion limits and size of the TurtleBot, shared by the node and the offline tools.
+ *  The tour cache builder generates its splines with these, so a cached spline is one the node could
+ *  have generated itself, and changing a limit here changes both.
+ *  @sa Sample TourCache
+ *  \version   1.00
+ */
+namespace robotlimits
+{
+  //! Top linear speed [m/s]
+  constexpr double MAX_VEL = 0.26;
+  //! Top linear acceleration [m/s^2]
+  constexpr double MAX_ACCEL = 0.43;
+  //! Top linear jerk [m/s^3]
+  constexpr double MAX_JERK = 1.0;
+  //! Distance between the wheels [m]
+  constexpr double ROBOT_WIDTH = 0.3;
+}
+
+#endif // ROBOTLIMITS_H
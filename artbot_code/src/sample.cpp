@@ -4,37 +4,115 @@
 #include <thread>
 #include <chrono>
 #include <time.h>
+#include <random>
 
 using std::cout;
 using std::endl;
 
 //Default constructor of the sample class
-Sample::Sample(ros::NodeHandle nh) :
+Sample::Sample(ros::NodeHandle nh, ros::NodeHandle pnh) :
     //Setting the default value for some variables
-    nh_(nh), running_(false), real_(true), laserProcessingPtr_(nullptr), pathPlanningPtr_(nullptr),
-    tooClose_(false), stateChange_(true), marker_counter_(0), world_x_(0.0), world_y_(0.0)
+    nh_(nh), missionRequest_(MISSION_NONE), running_(false), real_(true), stopping_(false), laserProcessingPtr_(nullptr), pathPlanningPtr_(nullptr),
+    tooClose_(false), stateChange_(true), plannedMapVersion_(0), plannedMapBase_(0),
+    world_x_(0.0), world_y_(0.0), eventDriven_(false), freshData_(false), latencyHist_(0.001, 250),
+    latencyPublishPeriod_(5.0), goalSeed_(0), clearanceMap_(std::make_shared<const ClearanceMap>()), threshold_distance_(0.15),
+    navfnFallback_(true), followPath_(false), numGoals_(5),
+    splineStream_(squiggles::Constraints(MAX_VEL, MAX_ACCEL, MAX_JERK),
+                  std::make_shared<squiggles::TankModel>(ROBOT_WIDTH_, squiggles::Constraints(MAX_VEL, MAX_ACCEL, MAX_JERK))),
+    streamGoal_(-1),
+    trajectoryValidator_(squiggles::Constraints(MAX_VEL, MAX_ACCEL, MAX_JERK), ROBOT_WIDTH_, 0.5 * ROBOT_WIDTH_),
+    localPlanner_(squiggles::Constraints(MAX_VEL, MAX_ACCEL, MAX_JERK), ROBOT_WIDTH_), localReplan_(true),
+    detouring_(false), detourTime_(0.0), detourRejoin_(0)
 {
+    //Private parameters select how the control loop is scheduled
+    pnh.param("event_driven", eventDriven_, false);
+    pnh.param("latency_publish_period", latencyPublishPeriod_, 5.0);
+    pnh.param("goal_seed", goalSeed_, 0);
+    pnh.param("threshold_distance", threshold_distance_, 0.15);
+    pnh.param("navfn_fallback", navfnFallback_, true);
+    pnh.param("num_goals", numGoals_, 5);
+    pnh.param("follow_thepath", followPath_, false);
+    pnh.param("traj_mode", trajMode_, 1);
+    double kx, ky, ktheta, maxAngular;
+    pnh.param("tracking_kx", kx, 1.0);
+    pnh.param("tracking_ky", ky, 4.0);
+    pnh.param("tracking_ktheta", ktheta, 2.0);
+    pnh.param("max_angular_vel", maxAngular, 1.8);
+    trajectoryTracker_ = TrajectoryTracker(kx, ky, ktheta, MAX_VEL, maxAngular);
+    detourTracker_ = trajectoryTracker_;
+    double localLookahead, localBudget, collisionRadius;
+    int localCandidates, repairCandidates;
+    pnh.param("local_replan", localReplan_, true);
+    pnh.param("local_lookahead", localLookahead, 1.0);
+    pnh.param("local_replan_budget", localBudget, 0.5 * LOOP_PERIOD_);
+    //A candidate count replaces the time budgets when set, as the replay harness does so its commands repeat
+    pnh.param("local_replan_candidates", localCandidates, 0);
+    pnh.param("local_collision_radius", collisionRadius, 0.14);
+    localPlanner_ = LocalPlanner(squiggles::Constraints(MAX_VEL, MAX_ACCEL, MAX_JERK), ROBOT_WIDTH_, localLookahead, localBudget,
+                                 std::max(0, localCandidates));
+    localCostmap_ = LocalCostmap(4.0, 0.05, collisionRadius);
+    double splineClearance, repairBudget;
+    pnh.param("spline_clearance", splineClearance, 0.5 * ROBOT_WIDTH_);
+    //A re-solve runs inside a control tick, next to a local replan that may take half of it
+    pnh.param("spline_repair_budget", repairBudget, 0.25 * LOOP_PERIOD_);
+    pnh.param("spline_repair_candidates", repairCandidates, 0);
+    trajectoryValidator_ = TrajectoryValidator(squiggles::Constraints(MAX_VEL, MAX_ACCEL, MAX_JERK), ROBOT_WIDTH_,
+                                               splineClearance, repairBudget, std::max(0, repairCandidates));
+    std::vector<double> exhibits;
+    std::string tourCacheDir;
+    pnh.param("exhibits", exhibits, std::vector<double>());
+    pnh.param("tour_cache_dir", tourCacheDir, std::string(""));
+    for(size_t i = 0; i + 1 < exhibits.size(); i += 2){
+        geometry_msgs::Point exhibit;
+        exhibit.x = exhibits[i];
+        exhibit.y = exhibits[i + 1];
+        exhibits_.push_back(exhibit);
+    }
+    tourCache_ = TourCache(tourCacheDir);
+    navfn_ = NavfnPlanner(nh_, threshold_distance_);
+    if(eventDriven_) ROS_INFO_STREAM("Control loop is event driven");
+#ifdef ARTBOT_PROFILE
+    double profilePublishPeriod;
+    std::string profileDumpFile;
+    pnh.param("profile_publish_period", profilePublishPeriod, 5.0);
+    pnh.param("profile_dump_file", profileDumpFile, std::string(""));
+    profiler_ = LoopProfiler(nh_, LOOP_PERIOD_, profilePublishPeriod, profileDumpFile);
+#endif
+
     //Subscribing to the laser sensor
-    sub1_ = nh_.subscribe("/scan", 100, &Sample::laserCallback,this);
+    sub1_ = nh_.subscribe("scan", 100, &Sample::laserCallback,this);
     //Subscribing to odometry of the robot
-    sub2_ = nh_.subscribe("/amcl_pose", 100, &Sample::amclCallback,this);
+    sub2_ = nh_.subscribe("amcl_pose", 100, &Sample::amclCallback,this);
+
+    sub3_ = nh_.subscribe("thepath", 10, &Sample::pathCallback,this);
 
-    sub3_ = nh_.subscribe("/thepath", 10, &Sample::pathCallback,this);
+    //Odometry carries the pose forward between amcl_pose fixes, noisy_odom drives the prediction off the noisy odometry
+    bool posePrediction;
+    std::string odomTopic;
+    pnh.param("pose_prediction", posePrediction, true);
+    pnh.param("odom_topic", odomTopic, std::string("odom"));
+    if(posePrediction){
+        sub6_ = nh_.subscribe(odomTopic, 100, &Sample::odomCallback, this);
+    }
 
-    sub4_ = nh_.subscribe("/map", 100, &Sample::mapCallback, this);
+    //Only the latest map matters, an update applies to the map received before it
+    sub4_ = nh_.subscribe("/map", 1, &Sample::mapCallback, this);
+    sub5_ = nh_.subscribe("/map_updates", 100, &Sample::mapUpdateCallback, this);
     //Publishing the driving commands
-    pubDrive_ = nh.advertise<geometry_msgs::Twist>("/cmd_vel",3,false);
+    pubDrive_ = nh.advertise<geometry_msgs::Twist>("cmd_vel",3,false);
 
-    pubVis_ = nh_.advertise<visualization_msgs::MarkerArray>("visualization_marker",3,false);
+    double lookaheadMarkerRate;
+    pnh.param("lookahead_marker_rate", lookaheadMarkerRate, 5.0);
+    markers_ = MarkerPublisher(nh_, lookaheadMarkerRate);
 
-    goal_pub_ = nh_.advertise<geometry_msgs::PoseStamped>("/move_base_simple/goal", 1);
+    goal_pub_ = nh_.advertise<geometry_msgs::PoseStamped>("move_base_simple/goal", 1);
 
-    //Service to enable the robot to start and stop from command line input
-    service1_ = nh_.advertiseService("/mission", &Sample::request,this);
+    pubLatency_ = nh_.advertise<std_msgs::UInt32MultiArray>("cmd_vel_latency_histogram", 1, false);
 
-    service2_ = nh_.advertiseService("/real", &Sample::real,this);
+    //Service to enable the robot to start and stop from command line input
+    service1_ = nh_.advertiseService("mission", &Sample::request,this);
 
-    make_plan_ = nh.serviceClient<nav_msgs::GetPlan>("/move_base/NavfnROS/make_plan");
+    service2_ = nh_.advertiseService("real", &Sample::real,this);
     
     //Sets the default robotPose_ to 0
     robotPose_.position.x = 0.0;
@@ -45,11 +123,6 @@ Sample::Sample(ros::NodeHandle nh) :
     robotPose_.orientation.z = 0.0;
     robotPose_.orientation.w = 0.0;
 
-    //Sets the default pathData_ to 0
-    pathData_.x = 0.0;
-    pathData_.y = 0.0;
-    pathData_.z = 0.0;
-
     //Sets the default goal to (0,0,0)
     goal_.x = DBL_MAX_;
     goal_.y = DBL_MAX_;
@@ -58,11 +131,10 @@ Sample::Sample(ros::NodeHandle nh) :
 
     goalIdx_ = 0;
     
-    velIdx_ = 0;
     time_ = 0;
     smoothVelIdx_ = 0;
+    logCounter_ = 0;
     poseError_ = 0.0;
-    minIdx_ = 0;
 }
 
 // We delete anything that needs removing here specifically
@@ -78,352 +150,437 @@ Sample::~Sample(){
 //A callback for the laser scanner
 void Sample::laserCallback(const sensor_msgs::LaserScanConstPtr& msg)
 {
-    std::unique_lock<std::mutex> lck(laserDataMtx_); // Locks the data for the laserData to be saved
-    laserData_ = *msg; // We store a copy of the LaserScan in laserData_
+    boost::atomic_store(&laserData_, msg); // We keep the shared message rather than copying the LaserScan
+    notifyFreshData();
 }
 
-// //A callback for odometry
-// void Sample::odomCallback(const nav_msgs::OdometryConstPtr &msg)
-// {
-//     geometry_msgs::Pose pose = msg->pose.pose;
-//     std::unique_lock<std::mutex> lck(robotPoseMtx_); // Locks the data for the robotPose to be saved
-//     robotPose_ = pose; // We copy the pose here
-// }
+//A callback for odometry, it only moves the predicted pose so it does not wake the control loop
+void Sample::odomCallback(const nav_msgs::OdometryConstPtr &msg)
+{
+    predictor_.addOdometry(msg->header.stamp.toSec(), msg->pose.pose, msg->twist.twist.linear.x, msg->twist.twist.angular.z);
+}
 
 void Sample::amclCallback(const geometry_msgs::PoseWithCovarianceStampedConstPtr &msg)
 {
-    geometry_msgs::Pose pose = msg->pose.pose;
-    std::unique_lock<std::mutex> lck(robotPoseMtx_); // Locks the data for the robotPose to be saved
-    robotPose_ = pose; // We copy the pose here
+    predictor_.addFix(msg->header.stamp.toSec(), msg->pose.pose); // We copy the pose here, the control thread never holds it locked
+    notifyFreshData();
 }
 
-//A callback for the laser scanner
-void Sample::pathCallback(const geometry_msgs::PointConstPtr& msg)
+//A callback for the tour on /thepath
+void Sample::pathCallback(const nav_msgs::PathConstPtr& msg)
 {
-    std::unique_lock<std::mutex> lck(pathDataMtx_); // Locks the data for the laserData to be saved
-    pathData_ = *msg; // We store a copy of the LaserScan in laserData_
+    boost::atomic_store(&pathData_, msg); // We keep the shared message, the whole tour arrives at once
 }
 
 //A callback for map
 void Sample::mapCallback(const nav_msgs::OccupancyGrid::ConstPtr& msg)
 {
-    std::unique_lock<std::mutex> lck(mapMtx_);
-     // Parse the map data
-    map_width_ = msg->info.width;
-    //std::cout << "Map Width: " << map_width_ << std::endl;
-    map_height_ = msg->info.height;
-    //std::cout << "Map Height: " << map_height_ << std::endl;
-    map_resolution_ = msg->info.resolution;
-    //std::cout << "Map Resolution: " << map_resolution_ << std::endl;
-    map_origin_x_ = msg->info.origin.position.x;
-    //std::cout << "Map Origin X: " << map_origin_x_ << std::endl;
-    map_origin_y_ = msg->info.origin.position.y;
-    //std::cout << "Map Origin Y: " << map_origin_y_ << std::endl;
-    map_data_ = msg->data;
-    //std::cout << "Map data provided." << std::endl;
-    // Generate a random goal point
+    // Keep the shared message, the grid is only parsed by the control thread when the version changes
+    boost::shared_ptr<const MapSnapshot> current = boost::atomic_load(&mapSnapshot_);
+    boost::shared_ptr<const MapSnapshot> next;
+    do{
+        const unsigned int version = current ? current->version + 1 : 1;
+        next = boost::make_shared<const MapSnapshot>(MapSnapshot{msg, version, version, std::vector<MapRegion>()});
+    } while(!boost::atomic_compare_exchange(&mapSnapshot_, &current, next));
+}
+
+//A callback for a patch of the map
+void Sample::mapUpdateCallback(const map_msgs::OccupancyGridUpdateConstPtr& msg)
+{
+    boost::shared_ptr<const MapSnapshot> current = boost::atomic_load(&mapSnapshot_);
+    boost::shared_ptr<const MapSnapshot> next;
+    do{
+        if(!current || !current->map) return;
+        const nav_msgs::OccupancyGrid& map = *current->map;
+        const int width = map.info.width;
+        const int height = map.info.height;
+        if(msg->x < 0 || msg->y < 0 || msg->x + static_cast<int>(msg->width) > width ||
+           msg->y + static_cast<int>(msg->height) > height || msg->data.size() < static_cast<size_t>(msg->width) * msg->height){
+            ROS_WARN_THROTTLE(5.0, "Dropping a map update outside the map");
+            return;
+        }
+        if(msg->width == 0 || msg->height == 0) return;
+
+        //Robots in one manager patching the same map with the same update share one patched grid
+        nav_msgs::OccupancyGrid::ConstPtr patched = SharedMap::patchGrid(current->map, *msg);
+        std::vector<MapRegion> patches = current->patches;
+        patches.push_back(MapRegion{msg->x, msg->y, msg->x + static_cast<int>(msg->width) - 1, msg->y + static_cast<int>(msg->height) - 1});
+        next = boost::make_shared<const MapSnapshot>(MapSnapshot{patched, current->version + 1, current->base, patches});
+    } while(!boost::atomic_compare_exchange(&mapSnapshot_, &current, next));
 }
 
 void Sample::seperateThread() {
     // Waits for the data to be populated from ROS
-    while(laserData_.range_min+laserData_.range_max == 0.0) ROS_INFO_STREAM("Loading...");
-    //Limits the execution of this code to 5Hz
-    int counter = 0;
-    ros::Rate rate_limiter(10.0);
-    while (ros::ok()) {
-        //Locks all of the data with mutexes
-        std::unique_lock<std::mutex> lck1 (laserDataMtx_);
-        std::unique_lock<std::mutex> lck2 (robotPoseMtx_);
-        // std::unique_lock<std::mutex> lck3 (pathDataMtx_);
-        std::unique_lock<std::mutex> lck3 (mapMtx_);
-        
-        //Creates the class object and gives the data from the sensors
-        LaserProcessing laserProcessing(laserData_);
-        PathPlanning pathPlanning(map_width_, map_height_, map_resolution_, map_origin_x_, map_origin_y_, map_data_, world_x_, world_y_);
-
-        //Unlocks all mutexes
-        // lck4.unlock();
-        lck3.unlock();
-        lck2.unlock();
-        lck1.unlock();
-
-        // ROS_INFO("AngleMin= %f\n AngleMax= %f\n AngleIncrement= %f", laserData_.angle_min, laserData_.angle_max, laserData_.angle_increment);
-        
-        std::pair<double, double> rangeBearing;
-        // rangeBearing.first = 0.0;
-        // rangeBearing.second = 0.0;
-        rangeBearing = laserProcessing.MinDistAngle();
-        // ROS_INFO("Min Range: %f", rangeBearing.first);
-
-        //Gets the distance from the angle
-        double dist = rangeBearing.first;
-        // dist = laserProcessing.FindDistance(angle);
-
-        //If the distance is less than the stop distance or more than the max value of an int (an invalid reading) the robot should stop
-        if(dist < STOP_DISTANCE_ || dist > 2147483647){
-            tooClose_ = true;
-            // ROS_INFO_STREAM("TurtleBot is too close to an obstacle!");
-            // ROS_INFO("Obstacle Range: %f\nObstacle angle: %f", rangeBearing.first, (rangeBearing.second*180/M_PI));
-        }
-        //Otherwise the robot is not too close
-        else if(!tooClose_) tooClose_ = false;
-        
-        // ROS_INFO("Obstacle Range: %f\nObstacle angle: %f", rangeBearing.first, (rangeBearing.second*180/M_PI));
-        tooClose_ = false;
-        
-        geometry_msgs::Point fakeMarker;
-        fakeMarker.x = 1.0;
-        fakeMarker.y = 1.0;
-        fakeMarker.z = 0.0;
-
-        visualization_msgs::MarkerArray markerArray; //creates the marker array for publishing
-
-        // markerArray = CollectGoals(markerArray);
-        // if(!goals_.empty()) goal_ = goals_.at(goalIdx_);
-
-        // for(int i = 0; )
-        //We create a marker for the goal
-        // visualization_msgs::Marker marker = createMarker(fakeMarker, 0, 1, 0);
-        // markerArray.markers.push_back(marker); //goal marker is pushed into marker array
-
-        // goals_ = pathPlanning.GetGoals();
-        // markerArray = CollectGoals(markerArray);
-        
-        if(goals_.empty()) goals_ = generateRandomGoals(pathPlanning);
-        else{
-            for(int i = 0; i < goals_.size(); i++){
-                geometry_msgs::Point markerPoint;
-                markerPoint.x = goals_.at(i).x;
-                markerPoint.y = goals_.at(i).y;
-                visualization_msgs::Marker marker = createMarker(markerPoint, 1.0, 0.0, 0.0);
-                markerArray.markers.push_back(marker);
-            }
-        }
-        goal_ = goals_.at(goalIdx_);
+    sensor_msgs::LaserScanConstPtr scan;
+    while(ros::ok() && !stopping_){
+        scan = boost::atomic_load(&laserData_);
+        if(scan) break;
+        ROS_INFO_STREAM_THROTTLE(1.0, "Loading...");
+        std::unique_lock<std::mutex> lck(dataCvMtx_);
+        dataCv_.wait_for(lck, std::chrono::duration<double>(EVENT_TIMEOUT_), [this]{ return freshData_; });
+        freshData_ = false;
+    }
+    //Limits the execution of this code to 10Hz
+    ros::Rate rate_limiter(1.0 / LOOP_PERIOD_);
+    geometry_msgs::Twist drive;
+    while (ros::ok() && !stopping_) {
+        step(drive);
+        //Waits for new sensor data, or on the rate timer which sleeps
+        //for the exact amount of time needed to run at 10Hz
+        waitForNextCycle(rate_limiter);
+    }
+}
 
+bool Sample::step(geometry_msgs::Twist& twist)
+{
+    //Only the cycle is timed, not the wait for the next one, so the replay harness records its ticks too
+    PROFILE_BEGIN_TICK(profiler_);
+    const bool sent = tick(twist);
+    PROFILE_END_TICK(profiler_);
+    return sent;
+}
 
-        // if(goal_.x == DBL_MAX_ && goal_.y == DBL_MAX_ && goal_.z == DBL_MAX_){
-        //     std::vector<geometry_msgs::Point> fakeGoals;
-        //     // int ARRAY_SIZE = 6;
-        //     // double goal_arrayX[ARRAY_SIZE] = {2.0, 4.0,  7.0, 10.0,  8.0};
-        //     // double goal_arrayY[ARRAY_SIZE] = {-2.0, 0.0, 1.0, -1.0, -2.5};
-        //     int ARRAY_SIZE = 5;
-        //     // double goal_arrayX[ARRAY_SIZE] = {1.0, 2.0, 1.0, 0.0};
-        //     // double goal_arrayY[ARRAY_SIZE] = {1.0, 0.0, -1.0, 0.0};
+bool Sample::tick(geometry_msgs::Twist& twist)
+{
+    //Takes a snapshot of the latest sensor data, nothing is locked
+    sensor_msgs::LaserScanConstPtr scan;
+    boost::shared_ptr<const MapSnapshot> mapSnapshot;
+    {
+        PROFILE_SCOPE(profiler_, SNAPSHOT);
+        scan = boost::atomic_load(&laserData_);
+        //The last fix moved on by the odometry since, so the pose is current between amcl updates
+        robotPose_ = predictor_.predict(ros::Time::now().toSec());
+        //A map newer than the version is planned again next tick
+        mapSnapshot = boost::atomic_load(&mapSnapshot_);
+    }
+    applyMissionRequest();
+    if(!scan) return false;
 
-        //     // double goal_arrayX[ARRAY_SIZE] = {2.0, 4.0, 6.0, 8.0};
-        //     // double goal_arrayY[ARRAY_SIZE] = {0.0, -2.0, -2.5, -2.5};
+    //Creates the class object and gives the data from the sensors
+    LaserProcessing laserProcessing(scan);
 
-        //     double goal_arrayX[ARRAY_SIZE] = {0.0, 0.5, 0.0, 2.0};
-        //     double goal_arrayY[ARRAY_SIZE] = {1.5, 0.0, -1.5, -1.5};
+    //The clearance and planner only need rebuilding when a new map has arrived, and only the first robot
+    //in the process to see it builds the clearance
+    if(mapSnapshot && mapSnapshot->map && (pathPlanningPtr_ == nullptr || mapSnapshot->version != plannedMapVersion_)){
+        PROFILE_SCOPE(profiler_, MAP);
+        planMap(*mapSnapshot);
+    }
 
-        //     for(int i = 0; i+1 < ARRAY_SIZE; i++){
-        //         geometry_msgs::Point fakeGoal;
-        //         fakeGoal.x = goal_arrayX[i];
-        //         fakeGoal.y = goal_arrayY[i];
-        //         fakeGoals.push_back(fakeGoal);
-        //     }
-        //     goals_ = fakeGoals;
-        // }
+    // ROS_INFO("AngleMin= %f\n AngleMax= %f\n AngleIncrement= %f", laserData_.angle_min, laserData_.angle_max, laserData_.angle_increment);
+    
+    //Splits the scan into obstacles, the buffers are kept between scans
+    double dist;
+    {
+        PROFILE_SCOPE(profiler_, SCAN);
+        laserProcessing.segmentScan(scanSegmenter_);
 
-        if(DistanceToGoal(goal_, robotPose_) < GOAL_DISTANCE_) {
-            if(goalIdx_+1 == goals_.size()){ //if this is the last goal
-                running_ = false;
-                stateChange_ = true;
+        //Gets the distance to the closest obstacle [m], infinity when no reading is valid
+        dist = scanSegmenter_.closestRange();
+
+        //The readings are already in the laser frame, they are marked around the robot's pose
+        if(localReplan_) localCostmap_.update(robotPose_.position.x, robotPose_.position.y, tf::getYaw(robotPose_.orientation),
+                                              scanSegmenter_.x(), scanSegmenter_.y(), scan->range_min);
+    }
+
+    //If the distance is less than the stop distance or more than the max value of an int (an invalid reading) the robot should stop
+    if(dist < STOP_DISTANCE_ || dist > 2147483647){
+        tooClose_ = true;
+        // ROS_INFO_STREAM("TurtleBot is too close to an obstacle!");
+        // ROS_INFO("Obstacle Range: %f\nObstacle angle: %f", rangeBearing.first, (rangeBearing.second*180/M_PI));
+    }
+    //Otherwise the robot is not too close
+    else tooClose_ = false;
+    
+    if(goals_.empty()){
+        //Goals are taken from /thepath, or can only be generated once a map has been received
+        {
+            PROFILE_SCOPE(profiler_, GOALS);
+            if(followPath_){
+                nav_msgs::PathConstPtr path = boost::atomic_load(&pathData_);
+                //A fleet planner stamps the tour with the time the robot may set off, to keep clear of the others
+                if(path && path->header.stamp <= ros::Time::now())
+                    for(const auto& pose : path->poses) goals_.push_back(pose.pose.position);
             }
-            else if(goalIdx_+1 < goals_.size()){ //if this isnt the last goal
-                ROS_INFO_STREAM("***GOAL REACHED***\n");
-                goalIdx_++;
+            else if(pathPlanningPtr_ != nullptr){
+                goals_ = exhibits_.empty() ? generateRandomGoals(*pathPlanningPtr_) : exhibitTour(*pathPlanningPtr_);
             }
-            if(trajMode_ == 2 && running_) GenerateSpline(); //generate a spline
         }
+        if(goals_.empty()) return false;
+        //The tracked path starts where the robot is
+        geometry_msgs::Point start;
+        start.x = robotPose_.position.x;
+        start.y = robotPose_.position.y;
+        tourPoints_.assign(1, start);
+        tourPoints_.insert(tourPoints_.end(), goals_.begin(), goals_.end());
+        goalTracker_.setPath(tourPoints_);
+        detouring_ = false;
+    }
+    //Only sent to RViz when the goals change
+    {
+        PROFILE_SCOPE(profiler_, MARKERS);
+        markers_.setGoals(goals_);
+    }
+    goal_ = goals_.at(goalIdx_);
+
 
-        if(trajMode_ == 2 && path_.empty()){
-            GenerateSpline();
+    // if(goal_.x == DBL_MAX_ && goal_.y == DBL_MAX_ && goal_.z == DBL_MAX_){
+    //     std::vector<geometry_msgs::Point> fakeGoals;
+    //     // int ARRAY_SIZE = 6;
+    //     // double goal_arrayX[ARRAY_SIZE] = {2.0, 4.0,  7.0, 10.0,  8.0};
+    //     // double goal_arrayY[ARRAY_SIZE] = {-2.0, 0.0, 1.0, -1.0, -2.5};
+    //     int ARRAY_SIZE = 5;
+    //     // double goal_arrayX[ARRAY_SIZE] = {1.0, 2.0, 1.0, 0.0};
+    //     // double goal_arrayY[ARRAY_SIZE] = {1.0, 0.0, -1.0, 0.0};
+
+    //     // double goal_arrayX[ARRAY_SIZE] = {2.0, 4.0, 6.0, 8.0};
+    //     // double goal_arrayY[ARRAY_SIZE] = {0.0, -2.0, -2.5, -2.5};
+
+    //     double goal_arrayX[ARRAY_SIZE] = {0.0, 0.5, 0.0, 2.0};
+    //     double goal_arrayY[ARRAY_SIZE] = {1.5, 0.0, -1.5, -1.5};
+
+    //     for(int i = 0; i+1 < ARRAY_SIZE; i++){
+    //         geometry_msgs::Point fakeGoal;
+    //         fakeGoal.x = goal_arrayX[i];
+    //         fakeGoal.y = goal_arrayY[i];
+    //         fakeGoals.push_back(fakeGoal);
+    //     }
+    //     goals_ = fakeGoals;
+    // }
+
+    if(DistanceToGoal(goal_, robotPose_) < GOAL_DISTANCE_) {
+        if(goalIdx_+1 == goals_.size()){ //if this is the last goal
+            if(running_) ROS_INFO_STREAM("***MISSION COMPLETE***\n");
+            running_ = false;
+            stateChange_ = true;
         }
-        
-        // Calculate pose error
-        if(trajMode_ == 2){
-            geometry_msgs::Point velPose;
-            velPose.x = path_.at(velIdx_).vector.pose.x;
-            velPose.y = path_.at(velIdx_).vector.pose.y;
-            poseError_ = DistanceToGoal(velPose, robotPose_);
-            for(int i = 0; i < path_.size(); i++){
-                geometry_msgs::Point markerPoint;
-                markerPoint.x = path_.at(i).vector.pose.x;
-                markerPoint.y = path_.at(i).vector.pose.y;
-                visualization_msgs::Marker marker = createMarker(markerPoint, 1.0, 0.0, 0.0);
-                markerArray.markers.push_back(marker);
-            }
+        else if(goalIdx_+1 < goals_.size()){ //if this isnt the last goal
+            ROS_INFO_STREAM("***GOAL REACHED***\n");
+            goalIdx_++;
         }
+        if(trajMode_ == 2 && running_) GenerateSpline(); //generate a spline
+    }
 
-        // if(poseError_ > 0.2) smoothVelIdx_ -= 2;
-
-        counter++;
-        if(counter == 10 && goal_.x != DBL_MAX_ && goal_.y != DBL_MAX_ && goal_.z != DBL_MAX_){
-            ROS_INFO("goal_: (%f, %f)", goal_.x, goal_.y);
-            ROS_INFO("Distance: %f", DistanceToGoal(goal_, robotPose_));
-            // ROS_INFO("GoalIdx: %d", goalIdx_);
-            // ROS_INFO("Pose error: %f", poseError_);
-            // ROS_INFO("goals_ size: %ld", goals_.size());
-            // if(!goals_.empty()){
-            //     for (int i = 0; i < goals_.size()-1; i++){
-            //         ROS_INFO("goals_ at %d: (%f, %f)", i, goals_.at(i).x, goals_.at(i).y);
-            //     }
-            // }
-            counter = 0;
-        }
-        else if (counter > 10) counter = 0;
-        // for(int i = 0; i < goals_.size(); i++){
-        //     ROS_INFO("goals_: (%f, %f)", goals_.at(i).x, goals_.at(i).y);
+    if(trajMode_ == 2 && path_.empty()){
+        GenerateSpline();
+    }
+    
+    // Pose error from the reference of the last tick
+    if(trajMode_ == 2 && !path_.empty()){
+        poseError_ = trajectoryTracker_.positionError();
+        PROFILE_SCOPE(profiler_, MARKERS);
+        markers_.setPath(path_.view());
+    }
+
+    // if(poseError_ > 0.2) smoothVelIdx_ -= 2;
+
+    //With local replanning the robot goes round obstacles on its path, and only stops when there is no way round
+    //or no reading is valid, rather than for every reading closer than STOP_DISTANCE_
+    if(localReplan_ && running_ && trajMode_ != 0){
+        PROFILE_SCOPE(profiler_, LOCAL);
+        tooClose_ = dist > 2147483647 || !updateDetour();
+    }
+    else if(!running_) detouring_ = false;
+
+    logCounter_++;
+    if(logCounter_ == 10 && goal_.x != DBL_MAX_ && goal_.y != DBL_MAX_ && goal_.z != DBL_MAX_){
+        ROS_INFO("goal_: (%f, %f)", goal_.x, goal_.y);
+        ROS_INFO("Distance: %f", DistanceToGoal(goal_, robotPose_));
+        // ROS_INFO("GoalIdx: %d", goalIdx_);
+        // ROS_INFO("Pose error: %f", poseError_);
+        // ROS_INFO("goals_ size: %ld", goals_.size());
+        // if(!goals_.empty()){
+        //     for (int i = 0; i < goals_.size()-1; i++){
+        //         ROS_INFO("goals_ at %d: (%f, %f)", i, goals_.at(i).x, goals_.at(i).y);
+        //     }
         // }
-        
-
-        //Creates the variable for driving the TurtleBot
-        geometry_msgs::Twist drive;
-        if(running_ && !tooClose_){
-            if(stateChange_){
-                ROS_INFO_STREAM("TurtleBot is moving");
-                stateChange_ = false;
-            }
+        logCounter_ = 0;
+    }
+    else if (logCounter_ > 10) logCounter_ = 0;
+    // for(int i = 0; i < goals_.size(); i++){
+    //     ROS_INFO("goals_: (%f, %f)", goals_.at(i).x, goals_.at(i).y);
+    // }
+    
 
-            drive.linear.x = 0.5; //sends it forward
-            drive.linear.y = 0.0;
-            drive.linear.z = 0.0;
-            drive.angular.x = 0.0;
-            drive.angular.y = 0.0;
-            drive.angular.z = 0.0;
-
-            if(trajMode_ == 1){
-                geometry_msgs::Point lookaheadPoint = FindLookaheadPoint(goals_);
-                double goal_angle = GetGoalAngle(lookaheadPoint,robotPose_);
-                visualization_msgs::Marker marker = createMarker(lookaheadPoint, 0.0, 1.0, 0.0);
-                markerArray.markers.push_back(marker);
-                
-                // ROS_INFO("steering = %f", goal_angle);
-                // ROS_INFO("smoothVelIdx = %d", smoothVelIdx_);
-
-                // double goal_angle = GetGoalAngle(goal_,robotPose_);
-                // ROS_INFO("steering = %f", fabs(goal_angle));
-                if(fabs(goal_angle) > 0.1){
-                    smoothVelIdx_ = 0;
-                    // goal_angle = GetGoalAngle(goal_,robotPose_);
-                    drive.linear.x = 0.0;
-                    drive.linear.y = 0.0;
-                    drive.linear.z = 0.0;
-                    drive.angular.x = 0.0;
-                    drive.angular.y = 0.0;
-                    drive.angular.z = goal_angle*STEERING_SENS_;
-                    // ROS_INFO("steering = %f", drive.angular.z);
-                }
-                else{
-                    smoothVelIdx_++;
-                    drive.linear.x = SmoothVel(smoothVelIdx_);
-                    drive.linear.y = 0.0;
-                    drive.linear.z = 0.0;
-                    drive.angular.x = 0.0;
-                    drive.angular.y = 0.0;
-                    drive.angular.z = 0.0;
-                    // ROS_INFO("driving = %f", drive.linear.x);
-                }
+    //Creates the variable for driving the TurtleBot
+    geometry_msgs::Twist drive;
+    if(running_ && !tooClose_){
+        PROFILE_SCOPE(profiler_, CONTROL);
+        if(stateChange_){
+            ROS_INFO_STREAM("TurtleBot is moving");
+            stateChange_ = false;
+        }
+
+        drive.linear.x = 0.5; //sends it forward
+        drive.linear.y = 0.0;
+        drive.linear.z = 0.0;
+        drive.angular.x = 0.0;
+        drive.angular.y = 0.0;
+        drive.angular.z = 0.0;
+
+        if(detouring_){
+            //Both paths keep their progress while the detour is followed
+            detourTime_ += trackingStep();
+            TrajectoryTracker::Command command = detourTracker_.update(detourTime_, robotPose_.position.x,
+                robotPose_.position.y, tf::getYaw(robotPose_.orientation));
+            geometry_msgs::Point reference;
+            detourTracker_.reference(reference.x, reference.y);
+            markers_.setLookahead(reference);
+
+            drive.linear.x = command.linear;
+            drive.angular.z = command.angular;
+        }
+        else if(trajMode_ == 1){
+            geometry_msgs::Point lookaheadPoint = FindLookaheadPoint(goalTracker_);
+            //The tracked path has the start in front of goals_
+            goalIdx_ = std::max(0, static_cast<int>(goalTracker_.lookaheadIndex()) - 1);
+            double goal_angle = GetGoalAngle(lookaheadPoint,robotPose_);
+            markers_.setLookahead(lookaheadPoint);
+            
+            // ROS_INFO("steering = %f", goal_angle);
+            // ROS_INFO("smoothVelIdx = %d", smoothVelIdx_);
+
+            // double goal_angle = GetGoalAngle(goal_,robotPose_);
+            // ROS_INFO("steering = %f", fabs(goal_angle));
+            if(fabs(goal_angle) > 0.1){
+                smoothVelIdx_ = 0;
+                // goal_angle = GetGoalAngle(goal_,robotPose_);
+                drive.linear.x = 0.0;
+                drive.linear.y = 0.0;
+                drive.linear.z = 0.0;
+                drive.angular.x = 0.0;
+                drive.angular.y = 0.0;
+                drive.angular.z = goal_angle*STEERING_SENS_;
+                // ROS_INFO("steering = %f", drive.angular.z);
             }
-            if(trajMode_ == 2){
-                std::vector<geometry_msgs::Point> goals;
-                for(int i = 0; i < path_.size(); i++){
-                    goals.at(i).x = path_.at(i).vector.pose.x;
-                    goals.at(i).y = path_.at(i).vector.pose.y;
-                }
-                geometry_msgs::Point lookaheadPoint = FindLookaheadPoint(goals);
-                double goal_angle = GetGoalAngle(lookaheadPoint,robotPose_);
-                visualization_msgs::Marker marker = createMarker(lookaheadPoint, 0.0, 1.0, 0.0);
-                markerArray.markers.push_back(marker);
-
-                // smoothVelIdx_++;
-                // drive.linear.x = SmoothVel(smoothVelIdx_);
-                drive.linear.x = 0.1;
+            else{
+                smoothVelIdx_++;
+                drive.linear.x = SmoothVel(smoothVelIdx_);
                 drive.linear.y = 0.0;
                 drive.linear.z = 0.0;
                 drive.angular.x = 0.0;
                 drive.angular.y = 0.0;
-                drive.angular.z = goal_angle;
+                drive.angular.z = 0.0;
+                // ROS_INFO("driving = %f", drive.linear.x);
             }
         }
-        //Stops the TurtleBot
-        else{
-            drive.linear.x = 0.0;
+        else if(trajMode_ == 2){
+            //The reference only moves on while the robot drives, so it waits for the robot after a stop
+            time_ += trackingStep();
+            TrajectoryTracker::Command command = trajectoryTracker_.update(time_, robotPose_.position.x,
+                robotPose_.position.y, tf::getYaw(robotPose_.orientation));
+            geometry_msgs::Point reference;
+            trajectoryTracker_.reference(reference.x, reference.y);
+            markers_.setLookahead(reference);
+
+            drive.linear.x = command.linear;
             drive.linear.y = 0.0;
             drive.linear.z = 0.0;
             drive.angular.x = 0.0;
             drive.angular.y = 0.0;
-            drive.angular.z = 0.0;
-
-            if(stateChange_){
-                ROS_INFO_STREAM("TurtleBot is stopped");
-                stateChange_ = false;
-            }
+            drive.angular.z = command.angular;
+        }
+    }
+    //Stops the TurtleBot
+    else{
+        lastTrackTime_ = ros::Time();
+        drive.linear.x = 0.0;
+        drive.linear.y = 0.0;
+        drive.linear.z = 0.0;
+        drive.angular.x = 0.0;
+        drive.angular.y = 0.0;
+        drive.angular.z = 0.0;
+
+        if(stateChange_){
+            ROS_INFO_STREAM("TurtleBot is stopped");
+            stateChange_ = false;
         }
-        // geometry_msgs::Twist drive;
-        // drive.linear.x = 0.5; //sends it forward
-        // drive.linear.y = 0.0;
-        // drive.linear.z = 0.0;
-        // drive.angular.x = 0.0;
-        // drive.angular.y = 0.0;
-        // drive.angular.z = 0.0;
-        // ROS_INFO_STREAM("TurtleBot is moving");
-        
-        // Publishes the drive variable to control the TurtleBot
-        if(trajMode_ != 0) pubDrive_.publish(drive);
-
-        pubVis_.publish(markerArray);
-
-        //We have a rate timer, this sleep here is needed to ensure it stops and sleeps 
-        //it will do it for the exact amount of time needed to run at 5Hz
-        rate_limiter.sleep();
     }
+    // geometry_msgs::Twist drive;
+    // drive.linear.x = 0.5; //sends it forward
+    // drive.linear.y = 0.0;
+    // drive.linear.z = 0.0;
+    // drive.angular.x = 0.0;
+    // drive.angular.y = 0.0;
+    // drive.angular.z = 0.0;
+    // ROS_INFO_STREAM("TurtleBot is moving");
+    
+    // Publishes the drive variable to control the TurtleBot
+    twist = drive;
+    if(trajMode_ == 0) return false;
+    {
+        PROFILE_SCOPE(profiler_, PUBLISH);
+        pubDrive_.publish(drive);
+        recordCommandLatency(scan);
+    }
+    return true;
 }
 
-visualization_msgs::Marker Sample::createMarker(geometry_msgs::Point point, double r, double g, double b){
-  
-  visualization_msgs::Marker marker;
-
-  //Set the reference frame ID and time stamp.
-  marker.header.frame_id = "map";
-  marker.header.stamp = ros::Time::now();
-
-  //Lifetime of the object, matches the Hz of the rate limiter
-  marker.lifetime = ros::Duration(0.1);
-  
-  //Unique ID of the marker
-  marker.id = marker_counter_++; 
+double Sample::loopPeriod() const
+{
+    return LOOP_PERIOD_;
+}
 
-  marker.type = visualization_msgs::Marker::CYLINDER;
-  // Set the scale of the marker
-  marker.scale.x = 0.1;
-  marker.scale.y = 0.1;
-  marker.scale.z = 0.1;
-  //Colour is r,g,b where each channel of colour is 0-1. This marker is green
-  marker.color.r = r;
-  marker.color.g = g;
-  marker.color.b = b;
+void Sample::stop()
+{
+    stopping_ = true;
+    notifyFreshData();
+}
 
-  // Set the marker action. This will add it to the screen
-  marker.action = visualization_msgs::Marker::ADD;
+void Sample::applyMissionRequest()
+{
+    int request = missionRequest_.exchange(MISSION_NONE);
+    if(request == MISSION_NONE) return;
+    running_ = request == MISSION_START;
+    stateChange_ = true;
+}
 
-  // Sets the position of the marker
-  marker.pose.position.x = point.x;
-  marker.pose.position.y = point.y;
-  marker.pose.position.z = point.z;
+void Sample::notifyFreshData()
+{
+    {
+        std::unique_lock<std::mutex> lck(dataCvMtx_);
+        freshData_ = true;
+    }
+    dataCv_.notify_one();
+}
 
-  //Sets the orientation, we are not going to orientate it
-  marker.pose.orientation.x = 0.0;
-  marker.pose.orientation.y = 0.0;
-  marker.pose.orientation.z = 0.0;
-  marker.pose.orientation.w = 1.0;
+void Sample::waitForNextCycle(ros::Rate& rate_limiter)
+{
+    if(!eventDriven_){
+        rate_limiter.sleep();
+    }
+    else{
+        //Wakes as soon as a callback delivers data, the timeout keeps the loop alive if the sensors stop
+        std::unique_lock<std::mutex> lck(dataCvMtx_);
+        dataCv_.wait_for(lck, std::chrono::duration<double>(EVENT_TIMEOUT_), [this]{ return freshData_; });
+        freshData_ = false;
+    }
+}
 
-  //Alpha is transparency (50% transparent)
-  marker.color.a = 0.5f;
+void Sample::recordCommandLatency(const sensor_msgs::LaserScanConstPtr& scan)
+{
+    ros::Time now = ros::Time::now();
+    //Only the first command computed from each scan is counted
+    if(scan != lastLatencyScan_ && !scan->header.stamp.isZero()){
+        latencyHist_.record((now - scan->header.stamp).toSec());
+        lastLatencyScan_ = scan;
+    }
 
-  return marker;
+    if(lastLatencyPublish_.isZero()) lastLatencyPublish_ = now;
+    if((now - lastLatencyPublish_).toSec() < latencyPublishPeriod_ || latencyHist_.total() == 0) return;
+
+    std_msgs::UInt32MultiArray msg;
+    std_msgs::MultiArrayDimension dim;
+    dim.label = "latency_ms";
+    dim.size = latencyHist_.counts().size();
+    dim.stride = latencyHist_.counts().size();
+    msg.layout.dim.push_back(dim);
+    msg.data = latencyHist_.counts();
+    pubLatency_.publish(msg);
+
+    ROS_INFO("cmd_vel latency over %u scans: p50 %.1f ms, p99 %.1f ms", latencyHist_.total(),
+             latencyHist_.percentile(0.5)*1000.0, latencyHist_.percentile(0.99)*1000.0);
+    latencyHist_.clear();
+    lastLatencyPublish_ = now;
 }
 
 //Service that handles starting and stopping the missions based on command line input
@@ -436,8 +593,7 @@ bool Sample::request(std_srvs::SetBool::Request  &req,
     if(req.data)
     {
         ROS_INFO_STREAM("Requested: Start mission");
-        running_ = true; //start the robot if there is a goal
-        stateChange_ = true;
+        missionRequest_ = MISSION_START; //start the robot if there is a goal, on the next tick
         res.success = true;
         res.message = "The Turtlebot has started it's mission";
 
@@ -447,9 +603,8 @@ bool Sample::request(std_srvs::SetBool::Request  &req,
     {
         ROS_INFO_STREAM("Requested: Stop mission");
         res.success = true;
-        stateChange_ = true;
         res.message = "Turtlebot stopping";
-        running_ = false;
+        missionRequest_ = MISSION_STOP;
     }
     //return true when the service completes its request
     return true;
@@ -518,44 +673,62 @@ double Sample::fabs(double x)
     else return x;
 }
 
-visualization_msgs::MarkerArray Sample::CollectGoals(visualization_msgs::MarkerArray markerArray)
-{
-    if(pathData_.x > 0.0 || pathData_.x < 0.0){
-        // if(goals_.empty()) goals_.push_back(pathData_);
-        // else if(pathData_.x != goals_.back().x &&
-        //         pathData_.y != goals_.back().y &&
-        //         pathData_.z != goals_.back().z) goals_.push_back(pathData_);
-        if(goals_.empty()||(pathData_ != goals_.back())) goals_.push_back(pathData_);
+void Sample::GenerateSpline(){
+    PROFILE_SCOPE(profiler_, SPLINE);
+    goal_ = goals_.at(goalIdx_);
+    size_t legFirst = static_cast<size_t>(goalIdx_);
+    const CachedLeg* cached = nullptr;
+    for(const auto& leg : cachedLegs_){
+        if(leg.first == static_cast<size_t>(goalIdx_)) cached = &leg;
     }
-
-    if(!goals_.empty()){
+    if(cached != nullptr){
+        //The robot is at an exhibit, the spline to the next one was generated with the tour cache
+        path_ = squiggles::Trajectory(cached->trajectory);
+        legFirst = cached->first;
+        goalIdx_ = cached->last;
         goal_ = goals_.at(goalIdx_);
-        for(int i = 0; i < goals_.size(); i++){
-            geometry_msgs::Point markerPoint;
-            markerPoint.x = goals_.at(i).x;
-            markerPoint.y = goals_.at(i).y;
-            visualization_msgs::Marker marker = createMarker(markerPoint, 1.0, 0.0, 0.0);
-            markerArray.markers.push_back(marker);
+    }
+    else{
+        //The stream runs along goals_, so reaching a goal only takes the next leg, which was generated while driving
+        try{
+            if(streamGoal_ != goalIdx_ || !splineStream_.next(path_)){
+                startSplineStream();
+                splineStream_.next(path_);
+            }
+            streamGoal_ = goalIdx_ + 1;
+        }
+        catch(const std::exception& e){
+            //The stream stops at a leg it cannot solve, so the next goal starts a new one
+            ROS_WARN("No spline to goal %d: %s, driving the straight leg", goalIdx_, e.what());
+            straightLeg();
+            streamGoal_ = -1;
         }
     }
-    return markerArray;
-}
-
-void Sample::GenerateSpline(){
-    goal_ = goals_.at(goalIdx_);
-    squiggles::Constraints constraints = squiggles::Constraints(MAX_VEL, MAX_ACCEL, MAX_JERK);
-    squiggles::SplineGenerator generator = squiggles::SplineGenerator(
-        constraints,
-        std::make_shared<squiggles::TankModel>(ROBOT_WIDTH_, constraints));
-    path_ = generator.generate({squiggles::Pose(robotPose_.position.x, robotPose_.position.y, tf::getYaw(robotPose_.orientation)),
-                                squiggles::Pose(goal_.x, goal_.y, GetGoalOrientation(goals_, robotPose_))});
+    //The quintics bulge off the straight legs the planner checked, so a spline cutting a corner is re-solved along them
+    if(!clearanceMap_->empty() && !path_.empty() && !trajectoryValidator_.validate(path_.view(), *clearanceMap_)){
+        const size_t violation = trajectoryValidator_.firstViolation();
+        splineCorners_.assign(goals_.begin() + legFirst, goals_.begin() + goalIdx_ + 1);
+        if(trajectoryValidator_.repair(path_.view(), splineCorners_, *clearanceMap_, path_)){
+            ROS_INFO("Spline re-solved clear of obstacles in %.2f ms", trajectoryValidator_.lastRepairTime());
+        }
+        else{
+            ROS_WARN("Spline comes within %.2f m of an obstacle from sample %zu", trajectoryValidator_.minClearance(), violation);
+        }
+    }
+    //The spline is tracked by time from its start, the view stays valid until path_ is next replaced
     time_ = 0.0;
-    velIdx_ = 0;
-    minIdx_ = 0;
+    trajectoryTracker_.setTrajectory(path_.view());
+    const squiggles::TrajectoryView path = path_.view();
+    splineSamples_.resize(path.size);
+    for(size_t i = 0; i < path.size; i++){
+        splineSamples_[i].x = path.x[i];
+        splineSamples_[i].y = path.y[i];
+    }
+    detouring_ = false;
     ROS_INFO_STREAM("Path generated\n");
 }
 
-double Sample::GetGoalOrientation(std::vector<geometry_msgs::Point> goals, geometry_msgs::Pose robot)
+double Sample::GetGoalOrientation(const std::vector<geometry_msgs::Point>& goals, geometry_msgs::Pose robot)
 {
     if (goalIdx_ < goals.size()-2){
         geometry_msgs::Point goal = goals.at(goalIdx_+1);
@@ -568,26 +741,49 @@ double Sample::GetGoalOrientation(std::vector<geometry_msgs::Point> goals, geome
     else return 0.0;
 }
 
-geometry_msgs::Point Sample::FindLookaheadPoint(std::vector<geometry_msgs::Point> goals)
+geometry_msgs::Point Sample::FindLookaheadPoint(PathTracker& tracker)
 {
-    for (size_t i = minIdx_; i < goals.size() - 1; i++) {
-        geometry_msgs::Point goal;
-        goal.x = goals.at(i).x;
-        goal.y = goals.at(i).y;
-        goalIdx_ = i;
-        
-        if (DistanceToGoal(goal, robotPose_) > lookahead_dist_) {
-            minIdx_ = i;
-            return goal;
+    // Moves the projection of the robot along the path, then looks ahead of it
+    tracker.update(robotPose_.position.x, robotPose_.position.y);
+    return tracker.lookahead(lookahead_dist_);
+}
+
+bool Sample::updateDetour()
+{
+    const std::vector<geometry_msgs::Point>& path = trajMode_ == 2 ? splineSamples_ : tourPoints_;
+    const size_t segment = trajMode_ == 2 ? trajectoryTracker_.index() : goalTracker_.segment();
+    const double x = robotPose_.position.x, y = robotPose_.position.y;
+    if(!localCostmap_.free(x, y)) return false;
+    if(path.size() < 2) return true;
+
+    if(detouring_){
+        //Once the detour's reference reaches the path, the path is followed again from where the detour joined it
+        if(detourTracker_.finished()){
+            detouring_ = false;
+            if(trajMode_ == 2) time_ = std::max(time_, trajectoryTracker_.timeAt(detourRejoin_));
+            return true;
         }
+        if(localPlanner_.free(detour_.view(), detourTracker_.index(), localCostmap_)) return true;
+    }
+    else if(!localPlanner_.blocked(path, segment, x, y, localCostmap_)) return true;
+
+    //Something is on the path or the detour, a new detour starts from where the robot is now
+    detouring_ = localPlanner_.replan(robotPose_, path, segment, localCostmap_, detour_, detourRejoin_);
+    if(detouring_){
+        detourTracker_.setTrajectory(detour_.view());
+        detourTime_ = 0.0;
+        ROS_INFO("Detour around an obstacle planned in %.2f ms", localPlanner_.lastPlanTime());
     }
+    else ROS_INFO_THROTTLE(1.0, "The path is blocked, waiting for it to clear");
+    return detouring_;
+}
 
-    // If no valid lookahead point is found, return the last waypoint
-    geometry_msgs::Point back;
-    back.x = goals.back().x;
-    back.y = goals.back().y;
-    goalIdx_ = goals.size() - 1;
-    return back;
+double Sample::trackingStep()
+{
+    ros::Time now = ros::Time::now();
+    double step = lastTrackTime_.isZero() ? 0.0 : std::min((now - lastTrackTime_).toSec(), 2 * LOOP_PERIOD_);
+    lastTrackTime_ = now;
+    return step;
 }
 
 double Sample::computeCurvature(geometry_msgs::Point goal, geometry_msgs::Pose robot)
@@ -603,113 +799,231 @@ double Sample::SmoothVel(unsigned int idx)
     else return 0.26;
 }
 
-std::vector<geometry_msgs::Point> Sample::generateRandomGoals(PathPlanning pathPlanning)
-{
-    // unordered_goals_.clear();
-    //PathPlanning.getGoals();
-    
-    geometry_msgs::Point start;
-    geometry_msgs::Point end;
-    std::vector<geometry_msgs::Point> waypts_simplified; // the vector created by plan between two Goals
-    std::vector<geometry_msgs::Point> combined_waypoints;
-    for (int i=0; i<5; i++)
-    {
-        // push a random goal into the unordered_goals_ vector
-        pathPlanning.generateRandomGoal(unordered_goals_, robotPose_);
-        //start = unordered_goals_[i].pose.position;
-        //std::cout << "unordered_goals_[ " << i << " ]: {" << start.x << " , " << start.y << "}." << std::endl; 
-        if(i==0)
-        {
-            start.x = robotPose_.position.x; start.y = robotPose_.position.x; // as starting point is always (0,0)
-            end = unordered_goals_[i].pose.position;
+void Sample::planMap(const MapSnapshot& snapshot){
+    const nav_msgs::OccupancyGrid& map = *snapshot.map;
+    PathPlanning* previous = pathPlanningPtr_;
+    //Only the patches since the planned version change anything, those before it are already planned on
+    const bool patch = previous != nullptr && snapshot.base == plannedMapBase_ && snapshot.version > plannedMapVersion_ &&
+                       !snapshot.patches.empty();
+    MapRegion patched;
+    if(patch){
+        for(size_t i = plannedMapVersion_ - snapshot.base; i < snapshot.patches.size(); i++) patched = patched.united(snapshot.patches[i]);
+        pathPlanningPtr_ = new PathPlanning(*previous, snapshot.map, patched);
+    }
+    else{
+        unsigned int seed = goalSeed_ != 0 ? goalSeed_ + snapshot.version : std::random_device{}();
+        pathPlanningPtr_ = new PathPlanning(snapshot.map, threshold_distance_, world_x_, world_y_, seed);
+    }
+    delete previous;
+    clearanceMap_ = pathPlanningPtr_->clearanceMap();
+    plannedMapVersion_ = snapshot.version;
+    plannedMapBase_ = snapshot.base;
+
+    const double resolution = map.info.resolution;
+    if(!patch){
+        //Cached splines map into the files of the previous map
+        if(tourCache_.setMap(TourCache::mapHash(map, exhibits_))) cachedLegs_.clear();
+        //A new map can block any leg of a tour already under way
+        replanBlockedLegs(map.info.origin.position.x, map.info.origin.position.y,
+                          map.info.origin.position.x + map.info.width * resolution,
+                          map.info.origin.position.y + map.info.height * resolution);
+        return;
+    }
+    //The cached legs of the full map stay valid away from the patch, a path keeps threshold_distance_ from it
+    const double minX = map.info.origin.position.x + patched.x0 * resolution - threshold_distance_;
+    const double minY = map.info.origin.position.y + patched.y0 * resolution - threshold_distance_;
+    const double maxX = map.info.origin.position.x + (patched.x1 + 1) * resolution + threshold_distance_;
+    const double maxY = map.info.origin.position.y + (patched.y1 + 1) * resolution + threshold_distance_;
+    tourCache_.invalidate(minX, minY, maxX, maxY);
+    size_t kept = 0;
+    for(const auto& leg : cachedLegs_){
+        if(leg.first == 0 || tourCache_.stale(goals_[leg.first - 1],
+                                              std::vector<geometry_msgs::Point>(goals_.begin() + leg.first, goals_.begin() + leg.last + 1))) continue;
+        cachedLegs_[kept++] = leg;
+    }
+    if(kept < cachedLegs_.size()) ROS_INFO("A map update touches %zu cached legs, they are splined live", cachedLegs_.size() - kept);
+    cachedLegs_.resize(kept);
+    replanBlockedLegs(minX, minY, maxX, maxY);
+}
+
+void Sample::replanBlockedLegs(double minX, double minY, double maxX, double maxY){
+    if(goals_.empty() || static_cast<size_t>(goalIdx_) >= goals_.size() || clearanceMap_->empty()) return;
+    //The legs ahead run from the robot through the goals not yet reached
+    std::vector<geometry_msgs::Point> ahead(1, robotPose_.position);
+    ahead.insert(ahead.end(), goals_.begin() + goalIdx_, goals_.end());
+    const double step = clearanceMap_->resolution();
+    std::vector<bool> blocked(ahead.size() - 1, false);
+    bool any = false;
+    for(size_t i = 0; i + 1 < ahead.size(); i++){
+        const geometry_msgs::Point& a = ahead[i];
+        const geometry_msgs::Point& b = ahead[i + 1];
+        if(std::max(a.x, b.x) < minX || std::min(a.x, b.x) > maxX || std::max(a.y, b.y) < minY || std::min(a.y, b.y) > maxY) continue;
+        //The planner kept threshold_distance_ along the leg, so a sample closer than that is a new obstacle
+        const size_t samples = std::max<size_t>(1, std::ceil(std::hypot(b.x - a.x, b.y - a.y) / step));
+        for(size_t k = 1; k <= samples && !blocked[i]; k++){
+            const double u = static_cast<double>(k) / samples;
+            blocked[i] = !clearanceMap_->isClear(a.x + u * (b.x - a.x), a.y + u * (b.y - a.y), threshold_distance_);
         }
-        else
-        {
-            start = unordered_goals_[i-1].pose.position;
-            end = unordered_goals_[i].pose.position;
+        any = any || blocked[i];
+    }
+    if(!any) return;
+
+    //Each run of blocked legs is replaced by a path between the waypoints either side of it
+    std::vector<geometry_msgs::Point> replanned;
+    std::vector<long> moved(ahead.size(), -1); //index in replanned of each kept waypoint of ahead
+    std::vector<geometry_msgs::Point> leg;
+    size_t runs = 0, failed = 0;
+    for(size_t i = 0; i + 1 < ahead.size(); ){
+        if(!blocked[i]){
+            moved[i + 1] = replanned.size();
+            replanned.push_back(ahead[i + 1]);
+            i++;
+            continue;
+        }
+        size_t j = i;
+        while(j + 1 < blocked.size() && blocked[j + 1]) j++;
+        runs++;
+        if(pathPlanningPtr_->planPath(ahead[i], ahead[j + 1], leg)){
+            replanned.insert(replanned.end(), leg.begin(), leg.end());
         }
-        
-        // for error checking
-        std::cout << "Start set: {" << start.x << " , " << start.y << "}." << std::endl; 
-        std::cout << "End set : {" << end.x << " , " << end.y << "}." << std::endl; 
-        
-        // find simplified path
-        waypts_simplified = planBetweenTwoGoals(pathPlanning, start, end);
-        // publish to rostopic 'thepath'
-        // publishPath(waypts_simplified);
-        std::cout << "Waypoints from Goal " << i << " to Goal " << (i+1) << " published to ROS Topic /thepath." << std::endl;
-        combined_waypoints.insert(combined_waypoints.end(), waypts_simplified.begin(), waypts_simplified.end());
+        else{
+            failed++;
+            replanned.insert(replanned.end(), ahead.begin() + i + 1, ahead.begin() + j + 1);
+            replanned.push_back(ahead[j + 1]);
+        }
+        moved[j + 1] = replanned.size() - 1;
+        i = j + 1;
     }
-    return combined_waypoints;
-            
-  
-        // // making vector of point msgs from start and end
- 
-
 
+    //Cached legs ahead keep their spline if no waypoint from their start exhibit on was replanned
+    size_t kept = 0;
+    for(const auto& cachedLeg : cachedLegs_){
+        if(cachedLeg.first <= static_cast<size_t>(goalIdx_)) continue;
+        //The start exhibit goals_[first - 1] is at first - goalIdx_ in ahead
+        const size_t from = cachedLeg.first - goalIdx_, to = cachedLeg.last - goalIdx_ + 1;
+        bool intact = moved[from] >= 0;
+        for(size_t k = from + 1; k <= to && intact; k++) intact = moved[k] == moved[k - 1] + 1;
+        if(!intact) continue;
+        CachedLeg remapped = cachedLeg;
+        remapped.first = moved[from] + 1;
+        remapped.last = moved[to];
+        cachedLegs_[kept++] = remapped;
+    }
+    cachedLegs_.resize(kept);
 
-    //  ADD TRAVELLING SALESMAN 
+    goals_.swap(replanned);
+    goalIdx_ = 0;
+    tourPoints_.assign(1, robotPose_.position);
+    tourPoints_.insert(tourPoints_.end(), goals_.begin(), goals_.end());
+    goalTracker_.setPath(tourPoints_);
+    goal_ = goals_.at(goalIdx_);
+    ROS_INFO("Replanned %zu blocked runs of legs ahead, %zu have no path and are kept", runs, failed);
+    //The stream and any detour followed the old waypoints, the spline starts again from the robot
+    streamGoal_ = -1;
+    detouring_ = false;
+    if(trajMode_ == 2 && running_) GenerateSpline();
+}
 
-        // geometry_msgs::PoseStamped goal_msg;
-        // goal_msg.pose.position.x = goal_point.x; // Set the goal position x-coordinate
-        // goal_msg.pose.position.y = goal_point.y; // Set the goal position y-coordinate
-        // goal_msg.pose.orientation.w = 1.0;
-        // goal_msg.header.stamp = ros::Time::now();
-        // goal_msg.header.frame_id = "map";
-        // //std::cout << "Goal about to be published." << std::endl;
-        // goal_pub_.publish(goal_msg);
-        // std::cout << "Goal published." << std::endl;
+void Sample::startSplineStream(){
+    size_t end = goals_.size();
+    for(const auto& leg : cachedLegs_){
+        if(leg.first > static_cast<size_t>(goalIdx_)) end = std::min(end, leg.first);
+    }
+    splineWaypoints_.clear();
+    splineWaypoints_.push_back(squiggles::Pose(robotPose_.position.x, robotPose_.position.y, tf::getYaw(robotPose_.orientation)));
+    for(size_t i = goalIdx_; i < end; i++){
+        const geometry_msgs::Point& from = i + 1 < end ? goals_[i] : (i > static_cast<size_t>(goalIdx_) ? goals_[i - 1] : robotPose_.position);
+        const geometry_msgs::Point& to = i + 1 < end ? goals_[i + 1] : goals_[i];
+        splineWaypoints_.push_back(squiggles::Pose(goals_[i].x, goals_[i].y, std::atan2(to.y - from.y, to.x - from.x)));
+    }
+    //Only the first leg is generated before this returns
+    splineStream_.start(splineWaypoints_);
+    ROS_INFO("Streaming the spline through %ld goals", end - goalIdx_);
+}
+void Sample::straightLeg(){
+    const double x0 = robotPose_.position.x, y0 = robotPose_.position.y;
+    const double length = std::hypot(goal_.x - x0, goal_.y - y0);
+    const double heading = length > 0.0 ? std::atan2(goal_.y - y0, goal_.x - x0) : tf::getYaw(robotPose_.orientation);
+    //Accelerates to the peak speed and back down, a leg too short to reach MAX_VEL peaks below it
+    const double peak = std::min(MAX_VEL, std::sqrt(length * MAX_ACCEL));
+    const double ramp = peak > 0.0 ? peak / MAX_ACCEL : 0.0;
+    const double cruise = peak > 0.0 ? (length - peak * ramp) / peak : 0.0;
+    const double total = 2.0 * ramp + cruise;
+    const double dt = 0.1;
+
+    std::vector<squiggles::ProfilePoint> points;
+    for(size_t i = 0; ; i++){
+        const double t = std::min(i * dt, total);
+        double s, v, a;
+        if(t < ramp){
+            s = 0.5 * MAX_ACCEL * t * t; v = MAX_ACCEL * t; a = MAX_ACCEL;
+        }
+        else if(t < ramp + cruise){
+            s = 0.5 * peak * ramp + peak * (t - ramp); v = peak; a = 0.0;
+        }
+        else{
+            const double left = total - t;
+            s = length - 0.5 * MAX_ACCEL * left * left; v = MAX_ACCEL * left; a = left > 0.0 ? -MAX_ACCEL : 0.0;
+        }
+        const double u = length > 0.0 ? s / length : 0.0;
+        points.push_back(squiggles::ProfilePoint(
+            squiggles::ControlVector(squiggles::Pose(x0 + u * (goal_.x - x0), y0 + u * (goal_.y - y0), heading), v, a, 0.0),
+            {v, v}, 0.0, t));
+        if(t >= total) break;
+    }
+    path_ = squiggles::Trajectory(points);
+}
 
+std::vector<geometry_msgs::Point> Sample::generateRandomGoals(PathPlanning& pathPlanning)
+{
+    // Planned in process, move_base is only asked for the legs the grid planner cannot plan
+    std::vector<geometry_msgs::Point> goals;
+    std::vector<geometry_msgs::Point> combined_waypoints;
+    pathPlanning.planRandomTour(robotPose_, numGoals_, navfnFallback_ ? &navfn_ : nullptr, goals, combined_waypoints);
+    for (size_t i = 0; i < goals.size(); i++)
+    {
+        std::cout << "Goal " << i << ": {" << goals[i].x << " , " << goals[i].y << "}." << std::endl;
+    }
+    return combined_waypoints;
 }
 
-std::vector<geometry_msgs::Point> Sample::planBetweenTwoGoals(PathPlanning pathPlanning, geometry_msgs::Point st, geometry_msgs::Point en)
+std::vector<geometry_msgs::Point> Sample::exhibitTour(PathPlanning& pathPlanning)
 {
-    std::vector<geometry_msgs::Point> points;
-  // Create a request message for the service
-    nav_msgs::GetPlan srv;
-    srv.request.start.header.frame_id = "map";
-    srv.request.start.pose.position.x = st.x;
-    srv.request.start.pose.position.y = st.y;
-    srv.request.start.pose.orientation.w = 1.0;
-
-    srv.request.goal.header.frame_id = "map";
-    srv.request.goal.pose.position.x = en.x;
-    srv.request.goal.pose.position.y = en.y;
-    srv.request.goal.pose.orientation.w = 1.0;
-
-    // Call the service - the statement within the if() calls the service with srv
-    if (make_plan_.call(srv)) {
-        if (!srv.response.plan.poses.empty())
+    cachedLegs_.clear();
+    std::vector<geometry_msgs::Point> tour;
+    std::vector<geometry_msgs::Point> leg;
+    squiggles::TrajectoryView trajectory;
+    auto begin = std::chrono::steady_clock::now();
+    unsigned int hits = 0;
+    unsigned int live = 0;
+
+    // The robot can start anywhere, so nothing is cached for the leg to the first exhibit
+    geometry_msgs::Point start;
+    start.x = robotPose_.position.x; start.y = robotPose_.position.y;
+    int last = -1; // the exhibit the robot will be at, -1 before the first
+    for (size_t i = 0; i < exhibits_.size(); i++)
+    {
+        if (last >= 0 && tourCache_.lookup(last, i, exhibits_[last], leg, trajectory))
         {
-            ROS_INFO("Plan received with %ld poses", srv.response.plan.poses.size());
-            for (size_t i = 0; i < srv.response.plan.poses.size(); i += 10) // get every 10 points
-            {   
-                points.push_back(srv.response.plan.poses[i].pose.position);
-                double x = srv.response.plan.poses[i].pose.position.x;
-                double y = srv.response.plan.poses[i].pose.position.y;
-                //std::cout << "Position: (" << x << " , " << y << ")." << std::endl; 
-            }
-            // if last point is not end point / goal
-            if(!(points.back()==en))
+            hits++;
+            if (!trajectory.empty()) cachedLegs_.push_back({tour.size(), tour.size() + leg.size() - 1, trajectory});
+        }
+        else
+        {
+            const geometry_msgs::Point& from = last >= 0 ? exhibits_[last] : start;
+            if (!pathPlanning.planPath(from, exhibits_[i], leg))
             {
-                //std::cout << "Since point vector doesn't have end goal as last point, pushing it back." << std::endl; 
-                points.push_back(en);
-                //std::cout << "Position: (" << en.x << " , " << en.y << ")." << std::endl; 
+                ROS_WARN("Exhibit %zu cannot be reached, leaving it out of the tour", i);
+                continue;
             }
-
-        } 
-        else 
-        {
-            ROS_WARN("Received an empty plan so removing last random goal. Generating new goal...");
-            unordered_goals_.pop_back();
-            pathPlanning.generateRandomGoal(unordered_goals_, robotPose_);
+            live++;
         }
-    } 
-    else
-    {
-        ROS_ERROR("Failed to call service make_plan");
+        tour.insert(tour.end(), leg.begin(), leg.end());
+        last = i;
     }
 
-    std::cout << "Number of elements in the simplified points vector is: " << points.size() << std::endl;
-    return points;
-}
\ No newline at end of file
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    ROS_INFO("Tour of %zu exhibits with %zu waypoints in %.2f ms, %u legs cached and %u planned live",
+             exhibits_.size(), tour.size(), elapsed, hits, live);
+    return tour;
+}
@@ -4,6 +4,7 @@
 #include "ros/ros.h"
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
 #include "squiggles.hpp"
 
 // #include "spline.hpp"
@@ -23,11 +24,27 @@
 #include "nav_msgs/OccupancyGrid.h"
 #include "std_msgs/Header.h"
 #include "nav_msgs/MapMetaData.h"
+#include "map_msgs/OccupancyGridUpdate.h"
 #include <nav_msgs/GetPlan.h>
+#include "std_msgs/UInt32MultiArray.h"
+#include "nav_msgs/Path.h"
 
 //We include header of another class we are developing
 #include "laserprocessing.h"
 #include "pathplanning.h"
+#include "latencyhistogram.h"
+#include "pathtracker.h"
+#include "trajectorytracker.h"
+#include "trajectoryvalidator.h"
+#include "localcostmap.h"
+#include "localplanner.h"
+#include "tourcache.h"
+#include "markerpublisher.h"
+#include "navfnplanner.h"
+#include "loopprofiler.h"
+#include "seqlock.h"
+#include "posepredictor.h"
+#include "robotlimits.h"
 
 /*!
  *  \brief     Sample Class
@@ -35,6 +52,11 @@
  *  This class is used for communicating with the simulator environment using ROS using the provided libraries.
  *  It is designed to use laserprocessing to interpret laser data and imageprocessing to interpret image data.
  *  This information is used to generate an input for the control or the Turtlebot to follow the AR tag.
+ *
+ *  The callbacks and services never block the control thread, nor it them. The pose, predicted from amcl_pose
+ *  and odometry, is published through a SeqLock, the scan, map snapshot and path are shared pointers swapped
+ *  atomically, and mission requests are posted for the control thread to apply. Everything else, the goals, the
+ *  spline and the mission state, is owned by the control thread and only touched from seperateThread().
  *  \author    Ashton Powell
  *  \version   1.00
  *  \date      2024-XX-XX
@@ -46,7 +68,22 @@ public:
   ///
   /// Sets the default values of variables such as the robot position, the goals, the running_ boolean, etc.
   /// Requires the NodeHandle input to communicate with ROS.
-  Sample(ros::NodeHandle nh);
+  /// Reads the private parameters ~event_driven (default false), ~latency_publish_period (default 5.0 s)
+  /// ~goal_seed (default 0, a non zero seed makes the random goals repeatable for a map)
+  /// ~threshold_distance (default 0.15 m, the clearance goals and paths keep from obstacles)
+  /// ~navfn_fallback (default true, asks move_base for a plan when the grid planner finds none)
+  /// ~num_goals (default 5, the number of exhibits toured), ~exhibits (a flat list x0, y0, x1, y1, ...
+  /// toured in order instead of random goals), ~tour_cache_dir (the tour cache built by the
+  /// tour_cache_builder node for ~exhibits, empty plans every leg live) and ~follow_thepath (default false,
+  /// tours the waypoints received on /thepath instead of planning its own), ~pose_prediction (default true, moves
+  /// the amcl_pose fix on by odometry between updates) and ~odom_topic (default odom, noisy_odom drives it off the
+  /// noisy odometry).
+  /// When built with ARTBOT_PROFILE also ~profile_publish_period (default 5.0 s) and ~profile_dump_file
+  /// (default empty, the file the loop profile is written to on SIGUSR1).
+  /// Every topic and service but /map and /map_updates is relative to nh, so each robot of a fleet runs in its own namespace.
+  /// @param [in] nh - node handle the topics are on
+  /// @param [in] pnh - node handle the private parameters are read from, a nodelet passes its own
+  Sample(ros::NodeHandle nh, ros::NodeHandle pnh = ros::NodeHandle("~"));
 
   /// @brief Destructor of the Sample class.
   ///
@@ -60,13 +97,27 @@ public:
   /// The data is then used to publish input to move the TurtleBot, causing new data to be generated on its updated position and perspective.
   void seperateThread();
 
+  /// @brief One cycle of the control loop on the latest sensor data, seperateThread() runs it at the loop rate
+  ///
+  /// Callers other than seperateThread() drive the loop themselves, such as the replay harness on a simulated clock.
+  /// @param [out] twist - the command computed this cycle
+  /// @return true if the command was published on /cmd_vel, false before there is a scan, goals or a drive mode
+  bool step(geometry_msgs::Twist& twist);
+
+  /// @brief Getter for the period of the control loop [s]
+  double loopPeriod() const;
+
+  /// @brief Makes seperateThread() return within a cycle, for a nodelet being unloaded while ROS keeps running
+  void stop();
+
   void laserCallback(const sensor_msgs::LaserScanConstPtr& msg);
 
   /// @brief Odometry Callback from the world reference of the TurtleBot
   ///
+  /// Moves the predicted pose on from the last amcl fix.
   /// @param [in|out] msg nav_msgs::OdometryConstPtr - The odometry message
   /// @note This function and the declaration are ROS specific
-  // void odomCallback(const nav_msgs::OdometryConstPtr& msg);
+  void odomCallback(const nav_msgs::OdometryConstPtr& msg);
 
   /// @brief Odometry Callback from the world reference of the TurtleBot
   ///
@@ -74,15 +125,22 @@ public:
   /// @note This function and the declaration are ROS specific
   void amclCallback(const geometry_msgs::PoseWithCovarianceStampedConstPtr& msg);
 
-  /// @brief Odometry Callback from the world reference of the TurtleBot
+  /// @brief Path Callback for the whole tour planned by the waypoints producer
   ///
-  /// @param [in|out] msg nav_msgs::OdometryConstPtr - The odometry message
+  /// @param [in] msg nav_msgs::PathConstPtr - every waypoint of the tour, in order
   /// @note This function and the declaration are ROS specific
-  void pathCallback(const geometry_msgs::PointConstPtr& msg);
+  void pathCallback(const nav_msgs::PathConstPtr& msg);
 
   void mapCallback(const nav_msgs::OccupancyGrid::ConstPtr& msg);
 
-  visualization_msgs::Marker createMarker(geometry_msgs::Point point, double r, double g, double b);
+  /// @brief Map update Callback patching a region of the latest map
+  ///
+  /// The latest map is copied with the patch written in, since shared messages are never modified, and stored
+  /// with the region patched since the last full map, so the control thread only updates the planning over it.
+  /// An update outside the map, or before any map, is dropped.
+  /// @param [in] msg map_msgs::OccupancyGridUpdateConstPtr - cells of a rectangle of the map
+  /// @note This function and the declaration are ROS specific
+  void mapUpdateCallback(const map_msgs::OccupancyGridUpdateConstPtr& msg);
 
   /// @brief request service callback for starting and stopping the mission and Turtlebot's movement.
   ///
@@ -135,29 +193,116 @@ public:
 
   void GenerateSpline();
 
-  visualization_msgs::MarkerArray CollectGoals(visualization_msgs::MarkerArray markerArray);
-
-  double GetGoalOrientation(std::vector<geometry_msgs::Point> goals, geometry_msgs::Pose robot);
+  double GetGoalOrientation(const std::vector<geometry_msgs::Point>& goals, geometry_msgs::Pose robot);
 
-  geometry_msgs::Point FindLookaheadPoint(std::vector<geometry_msgs::Point> goals);
+  /// @brief Gets the point lookahead_dist_ along a path ahead of the robot
+  ///
+  /// @param [in|out] tracker the path, keeps the robot's progress along it between calls
+  ///
+  /// @return the lookahead point, the end of the path when the robot is closer than lookahead_dist_ to it.
+  geometry_msgs::Point FindLookaheadPoint(PathTracker& tracker);
 
   double computeCurvature(geometry_msgs::Point goal, geometry_msgs::Pose robot);
 
   double SmoothVel(unsigned int idx);
 
-  std::vector<geometry_msgs::Point> generateRandomGoals(PathPlanning pathPlanning);
+  std::vector<geometry_msgs::Point> generateRandomGoals(PathPlanning& pathPlanning);
 
-  std::vector<geometry_msgs::Point> planBetweenTwoGoals(PathPlanning pathPlanning, geometry_msgs::Point st, geometry_msgs::Point en);
+  /// @brief Gets the waypoints of a tour of exhibits_ in order, starting at the robot
+  ///
+  /// Legs between exhibits are read from tourCache_ and planned live when they are missing from it,
+  /// the leg from the robot to the first exhibit is always planned live.
+  /// Exhibits which cannot be reached are left out of the tour.
+  /// @param [in] pathPlanning the planner for the current map
+  ///
+  /// @return the waypoints of every leg joined in order
+  std::vector<geometry_msgs::Point> exhibitTour(PathPlanning& pathPlanning);
   
 private:
+  //! A map with its version, swapped whole so the version always labels its own map
+  struct MapSnapshot
+  {
+    //! The occupancy grid, never modified
+    nav_msgs::OccupancyGrid::ConstPtr map;
+    //! Incremented for every map and every patch
+    unsigned int version;
+    //! Version of the last full map, the map is that one with patches written in
+    unsigned int base;
+    //! Cells of each patch since the full map, the patch making version base + i + 1 first
+    std::vector<MapRegion> patches;
+  };
+
+  /// @brief Builds the path planning for a new map snapshot, patching the current one when the map only changed in a region
+  ///
+  /// A patch keeps the tour cache on its map and only stops it looking up, and cachedLegs_ following, the legs
+  /// through the cells patched since the planned version, grown by threshold_distance_. The legs of goals_ still
+  /// ahead which no longer keep clear of the changed box are then replanned, see replanBlockedLegs().
+  void planMap(const MapSnapshot& snapshot);
+
+  /// @brief Replans the legs ahead of the robot which cross a box and no longer keep threshold_distance_ on the map
+  ///
+  /// Each run of blocked legs is replaced by a grid path between the waypoints either side of it, the goals
+  /// already reached are dropped from goals_ and the tracked path, and the spline is generated again from the robot.
+  /// A run with no path is kept, for the local planner to detour round.
+  /// @param [in] minX - lower x of the box [m]
+  /// @param [in] minY - lower y of the box [m]
+  /// @param [in] maxX - upper x of the box [m]
+  /// @param [in] maxY - upper y of the box [m]
+  void replanBlockedLegs(double minX, double minY, double maxX, double maxY);
+
+  /// @brief Starts, replans or ends a detour around obstacles the local costmap has on the path ahead
+  ///
+  /// The path is the spline samples in trajMode 2 and the robot start followed by goals_ otherwise.
+  /// @return false if the robot should stop, the path and every detour are blocked or the robot is boxed in
+  bool updateDetour();
+
+  /// @brief Gets the time since the last tick that drove the robot, used to advance the tracking clocks
+  /// @return the time, at most two loop periods and 0 on the first tick after a stop [s]
+  double trackingStep();
+
+  /// @brief Wakes the control thread when a callback has delivered new data
+  void notifyFreshData();
+
+  /// @brief The body of step(), which times it as one tick of the loop profiler
+  /// @param [out] twist - the command computed this cycle
+  /// @return true if the command was published on /cmd_vel
+  bool tick(geometry_msgs::Twist& twist);
+
+  /// @brief Applies the latest /mission request, called by the control thread at the start of a tick
+  void applyMissionRequest();
+
+  /// @brief Blocks until the next control cycle should run.
+  ///
+  /// In event driven mode this waits for notifyFreshData(), otherwise it sleeps on the rate limiter.
+  /// @param [in] rate_limiter the fixed rate used when not event driven
+  void waitForNextCycle(ros::Rate& rate_limiter);
+
+  /// @brief Records the scan stamp to cmd_vel latency and publishes the histogram when it is due.
+  /// @param [in] scan the scan the published command was computed from
+  void recordCommandLatency(const sensor_msgs::LaserScanConstPtr& scan);
+
+  /// @brief Starts streaming the spline from the robot through goals_ from goalIdx_
+  ///
+  /// The stream stops at the exhibit a cached leg starts from, the cached spline is followed from there.
+  /// Each goal faces the next one and the last keeps the heading it is reached with.
+  void startSplineStream();
+
+  /// @brief Replaces path_ with the straight line from the robot to goal_
+  ///
+  /// The fallback when no spline can be generated: a trapezoidal speed profile within MAX_VEL and MAX_ACCEL,
+  /// sampled as often as the spline stream, with both wheels at the same speed.
+  void straightLeg();
+
   //! Node handle for communication
   ros::NodeHandle nh_;
   //! Driving command publisher
   ros::Publisher pubDrive_;
-  //! Driving command publisher
-  ros::Publisher pubVis_;
+  //! Goal, path and lookahead markers for RViz
+  MarkerPublisher markers_;
   //! Goal publisher 
   ros::Publisher goal_pub_;
+  //! Scan to cmd_vel latency histogram publisher, bin i counts latencies in [i, i+1) ms and the last bin is overflow
+  ros::Publisher pubLatency_;
   //! Laser scan subscriber, uses LaserCallback
   ros::Subscriber sub1_;
   //! Robot odometry subscriber, uses OdomCallback
@@ -166,35 +311,70 @@ private:
   ros::Subscriber sub3_;
   //! Map subscribe
   ros::Subscriber sub4_;
+  //! Map update subscribe
+  ros::Subscriber sub5_;
+  //! Robot odometry subscriber, uses odomCallback
+  ros::Subscriber sub6_;
   //! Mission service, starts and stops the mission
   ros::ServiceServer service1_;
   //! Mission service, starts and stops the mission
   ros::ServiceServer service2_;
-  //! Make Plan
-  ros::ServiceClient make_plan_;
+  //! Plans the legs the grid planner cannot with move_base
+  NavfnPlanner navfn_;
   
   //! Pointer to Laser Object
   LaserProcessing* laserProcessingPtr_;
 
   PathPlanning* pathPlanningPtr_;
 
-  //! Stores the laser data from the LIDAR scanner
-  sensor_msgs::LaserScan laserData_;
-  //! Mutex to lock laserData_
-  std::mutex laserDataMtx_;
-  //! Stores the position and orientation of the robot
+  //! Latest laser scan from the LIDAR scanner, never modified, only swapped and copied with boost::atomic_store/load
+  sensor_msgs::LaserScanConstPtr laserData_;
+  //! Segments of the latest scan, owned by the control thread
+  ScanSegmenter scanSegmenter_;
+  //! Latest fix from amclCallback moved on by odomCallback
+  PosePredictor predictor_;
+  //! Position and orientation of the robot, predicted from predictor_ at the start of each tick by the control thread
   geometry_msgs::Pose robotPose_;
-  //! Mutex to lock robotPose_
-  std::mutex robotPoseMtx_;
-  //! Stores the position and orientation of the robot
-  geometry_msgs::Point pathData_;
-  //! Mutex to lock robotPose_
-  std::mutex pathDataMtx_;
-
-  //! Flag for whether the car is moving and the mission is active
-  std::atomic<bool> running_;
+  //! Latest tour received on /thepath, never modified, only swapped and copied with boost::atomic_store/load
+  nav_msgs::PathConstPtr pathData_;
+  //! Flag for touring the waypoints of /thepath instead of planning goals_
+  bool followPath_;
+
+  //! Mission requests posted by the /mission service
+  enum MissionRequest {MISSION_NONE = 0, MISSION_START, MISSION_STOP};
+  //! Latest request from the /mission service, taken by the control thread at the start of a tick
+  std::atomic<int> missionRequest_;
+  //! Flag for whether the car is moving and the mission is active, owned by the control thread
+  bool running_;
   //! Flag for whether the it in sim or real life
   std::atomic<bool> real_;
+  //! Flag set by stop() to end seperateThread()
+  std::atomic<bool> stopping_;
+  //! Flag for waking the control loop on new scan/pose data instead of polling at a fixed rate
+  bool eventDriven_;
+  //! Signalled by laserCallback and amclCallback when new data arrives
+  std::condition_variable dataCv_;
+  //! Mutex to lock freshData_
+  std::mutex dataCvMtx_;
+  //! Set when new data has arrived since the control thread last woke
+  bool freshData_;
+  //! Timeout on waiting for new data, keeps the robot stopping when the sensors go quiet [s]
+  const double EVENT_TIMEOUT_ = 0.1;
+  //! Period of the control loop, a tick taking longer misses its deadline [s]
+  const double LOOP_PERIOD_ = 0.1;
+
+#ifdef ARTBOT_PROFILE
+  //! Times the stages of seperateThread()
+  LoopProfiler profiler_;
+#endif
+  //! Scan stamp to cmd_vel publish latency
+  LatencyHistogram latencyHist_;
+  //! Period between latency histogram publishes [s]
+  double latencyPublishPeriod_;
+  //! Time the latency histogram was last published
+  ros::Time lastLatencyPublish_;
+  //! Scan the last latency sample was taken from, so each scan is only counted once
+  sensor_msgs::LaserScanConstPtr lastLatencyScan_;
   //! Flag to prevent the terminal from being flooded with messages
   bool stateChange_;
   //! Stores a goal for the robot to move towards
@@ -217,42 +397,101 @@ private:
 
   int goalIdx_;
 
-  int velIdx_;
-
+  //! Time along path_ of the reference being tracked, only advanced while the robot drives [s]
   double time_;
+  //! Time of the last tick that advanced time_, zero when the robot was not driving
+  ros::Time lastTrackTime_;
 
   double DBL_MAX_ = 1.7976931348623157E+308;
 
-  const double MAX_VEL = 0.26;   // in meters per second
-  const double MAX_ACCEL = 0.43; // in meters per second per second
-  const double MAX_JERK = 1.0;  // in meters per second per second per second
-
-  const double ROBOT_WIDTH_ = 0.3;
-
-  std::vector<squiggles::ProfilePoint> path_;
-
-  //! Provides the unique ID of the markers
-  unsigned int marker_counter_;
+  const double MAX_VEL = robotlimits::MAX_VEL;   // in meters per second
+  const double MAX_ACCEL = robotlimits::MAX_ACCEL; // in meters per second per second
+  const double MAX_JERK = robotlimits::MAX_JERK;  // in meters per second per second per second
+
+  const double ROBOT_WIDTH_ = robotlimits::ROBOT_WIDTH;
+
+  //! Streams the spline along goals_ a leg at a time, kept for the whole tour so its buffers are reused
+  squiggles::BasicSplineStream<squiggles::TankModel> splineStream_;
+  //! Index in goals_ the next leg of splineStream_ ends at, -1 when nothing is streamed
+  int streamGoal_;
+  //! Robot pose and goal poses handed to splineStream_
+  std::vector<squiggles::Pose> splineWaypoints_;
+
+  //! Spline for the current leg, stored column-wise
+  squiggles::Trajectory path_;
+  //! Positions of path_, the path the local planner reroutes in trajMode 2
+  std::vector<geometry_msgs::Point> splineSamples_;
+  //! The robot start followed by goals_, the path goalTracker_ follows
+  std::vector<geometry_msgs::Point> tourPoints_;
+  //! Checks path_ against the clearance map before it is driven, and re-solves it when it is not clear
+  TrajectoryValidator trajectoryValidator_;
+  //! The goals path_ passes after its start, the straight legs it is re-solved along
+  std::vector<geometry_msgs::Point> splineCorners_;
+
+  //! Obstacles the laser has seen around the robot
+  LocalCostmap localCostmap_;
+  //! Plans detours around obstacles on the path
+  LocalPlanner localPlanner_;
+  //! Flag for rerouting around obstacles on the path rather than stopping for every close reading
+  bool localReplan_;
+  //! Set while the robot follows detour_ instead of its path
+  bool detouring_;
+  //! The detour being followed
+  squiggles::Trajectory detour_;
+  //! Follows detour_ by detourTime_
+  TrajectoryTracker detourTracker_;
+  //! Time along detour_ of the reference being tracked [s]
+  double detourTime_;
+  //! Index of the path point ending the segment detour_ rejoins the path on
+  size_t detourRejoin_;
 
   int smoothVelIdx_;
+  //! Cycles since the goal was last logged
+  int logCounter_;
 
   double poseError_;
 
   double lookahead_dist_ = 0.4;
 
-  int minIdx_;
-
-  std::mutex mapMtx_;
+  //! Progress along the robot start followed by goals_
+  PathTracker goalTracker_;
+  //! Follows path_ by the elapsed time_
+  TrajectoryTracker trajectoryTracker_;
+
+  //! Latest map, only swapped and copied with boost::atomic_store/load/compare_exchange
+  boost::shared_ptr<const MapSnapshot> mapSnapshot_;
+  //! Map version pathPlanningPtr_ was built from
+  unsigned int plannedMapVersion_;
+  //! Version of the full map the map of pathPlanningPtr_ was patched from
+  unsigned int plannedMapBase_;
+  //! Seed of the goal sampler, offset by the map version, 0 seeds from std::random_device
+  int goalSeed_;
+  //! Clearance of the planned map, taken from the path planning when the map version changes
+  std::shared_ptr<const ClearanceMap> clearanceMap_;
+  //! The clearance goals and paths keep from obstacles [m]
   double threshold_distance_;
-  int map_width_;
-  int map_height_;
-  double map_resolution_;
-  double map_origin_x_;
-  double map_origin_y_;
-  std::vector<int8_t> map_data_;
+  //! Flag for asking /move_base/NavfnROS/make_plan when the grid planner finds no path
+  bool navfnFallback_;
+  //! Number of random goals in a tour
+  int numGoals_;
   double world_x_;
   double world_y_;
-  std::vector<geometry_msgs::PoseStamped> unordered_goals_;
+  //! Exhibits toured in order when set, otherwise random goals are toured
+  std::vector<geometry_msgs::Point> exhibits_;
+  //! Legs between exhibits planned ahead of time for the current map
+  TourCache tourCache_;
+  //! A leg of goals_ with a spline from tourCache_
+  struct CachedLeg
+  {
+    //! Index in goals_ of the first waypoint after the exhibit the leg starts at
+    size_t first;
+    //! Index in goals_ of the exhibit the leg ends at
+    size_t last;
+    //! The spline from the start exhibit to goals_[last], maps into tourCache_
+    squiggles::TrajectoryView trajectory;
+  };
+  //! Legs of goals_ that follow a cached spline, cleared with goals_ or a new map, dropped when a map update touches them
+  std::vector<CachedLeg> cachedLegs_;
 };
 
 #endif // SAMPLE_H
\ No newline at end of file
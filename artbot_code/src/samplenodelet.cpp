@@ -0,0 +1,43 @@
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+#include <memory>
+#include <thread>
+#include "sample.h"
+
+namespace artbot_code
+{
+/*!
+ *  \brief     Sample Nodelet Class
+ *  \details
+ *  Runs Sample inside a nodelet manager, so messages from other nodelets in the same manager arrive as
+ *  shared pointers without being serialised. Topics and parameters are those of the artbot_code node,
+ *  the private parameters are read from the nodelet's own namespace.
+ *  @sa Sample
+ *  \version   1.00
+ */
+class SampleNodelet : public nodelet::Nodelet
+{
+public:
+  /// @brief Destructor, stops the processing thread of the unloaded nodelet
+  ~SampleNodelet()
+  {
+      if(sample_) sample_->stop();
+      if(thread_.joinable()) thread_.join();
+  }
+
+private:
+  /// @brief Creates the Sample and starts its processing thread, called once the nodelet is loaded
+  void onInit() override
+  {
+      sample_ = std::make_shared<Sample>(getNodeHandle(), getPrivateNodeHandle());
+      thread_ = std::thread(&Sample::seperateThread, sample_);
+  }
+
+  //! The Sample, owned here and by its processing thread
+  std::shared_ptr<Sample> sample_;
+  //! Runs Sample::seperateThread
+  std::thread thread_;
+};
+} // namespace artbot_code
+
+PLUGINLIB_EXPORT_CLASS(artbot_code::SampleNodelet, nodelet::Nodelet)
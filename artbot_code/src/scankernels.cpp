@@ -0,0 +1,85 @@
+#include "scankernels.h"
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+namespace scankernels
+{
+
+std::shared_ptr<const TrigTable> trigTableFor(float angleMin, float angleIncrement, std::size_t size)
+{
+    // Only a handful of geometries are ever seen, so a short list is searched
+    static std::mutex tablesMtx;
+    static std::vector<std::shared_ptr<const TrigTable> > tables;
+
+    std::unique_lock<std::mutex> lck(tablesMtx);
+    for (std::size_t i = 0; i < tables.size(); i++) {
+        const TrigTable& t = *tables[i];
+        if (t.angleMin == angleMin && t.angleIncrement == angleIncrement && t.cos.size() == size) {
+            return tables[i];
+        }
+    }
+
+    std::shared_ptr<TrigTable> table(new TrigTable);
+    table->angleMin = angleMin;
+    table->angleIncrement = angleIncrement;
+    table->cos.resize(size);
+    table->sin.resize(size);
+    for (std::size_t i = 0; i < size; i++) {
+        double angle = angleMin + static_cast<double>(i) * angleIncrement;
+        table->cos[i] = static_cast<float>(std::cos(angle));
+        table->sin[i] = static_cast<float>(std::sin(angle));
+    }
+    tables.push_back(table);
+    return table;
+}
+
+MinResult maskedMin(const float* ranges, std::size_t n, float lowerBound)
+{
+    const float inf = std::numeric_limits<float>::infinity();
+
+    // First pass is a plain min reduction, readings failing the mask are replaced with infinity
+    float minValue = inf;
+    #pragma omp simd reduction(min:minValue)
+    for (std::size_t i = 0; i < n; i++) {
+        float r = ranges[i] > lowerBound ? ranges[i] : inf;
+        minValue = r < minValue ? r : minValue;
+    }
+
+    // Second pass finds the first reading holding the minimum
+    MinResult result;
+    result.value = minValue;
+    result.index = -1;
+    for (std::size_t i = 0; i < n; i++) {
+        if (ranges[i] > lowerBound && ranges[i] == minValue) {
+            result.index = static_cast<long>(i);
+            break;
+        }
+    }
+    return result;
+}
+
+std::size_t countFinite(const float* ranges, std::size_t n, float rangeMax)
+{
+    std::size_t count = 0;
+    // NaN fails both comparisons and infinity fails the first
+    #pragma omp simd reduction(+:count)
+    for (std::size_t i = 0; i < n; i++) {
+        count += (std::fabs(ranges[i]) <= FLT_MAX) & (ranges[i] != rangeMax);
+    }
+    return count;
+}
+
+void polarToCart(const float* ranges, const TrigTable& table, std::size_t n, float* x, float* y)
+{
+    const float* c = table.cos.data();
+    const float* s = table.sin.data();
+    #pragma omp simd
+    for (std::size_t i = 0; i < n; i++) {
+        x[i] = ranges[i] * c[i];
+        y[i] = ranges[i] * s[i];
+    }
+}
+
+}
@@ -0,0 +1,78 @@
+#ifndef SCANKERNELS_H
+#define SCANKERNELS_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/*!
+ *  \brief     Scan Kernels
+ *  \details
+ *  Reductions and conversions over the contiguous float ranges of a laser scan,
+ *  written as branch free loops so the compiler can vectorise them, and a cache of
+ *  the sin/cos of each beam angle so trigonometry is only evaluated once per scan geometry.
+ *  Kept free of ROS types (and C++11 compatible) so every package processing LaserScan data can share them.
+ *  @sa LaserProcessing
+ *  \version   1.00
+ */
+namespace scankernels
+{
+
+/// @brief The sin and cos of every beam angle for one scan geometry
+struct TrigTable
+{
+  //! Angle of the first beam [rad]
+  float angleMin;
+  //! Angle between beams [rad]
+  float angleIncrement;
+  //! cos(angleMin + i * angleIncrement)
+  std::vector<float> cos;
+  //! sin(angleMin + i * angleIncrement)
+  std::vector<float> sin;
+};
+
+/// @brief Getter for the trig table of a scan geometry
+///
+/// The table is built the first time a geometry is seen and shared by every later scan with the same geometry.
+/// @param [in] angleMin - angle of the first beam [rad]
+/// @param [in] angleIncrement - angle between beams [rad]
+/// @param [in] size - number of beams
+/// @return the shared, immutable table
+std::shared_ptr<const TrigTable> trigTableFor(float angleMin, float angleIncrement, std::size_t size);
+
+/// @brief Result of a masked minimum
+struct MinResult
+{
+  //! The minimum value
+  float value;
+  //! Index of the first element holding value, -1 if no element passed the mask
+  long index;
+};
+
+/// @brief Finds the smallest range strictly greater than a lower bound
+///
+/// NaN readings never pass the mask. Ties resolve to the lowest index.
+/// @param [in] ranges - the ranges
+/// @param [in] n - number of ranges
+/// @param [in] lowerBound - readings at or below this are ignored
+/// @return the minimum and its index
+MinResult maskedMin(const float* ranges, std::size_t n, float lowerBound);
+
+/// @brief Counts readings which are finite and not equal to the max range
+/// @param [in] ranges - the ranges
+/// @param [in] n - number of ranges
+/// @param [in] rangeMax - the max range of the scanner
+/// @return the number of readings that are NOT at infinity, nan or max range
+std::size_t countFinite(const float* ranges, std::size_t n, float rangeMax);
+
+/// @brief Converts ranges to cartesian points in the scanner frame using a trig table
+/// @param [in] ranges - the ranges
+/// @param [in] table - trig table of the scan geometry, holding at least n entries
+/// @param [in] n - number of ranges
+/// @param [out] x - x of each point, holding at least n entries
+/// @param [out] y - y of each point, holding at least n entries
+void polarToCart(const float* ranges, const TrigTable& table, std::size_t n, float* x, float* y);
+
+}
+
+#endif // SCANKERNELS_H
@@ -0,0 +1,134 @@
+#include "scansegmenter.h"
+#include <cmath>
+#include <limits>
+
+ScanSegmenter::ScanSegmenter(double gapThreshold):
+    gapThreshold2_(static_cast<float>(gapThreshold * gapThreshold)), closestIdx_(-1)
+{
+}
+
+void ScanSegmenter::process(const float* ranges, std::size_t n, const scankernels::TrigTable& trig, float rangeMin, float rangeMax)
+{
+    // Resizing only allocates when the scan is larger than any seen before
+    x_.resize(n);
+    y_.resize(n);
+    segments_.clear();
+    closestIdx_ = -1;
+    if (n == 0) return;
+    if (segments_.capacity() < n) segments_.reserve(n);
+
+    scankernels::polarToCart(ranges, trig, n, x_.data(), y_.data());
+
+    bool inSegment = false;
+    std::size_t prev = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        float r = ranges[i];
+        // NaN fails both comparisons
+        bool valid = r > rangeMin && r < rangeMax;
+        if (!valid) {
+            if (inSegment) closeSegment(segments_.back());
+            inSegment = false;
+            continue;
+        }
+
+        if (inSegment) {
+            float dx = x_[i] - x_[prev];
+            float dy = y_[i] - y_[prev];
+            if (dx * dx + dy * dy > gapThreshold2_) {
+                closeSegment(segments_.back());
+                inSegment = false;
+            }
+        }
+
+        if (!inSegment) {
+            Segment segment;
+            segment.startIdx = i;
+            segment.endIdx = i;
+            segment.count = 0;
+            segment.centroidX = 0.0f;
+            segment.centroidY = 0.0f;
+            segment.extent = 0.0f;
+            segment.minRange = r;
+            segment.minIdx = i;
+            segments_.push_back(segment);
+            inSegment = true;
+        }
+
+        // The centroid holds the running sum until the segment is closed
+        Segment& segment = segments_.back();
+        segment.endIdx = i;
+        segment.count++;
+        segment.centroidX += x_[i];
+        segment.centroidY += y_[i];
+        if (r < segment.minRange) {
+            segment.minRange = r;
+            segment.minIdx = i;
+        }
+        prev = i;
+    }
+    if (inSegment) closeSegment(segments_.back());
+
+    // On a full circle scan, an object behind the scanner shows up as a segment at each end
+    double span = n * static_cast<double>(trig.angleIncrement);
+    if (segments_.size() >= 2 && std::fabs(std::fabs(span) - 2.0 * M_PI) < std::fabs(trig.angleIncrement) * 1.5) {
+        Segment& first = segments_.front();
+        Segment& last = segments_.back();
+        float dx = x_[0] - x_[n - 1];
+        float dy = y_[0] - y_[n - 1];
+        if (first.startIdx == 0 && last.endIdx == n - 1 && dx * dx + dy * dy <= gapThreshold2_) {
+            float total = static_cast<float>(first.count + last.count);
+            first.centroidX = (first.centroidX * first.count + last.centroidX * last.count) / total;
+            first.centroidY = (first.centroidY * first.count + last.centroidY * last.count) / total;
+            if (last.minRange < first.minRange) {
+                first.minRange = last.minRange;
+                first.minIdx = last.minIdx;
+            }
+            first.startIdx = last.startIdx;
+            first.count += last.count;
+            float ex = x_[first.endIdx] - x_[first.startIdx];
+            float ey = y_[first.endIdx] - y_[first.startIdx];
+            first.extent = std::sqrt(ex * ex + ey * ey);
+            segments_.pop_back();
+        }
+    }
+
+    for (std::size_t i = 0; i < segments_.size(); i++) {
+        if (closestIdx_ < 0 || segments_[i].minRange < segments_[closestIdx_].minRange) closestIdx_ = static_cast<long>(i);
+    }
+}
+
+void ScanSegmenter::closeSegment(Segment& segment)
+{
+    segment.centroidX /= segment.count;
+    segment.centroidY /= segment.count;
+    float dx = x_[segment.endIdx] - x_[segment.startIdx];
+    float dy = y_[segment.endIdx] - y_[segment.startIdx];
+    segment.extent = std::sqrt(dx * dx + dy * dy);
+}
+
+const std::vector<ScanSegmenter::Segment>& ScanSegmenter::segments() const
+{
+    return segments_;
+}
+
+const std::vector<float>& ScanSegmenter::x() const
+{
+    return x_;
+}
+
+const std::vector<float>& ScanSegmenter::y() const
+{
+    return y_;
+}
+
+const ScanSegmenter::Segment* ScanSegmenter::closestSegment() const
+{
+    if (closestIdx_ < 0) return nullptr;
+    return &segments_[closestIdx_];
+}
+
+float ScanSegmenter::closestRange() const
+{
+    if (closestIdx_ < 0) return std::numeric_limits<float>::infinity();
+    return segments_[closestIdx_].minRange;
+}
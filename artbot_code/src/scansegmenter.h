@@ -0,0 +1,87 @@
+#ifndef SCANSEGMENTER_H
+#define SCANSEGMENTER_H
+
+#include <cstddef>
+#include <vector>
+#include "scankernels.h"
+
+/*!
+ *  \brief     Scan Segmenter Class
+ *  \details
+ *  Splits a laser scan into segments of consecutive valid readings in a single pass.
+ *  A segment ends at an invalid reading or where neighbouring points are further apart than the gap threshold.
+ *  On a scan covering the full circle, a segment crossing the last and first readings is joined into one.
+ *  The buffers are kept between scans, so once they have grown to the scan size no memory is allocated.
+ *  @sa LaserProcessing
+ *  \version   1.00
+ */
+class ScanSegmenter
+{
+public:
+  /// @brief A segment of consecutive readings, indices wrap past the end of the scan when joined across it
+  struct Segment
+  {
+    //! Index of the first reading
+    unsigned int startIdx;
+    //! Index of the last reading
+    unsigned int endIdx;
+    //! Number of readings
+    unsigned int count;
+    //! Mean x of the readings in the laser frame [m]
+    float centroidX;
+    //! Mean y of the readings in the laser frame [m]
+    float centroidY;
+    //! Distance between the first and last reading [m]
+    float extent;
+    //! Smallest range in the segment [m]
+    float minRange;
+    //! Index of the smallest range
+    unsigned int minIdx;
+  };
+
+  /// @brief Constructor for the scan segmenter
+  /// @param [in] gapThreshold - neighbouring points further apart than this start a new segment [m]
+  ScanSegmenter(double gapThreshold = 0.3);
+
+  /// @brief Segments a scan, replacing the previous result
+  /// @param [in] ranges - the ranges
+  /// @param [in] n - number of ranges
+  /// @param [in] trig - trig table of the scan geometry
+  /// @param [in] rangeMin - readings at or below this are invalid [m]
+  /// @param [in] rangeMax - readings at or above this are invalid [m]
+  void process(const float* ranges, std::size_t n, const scankernels::TrigTable& trig, float rangeMin, float rangeMax);
+
+  /// @brief Getter for the segments of the last scan, in order of their first reading
+  const std::vector<Segment>& segments() const;
+
+  /// @brief Getter for the x of every reading of the last scan in the laser frame (invalid readings included)
+  const std::vector<float>& x() const;
+
+  /// @brief Getter for the y of every reading of the last scan in the laser frame (invalid readings included)
+  const std::vector<float>& y() const;
+
+  /// @brief Getter for the segment holding the closest reading
+  /// @return the segment, nullptr if the last scan had no valid readings
+  const Segment* closestSegment() const;
+
+  /// @brief Getter for the closest valid reading
+  /// @return the range [m], infinity if the last scan had no valid readings
+  float closestRange() const;
+
+private:
+  /// @brief Finishes the centroid and extent of a segment once its last reading is known
+  void closeSegment(Segment& segment);
+
+  //! Square of the gap threshold [m^2]
+  float gapThreshold2_;
+  //! x of every reading of the last scan
+  std::vector<float> x_;
+  //! y of every reading of the last scan
+  std::vector<float> y_;
+  //! Segments of the last scan
+  std::vector<Segment> segments_;
+  //! Index into segments_ of the closest segment, -1 if there is none
+  long closestIdx_;
+};
+
+#endif // SCANSEGMENTER_H
@@ -0,0 +1,79 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/*!
+ *  \brief     SeqLock Class
+ *  \details
+ *  Holds a small value written by one thread and read by others without either ever blocking.
+ *  The writer bumps a sequence number around each store, a reader copies the value and retries if the
+ *  sequence was odd or changed while it copied, so it never sees half of an update.
+ *  The value is kept in relaxed atomic words so the copies are not data races.
+ *  Only one thread may store at a time.
+ *  @sa Sample
+ *  \version   1.00
+ */
+template <typename T>
+class SeqLock
+{
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock copies the value bytewise");
+
+public:
+  SeqLock() : seq_(0)
+  {
+    store(T());
+  }
+
+  /// @brief Replaces the value, only called by the writer
+  /// @param [in] value - the new value
+  void store(const T& value)
+  {
+    std::array<uint64_t, WORDS> words{};
+    std::memcpy(words.data(), &value, sizeof(T));
+    uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORDS; i++) words_[i].store(words[i], std::memory_order_relaxed);
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  /// @brief Copies the latest value, retrying while a store is in progress
+  /// @return the value
+  T load() const
+  {
+    std::array<uint64_t, WORDS> words;
+    uint32_t before, after;
+    do
+    {
+      before = seq_.load(std::memory_order_acquire);
+      for (size_t i = 0; i < WORDS; i++) words[i] = words_[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = seq_.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    T value;
+    std::memcpy(&value, words.data(), sizeof(T));
+    return value;
+  }
+
+  /// @brief Getter for the number of stores, the reader can tell a new value from the one it has
+  uint32_t version() const
+  {
+    return seq_.load(std::memory_order_acquire) / 2;
+  }
+
+private:
+  //! Words holding the value
+  static const size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  //! Odd while a store is in progress
+  std::atomic<uint32_t> seq_;
+  //! The value, copied in and out bytewise
+  std::array<std::atomic<uint64_t>, WORDS> words_;
+};
+
+#endif // SEQLOCK_H
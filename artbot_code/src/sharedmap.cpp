@@ -0,0 +1,195 @@
+#include "sharedmap.h"
+#include <algorithm>
+#include <cmath>
+#include "ros/ros.h"
+
+std::mutex SharedMap::cacheMtx_;
+std::vector<std::weak_ptr<const SharedMap> > SharedMap::cache_;
+std::shared_ptr<const ClearanceMap> SharedMap::lastClearance_;
+std::vector<SharedMap::PatchedGrid> SharedMap::grids_;
+
+std::shared_ptr<const SharedMap> SharedMap::acquire(const nav_msgs::OccupancyGrid::ConstPtr& map, double goalClearance,
+                                                    const FreeSpaceIndex::Bounds& bounds, unsigned int marginCells)
+{
+    std::unique_lock<std::mutex> lck(cacheMtx_);
+    cache_.erase(std::remove_if(cache_.begin(), cache_.end(),
+                                [](const std::weak_ptr<const SharedMap>& entry) { return entry.expired(); }),
+                 cache_.end());
+    for (const auto& entry : cache_) {
+        std::shared_ptr<const SharedMap> shared = entry.lock();
+        if (shared && shared->matches(*map, goalClearance, bounds, marginCells)) return shared;
+    }
+
+    // The clearance only depends on the map, so products for other goal settings of the same map reuse it
+    std::shared_ptr<const ClearanceMap> clearanceMap;
+    for (const auto& entry : cache_) {
+        std::shared_ptr<const SharedMap> shared = entry.lock();
+        if (shared && shared->sameMap(*map)) {
+            clearanceMap = shared->clearanceMap_;
+            break;
+        }
+    }
+    if (!clearanceMap) {
+        auto updated = lastClearance_ ? std::make_shared<ClearanceMap>(*lastClearance_) : std::make_shared<ClearanceMap>();
+        updated->update(*map);
+        clearanceMap = updated;
+        lastClearance_ = clearanceMap;
+    }
+
+    std::shared_ptr<const SharedMap> shared(new SharedMap(map, clearanceMap, goalClearance, bounds, marginCells));
+    cache_.push_back(shared);
+    return shared;
+}
+
+SharedMap::SharedMap(const nav_msgs::OccupancyGrid::ConstPtr& map, const std::shared_ptr<const ClearanceMap>& clearanceMap,
+                     double goalClearance, const FreeSpaceIndex::Bounds& bounds, unsigned int marginCells):
+    map_(map), info_(map->info), clearanceMap_(clearanceMap), goalClearance_(goalClearance), bounds_(bounds),
+    marginCells_(marginCells)
+{
+    auto pyramid = std::make_shared<MapPyramid>();
+    pyramid->build(*map);
+    pyramid_ = pyramid;
+    ROS_INFO("Map pyramid of %u levels in %zu bytes, clearance in %zu bytes", pyramid_->levels(), pyramid_->bytes(),
+             clearanceMap_->bytes());
+    freeSpace_.build(*map, *clearanceMap_, bounds_, marginCells_, goalClearance_);
+    ROS_INFO("%zu cells can hold a goal", freeSpace_.size());
+}
+
+std::shared_ptr<const SharedMap> SharedMap::patch(const std::shared_ptr<const SharedMap>& previous,
+                                                  const nav_msgs::OccupancyGrid::ConstPtr& map, const MapRegion& region)
+{
+    std::unique_lock<std::mutex> lck(cacheMtx_);
+    // Every robot in the process gets the same update, only the first one to ask patches the products
+    for (const auto& entry : cache_) {
+        std::shared_ptr<const SharedMap> shared = entry.lock();
+        if (shared && shared->patchedFrom(*previous, *map, region)) return shared;
+    }
+    std::shared_ptr<SharedMap> patched(new SharedMap(*previous, map, region));
+    patched->previous_ = previous;
+    cache_.push_back(patched);
+    lastClearance_ = patched->clearanceMap_;
+    return patched;
+}
+
+nav_msgs::OccupancyGrid::ConstPtr SharedMap::patchGrid(const nav_msgs::OccupancyGrid::ConstPtr& map,
+                                                       const map_msgs::OccupancyGridUpdate& update)
+{
+    const size_t width = map->info.width;
+    const MapRegion region{update.x, update.y, update.x + static_cast<int>(update.width) - 1,
+                           update.y + static_cast<int>(update.height) - 1};
+    std::unique_lock<std::mutex> lck(cacheMtx_);
+    grids_.erase(std::remove_if(grids_.begin(), grids_.end(),
+                                [](const PatchedGrid& entry) { return entry.to.expired(); }),
+                 grids_.end());
+    for (const auto& entry : grids_) {
+        nav_msgs::OccupancyGrid::ConstPtr to = entry.to.lock();
+        if (!to || entry.from.lock() != map || entry.region.x0 != region.x0 || entry.region.y0 != region.y0 ||
+            entry.region.x1 != region.x1 || entry.region.y1 != region.y1) continue;
+        bool same = true;
+        for (unsigned int row = 0; row < update.height && same; row++) {
+            same = std::equal(update.data.begin() + static_cast<size_t>(row) * update.width,
+                              update.data.begin() + static_cast<size_t>(row + 1) * update.width,
+                              to->data.begin() + (update.y + row) * width + update.x);
+        }
+        if (same) return to;
+    }
+
+    // The grid is a message, so it is copied whole once and every holder shares the copy
+    nav_msgs::OccupancyGrid::Ptr patched = boost::make_shared<nav_msgs::OccupancyGrid>(*map);
+    patched->header.stamp = update.header.stamp;
+    for (unsigned int row = 0; row < update.height; row++) {
+        std::copy_n(update.data.begin() + static_cast<size_t>(row) * update.width, update.width,
+                    patched->data.begin() + (update.y + row) * width + update.x);
+    }
+    grids_.push_back(PatchedGrid{map, patched, region});
+    return patched;
+}
+
+SharedMap::SharedMap(const SharedMap& previous, const nav_msgs::OccupancyGrid::ConstPtr& map, const MapRegion& region):
+    map_(map), info_(map->info), freeSpace_(previous.freeSpace_), goalClearance_(previous.goalClearance_),
+    bounds_(previous.bounds_), marginCells_(previous.marginCells_), region_(region)
+{
+    auto clearanceMap = std::make_shared<ClearanceMap>(*previous.clearanceMap_);
+    clearanceMap->update(*map, region);
+    clearanceMap_ = clearanceMap;
+    auto pyramid = std::make_shared<MapPyramid>(*previous.pyramid_);
+    pyramid->update(*map, region);
+    pyramid_ = pyramid;
+
+    // A cell can only gain or lose the goal clearance if it is that close to a patched cell
+    const double resolution = info_.resolution;
+    const int reach = resolution > 0.0 ? static_cast<int>(std::ceil(goalClearance_ / resolution)) + 1 : 0;
+    freeSpace_.update(*map, *clearanceMap_, bounds_, marginCells_, goalClearance_,
+                      region.grown(reach, info_.width, info_.height));
+    ROS_DEBUG("Patched %d x %d cells, %zu cells can hold a goal", region.x1 - region.x0 + 1, region.y1 - region.y0 + 1,
+              freeSpace_.size());
+}
+
+bool SharedMap::matches(const nav_msgs::OccupancyGrid& map, double goalClearance, const FreeSpaceIndex::Bounds& bounds,
+                        unsigned int marginCells) const
+{
+    return goalClearance == goalClearance_ && marginCells == marginCells_ && bounds.minX == bounds_.minX &&
+           bounds.maxX == bounds_.maxX && bounds.minY == bounds_.minY && bounds.maxY == bounds_.maxY && sameMap(map);
+}
+
+bool SharedMap::patchedFrom(const SharedMap& previous, const nav_msgs::OccupancyGrid& map, const MapRegion& region) const
+{
+    // Outside the region both maps are the map of previous, so only the region is compared
+    std::shared_ptr<const SharedMap> from = previous_.lock();
+    if (from.get() != &previous || region.x0 != region_.x0 || region.y0 != region_.y0 || region.x1 != region_.x1 ||
+        region.y1 != region_.y1) return false;
+    if (&map == map_.lock().get()) return true;
+    const size_t width = info_.width;
+    for (int y = region.y0; y <= region.y1; y++) {
+        const size_t row = y * width;
+        for (int x = region.x0; x <= region.x1; x++) {
+            if ((map.data[row + x] != 0) != pyramid_->blocked(0, x, y)) return false;
+        }
+    }
+    return true;
+}
+
+bool SharedMap::sameMap(const nav_msgs::OccupancyGrid& map) const
+{
+    if (&map == map_.lock().get()) return true;
+
+    const nav_msgs::MapMetaData& a = map.info;
+    const nav_msgs::MapMetaData& b = info_;
+    if (a.width != b.width || a.height != b.height || a.resolution != b.resolution ||
+        a.origin.position.x != b.origin.position.x || a.origin.position.y != b.origin.position.y ||
+        a.origin.orientation.z != b.origin.orientation.z || a.origin.orientation.w != b.origin.orientation.w) return false;
+    if (map.data.size() != static_cast<size_t>(b.width) * b.height) return false;
+    // Only the cells known free went into the products, so the base layer stands in for the grid
+    for (int y = 0; y < static_cast<int>(b.height); y++) {
+        const size_t row = static_cast<size_t>(y) * b.width;
+        for (int x = 0; x < static_cast<int>(b.width); x++) {
+            if ((map.data[row + x] != 0) != pyramid_->blocked(0, x, y)) return false;
+        }
+    }
+    return true;
+}
+
+nav_msgs::OccupancyGrid::ConstPtr SharedMap::map() const
+{
+    return map_.lock();
+}
+
+const std::shared_ptr<const ClearanceMap>& SharedMap::clearanceMap() const
+{
+    return clearanceMap_;
+}
+
+const std::shared_ptr<const MapPyramid>& SharedMap::pyramid() const
+{
+    return pyramid_;
+}
+
+const FreeSpaceIndex& SharedMap::freeSpace() const
+{
+    return freeSpace_;
+}
+
+double SharedMap::goalClearance() const
+{
+    return goalClearance_;
+}
@@ -0,0 +1,137 @@
+#ifndef SHAREDMAP_H
+#define SHAREDMAP_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <boost/weak_ptr.hpp>
+#include "nav_msgs/OccupancyGrid.h"
+#include "map_msgs/OccupancyGridUpdate.h"
+#include "clearancemap.h"
+#include "freespaceindex.h"
+#include "mappyramid.h"
+
+/*!
+ *  \brief     Shared Map Class
+ *  \details
+ *  Holds everything the planners derive from one map: its clearance map, its map pyramid and the index of the
+ *  cells which can hold a goal. They are built once per map in a process and handed out by shared pointer, so
+ *  every robot loaded as a nodelet into one manager, and the fleet planner beside them, plan on one copy.
+ *  Products are found by the content of the map, so robots whose /map messages were deserialised separately
+ *  still share them. The clearance of the last map built is updated for the next one rather than recomputed,
+ *  and a map patched by a map update only updates the products over the patch. The products are held in copy
+ *  on write tiles, so the products of a patched map share every tile away from the patch with the earlier ones.
+ *  The products only depend on which cells are known free, so once the pyramid is packed the grid itself is not
+ *  held: maps are compared with the base layer of the pyramid, and products kept alive by a planner or the cache
+ *  never keep an old grid in memory.
+ *  @sa PathPlanning FleetPlanner
+ *  \version   1.00
+ */
+class SharedMap
+{
+public:
+  /// @brief Gets the products of a map, building them if nothing in the process holds them
+  ///
+  /// Building holds a process wide lock, so robots asking for the same new map at once wait for the first one
+  /// rather than each building their own.
+  /// @param [in] map - the occupancy grid
+  /// @param [in] goalClearance - goals are at least this far from any obstacle [m]
+  /// @param [in] bounds - box the goals have to lie in [m]
+  /// @param [in] marginCells - cells closer than this to the map edge never hold a goal
+  /// @return the products, shared with every other holder of the same map and goal settings
+  static std::shared_ptr<const SharedMap> acquire(const nav_msgs::OccupancyGrid::ConstPtr& map, double goalClearance,
+                                                  const FreeSpaceIndex::Bounds& bounds, unsigned int marginCells);
+
+  /// @brief Gets the products of a map which only differs from the map of earlier products inside a region
+  ///
+  /// Products another holder already patched from previous with the same cells in the region are shared.
+  /// Otherwise the earlier products are copied a tile pointer at a time and only the tiles over the region, and
+  /// the clearance round it, are brought up to date, so a map update costs the size of its patch rather than a
+  /// rebuild. The earlier products are left as they were.
+  /// @param [in] previous - products of the map the patch was applied to
+  /// @param [in] map - the patched occupancy grid, the map of previous outside the region
+  /// @param [in] region - the cells the patch covers
+  /// @return the products of the patched map, with the goal settings of previous
+  static std::shared_ptr<const SharedMap> patch(const std::shared_ptr<const SharedMap>& previous,
+                                                const nav_msgs::OccupancyGrid::ConstPtr& map, const MapRegion& region);
+
+  /// @brief Gets a map with a map update written in
+  ///
+  /// A grid another holder already patched from the same map with the same update is shared, so robots handed
+  /// one /map_updates message copy the grid once between them and then find the same products with patch().
+  /// @param [in] map - the occupancy grid the update applies to
+  /// @param [in] update - the update, inside the map
+  /// @return the patched grid, stamped with the update
+  static nav_msgs::OccupancyGrid::ConstPtr patchGrid(const nav_msgs::OccupancyGrid::ConstPtr& map,
+                                                     const map_msgs::OccupancyGridUpdate& update);
+
+  /// @brief Getter for the occupancy grid the products were built from
+  /// @return the grid, nullptr once nothing else holds it
+  nav_msgs::OccupancyGrid::ConstPtr map() const;
+
+  /// @brief Getter for the clearance of the map
+  const std::shared_ptr<const ClearanceMap>& clearanceMap() const;
+
+  /// @brief Getter for the bit-packed layers of the map
+  const std::shared_ptr<const MapPyramid>& pyramid() const;
+
+  /// @brief Getter for the cells which can hold a goal
+  const FreeSpaceIndex& freeSpace() const;
+
+  /// @brief Getter for the goal clearance the free space was indexed with [m]
+  double goalClearance() const;
+
+private:
+  SharedMap(const nav_msgs::OccupancyGrid::ConstPtr& map, const std::shared_ptr<const ClearanceMap>& clearanceMap,
+            double goalClearance, const FreeSpaceIndex::Bounds& bounds, unsigned int marginCells);
+
+  SharedMap(const SharedMap& previous, const nav_msgs::OccupancyGrid::ConstPtr& map, const MapRegion& region);
+
+  /// @brief Checks if these are the products of a map and goal settings
+  bool matches(const nav_msgs::OccupancyGrid& map, double goalClearance, const FreeSpaceIndex::Bounds& bounds,
+               unsigned int marginCells) const;
+
+  /// @brief Checks if a map has the same geometry as map_ and the same cells known free
+  bool sameMap(const nav_msgs::OccupancyGrid& map) const;
+
+  /// @brief Checks if these are the products previous patched in a region into a map
+  bool patchedFrom(const SharedMap& previous, const nav_msgs::OccupancyGrid& map, const MapRegion& region) const;
+
+  /// @brief A grid patched by patchGrid(), kept while someone holds it
+  struct PatchedGrid
+  {
+    boost::weak_ptr<const nav_msgs::OccupancyGrid> from;
+    boost::weak_ptr<const nav_msgs::OccupancyGrid> to;
+    MapRegion region;
+  };
+
+  //! The occupancy grid, not held past building the products
+  boost::weak_ptr<const nav_msgs::OccupancyGrid> map_;
+  //! Geometry of map_
+  nav_msgs::MapMetaData info_;
+  //! Clearance of map_
+  std::shared_ptr<const ClearanceMap> clearanceMap_;
+  //! Bit-packed layers of map_
+  std::shared_ptr<const MapPyramid> pyramid_;
+  //! Cells of map_ which can hold a goal
+  FreeSpaceIndex freeSpace_;
+  //! Goal settings freeSpace_ was built with
+  double goalClearance_;
+  FreeSpaceIndex::Bounds bounds_;
+  unsigned int marginCells_;
+  //! Products these were patched from, expired for products built from a whole map
+  std::weak_ptr<const SharedMap> previous_;
+  //! Cells patched into the map of previous_
+  MapRegion region_;
+
+  //! Guards the products held in the process
+  static std::mutex cacheMtx_;
+  //! Products in the process, an expired entry is dropped on the next acquire
+  static std::vector<std::weak_ptr<const SharedMap> > cache_;
+  //! Clearance of the last map built, a map of the same geometry only recomputes the changed region of it
+  static std::shared_ptr<const ClearanceMap> lastClearance_;
+  //! Grids patched in the process, an expired entry is dropped on the next patchGrid
+  static std::vector<PatchedGrid> grids_;
+};
+
+#endif // SHAREDMAP_H
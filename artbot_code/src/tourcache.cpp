@@ -0,0 +1,185 @@
+#include "tourcache.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+void fnv1a(uint64_t& hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+}
+
+template <class T>
+void fnv1a(uint64_t& hash, T value)
+{
+    fnv1a(hash, &value, sizeof(value));
+}
+
+// Writes the file beside its final path and renames it, so a reader never maps half a leg
+bool writeAtomically(const std::string& filename, const squiggles::TrajectoryView& path)
+{
+    const std::string tmp = filename + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (squiggles::serialize_binary_path(out, path) != 0) return false;
+        out.close();
+        if (!out) return false;
+    }
+    return std::rename(tmp.c_str(), filename.c_str()) == 0;
+}
+
+// Clips the segment to the box, it crosses the box if anything is left of it
+bool crosses(const geometry_msgs::Point& a, const geometry_msgs::Point& b, double minX, double minY, double maxX, double maxY)
+{
+    double t0 = 0.0, t1 = 1.0;
+    const double d[2] = {b.x - a.x, b.y - a.y};
+    const double lo[2] = {minX - a.x, minY - a.y};
+    const double hi[2] = {maxX - a.x, maxY - a.y};
+    for (int axis = 0; axis < 2; axis++) {
+        if (d[axis] == 0.0) {
+            if (lo[axis] > 0.0 || hi[axis] < 0.0) return false;
+            continue;
+        }
+        double enter = lo[axis] / d[axis], exit = hi[axis] / d[axis];
+        if (enter > exit) std::swap(enter, exit);
+        t0 = std::max(t0, enter);
+        t1 = std::min(t1, exit);
+        if (t0 > t1) return false;
+    }
+    return true;
+}
+}
+
+TourCache::TourCache(const std::string& directory) :
+    directory_(directory), mapHash_(0), hasMap_(false)
+{
+}
+
+uint64_t TourCache::mapHash(const nav_msgs::OccupancyGrid& map, const std::vector<geometry_msgs::Point>& exhibits)
+{
+    uint64_t hash = FNV_OFFSET;
+    fnv1a(hash, map.info.width);
+    fnv1a(hash, map.info.height);
+    fnv1a(hash, map.info.resolution);
+    fnv1a(hash, map.info.origin.position.x);
+    fnv1a(hash, map.info.origin.position.y);
+    fnv1a(hash, map.info.origin.orientation.z);
+    fnv1a(hash, map.info.origin.orientation.w);
+    if (!map.data.empty()) fnv1a(hash, map.data.data(), map.data.size());
+    fnv1a(hash, exhibits.size());
+    for (const auto& exhibit : exhibits) {
+        fnv1a(hash, exhibit.x);
+        fnv1a(hash, exhibit.y);
+    }
+    return hash;
+}
+
+bool TourCache::setMap(uint64_t hash)
+{
+    stale_.clear();
+    if (hasMap_ && hash == mapHash_) return false;
+    legs_.clear();
+    mapHash_ = hash;
+    hasMap_ = true;
+    return true;
+}
+
+void TourCache::invalidate(double minX, double minY, double maxX, double maxY)
+{
+    stale_.push_back({minX, minY, maxX, maxY});
+}
+
+bool TourCache::stale(const geometry_msgs::Point& start, const std::vector<geometry_msgs::Point>& waypoints) const
+{
+    for (const Box& box : stale_) {
+        const geometry_msgs::Point* prev = &start;
+        for (const auto& point : waypoints) {
+            if (crosses(*prev, point, box.minX, box.minY, box.maxX, box.maxY)) return true;
+            prev = &point;
+        }
+    }
+    return false;
+}
+
+bool TourCache::lookup(unsigned int from, unsigned int to, const geometry_msgs::Point& start,
+                       std::vector<geometry_msgs::Point>& waypoints, squiggles::TrajectoryView& trajectory)
+{
+    waypoints.clear();
+    trajectory = squiggles::TrajectoryView();
+    if (!enabled() || !hasMap_) return false;
+
+    const uint64_t key = (uint64_t(from) << 32) | to;
+    auto it = legs_.find(key);
+    if (it == legs_.end()) {
+        Leg leg;
+        leg.waypoints = squiggles::MappedTrajectory::open(legFile(from, to, ".path.sqgt"));
+        if (!leg.waypoints) return false;
+        leg.trajectory = squiggles::MappedTrajectory::open(legFile(from, to, ".traj.sqgt"));
+        it = legs_.emplace(key, std::move(leg)).first;
+    }
+
+    const squiggles::TrajectoryView& path = it->second.waypoints->view();
+    waypoints.resize(path.size);
+    for (size_t i = 0; i < path.size; i++) {
+        waypoints[i].x = path.x[i];
+        waypoints[i].y = path.y[i];
+        waypoints[i].z = 0.0;
+    }
+    // The leg was planned before the map update, it is planned live again if the update touched it
+    if (stale(start, waypoints)) {
+        waypoints.clear();
+        return false;
+    }
+    if (it->second.trajectory) trajectory = it->second.trajectory->view();
+    return true;
+}
+
+bool TourCache::store(unsigned int from, unsigned int to, const std::vector<geometry_msgs::Point>& waypoints,
+                      const squiggles::TrajectoryView& trajectory)
+{
+    if (!enabled() || !hasMap_ || waypoints.empty()) return false;
+    std::error_code error;
+    std::filesystem::create_directories(mapDirectory(), error);
+    if (error) return false;
+
+    // The waypoints are kept as states with only a position so both files share one format
+    squiggles::Trajectory path;
+    path.reserve(waypoints.size(), 0);
+    for (const auto& p : waypoints) {
+        path.push_back(squiggles::ProfilePoint(squiggles::ControlVector(squiggles::Pose(p.x, p.y, 0.0), 0.0), {}, 0.0, 0.0));
+    }
+    legs_.erase((uint64_t(from) << 32) | to);
+    if (!writeAtomically(legFile(from, to, ".path.sqgt"), path)) return false;
+
+    const std::string trajectoryFile = legFile(from, to, ".traj.sqgt");
+    if (trajectory.empty()) {
+        std::remove(trajectoryFile.c_str());
+        return true;
+    }
+    return writeAtomically(trajectoryFile, trajectory);
+}
+
+bool TourCache::enabled() const
+{
+    return !directory_.empty();
+}
+
+std::string TourCache::mapDirectory() const
+{
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(mapHash_));
+    return directory_ + "/" + hex;
+}
+
+std::string TourCache::legFile(unsigned int from, unsigned int to, const char* suffix) const
+{
+    return mapDirectory() + "/" + std::to_string(from) + "_" + std::to_string(to) + suffix;
+}
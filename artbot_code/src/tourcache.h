@@ -0,0 +1,123 @@
+#ifndef TOURCACHE_H
+#define TOURCACHE_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "nav_msgs/OccupancyGrid.h"
+#include <geometry_msgs/Point.h>
+#include "squiggles.hpp"
+
+/*!
+ *  \brief     Tour Cache Class
+ *  \details
+ *  Library of legs between exhibits planned ahead of time for one map.
+ *  Every ordered pair of exhibits has its simplified waypoints and the spline through them stored in
+ *  the squiggles binary trajectory format under <directory>/<map hash>/, so a tour over a known map
+ *  is read back from disk instead of being planned when the mission starts.
+ *  Files are memory mapped the first time a leg is looked up and stay mapped until the map changes.
+ *  @sa PathPlanning
+ *  \version   1.00
+ */
+class TourCache
+{
+public:
+  /// @brief Constructor for the tour cache
+  /// @param [in] directory - root of the library, an empty directory disables the cache
+  TourCache(const std::string& directory = "");
+
+  /// @brief Hash of a map and the exhibits on it, FNV-1a over its size, resolution, origin and cells then the
+  /// exhibit positions in order
+  ///
+  /// The stamp is left out so the same map published again hashes the same. Exhibit ids are their positions in
+  /// the list, so moving, adding or reordering exhibits selects a different directory rather than reusing legs
+  /// stored under the old ids.
+  /// @param [in] map - the map
+  /// @param [in] exhibits - the exhibits, in id order [m]
+  static uint64_t mapHash(const nav_msgs::OccupancyGrid& map, const std::vector<geometry_msgs::Point>& exhibits);
+
+  /// @brief Selects the map legs are stored and looked up for
+  ///
+  /// Legs of the previous map are unmapped when the hash changes, invalidating their views. Every box passed to
+  /// invalidate() is dropped, the whole map is current again.
+  /// @param [in] hash - hash of the map from mapHash()
+  /// @return true if the hash differs from the selected map
+  bool setMap(uint64_t hash);
+
+  /// @brief Marks a box of the selected map as changed by a map update
+  ///
+  /// Stored legs passing through the box are no longer looked up until setMap() selects a map again, the
+  /// rest of the selected map's legs are still read from disk.
+  /// @param [in] minX - lower x of the box [m]
+  /// @param [in] minY - lower y of the box [m]
+  /// @param [in] maxX - upper x of the box [m]
+  /// @param [in] maxY - upper y of the box [m]
+  void invalidate(double minX, double minY, double maxX, double maxY);
+
+  /// @brief Checks if a path passes through a box passed to invalidate()
+  /// @param [in] start - where the path starts [m]
+  /// @param [in] waypoints - the waypoints after start [m]
+  bool stale(const geometry_msgs::Point& start, const std::vector<geometry_msgs::Point>& waypoints) const;
+
+  /// @brief Looks up the leg between two exhibits of the selected map
+  ///
+  /// @param [in] from - id of the exhibit the leg starts at
+  /// @param [in] to - id of the exhibit the leg ends at
+  /// @param [in] start - position of exhibit from [m]
+  /// @param [out] waypoints - the waypoints after from, ending at to
+  /// @param [out] trajectory - the spline from from to to, empty when none was stored, valid until setMap() changes map
+  /// @return false if the leg is not in the cache or passes through a box passed to invalidate()
+  bool lookup(unsigned int from, unsigned int to, const geometry_msgs::Point& start,
+              std::vector<geometry_msgs::Point>& waypoints, squiggles::TrajectoryView& trajectory);
+
+  /// @brief Stores the leg between two exhibits of the selected map
+  ///
+  /// @param [in] from - id of the exhibit the leg starts at
+  /// @param [in] to - id of the exhibit the leg ends at
+  /// @param [in] waypoints - the waypoints after from, ending at to
+  /// @param [in] trajectory - the spline from from to to, may be empty
+  /// @return false if the files could not be written
+  bool store(unsigned int from, unsigned int to, const std::vector<geometry_msgs::Point>& waypoints,
+             const squiggles::TrajectoryView& trajectory);
+
+  /// @brief Getter for whether a directory was given
+  bool enabled() const;
+
+  /// @brief Getter for the directory legs of the selected map live in
+  std::string mapDirectory() const;
+
+private:
+  /// @brief Path of one file of a leg
+  std::string legFile(unsigned int from, unsigned int to, const char* suffix) const;
+
+  //! The mapped files of a leg
+  struct Leg
+  {
+    std::optional<squiggles::MappedTrajectory> waypoints;
+    std::optional<squiggles::MappedTrajectory> trajectory;
+  };
+
+  //! A box changed by a map update [m]
+  struct Box
+  {
+    double minX;
+    double minY;
+    double maxX;
+    double maxY;
+  };
+
+  //! Root of the library
+  std::string directory_;
+  //! Hash of the selected map
+  uint64_t mapHash_;
+  //! Flag for whether a map has been selected
+  bool hasMap_;
+  //! Legs looked up so far, keyed by from in the high and to in the low 32 bits
+  std::unordered_map<uint64_t, Leg> legs_;
+  //! Boxes of the selected map changed since it was selected
+  std::vector<Box> stale_;
+};
+
+#endif // TOURCACHE_H
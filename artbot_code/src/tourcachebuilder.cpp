@@ -0,0 +1,105 @@
+#include "ros/ros.h"
+#include "ros/topic.h"
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include "clearancemap.h"
+#include "gridplanner.h"
+#include "robotlimits.h"
+#include "tourcache.h"
+
+// Builds the tour cache for the map on /map and exits.
+// Reads the private parameters ~tour_cache_dir (the library root), ~exhibits (a flat list x0, y0, x1, y1, ...
+// where the id of an exhibit is its position in the list), ~threshold_distance (default 0.15 m, must match
+// the artbot_code node) and ~map_timeout (default 30 s).
+// Every ordered pair of exhibits is planned with the same GridPlanner the artbot_code node uses, and the
+// spline through each leg is generated with the robot's constraints.
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "tour_cache_builder");
+    ros::NodeHandle nh;
+    ros::NodeHandle pnh("~");
+
+    std::string directory;
+    std::vector<double> flat;
+    double threshold = 0.15;
+    double mapTimeout = 30.0;
+    pnh.param("tour_cache_dir", directory, std::string(""));
+    pnh.param("exhibits", flat, std::vector<double>());
+    pnh.param("threshold_distance", threshold, 0.15);
+    pnh.param("map_timeout", mapTimeout, 30.0);
+    if (directory.empty() || flat.size() < 4 || flat.size() % 2 != 0) {
+        ROS_ERROR("~tour_cache_dir and at least two ~exhibits as x, y pairs are required");
+        return 1;
+    }
+    std::vector<geometry_msgs::Point> exhibits(flat.size() / 2);
+    for (size_t i = 0; i < exhibits.size(); i++) {
+        exhibits[i].x = flat[2 * i];
+        exhibits[i].y = flat[2 * i + 1];
+    }
+
+    nav_msgs::OccupancyGrid::ConstPtr map =
+        ros::topic::waitForMessage<nav_msgs::OccupancyGrid>("/map", nh, ros::Duration(mapTimeout));
+    if (!map) {
+        ROS_ERROR("No map received on /map");
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    TourCache cache(directory);
+    cache.setMap(TourCache::mapHash(*map, exhibits));
+    auto clearanceMap = std::make_shared<ClearanceMap>();
+    clearanceMap->update(*map);
+    auto pyramid = std::make_shared<MapPyramid>();
+    pyramid->build(*map);
+    GridPlanner planner(threshold);
+    planner.setMap(clearanceMap, pyramid);
+
+    // The same limits as the artbot_code node, so a cached spline is one it could have generated
+    const squiggles::Constraints constraints(robotlimits::MAX_VEL, robotlimits::MAX_ACCEL, robotlimits::MAX_JERK);
+    squiggles::BasicSplineGenerator<squiggles::TankModel> generator(
+        constraints, std::make_shared<squiggles::TankModel>(robotlimits::ROBOT_WIDTH, constraints));
+
+    std::vector<geometry_msgs::Point> waypoints;
+    std::vector<squiggles::Pose> poses;
+    squiggles::Trajectory trajectory;
+    unsigned int stored = 0;
+    unsigned int unreachable = 0;
+    for (unsigned int from = 0; from < exhibits.size() && ros::ok(); from++) {
+        for (unsigned int to = 0; to < exhibits.size(); to++) {
+            if (from == to) continue;
+            if (!planner.plan(exhibits[from], exhibits[to], waypoints)) {
+                ROS_WARN("No path from exhibit %u to exhibit %u", from, to);
+                unreachable++;
+                continue;
+            }
+
+            // Each pose faces the next one, the last keeps the heading it arrives with
+            poses.clear();
+            poses.emplace_back(exhibits[from].x, exhibits[from].y, 0.0);
+            for (const auto& p : waypoints) poses.emplace_back(p.x, p.y, 0.0);
+            for (size_t i = 0; i + 1 < poses.size(); i++) {
+                poses[i].yaw = std::atan2(poses[i + 1].y - poses[i].y, poses[i + 1].x - poses[i].x);
+            }
+            poses.back().yaw = poses[poses.size() - 2].yaw;
+            trajectory.clear();
+            try {
+                generator.generate(poses, trajectory);
+            }
+            catch (const std::exception& e) {
+                ROS_WARN("No spline from exhibit %u to exhibit %u: %s", from, to, e.what());
+                trajectory.clear();
+            }
+
+            if (!cache.store(from, to, waypoints, trajectory.view())) {
+                ROS_ERROR("Could not write to %s", cache.mapDirectory().c_str());
+                return 1;
+            }
+            stored++;
+        }
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ROS_INFO("Stored %u legs (%u unreachable) in %s in %.2f s", stored, unreachable, cache.mapDirectory().c_str(), elapsed);
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include "tourplanner.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+
+TourPlanner::TourPlanner(double robotRadius, unsigned int threads):
+    robotRadius_(robotRadius), threads_(threads), n_(0), length_(0.0)
+{
+    if (threads_ == 0) threads_ = std::max(1u, std::thread::hardware_concurrency());
+}
+
+bool TourPlanner::plan(const std::shared_ptr<const ClearanceMap>& clearanceMap, const geometry_msgs::Point& start, const std::vector<geometry_msgs::Point>& goals,
+                       const std::shared_ptr<const MapPyramid>& pyramid)
+{
+    order_.clear();
+    waypoints_.clear();
+    length_ = 0.0;
+
+    nodes_.clear();
+    nodes_.push_back(start);
+    nodes_.insert(nodes_.end(), goals.begin(), goals.end());
+    n_ = nodes_.size();
+    cost_.assign(static_cast<size_t>(n_) * n_, std::numeric_limits<double>::infinity());
+    legs_.assign(cost_.size(), std::vector<geometry_msgs::Point>());
+    for (unsigned int i = 0; i < n_; i++) cost_[i * n_ + i] = 0.0;
+
+    // Every pair is planned once, from the lower to the higher node
+    std::vector<std::pair<unsigned int, unsigned int> > pairs;
+    for (unsigned int i = 0; i < n_; i++) {
+        for (unsigned int j = i + 1; j < n_; j++) pairs.push_back(std::make_pair(i, j));
+    }
+
+    unsigned int threads = std::min<unsigned int>(threads_, std::max<size_t>(1, pairs.size()));
+    while (planners_.size() < threads) planners_.push_back(GridPlanner(robotRadius_));
+    std::atomic<size_t> next(0);
+    auto worker = [&](unsigned int t) {
+        GridPlanner& planner = planners_[t];
+        planner.setMap(clearanceMap, pyramid);
+        for (size_t k = next++; k < pairs.size(); k = next++) {
+            unsigned int i = pairs[k].first, j = pairs[k].second;
+            std::vector<geometry_msgs::Point>& leg = legs_[i * n_ + j];
+            if (!planner.plan(nodes_[i], nodes_[j], leg)) continue;
+            cost_[i * n_ + j] = planner.pathLength();
+            cost_[j * n_ + i] = planner.pathLength();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned int t = 1; t < threads; t++) pool.push_back(std::thread(worker, t));
+    worker(0);
+    for (auto& thread : pool) thread.join();
+
+    // Only goals with a path from the start can be toured
+    std::vector<unsigned int> reachable;
+    for (unsigned int i = 1; i < n_; i++) {
+        if (cost_[i] < std::numeric_limits<double>::infinity()) reachable.push_back(i);
+    }
+    if (reachable.empty()) return false;
+
+    std::vector<unsigned int> tour = orderTour(cost_, n_, reachable);
+    length_ = tourLength(cost_, n_, tour);
+
+    unsigned int prev = 0;
+    for (unsigned int node : tour) {
+        order_.push_back(node - 1);
+        if (prev < node) {
+            const std::vector<geometry_msgs::Point>& leg = legs_[prev * n_ + node];
+            waypoints_.insert(waypoints_.end(), leg.begin(), leg.end());
+        }
+        else {
+            // The leg was planned the other way, so it is walked backwards, ending at this node
+            const std::vector<geometry_msgs::Point>& leg = legs_[node * n_ + prev];
+            if (leg.size() > 1) waypoints_.insert(waypoints_.end(), leg.rbegin() + 1, leg.rend());
+            waypoints_.push_back(nodes_[node]);
+        }
+        prev = node;
+    }
+    return true;
+}
+
+std::vector<unsigned int> TourPlanner::orderTour(const std::vector<double>& cost, unsigned int n, std::vector<unsigned int> nodes)
+{
+    auto c = [&](unsigned int a, unsigned int b) { return cost[static_cast<size_t>(a) * n + b]; };
+
+    // Nearest neighbour from the start
+    std::vector<unsigned int> tour;
+    unsigned int current = 0;
+    while (!nodes.empty()) {
+        size_t best = 0;
+        for (size_t k = 1; k < nodes.size(); k++) {
+            if (c(current, nodes[k]) < c(current, nodes[best])) best = k;
+        }
+        current = nodes[best];
+        tour.push_back(current);
+        nodes.erase(nodes.begin() + best);
+    }
+
+    // The start is held at the front, position 0 of path is the start
+    std::vector<unsigned int> path(1, 0);
+    path.insert(path.end(), tour.begin(), tour.end());
+    const size_t m = path.size();
+    const double eps = 1e-9;
+
+    bool improved = true;
+    while (improved) {
+        improved = false;
+
+        // 2-opt, reversing path[i..j], the open end means j may be the last node with no edge after it
+        for (size_t i = 1; i + 1 < m; i++) {
+            for (size_t j = i + 1; j < m; j++) {
+                double before = c(path[i - 1], path[i]) + (j + 1 < m ? c(path[j], path[j + 1]) : 0.0);
+                double after = c(path[i - 1], path[j]) + (j + 1 < m ? c(path[i], path[j + 1]) : 0.0);
+                if (after + eps < before) {
+                    std::reverse(path.begin() + i, path.begin() + j + 1);
+                    improved = true;
+                }
+            }
+        }
+
+        // Or-opt, moving a run of up to 3 nodes elsewhere, either way round
+        for (size_t len = 1; len <= 3 && !improved; len++) {
+            for (size_t i = 1; i + len <= m && !improved; i++) {
+                size_t last = i + len - 1;
+                double removeGain = c(path[i - 1], path[i]) + (last + 1 < m ? c(path[last], path[last + 1]) : 0.0) -
+                                    (last + 1 < m ? c(path[i - 1], path[last + 1]) : 0.0);
+                for (size_t k = 0; k < m && !improved; k++) {
+                    // Inserting between path[k] and path[k+1], which must be outside the run
+                    if (k + 1 >= i && k <= last) continue;
+                    bool hasNext = k + 1 < m;
+                    double edge = hasNext ? c(path[k], path[k + 1]) : 0.0;
+                    double forward = c(path[k], path[i]) + (hasNext ? c(path[last], path[k + 1]) : 0.0) - edge;
+                    double backward = c(path[k], path[last]) + (hasNext ? c(path[i], path[k + 1]) : 0.0) - edge;
+                    bool reversed = backward < forward;
+                    if (std::min(forward, backward) + eps >= removeGain) continue;
+
+                    std::vector<unsigned int> run(path.begin() + i, path.begin() + last + 1);
+                    if (reversed) std::reverse(run.begin(), run.end());
+                    path.erase(path.begin() + i, path.begin() + last + 1);
+                    size_t insertAt = k < i ? k + 1 : k + 1 - len;
+                    path.insert(path.begin() + insertAt, run.begin(), run.end());
+                    improved = true;
+                }
+            }
+        }
+    }
+    return std::vector<unsigned int>(path.begin() + 1, path.end());
+}
+
+double TourPlanner::tourLength(const std::vector<double>& cost, unsigned int n, const std::vector<unsigned int>& tour)
+{
+    double length = 0.0;
+    unsigned int prev = 0;
+    for (unsigned int node : tour) {
+        length += cost[static_cast<size_t>(prev) * n + node];
+        prev = node;
+    }
+    return length;
+}
+
+const std::vector<unsigned int>& TourPlanner::order() const
+{
+    return order_;
+}
+
+const std::vector<geometry_msgs::Point>& TourPlanner::waypoints() const
+{
+    return waypoints_;
+}
+
+double TourPlanner::length() const
+{
+    return length_;
+}
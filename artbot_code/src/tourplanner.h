@@ -0,0 +1,84 @@
+#ifndef TOURPLANNER_H
+#define TOURPLANNER_H
+
+#include <memory>
+#include <vector>
+#include <geometry_msgs/Point.h>
+#include "clearancemap.h"
+#include "gridplanner.h"
+
+/*!
+ *  \brief     Tour Planner Class
+ *  \details
+ *  Orders a set of goals into a short tour starting at the robot.
+ *  The leg between every pair of goals is planned with a GridPlanner, the legs are split
+ *  across threads which each own a planner so their buffers are not shared.
+ *  The order is a nearest neighbour tour improved with 2-opt and Or-opt moves until none shortens it.
+ *  The tour is open, it ends at the last goal rather than returning to the start.
+ *  @sa PathPlanning
+ *  \version   1.00
+ */
+class TourPlanner
+{
+public:
+  /// @brief Constructor for the tour planner
+  /// @param [in] robotRadius - paths keep at least this clearance [m]
+  /// @param [in] threads - number of threads planning legs, 0 uses every core
+  TourPlanner(double robotRadius, unsigned int threads = 0);
+
+  /// @brief Plans every leg and orders the goals
+  ///
+  /// Goals which cannot be reached from the start are left out of the tour.
+  /// @param [in] clearanceMap - clearance of the map
+  /// @param [in] start - the start of the tour [m]
+  /// @param [in] goals - the goals to visit [m]
+  /// @param [in] pyramid - pyramid of the map, nullptr plans every leg at full resolution only
+  /// @return false if no goal can be reached
+  bool plan(const std::shared_ptr<const ClearanceMap>& clearanceMap, const geometry_msgs::Point& start, const std::vector<geometry_msgs::Point>& goals,
+            const std::shared_ptr<const MapPyramid>& pyramid = nullptr);
+
+  /// @brief Getter for the order of the goals in the last tour
+  /// @return indices into the goals given to plan()
+  const std::vector<unsigned int>& order() const;
+
+  /// @brief Getter for the waypoints of the last tour, every leg joined in order
+  const std::vector<geometry_msgs::Point>& waypoints() const;
+
+  /// @brief Getter for the length of the last tour [m]
+  double length() const;
+
+  /// @brief Orders an open tour over a cost matrix, starting at node 0
+  ///
+  /// @param [in] cost - row major n by n matrix of the cost between nodes, symmetric
+  /// @param [in] n - number of nodes, node 0 is the start
+  /// @param [in] nodes - the nodes to visit, excluding the start
+  /// @return the nodes in tour order, excluding the start
+  static std::vector<unsigned int> orderTour(const std::vector<double>& cost, unsigned int n, std::vector<unsigned int> nodes);
+
+  /// @brief Length of an open tour starting at node 0
+  static double tourLength(const std::vector<double>& cost, unsigned int n, const std::vector<unsigned int>& tour);
+
+private:
+  //! Paths keep at least this clearance [m]
+  double robotRadius_;
+  //! Threads to plan legs on
+  unsigned int threads_;
+  //! One planner per thread, kept so their buffers are reused
+  std::vector<GridPlanner> planners_;
+  //! Node count of the last plan, the start and every goal
+  unsigned int n_;
+  //! Path length of every leg, infinite if there is no path
+  std::vector<double> cost_;
+  //! Waypoints of the leg from the lower to the higher node of each pair
+  std::vector<std::vector<geometry_msgs::Point> > legs_;
+  //! Nodes of the last plan, the start and every goal
+  std::vector<geometry_msgs::Point> nodes_;
+  //! Goal order of the last tour
+  std::vector<unsigned int> order_;
+  //! Waypoints of the last tour
+  std::vector<geometry_msgs::Point> waypoints_;
+  //! Length of the last tour [m]
+  double length_;
+};
+
+#endif // TOURPLANNER_H
@@ -0,0 +1,121 @@
+#include "trajectorytracker.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    //Wraps an angle to [-pi, pi]
+    double wrapAngle(double angle)
+    {
+        return std::atan2(std::sin(angle), std::cos(angle));
+    }
+
+    double clamp(double value, double limit)
+    {
+        return std::min(std::max(value, -limit), limit);
+    }
+
+    //Slowest velocity the reference moves at between samples, so it does not crawl away from a standstill [m/s]
+    const double MIN_SPEED = 0.05;
+}
+
+TrajectoryTracker::TrajectoryTracker(double kx, double ky, double ktheta, double maxLinear, double maxAngular):
+    kx_(kx), ky_(ky), ktheta_(ktheta), maxLinear_(maxLinear), maxAngular_(maxAngular),
+    index_(0), refX_(0.0), refY_(0.0), error_(0.0), finished_(false)
+{
+}
+
+void TrajectoryTracker::setTrajectory(const squiggles::TrajectoryView& trajectory)
+{
+    trajectory_ = trajectory;
+    index_ = 0;
+    error_ = 0.0;
+    finished_ = false;
+    if (trajectory_.empty()) return;
+    refX_ = trajectory_.x[0];
+    refY_ = trajectory_.y[0];
+
+    // Time to cover each gap between samples at their mean velocity
+    times_.resize(trajectory_.size);
+    times_[0] = 0.0;
+    for (size_t i = 1; i < trajectory_.size; i++) {
+        const double distance = std::hypot(trajectory_.x[i] - trajectory_.x[i - 1], trajectory_.y[i] - trajectory_.y[i - 1]);
+        const double speed = 0.5 * std::fabs(trajectory_.vel[i] + trajectory_.vel[i - 1]);
+        times_[i] = times_[i - 1] + distance / std::max(speed, MIN_SPEED);
+    }
+}
+
+TrajectoryTracker::Command TrajectoryTracker::update(double time, double x, double y, double yaw)
+{
+    Command command = {0.0, 0.0};
+    if (trajectory_.empty()) return command;
+
+    // The cursor only moves forward, so over a whole trajectory it passes each sample once
+    const squiggles::TrajectoryView& path = trajectory_;
+    while (index_ + 1 < path.size && times_[index_ + 1] <= time) index_++;
+    finished_ = index_ + 1 >= path.size;
+
+    // Reference state between the samples around the elapsed time, held at the last sample after the end
+    size_t next = std::min(index_ + 1, path.size - 1);
+    double u = 0.0;
+    if (next > index_ && times_[next] > times_[index_]) {
+        u = std::min(std::max((time - times_[index_]) / (times_[next] - times_[index_]), 0.0), 1.0);
+    }
+    refX_ = path.x[index_] + u * (path.x[next] - path.x[index_]);
+    refY_ = path.y[index_] + u * (path.y[next] - path.y[index_]);
+    const double turn = wrapAngle(path.yaw[next] - path.yaw[index_]);
+    const double refYaw = path.yaw[index_] + u * turn;
+    const double refVel = path.vel[index_] + u * (path.vel[next] - path.vel[index_]);
+    // The curvature of the samples is unsigned, the turn between them gives its sign
+    const double gap = std::hypot(path.x[next] - path.x[index_], path.y[next] - path.y[index_]);
+    const double refCurvature = gap > 0.0 ? turn / gap : 0.0;
+
+    // Error from the robot to the reference in the robot's frame
+    const double dx = refX_ - x, dy = refY_ - y;
+    const double ex = std::cos(yaw) * dx + std::sin(yaw) * dy;
+    const double ey = -std::sin(yaw) * dx + std::cos(yaw) * dy;
+    const double eth = wrapAngle(refYaw - yaw);
+    error_ = std::hypot(dx, dy);
+
+    command.linear = clamp(refVel * std::cos(eth) + kx_ * ex, maxLinear_);
+    // The feedback still steers at MIN_SPEED once the reference stops, so the robot closes on the end of the path
+    const double feedbackVel = std::max(std::fabs(refVel), MIN_SPEED);
+    command.angular = clamp(refVel * refCurvature + feedbackVel * (ky_ * ey + ktheta_ * std::sin(eth)), maxAngular_);
+    return command;
+}
+
+void TrajectoryTracker::reference(double& x, double& y) const
+{
+    x = refX_;
+    y = refY_;
+}
+
+double TrajectoryTracker::positionError() const
+{
+    return error_;
+}
+
+size_t TrajectoryTracker::index() const
+{
+    return index_;
+}
+
+double TrajectoryTracker::timeAt(size_t index) const
+{
+    if (trajectory_.empty() || times_.empty()) return 0.0;
+    return times_[std::min(index, trajectory_.size - 1)];
+}
+
+double TrajectoryTracker::duration() const
+{
+    return times_.empty() || trajectory_.empty() ? 0.0 : times_.back();
+}
+
+bool TrajectoryTracker::finished() const
+{
+    return finished_;
+}
+
+bool TrajectoryTracker::empty() const
+{
+    return trajectory_.empty();
+}
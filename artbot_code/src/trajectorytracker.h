@@ -0,0 +1,98 @@
+#ifndef TRAJECTORYTRACKER_H
+#define TRAJECTORYTRACKER_H
+
+#include <cstddef>
+#include <vector>
+#include "squiggles.hpp"
+
+/*!
+ *  \brief     Trajectory Tracker Class
+ *  \details
+ *  Follows a time parameterised squiggles trajectory. The reference state at the elapsed time is
+ *  interpolated between the two samples around it, its velocity and velocity times curvature are the
+ *  feedforward command, and the robot's error from it in the robot's frame is fed back:
+ *  v = vr cos(eth) + kx ex and w = vr kr + max(|vr|, vmin) (ky ey + ktheta sin(eth)),
+ *  where kr is the curvature between the samples around the reference.
+ *  On curves the samples of a squiggles spline are further apart than their profiled velocity covers in the
+ *  time between them, so the samples are retimed once from their spacing and velocity, keeping the reference
+ *  at the profiled speed. The elapsed time only moves forward, so a cursor into the retimed samples finds the
+ *  reference in O(1) amortised.
+ *  @sa Sample
+ *  \version   1.00
+ */
+class TrajectoryTracker
+{
+public:
+  //! Velocities sent to the robot
+  struct Command
+  {
+    //! Linear velocity [m/s]
+    double linear;
+    //! Angular velocity [rad/s]
+    double angular;
+  };
+
+  /// @brief Constructor for the trajectory tracker
+  /// @param [in] kx - gain on the error along the robot's heading [1/s]
+  /// @param [in] ky - gain on the error across the robot's heading [1/m^2]
+  /// @param [in] ktheta - gain on the heading error [1/m]
+  /// @param [in] maxLinear - largest linear velocity commanded [m/s]
+  /// @param [in] maxAngular - largest angular velocity commanded [rad/s]
+  TrajectoryTracker(double kx = 1.0, double ky = 4.0, double ktheta = 2.0, double maxLinear = 0.26, double maxAngular = 1.8);
+
+  /// @brief Sets the trajectory to follow and resets the cursor to its start
+  /// @param [in] trajectory - the trajectory, it must outlive its use here and not be modified while set
+  void setTrajectory(const squiggles::TrajectoryView& trajectory);
+
+  /// @brief Gets the command that tracks the trajectory at an elapsed time
+  /// @param [in] time - time since the start of the trajectory, by the retimed samples, never less than in the last call [s]
+  /// @param [in] x - x of the robot [m]
+  /// @param [in] y - y of the robot [m]
+  /// @param [in] yaw - heading of the robot [rad]
+  /// @return the command, zero when there is no trajectory
+  Command update(double time, double x, double y, double yaw);
+
+  /// @brief Getter for the reference position of the last update
+  /// @param [out] x - x of the reference [m]
+  /// @param [out] y - y of the reference [m]
+  void reference(double& x, double& y) const;
+
+  /// @brief Getter for the distance between the robot and the reference at the last update [m]
+  double positionError() const;
+
+  /// @brief Getter for the index of the sample starting the interval holding the last reference
+  size_t index() const;
+
+  /// @brief Getter for the time the reference reaches a sample at, by the retimed samples [s]
+  /// @param [in] index - index of the sample, the last sample past the end
+  double timeAt(size_t index) const;
+
+  /// @brief Getter for the time the retimed trajectory takes [s]
+  double duration() const;
+
+  /// @brief Checks if the elapsed time of the last update is past the end of the trajectory
+  bool finished() const;
+
+  /// @brief Checks if there is no trajectory
+  bool empty() const;
+
+private:
+  //! Gains on the along track, cross track and heading errors
+  double kx_, ky_, ktheta_;
+  //! Limits of the command
+  double maxLinear_, maxAngular_;
+  //! The trajectory followed
+  squiggles::TrajectoryView trajectory_;
+  //! Time the reference reaches each sample at the profiled velocity [s]
+  std::vector<double> times_;
+  //! Sample starting the interval holding the last reference
+  size_t index_;
+  //! Reference position of the last update [m]
+  double refX_, refY_;
+  //! Distance to the reference at the last update [m]
+  double error_;
+  //! Set when the last update was at or past the end of the trajectory
+  bool finished_;
+};
+
+#endif // TRAJECTORYTRACKER_H
@@ -0,0 +1,137 @@
+#include "trajectoryvalidator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <utility>
+
+namespace {
+    //Most times the straight segments are halved while re-solving
+    const int MAX_SPLITS = 3;
+}
+
+TrajectoryValidator::TrajectoryValidator(const squiggles::Constraints& constraints, double robotWidth, double clearance,
+                                         double budget, unsigned int maxCandidates):
+    generator_(new squiggles::BasicSplineGenerator<squiggles::TankModel>(
+        constraints, std::make_shared<squiggles::TankModel>(robotWidth, constraints), 0.01, 1)),
+    cruise_(constraints.max_vel), clearance_(clearance), budget_(budget), maxCandidates_(maxCandidates),
+    firstViolation_(0), minClearance_(0.0), lastRepairTime_(0.0)
+{
+}
+
+bool TrajectoryValidator::validate(const squiggles::TrajectoryView& trajectory, const ClearanceMap& clearanceMap)
+{
+    const size_t n = trajectory.size;
+    clearances_.resize(n);
+    clearanceMap.clearances(trajectory.x, trajectory.y, n, clearances_.data());
+
+    // A min reduction over every sample, the first violation is only searched for when there is one
+    float minValue = std::numeric_limits<float>::infinity();
+    const float* c = clearances_.data();
+    #pragma omp simd reduction(min:minValue)
+    for (size_t i = 0; i < n; i++) {
+        minValue = c[i] < minValue ? c[i] : minValue;
+    }
+    minClearance_ = n == 0 ? 0.0 : minValue;
+    firstViolation_ = n;
+    if (minClearance_ >= clearance_) return true;
+    const float threshold = static_cast<float>(clearance_);
+    firstViolation_ = static_cast<size_t>(std::find_if(c, c + n, [threshold](float d) { return d < threshold; }) - c);
+    return false;
+}
+
+bool TrajectoryValidator::repair(const squiggles::TrajectoryView& trajectory, const std::vector<geometry_msgs::Point>& corners,
+                                 const ClearanceMap& clearanceMap, squiggles::Trajectory& out)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::duration<double>(budget_);
+    if (trajectory.empty() || corners.empty()) return false;
+    validate(trajectory, clearanceMap);
+    const double original = minClearance_;
+    const size_t originalViolation = firstViolation_;
+
+    // The straight segments from the start of the trajectory through the corners
+    const size_t last = trajectory.size - 1;
+    std::vector<geometry_msgs::Point> points(1);
+    points[0].x = trajectory.x[0];
+    points[0].y = trajectory.y[0];
+    points.insert(points.end(), corners.begin(), corners.end());
+    // The ends keep the velocities of the trajectory, so a leg from a standstill to a stop still starts and stops
+    const double startVel = std::isnan(trajectory.vel[0]) ? 0.0 : trajectory.vel[0];
+    const double endVel = std::isnan(trajectory.vel[last]) ? 0.0 : trajectory.vel[last];
+
+    double bestClearance = -1.0;
+    size_t bestViolation = 0;
+    bool clear = false;
+    // Each split is one candidate, a candidate limit stands in for the clock
+    const int splits = maxCandidates_ > 0 ? std::min<int>(MAX_SPLITS, maxCandidates_) : MAX_SPLITS;
+    for (int split = 1; split <= splits && !clear && (maxCandidates_ > 0 || std::chrono::steady_clock::now() < deadline);
+         split++) {
+        const int pieces = 1 << split;
+        waypoints_.clear();
+        waypoints_.push_back(squiggles::ControlVector(
+            squiggles::Pose(trajectory.x[0], trajectory.y[0], trajectory.yaw[0]), startVel));
+        for (size_t k = 0; k + 1 < points.size(); k++) {
+            const geometry_msgs::Point& a = points[k];
+            const geometry_msgs::Point& b = points[k + 1];
+            const double heading = std::atan2(b.y - a.y, b.x - a.x);
+            for (int j = 1; j < pieces; j++) {
+                const double t = static_cast<double>(j) / pieces;
+                waypoints_.push_back(squiggles::ControlVector(
+                    squiggles::Pose(a.x + t * (b.x - a.x), a.y + t * (b.y - a.y), heading), cruise_));
+            }
+            // Corners are passed heading from the point before them to the point after, as the stream does
+            if (k + 2 < points.size()) {
+                const geometry_msgs::Point& c = points[k + 2];
+                waypoints_.push_back(squiggles::ControlVector(
+                    squiggles::Pose(b.x, b.y, std::atan2(c.y - a.y, c.x - a.x)), cruise_));
+            }
+        }
+        waypoints_.push_back(squiggles::ControlVector(
+            squiggles::Pose(trajectory.x[last], trajectory.y[last], trajectory.yaw[last]), endVel));
+
+        try {
+            generator_->generate(waypoints_, candidate_);
+        }
+        catch (const std::exception&) {
+            continue;
+        }
+        if (candidate_.empty()) continue;
+        clear = validate(candidate_.view(), clearanceMap);
+        if (minClearance_ > bestClearance) {
+            bestClearance = minClearance_;
+            bestViolation = firstViolation_;
+            std::swap(best_, candidate_);
+        }
+    }
+
+    // The trajectory may be a view of out, so it is not read after this
+    if (bestClearance > original) {
+        std::swap(out, best_);
+        minClearance_ = bestClearance;
+        firstViolation_ = bestViolation;
+    }
+    else {
+        minClearance_ = original;
+        firstViolation_ = originalViolation;
+        clear = false;
+    }
+    lastRepairTime_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return clear;
+}
+
+size_t TrajectoryValidator::firstViolation() const
+{
+    return firstViolation_;
+}
+
+double TrajectoryValidator::minClearance() const
+{
+    return minClearance_;
+}
+
+double TrajectoryValidator::lastRepairTime() const
+{
+    return lastRepairTime_;
+}
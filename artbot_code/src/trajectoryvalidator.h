@@ -0,0 +1,88 @@
+#ifndef TRAJECTORYVALIDATOR_H
+#define TRAJECTORYVALIDATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <geometry_msgs/Point.h>
+#include "squiggles.hpp"
+#include "clearancemap.h"
+
+/*!
+ *  \brief     Trajectory Validator Class
+ *  \details
+ *  Checks a spline against the clearance map before it is driven. The quintics between waypoints bulge
+ *  away from the straight segments the planner checked, so on tight corners a spline can cut into a
+ *  wall or an exhibit. Every sample is looked up in one pass over the position arrays of the trajectory,
+ *  and a sample is clear when the robot's footprint centred on it touches no obstacle.
+ *  A spline that is not clear is re-solved through points along the straight segments it replaces,
+ *  halving the segments until the spline is clear or the time budget is spent. With a candidate limit the
+ *  budget is that many re-solved splines instead, so a repair does not depend on how fast the machine is.
+ *  @sa ClearanceMap Sample
+ *  \version   1.00
+ */
+class TrajectoryValidator
+{
+public:
+  /// @brief Constructor for the trajectory validator
+  /// @param [in] constraints - limits of the re-solved splines
+  /// @param [in] robotWidth - distance between the wheels [m]
+  /// @param [in] clearance - distance every sample keeps from obstacles [m]
+  /// @param [in] budget - most time spent re-solving one spline [s]
+  /// @param [in] maxCandidates - most candidates generated re-solving one spline, 0 to only stop on the time budget
+  TrajectoryValidator(const squiggles::Constraints& constraints, double robotWidth, double clearance = 0.15,
+                      double budget = 0.025, unsigned int maxCandidates = 0);
+
+  /// @brief Checks every sample of a trajectory against the clearance map
+  /// @param [in] trajectory - the trajectory
+  /// @param [in] clearanceMap - clearance of the map
+  /// @return true if every sample has at least the clearance
+  bool validate(const squiggles::TrajectoryView& trajectory, const ClearanceMap& clearanceMap);
+
+  /// @brief Re-solves a trajectory through points along the straight segments it follows
+  ///
+  /// The re-solved spline starts and ends at the poses and velocities of the trajectory, only the points added
+  /// along the segments are passed at cruise speed. When no candidate is clear the one
+  /// keeping furthest from obstacles replaces the trajectory if it keeps further than the trajectory did.
+  /// @param [in] trajectory - the trajectory that failed validate()
+  /// @param [in] corners - the points after the start of the trajectory that it passes, ending at its end
+  /// @param [in] clearanceMap - clearance of the map
+  /// @param [out] out - the re-solved trajectory, unchanged when no candidate improves on the trajectory
+  /// @return true if the re-solved trajectory is clear
+  bool repair(const squiggles::TrajectoryView& trajectory, const std::vector<geometry_msgs::Point>& corners,
+              const ClearanceMap& clearanceMap, squiggles::Trajectory& out);
+
+  /// @brief Getter for the index of the first sample without the clearance in the last validate(), the size when none
+  size_t firstViolation() const;
+
+  /// @brief Getter for the smallest clearance of a sample in the last validate() [m]
+  double minClearance() const;
+
+  /// @brief Getter for the time the last repair took [ms]
+  double lastRepairTime() const;
+
+private:
+  //! Generates the re-solved splines, held by pointer as it cannot be assigned
+  std::unique_ptr<squiggles::BasicSplineGenerator<squiggles::TankModel>> generator_;
+  //! Waypoints of the candidate being generated
+  std::vector<squiggles::ControlVector> waypoints_;
+  //! The candidate being checked, and the best candidate so far
+  squiggles::Trajectory candidate_, best_;
+  //! Clearance of each sample of the last trajectory validated [m]
+  std::vector<float> clearances_;
+  //! Velocity the waypoints added between the ends are passed at [m/s]
+  double cruise_;
+  //! Distance every sample keeps from obstacles [m]
+  double clearance_;
+  //! Most time spent re-solving one spline [s]
+  double budget_;
+  //! Most candidates generated re-solving one spline, replaces the time budget when not 0
+  unsigned int maxCandidates_;
+  //! Results of the last validate()
+  size_t firstViolation_;
+  double minClearance_;
+  //! Time the last repair took [ms]
+  double lastRepairTime_;
+};
+
+#endif // TRAJECTORYVALIDATOR_H
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "clearancemap.h"
+#include "testmaps.h"
+
+namespace
+{
+    /// Checks every cell of an incrementally updated clearance map against one built from scratch
+    void expectSameAsRebuild(const ClearanceMap& incremental, const nav_msgs::OccupancyGrid& map)
+    {
+        ClearanceMap full;
+        full.update(map);
+        const uint32_t cells = map.info.width * map.info.height;
+        for (uint32_t i = 0; i < cells; i++) {
+            ASSERT_EQ(incremental.clearanceAt(i), full.clearanceAt(i)) << "cell " << i;
+        }
+    }
+}
+
+TEST(ClearanceMap, DistanceToNearestObstacle)
+{
+    nav_msgs::OccupancyGridPtr map = testmaps::room(100, 100, 0.05f);
+    ClearanceMap clearance;
+    ASSERT_TRUE(clearance.update(*map));
+    // Cell (10, 50) is 10 cells from the wall at x = 0, the distance is taken between cell centres
+    EXPECT_NEAR(clearance.clearance(0.525, 2.525), 0.5, 1e-3);
+    EXPECT_EQ(clearance.clearance(0.025, 2.525), 0.0);
+    // Capped far from every wall, and 0 outside the map
+    EXPECT_NEAR(clearance.clearance(2.5, 2.5), clearance.maxDistance(), 1e-3);
+    EXPECT_EQ(clearance.clearance(-1.0, 2.5), 0.0);
+    EXPECT_TRUE(clearance.isClear(0.525, 2.525, 0.45));
+    EXPECT_FALSE(clearance.isClear(0.525, 2.525, 0.55));
+}
+
+TEST(ClearanceMap, IncrementalMatchesRebuild)
+{
+    std::mt19937 gen(6);
+    std::bernoulli_distribution add(0.6);
+    nav_msgs::OccupancyGridPtr map = testmaps::room(160, 140, 0.05f);
+    ClearanceMap incremental;
+    incremental.update(*map);
+
+    // Obstacles appear and vanish at random, each map differs from the last in one box
+    for (int i = 0; i < 40; i++) {
+        testmaps::fill(*map, testmaps::randomBox(*map, 12, gen), add(gen) ? 100 : 0);
+        incremental.update(*map);
+        expectSameAsRebuild(incremental, *map);
+        if (HasFatalFailure()) return;
+    }
+}
+
+TEST(ClearanceMap, RegionUpdateMatchesRebuild)
+{
+    std::mt19937 gen(7);
+    std::bernoulli_distribution add(0.6);
+    nav_msgs::OccupancyGridPtr map = testmaps::room(160, 140, 0.05f);
+    ClearanceMap incremental;
+    incremental.update(*map);
+
+    for (int i = 0; i < 40; i++) {
+        MapRegion box = testmaps::randomBox(*map, 12, gen);
+        testmaps::fill(*map, box, add(gen) ? 100 : 0);
+        incremental.update(*map, box);
+        expectSameAsRebuild(incremental, *map);
+        if (HasFatalFailure()) return;
+    }
+}
+
+TEST(ClearanceMap, QuantisedBelowExactDistance)
+{
+    std::mt19937 gen(36);
+    nav_msgs::OccupancyGridPtr map = testmaps::room(120, 90, 0.05f);
+    for (int i = 0; i < 8; i++) testmaps::fill(*map, testmaps::randomBox(*map, 10, gen));
+    ClearanceMap clearance;
+    clearance.update(*map);
+    // Two bytes a cell, tiles round the grid up to whole tiles
+    EXPECT_EQ(clearance.bytes(), 2u * 2u * tiles::CELLS * sizeof(uint16_t));
+
+    // Checked against the brute force distance between cell centres, never above it and at most a step below
+    std::vector<uint32_t> obstacles;
+    for (uint32_t i = 0; i < map->data.size(); i++) {
+        if (map->data[i] != 0) obstacles.push_back(i);
+    }
+    for (uint32_t i = 0; i < map->data.size(); i += 7) {
+        double exact = clearance.maxDistance();
+        for (uint32_t o : obstacles) {
+            const double dx = static_cast<int>(i % 120) - static_cast<int>(o % 120);
+            const double dy = static_cast<int>(i / 120) - static_cast<int>(o / 120);
+            exact = std::min(exact, std::hypot(dx, dy) * 0.05);
+        }
+        ASSERT_LE(clearance.clearanceAt(i), exact + 1e-6) << "cell " << i;
+        ASSERT_GE(clearance.clearanceAt(i), exact - clearance.quantum() - 1e-6) << "cell " << i;
+        ASSERT_EQ(clearance.clearanceAt(i) == 0.0, map->data[i] != 0) << "cell " << i;
+    }
+}
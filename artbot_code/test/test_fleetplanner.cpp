@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include "fleetplanner.h"
+#include "sharedmap.h"
+#include "testmaps.h"
+
+namespace
+{
+    const FreeSpaceIndex::Bounds BOUNDS = {0.0, 10.0, 0.0, 5.0};
+
+    std::shared_ptr<const SharedMap> share(const nav_msgs::OccupancyGridPtr& map)
+    {
+        return SharedMap::acquire(map, 0.15, BOUNDS, 2);
+    }
+
+    /// Two rooms of 5 x 5 m joined by a 0.6 m door in the middle of the wall between them
+    nav_msgs::OccupancyGridPtr twoRooms()
+    {
+        nav_msgs::OccupancyGridPtr map = testmaps::room(200, 100);
+        testmaps::fill(*map, MapRegion{100, 0, 100, 43});
+        testmaps::fill(*map, MapRegion{100, 56, 100, 99});
+        return map;
+    }
+}
+
+TEST(FleetPlanner, SplitsGoalsByRobot)
+{
+    std::shared_ptr<const SharedMap> shared = share(testmaps::room(200, 100));
+    FleetPlanner planner(0.15, 0.26, 2);
+    std::vector<geometry_msgs::Point> starts = {testmaps::point(1.0, 2.5), testmaps::point(9.0, 2.5)};
+    std::vector<geometry_msgs::Point> goals = {testmaps::point(1.5, 1.0), testmaps::point(8.5, 1.0),
+                                               testmaps::point(1.5, 4.0), testmaps::point(8.5, 4.0)};
+    ASSERT_TRUE(planner.plan(shared, starts, goals));
+
+    // Each robot tours the two goals on its side of the room
+    std::vector<unsigned int> first = planner.orders()[0], second = planner.orders()[1];
+    std::sort(first.begin(), first.end());
+    std::sort(second.begin(), second.end());
+    EXPECT_EQ(first, std::vector<unsigned int>({0, 2}));
+    EXPECT_EQ(second, std::vector<unsigned int>({1, 3}));
+
+    // The waypoints of each tour end at its last goal
+    for (unsigned int r = 0; r < 2; r++) {
+        ASSERT_FALSE(planner.waypoints()[r].empty());
+        const geometry_msgs::Point& last = planner.waypoints()[r].back();
+        const geometry_msgs::Point& goal = goals[planner.orders()[r].back()];
+        EXPECT_NEAR(last.x, goal.x, 1e-9);
+        EXPECT_NEAR(last.y, goal.y, 1e-9);
+    }
+    EXPECT_GT(planner.makespan(), 0.0);
+}
+
+TEST(FleetPlanner, LeavesOutUnreachableGoals)
+{
+    nav_msgs::OccupancyGridPtr map = testmaps::room(200, 100);
+    // A closed box round (5, 2.5)
+    testmaps::fill(*map, MapRegion{90, 40, 110, 40});
+    testmaps::fill(*map, MapRegion{90, 60, 110, 60});
+    testmaps::fill(*map, MapRegion{90, 40, 90, 60});
+    testmaps::fill(*map, MapRegion{110, 40, 110, 60});
+    std::shared_ptr<const SharedMap> shared = share(map);
+    FleetPlanner planner(0.15, 0.26, 2);
+    std::vector<geometry_msgs::Point> starts = {testmaps::point(1.0, 2.5), testmaps::point(9.0, 2.5)};
+    std::vector<geometry_msgs::Point> goals = {testmaps::point(2.0, 1.0), testmaps::point(5.0, 2.5),
+                                               testmaps::point(8.0, 4.0)};
+    ASSERT_TRUE(planner.plan(shared, starts, goals));
+
+    std::vector<unsigned int> toured;
+    for (const auto& order : planner.orders()) toured.insert(toured.end(), order.begin(), order.end());
+    std::sort(toured.begin(), toured.end());
+    EXPECT_EQ(toured, std::vector<unsigned int>({0, 2}));
+
+    // Nothing to tour at all is a failed plan
+    EXPECT_FALSE(planner.plan(shared, starts, {testmaps::point(5.0, 2.5)}));
+}
+
+TEST(FleetPlanner, DelaysRobotsSharingADoor)
+{
+    std::shared_ptr<const SharedMap> shared = share(twoRooms());
+    FleetPlanner planner(0.15, 0.26, 2);
+    // Both robots cross the door to the far corners of the other room at the same time
+    std::vector<geometry_msgs::Point> starts = {testmaps::point(1.0, 1.0), testmaps::point(1.0, 4.0)};
+    std::vector<geometry_msgs::Point> goals = {testmaps::point(9.0, 0.5), testmaps::point(9.0, 4.5)};
+    ASSERT_TRUE(planner.plan(shared, starts, goals));
+    ASSERT_EQ(planner.orders()[0].size(), 1u);
+    ASSERT_EQ(planner.orders()[1].size(), 1u);
+
+    // One robot sets off at once, the other waits until the first is through the door
+    const std::vector<double>& delays = planner.delays();
+    EXPECT_EQ(std::min(delays[0], delays[1]), 0.0);
+    EXPECT_GT(std::max(delays[0], delays[1]), 0.0);
+    EXPECT_EQ(planner.unresolved(), 0u);
+    EXPECT_GE(planner.makespan(), std::max(delays[0], delays[1]));
+}
@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+#include "gridplanner.h"
+#include "testmaps.h"
+
+namespace
+{
+    /// A 20 x 15 m floor split into four rooms by walls with one 1 m doorway each, at alternating ends
+    nav_msgs::OccupancyGridPtr floorWithDoorways()
+    {
+        nav_msgs::OccupancyGridPtr map = testmaps::room(400, 300, 0.05f);
+        testmaps::fill(*map, MapRegion{100, 1, 101, 259});
+        testmaps::fill(*map, MapRegion{200, 41, 201, 298});
+        testmaps::fill(*map, MapRegion{300, 1, 301, 259});
+        return map;
+    }
+}
+
+TEST(GridPlanner, CoarseSearchExpandsFewerCells)
+{
+    nav_msgs::OccupancyGridPtr map = floorWithDoorways();
+    auto clearance = std::make_shared<ClearanceMap>();
+    clearance->update(*map);
+    auto pyramid = std::make_shared<MapPyramid>();
+    pyramid->build(*map);
+    const geometry_msgs::Point start = testmaps::point(1.0, 1.0), goal = testmaps::point(19.0, 1.0);
+
+    GridPlanner full, coarse;
+    full.setMap(clearance);
+    coarse.setMap(clearance, pyramid);
+    std::vector<geometry_msgs::Point> fullPath, coarsePath;
+    ASSERT_TRUE(full.plan(start, goal, fullPath));
+    ASSERT_TRUE(coarse.plan(start, goal, coarsePath));
+
+    // Through the doorways the full search expands about 80k cells and the corridor about 20k, for a path
+    // within 1% of the full one
+    EXPECT_LT(coarse.expanded() * 3, full.expanded());
+    EXPECT_LT(coarse.pathLength(), full.pathLength() * 1.01);
+    EXPECT_NEAR(coarsePath.back().x, goal.x, 1e-9);
+    EXPECT_NEAR(coarsePath.back().y, goal.y, 1e-9);
+}
+
+TEST(GridPlanner, PlansWithoutPyramid)
+{
+    nav_msgs::OccupancyGridPtr map = floorWithDoorways();
+    auto clearance = std::make_shared<ClearanceMap>();
+    clearance->update(*map);
+    GridPlanner planner;
+    planner.setMap(clearance);
+    std::vector<geometry_msgs::Point> waypoints;
+
+    // Every waypoint keeps the robot radius, and a goal in a wall or off the map has no path
+    ASSERT_TRUE(planner.plan(testmaps::point(1.0, 1.0), testmaps::point(9.0, 14.0), waypoints));
+    for (const auto& p : waypoints) EXPECT_GE(clearance->clearance(p.x, p.y), 0.15);
+    EXPECT_FALSE(planner.plan(testmaps::point(1.0, 1.0), testmaps::point(5.025, 5.0), waypoints));
+    EXPECT_TRUE(waypoints.empty());
+    EXPECT_FALSE(planner.plan(testmaps::point(1.0, 1.0), testmaps::point(25.0, 5.0), waypoints));
+}
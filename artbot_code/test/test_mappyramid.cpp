@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include "mappyramid.h"
+#include "testmaps.h"
+
+namespace
+{
+    /// Checks every cell of every layer is blocked exactly when a base cell under it is not known free
+    void expectPooled(const MapPyramid& pyramid, const nav_msgs::OccupancyGrid& map)
+    {
+        const int width = map.info.width, height = map.info.height;
+        for (unsigned int level = 0; level < pyramid.levels(); level++) {
+            ASSERT_EQ(pyramid.width(level), (width + (1 << level) - 1) >> level);
+            ASSERT_EQ(pyramid.height(level), (height + (1 << level) - 1) >> level);
+            for (int y = 0; y < pyramid.height(level); y++) {
+                for (int x = 0; x < pyramid.width(level); x++) {
+                    bool blocked = false;
+                    for (int by = y << level; by < std::min(height, (y + 1) << level); by++) {
+                        for (int bx = x << level; bx < std::min(width, (x + 1) << level); bx++) {
+                            blocked = blocked || map.data[static_cast<size_t>(by) * width + bx] != 0;
+                        }
+                    }
+                    ASSERT_EQ(pyramid.blocked(level, x, y), blocked) << "level " << level << " cell " << x << ", " << y;
+                }
+            }
+        }
+    }
+}
+
+TEST(MapPyramid, CoarseCellsBlockedIfAnyCellUnder)
+{
+    std::mt19937 gen(36);
+    // Odd sizes, so the last coarse cells of a row or column only cover part of their block
+    nav_msgs::OccupancyGridPtr map = testmaps::room(150, 131);
+    for (int i = 0; i < 30; i++) testmaps::fill(*map, testmaps::randomBox(*map, 6, gen));
+    MapPyramid pyramid;
+    pyramid.build(*map);
+    EXPECT_EQ(pyramid.levels(), 6u);
+    expectPooled(pyramid, *map);
+    EXPECT_TRUE(pyramid.blocked(0, -1, 0));
+    EXPECT_TRUE(pyramid.blocked(2, pyramid.width(2), 0));
+    EXPECT_TRUE(pyramid.blocked(pyramid.levels(), 0, 0));
+}
+
+TEST(MapPyramid, UpdateMatchesBuild)
+{
+    std::mt19937 gen(37);
+    std::bernoulli_distribution add(0.6);
+    nav_msgs::OccupancyGridPtr map = testmaps::room(150, 131);
+    MapPyramid pyramid;
+    pyramid.build(*map);
+    for (int i = 0; i < 40; i++) {
+        const MapRegion box = testmaps::randomBox(*map, 12, gen);
+        testmaps::fill(*map, box, add(gen) ? 100 : -1);
+        pyramid.update(*map, box);
+        expectPooled(pyramid, *map);
+        if (HasFatalFailure()) return;
+    }
+}
+
+TEST(MapPyramid, BitPackedLayers)
+{
+    // One bit a cell at the base and a third more for the layers above, against a byte a cell for the grid
+    nav_msgs::OccupancyGridPtr map = testmaps::room(1024, 1024);
+    MapPyramid pyramid;
+    pyramid.build(*map);
+    EXPECT_LT(pyramid.bytes(), map->data.size() / 5);
+    EXPECT_GE(pyramid.bytes(), map->data.size() / 8);
+}
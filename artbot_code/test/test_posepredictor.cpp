@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include "posepredictor.h"
+#include "tf/transform_datatypes.h"
+
+namespace
+{
+    geometry_msgs::Pose pose(double x, double y, double yaw)
+    {
+        geometry_msgs::Pose p;
+        p.position.x = x;
+        p.position.y = y;
+        p.orientation = tf::createQuaternionMsgFromYaw(yaw);
+        return p;
+    }
+
+    /// Odometry of a robot driving along x at 0.5 m/s from the odometry origin, at 50 Hz from 0 to end
+    void driveStraight(PosePredictor& predictor, double end)
+    {
+        for (int i = 0; i * 0.02 <= end + 1e-9; i++) {
+            const double t = i * 0.02;
+            predictor.addOdometry(t, pose(0.5 * t, 0.0, 0.0), 0.5, 0.0);
+        }
+    }
+}
+
+TEST(PosePredictor, LastFixWithoutOdometry)
+{
+    PosePredictor predictor;
+    EXPECT_EQ(predictor.fixes(), 0u);
+    EXPECT_EQ(predictor.predict(1.0).position.x, 0.0);
+
+    predictor.addFix(1.0, pose(2.0, 3.0, 0.5));
+    EXPECT_EQ(predictor.fixes(), 1u);
+    const geometry_msgs::Pose predicted = predictor.predict(5.0);
+    EXPECT_EQ(predicted.position.x, 2.0);
+    EXPECT_EQ(predicted.position.y, 3.0);
+    EXPECT_NEAR(tf::getYaw(predicted.orientation), 0.5, 1e-9);
+}
+
+TEST(PosePredictor, LateFixMovedOnByOdometry)
+{
+    PosePredictor predictor;
+    driveStraight(predictor, 2.0);
+    // The fix was valid half way between two messages a second ago, facing +y in the map
+    predictor.addFix(1.01, pose(10.0, 5.0, M_PI / 2));
+
+    // The 0.495 m driven since along the robot's heading, which is +y in the map
+    geometry_msgs::Pose predicted = predictor.predict(2.0);
+    EXPECT_NEAR(predicted.position.x, 10.0, 1e-9);
+    EXPECT_NEAR(predicted.position.y, 5.495, 1e-9);
+    EXPECT_NEAR(tf::getYaw(predicted.orientation), M_PI / 2, 1e-9);
+
+    // Carried forward at the latest velocity for at most 0.2 s
+    predicted = predictor.predict(2.1);
+    EXPECT_NEAR(predicted.position.y, 5.545, 1e-9);
+    predicted = predictor.predict(10.0);
+    EXPECT_NEAR(predicted.position.y, 5.595, 1e-9);
+
+    // A fix stamped 0 is taken as valid at the latest odometry
+    predictor.addFix(0.0, pose(1.0, 1.0, 0.0));
+    EXPECT_EQ(predictor.fixes(), 2u);
+    EXPECT_NEAR(predictor.predict(2.0).position.x, 1.0, 1e-9);
+}
+
+TEST(PosePredictor, TurnsWithOdometry)
+{
+    PosePredictor predictor;
+    // Turning on the spot at 1 rad/s for a second
+    for (int i = 0; i <= 50; i++) {
+        const double t = i * 0.02;
+        predictor.addOdometry(t, pose(1.0, 1.0, t), 0.0, 1.0);
+    }
+    predictor.addFix(0.5, pose(0.0, 0.0, 3.0));
+    EXPECT_NEAR(tf::getYaw(predictor.predict(1.0).orientation), 3.5 - 2 * M_PI, 1e-9);
+    EXPECT_NEAR(tf::getYaw(predictor.predict(1.1).orientation), 3.6 - 2 * M_PI, 1e-9);
+    EXPECT_NEAR(predictor.predict(1.1).position.x, 0.0, 1e-9);
+}
+
+TEST(PosePredictor, KeepsOnlyRecentOdometry)
+{
+    PosePredictor predictor(0.2, 10);
+    driveStraight(predictor, 2.0);
+    // Messages out of order are dropped
+    predictor.addOdometry(1.0, pose(100.0, 0.0, 0.0), 0.5, 0.0);
+
+    // Only the last 10 messages are kept, from 1.82 s, so an older fix is placed on the oldest
+    predictor.addFix(0.5, pose(0.0, 0.0, 0.0));
+    EXPECT_NEAR(predictor.predict(2.0).position.x, 0.09, 1e-9);
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "sharedmap.h"
+#include "testmaps.h"
+
+namespace
+{
+    const FreeSpaceIndex::Bounds BOUNDS = {0.0, 5.0, 0.0, 5.0};
+
+    /// An update setting every cell of a box to a value
+    map_msgs::OccupancyGridUpdate boxUpdate(const MapRegion& box, int8_t value)
+    {
+        map_msgs::OccupancyGridUpdate update;
+        update.x = box.x0;
+        update.y = box.y0;
+        update.width = box.x1 - box.x0 + 1;
+        update.height = box.y1 - box.y0 + 1;
+        update.data.assign(static_cast<size_t>(update.width) * update.height, value);
+        return update;
+    }
+
+    /// Checks every product of a patched map against ones built from scratch for it
+    void expectSameAsRebuild(const SharedMap& patched, double goalClearance)
+    {
+        const nav_msgs::OccupancyGrid& map = *patched.map();
+        ClearanceMap clearance;
+        clearance.update(map);
+        MapPyramid pyramid;
+        pyramid.build(map);
+        FreeSpaceIndex freeSpace;
+        freeSpace.build(map, clearance, BOUNDS, 2, goalClearance);
+
+        const uint32_t cells = map.info.width * map.info.height;
+        ASSERT_EQ(patched.freeSpace().size(), freeSpace.size());
+        for (uint32_t i = 0; i < cells; i++) {
+            ASSERT_EQ(patched.clearanceMap()->clearanceAt(i), clearance.clearanceAt(i)) << "cell " << i;
+            ASSERT_EQ(patched.freeSpace().contains(i), freeSpace.contains(i)) << "cell " << i;
+        }
+        ASSERT_EQ(patched.pyramid()->levels(), pyramid.levels());
+        for (unsigned int level = 0; level < pyramid.levels(); level++) {
+            for (int y = 0; y < pyramid.height(level); y++) {
+                for (int x = 0; x < pyramid.width(level); x++) {
+                    ASSERT_EQ(patched.pyramid()->blocked(level, x, y), pyramid.blocked(level, x, y))
+                        << "level " << level << " cell " << x << ", " << y;
+                }
+            }
+        }
+    }
+}
+
+TEST(SharedMap, MatchesMapsByContent)
+{
+    nav_msgs::OccupancyGridPtr map = testmaps::room(100, 100);
+    testmaps::fill(*map, MapRegion{40, 40, 50, 50});
+    // The same map deserialised again, as each robot of a fleet gets its own /map message
+    nav_msgs::OccupancyGridPtr copy = boost::make_shared<nav_msgs::OccupancyGrid>(*map);
+
+    std::shared_ptr<const SharedMap> first = SharedMap::acquire(map, 0.2, BOUNDS, 2);
+    std::shared_ptr<const SharedMap> second = SharedMap::acquire(copy, 0.2, BOUNDS, 2);
+    EXPECT_EQ(first, second);
+    EXPECT_FALSE(first->freeSpace().empty());
+
+    // Other goal settings index the free space again over the same clearance
+    std::shared_ptr<const SharedMap> wider = SharedMap::acquire(copy, 0.4, BOUNDS, 2);
+    EXPECT_NE(first, wider);
+    EXPECT_EQ(first->clearanceMap(), wider->clearanceMap());
+    EXPECT_LT(wider->freeSpace().size(), first->freeSpace().size());
+
+    // A map differing in one cell has products of its own
+    nav_msgs::OccupancyGridPtr changed = boost::make_shared<nav_msgs::OccupancyGrid>(*map);
+    changed->data[20 * 100 + 20] = 100;
+    std::shared_ptr<const SharedMap> other = SharedMap::acquire(changed, 0.2, BOUNDS, 2);
+    EXPECT_NE(first, other);
+    EXPECT_TRUE(first->freeSpace().contains(20 * 100 + 20));
+    EXPECT_FALSE(other->freeSpace().contains(20 * 100 + 20));
+}
+
+TEST(SharedMap, DropsProductsNoOneHolds)
+{
+    nav_msgs::OccupancyGridPtr map = testmaps::room(60, 60);
+    std::weak_ptr<const SharedMap> held;
+    {
+        std::shared_ptr<const SharedMap> shared = SharedMap::acquire(map, 0.2, BOUNDS, 2);
+        held = shared;
+    }
+    EXPECT_TRUE(held.expired());
+}
+
+TEST(SharedMap, DoesNotHoldTheGrid)
+{
+    nav_msgs::OccupancyGridPtr map = testmaps::room(80, 80);
+    testmaps::fill(*map, MapRegion{30, 30, 40, 40});
+    nav_msgs::OccupancyGridPtr copy = boost::make_shared<nav_msgs::OccupancyGrid>(*map);
+    std::shared_ptr<const SharedMap> shared = SharedMap::acquire(map, 0.2, BOUNDS, 2);
+    EXPECT_EQ(shared->map(), map);
+
+    // Once the grid is dropped the products are still found from the cells known free
+    boost::weak_ptr<const nav_msgs::OccupancyGrid> grid = map;
+    map.reset();
+    EXPECT_TRUE(grid.expired());
+    EXPECT_FALSE(shared->map());
+    EXPECT_EQ(shared, SharedMap::acquire(copy, 0.2, BOUNDS, 2));
+    // Unknown and occupied cells give the same products
+    testmaps::fill(*copy, MapRegion{30, 30, 40, 40}, -1);
+    EXPECT_EQ(shared, SharedMap::acquire(copy, 0.2, BOUNDS, 2));
+    copy->data[10 * 80 + 10] = 100;
+    EXPECT_NE(shared, SharedMap::acquire(copy, 0.2, BOUNDS, 2));
+}
+
+TEST(SharedMap, PatchesMatchRebuild)
+{
+    std::mt19937 gen(40);
+    std::bernoulli_distribution add(0.6);
+    // Larger than a tile, so patches land in some tiles and leave others shared
+    nav_msgs::OccupancyGridPtr map = testmaps::room(150, 130);
+    std::shared_ptr<const SharedMap> shared = SharedMap::acquire(map, 0.2, BOUNDS, 2);
+    nav_msgs::OccupancyGrid::ConstPtr grid = map;
+
+    for (int i = 0; i < 40; i++) {
+        const MapRegion box = testmaps::randomBox(*grid, 12, gen);
+        grid = SharedMap::patchGrid(grid, boxUpdate(box, add(gen) ? 100 : 0));
+        shared = SharedMap::patch(shared, grid, box);
+        ASSERT_EQ(shared->map(), grid);
+        expectSameAsRebuild(*shared, 0.2);
+        if (HasFatalFailure()) return;
+    }
+}
+
+TEST(SharedMap, SharesPatchedProducts)
+{
+    nav_msgs::OccupancyGridPtr map = testmaps::room(100, 100);
+    std::shared_ptr<const SharedMap> first = SharedMap::acquire(map, 0.2, BOUNDS, 2);
+    const map_msgs::OccupancyGridUpdate update = boxUpdate(MapRegion{30, 30, 35, 35}, 100);
+
+    // Two robots handed the same update share the patched grid and the products patched on it
+    nav_msgs::OccupancyGrid::ConstPtr grid = SharedMap::patchGrid(map, update);
+    EXPECT_EQ(grid, SharedMap::patchGrid(map, update));
+    std::shared_ptr<const SharedMap> patched = SharedMap::patch(first, grid, MapRegion{30, 30, 35, 35});
+    EXPECT_EQ(patched, SharedMap::patch(first, grid, MapRegion{30, 30, 35, 35}));
+    EXPECT_EQ(patched, SharedMap::acquire(grid, 0.2, BOUNDS, 2));
+    EXPECT_EQ(grid->data[32 * 100 + 32], 100);
+    EXPECT_EQ(map->data[32 * 100 + 32], 0);
+
+    // A separately patched grid with the same cells still finds the same products
+    nav_msgs::OccupancyGridPtr copy = boost::make_shared<nav_msgs::OccupancyGrid>(*grid);
+    EXPECT_EQ(patched, SharedMap::patch(first, copy, MapRegion{30, 30, 35, 35}));
+
+    // Another update has products of its own
+    nav_msgs::OccupancyGrid::ConstPtr other = SharedMap::patchGrid(map, boxUpdate(MapRegion{30, 30, 35, 35}, 0));
+    EXPECT_NE(grid, other);
+    EXPECT_NE(patched, SharedMap::patch(first, other, MapRegion{30, 30, 35, 35}));
+    EXPECT_FALSE(first->freeSpace().empty());
+}
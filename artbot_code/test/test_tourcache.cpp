@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <unistd.h>
+#include "tourcache.h"
+#include "testmaps.h"
+
+namespace
+{
+    /// @brief A fresh library directory under the temporary directory, removed when the test ends
+    class TourCacheTest : public testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            directory_ = (std::filesystem::temp_directory_path() /
+                          ("tourcache_test_" + std::to_string(::getpid()))).string();
+            std::filesystem::remove_all(directory_);
+        }
+
+        void TearDown() override
+        {
+            std::filesystem::remove_all(directory_);
+        }
+
+        std::string directory_;
+    };
+
+    //! A short straight spline with two wheels
+    squiggles::Trajectory spline()
+    {
+        squiggles::Trajectory trajectory;
+        for (int i = 0; i <= 10; i++) {
+            trajectory.push_back(squiggles::ProfilePoint(
+                squiggles::ControlVector(squiggles::Pose(0.1 * i, 0.0, 0.0), 0.2), {0.2, 0.2}, 0.0, 0.5 * i));
+        }
+        return trajectory;
+    }
+}
+
+TEST_F(TourCacheTest, StoresAndLooksUpLegs)
+{
+    nav_msgs::OccupancyGridPtr map = testmaps::room(40, 40);
+    const std::vector<geometry_msgs::Point> exhibits = {testmaps::point(0.0, 0.0), testmaps::point(1.0, 0.0)};
+    const std::vector<geometry_msgs::Point> waypoints = {testmaps::point(0.5, 0.0), testmaps::point(1.0, 0.0)};
+    const squiggles::Trajectory trajectory = spline();
+
+    TourCache writer(directory_);
+    ASSERT_TRUE(writer.setMap(TourCache::mapHash(*map, exhibits)));
+    ASSERT_TRUE(writer.store(0, 1, waypoints, trajectory.view()));
+
+    // A second cache over the same directory reads the leg back from disk
+    TourCache reader(directory_);
+    EXPECT_TRUE(reader.setMap(TourCache::mapHash(*map, exhibits)));
+    std::vector<geometry_msgs::Point> leg;
+    squiggles::TrajectoryView view;
+    ASSERT_TRUE(reader.lookup(0, 1, exhibits[0], leg, view));
+    ASSERT_EQ(leg.size(), waypoints.size());
+    for (size_t i = 0; i < leg.size(); i++) {
+        EXPECT_EQ(leg[i].x, waypoints[i].x);
+        EXPECT_EQ(leg[i].y, waypoints[i].y);
+    }
+    EXPECT_EQ(squiggles::Trajectory(view).to_profile_points(), trajectory.to_profile_points());
+    EXPECT_FALSE(reader.lookup(1, 0, exhibits[1], leg, view));
+
+    // A box on the leg hides it until the map is selected again
+    reader.invalidate(0.2, -0.1, 0.3, 0.1);
+    EXPECT_FALSE(reader.lookup(0, 1, exhibits[0], leg, view));
+    EXPECT_FALSE(reader.setMap(TourCache::mapHash(*map, exhibits)));
+    EXPECT_TRUE(reader.lookup(0, 1, exhibits[0], leg, view));
+}
+
+TEST_F(TourCacheTest, KeysOnTheMapAndTheExhibits)
+{
+    nav_msgs::OccupancyGridPtr map = testmaps::room(40, 40);
+    const std::vector<geometry_msgs::Point> exhibits = {testmaps::point(0.5, 0.5), testmaps::point(1.5, 0.5)};
+    const uint64_t hash = TourCache::mapHash(*map, exhibits);
+
+    // The stamp is not part of the key
+    nav_msgs::OccupancyGrid republished = *map;
+    republished.header.stamp = ros::Time(100.0);
+    EXPECT_EQ(TourCache::mapHash(republished, exhibits), hash);
+
+    // A changed cell, a moved exhibit and swapped ids each select other legs
+    nav_msgs::OccupancyGrid changed = *map;
+    changed.data[20 * 40 + 20] = 100;
+    EXPECT_NE(TourCache::mapHash(changed, exhibits), hash);
+    std::vector<geometry_msgs::Point> moved = exhibits;
+    moved[1].x += 0.05;
+    EXPECT_NE(TourCache::mapHash(*map, moved), hash);
+    const std::vector<geometry_msgs::Point> swapped = {exhibits[1], exhibits[0]};
+    EXPECT_NE(TourCache::mapHash(*map, swapped), hash);
+
+    TourCache cache(directory_);
+    cache.setMap(hash);
+    const std::string original = cache.mapDirectory();
+    cache.setMap(TourCache::mapHash(*map, moved));
+    EXPECT_NE(cache.mapDirectory(), original);
+}
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "spline.hpp"
+#include "robotlimits.h"
+#include "trajectoryvalidator.h"
+#include "testmaps.h"
+
+TEST(TrajectoryValidator, RepairKeepsEndVelocities)
+{
+    // A box past the corner the leg is meant to turn at, which the spline between its ends swings out into
+    nav_msgs::OccupancyGridPtr map = testmaps::room(100, 100, 0.05f);
+    testmaps::fill(*map, MapRegion{68, 6, 76, 14});
+    ClearanceMap clearanceMap;
+    clearanceMap.update(*map);
+
+    const squiggles::Constraints constraints(robotlimits::MAX_VEL, robotlimits::MAX_ACCEL, robotlimits::MAX_JERK);
+    squiggles::BasicSplineGenerator<squiggles::TankModel> generator(
+        constraints, std::make_shared<squiggles::TankModel>(robotlimits::ROBOT_WIDTH, constraints), 0.01, 1);
+    squiggles::Trajectory path;
+    generator.generate(std::vector<squiggles::ControlVector>{
+        squiggles::ControlVector(squiggles::Pose(1.0, 1.0, 0.0)),
+        squiggles::ControlVector(squiggles::Pose(3.0, 3.0, M_PI / 2))}, path);
+
+    // The last sample is one time step short of the end, where the leg has all but stopped
+    const double endVel = path.view().vel[path.size() - 1];
+    ASSERT_LT(endVel, 0.1 * robotlimits::MAX_VEL);
+
+    TrajectoryValidator validator(constraints, robotlimits::ROBOT_WIDTH, 0.15, 0.025, 3);
+    ASSERT_FALSE(validator.validate(path.view(), clearanceMap));
+    const std::vector<geometry_msgs::Point> corners{testmaps::point(3.0, 1.0), testmaps::point(3.0, 3.0)};
+    EXPECT_TRUE(validator.repair(path.view(), corners, clearanceMap, path));
+
+    // The legs are streamed from a standstill to a stop at the exhibit, and the repaired one keeps to that
+    const squiggles::TrajectoryView repaired = path.view();
+    ASSERT_FALSE(repaired.empty());
+    EXPECT_NEAR(repaired.vel[0], 0.0, 1e-6);
+    EXPECT_LT(repaired.vel[repaired.size - 1], 0.1 * robotlimits::MAX_VEL);
+    EXPECT_NEAR(repaired.vel[repaired.size - 1], endVel, 0.02);
+    EXPECT_NEAR(repaired.x[repaired.size - 1], 3.0, 0.02);
+    EXPECT_NEAR(repaired.y[repaired.size - 1], 3.0, 0.02);
+    for (size_t i = 0; i < repaired.size; i++) ASSERT_LE(std::abs(repaired.accel[i]), robotlimits::MAX_ACCEL + 1e-6) << i;
+}
@@ -0,0 +1,72 @@
+#ifndef TESTMAPS_H
+#define TESTMAPS_H
+
+#include <cstdint>
+#include <random>
+#include <boost/make_shared.hpp>
+#include "nav_msgs/OccupancyGrid.h"
+#include "geometry_msgs/Point.h"
+#include "mapregion.h"
+
+/*!
+ *  \brief     Test Maps
+ *  \details
+ *  Occupancy grids built in code for the tests: a free room walled in on every side, with boxes of occupied
+ *  cells added where a test needs them.
+ *  \version   1.00
+ */
+namespace testmaps
+{
+
+/// @brief A free room of width x height cells with a one cell wall round it, origin at (0, 0)
+inline nav_msgs::OccupancyGridPtr room(uint32_t width, uint32_t height, float resolution = 0.05f)
+{
+    nav_msgs::OccupancyGridPtr map = boost::make_shared<nav_msgs::OccupancyGrid>();
+    map->info.width = width;
+    map->info.height = height;
+    map->info.resolution = resolution;
+    map->info.origin.orientation.w = 1.0;
+    map->data.assign(static_cast<size_t>(width) * height, 0);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            if (x == 0 || y == 0 || x + 1 == width || y + 1 == height) map->data[y * width + x] = 100;
+        }
+    }
+    return map;
+}
+
+/// @brief Sets every cell of a box, both corners included, to a value
+inline void fill(nav_msgs::OccupancyGrid& map, const MapRegion& box, int8_t value = 100)
+{
+    for (int y = box.y0; y <= box.y1; y++) {
+        for (int x = box.x0; x <= box.x1; x++) map.data[static_cast<size_t>(y) * map.info.width + x] = value;
+    }
+}
+
+/// @brief A random box of up to size cells a side inside the walls of a map
+inline MapRegion randomBox(const nav_msgs::OccupancyGrid& map, int size, std::mt19937& gen)
+{
+    std::uniform_int_distribution<int> side(1, size);
+    const int w = side(gen), h = side(gen);
+    std::uniform_int_distribution<int> x(1, static_cast<int>(map.info.width) - 1 - w);
+    std::uniform_int_distribution<int> y(1, static_cast<int>(map.info.height) - 1 - h);
+    MapRegion box;
+    box.x0 = x(gen);
+    box.y0 = y(gen);
+    box.x1 = box.x0 + w - 1;
+    box.y1 = box.y0 + h - 1;
+    return box;
+}
+
+/// @brief A world position
+inline geometry_msgs::Point point(double x, double y)
+{
+    geometry_msgs::Point p;
+    p.x = x;
+    p.y = y;
+    return p;
+}
+
+} // namespace testmaps
+
+#endif // TESTMAPS_H
@@ -0,0 +1,24 @@
+#ifndef _BENCH_ALLOC_COUNTER_HPP_
+#define _BENCH_ALLOC_COUNTER_HPP_
+
+#include <cstddef>
+
+#include "benchmark/benchmark.h"
+
+/**
+ * Counts the calls to the global operator new made by this process, which
+ * alloc-counter.cpp replaces.
+ */
+std::size_t allocation_count();
+
+/**
+ * Reports the allocations made since the given count, averaged over the
+ * iterations of the benchmark, as the "allocs" counter.
+ */
+inline void report_allocations(benchmark::State& state, std::size_t since) {
+  state.counters["allocs"] =
+    benchmark::Counter(static_cast<double>(allocation_count() - since),
+                       benchmark::Counter::kAvgIterations);
+}
+
+#endif
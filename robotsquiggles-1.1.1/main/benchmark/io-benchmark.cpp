@@ -0,0 +1,143 @@
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "alloc-counter.hpp"
+#include "benchmark/benchmark.h"
+#include "scenarios.hpp"
+
+using namespace squiggles;
+
+static Trajectory bench_path(std::size_t waypoints) {
+  auto generator = BasicSplineGenerator<TankModel>(bench_constraints(),
+                                                   bench_model<TankModel>());
+  Trajectory path;
+  generator.generate(zigzag(waypoints), path);
+  return path;
+}
+
+static void BM_csv_round_trip(benchmark::State& state) {
+  const auto points = bench_path(state.range(0)).to_profile_points();
+
+  const std::size_t allocations = allocation_count();
+  for (auto _ : state) {
+    std::stringstream buffer;
+    serialize_path(buffer, points);
+    auto read = deserialize_path(buffer);
+    benchmark::DoNotOptimize(read);
+  }
+  report_allocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_csv_round_trip)
+  ->ArgsProduct({WAYPOINT_COUNTS})
+  ->ArgNames({"waypoints"})
+  ->Unit(benchmark::kMillisecond);
+
+static void BM_binary_round_trip(benchmark::State& state) {
+  const auto path = bench_path(state.range(0));
+
+  const std::size_t allocations = allocation_count();
+  for (auto _ : state) {
+    std::stringstream buffer;
+    serialize_binary_path(buffer, path.view());
+    auto read = deserialize_binary_path(buffer);
+    benchmark::DoNotOptimize(read);
+  }
+  report_allocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * path.size());
+}
+BENCHMARK(BM_binary_round_trip)
+  ->ArgsProduct({WAYPOINT_COUNTS})
+  ->ArgNames({"waypoints"})
+  ->Unit(benchmark::kMicrosecond);
+
+/**
+ * Checking a buffer in the binary format and viewing it in place, as is done
+ * for a mapped file.
+ */
+static void BM_binary_view(benchmark::State& state) {
+  const auto path = bench_path(state.range(0));
+  std::stringstream buffer;
+  serialize_binary_path(buffer, path.view());
+  const std::string bytes = buffer.str();
+  std::vector<double> aligned((bytes.size() + sizeof(double) - 1) /
+                              sizeof(double));
+  std::copy(bytes.begin(), bytes.end(), reinterpret_cast<char*>(aligned.data()));
+
+  const std::size_t allocations = allocation_count();
+  for (auto _ : state) {
+    auto view = view_binary_path(aligned.data(), bytes.size());
+    benchmark::DoNotOptimize(view);
+  }
+  report_allocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * path.size());
+}
+BENCHMARK(BM_binary_view)
+  ->ArgsProduct({WAYPOINT_COUNTS})
+  ->ArgNames({"waypoints"})
+  ->Unit(benchmark::kNanosecond);
+
+/**
+ * Writes one wheel of a path in the Pathfinder format, offset from the center
+ * by half the track width to the left or right, at 6 decimals as Pathfinder
+ * writes it.
+ */
+static std::string pathfinder_wheel(const TrajectoryView& path, bool left) {
+  const double offset = left ? 0.2 : -0.2;
+  std::string csv = "dt,x,y,position,velocity,acceleration,jerk,heading\n";
+  char line[160];
+  double position = 0.0;
+  for (std::size_t i = 0; i < path.size; ++i) {
+    const double vel = path.wheel_velocity(i, left ? 0 : 1);
+    const double dt = i == 0 ? 0.0 : path.time[i] - path.time[i - 1];
+    position += vel * dt;
+    std::snprintf(line,
+                  sizeof(line),
+                  "%f,%f,%f,%f,%f,%f,%f,%f\n",
+                  dt,
+                  path.x[i] - offset * std::sin(path.yaw[i]),
+                  path.y[i] + offset * std::cos(path.yaw[i]),
+                  position,
+                  vel,
+                  path.accel[i],
+                  path.jerk[i],
+                  path.yaw[i]);
+    csv += line;
+  }
+  return csv;
+}
+
+/**
+ * Importing a long Pathfinder path, line by line with
+ * deserialize_pathfinder_path for zero threads and with parse_pathfinder_path
+ * on the given number of threads otherwise.
+ */
+static void BM_pathfinder_ingest(benchmark::State& state) {
+  const auto path = bench_path(state.range(0));
+  const std::string left = pathfinder_wheel(path.view(), true);
+  const std::string right = pathfinder_wheel(path.view(), false);
+  const auto threads = static_cast<unsigned int>(state.range(1));
+
+  const std::size_t allocations = allocation_count();
+  for (auto _ : state) {
+    if (threads == 0) {
+      std::istringstream left_stream(left);
+      std::istringstream right_stream(right);
+      auto read = deserialize_pathfinder_path(left_stream, right_stream);
+      benchmark::DoNotOptimize(read);
+    } else {
+      auto read = parse_pathfinder_path(left, right, threads);
+      benchmark::DoNotOptimize(read);
+    }
+  }
+  report_allocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * path.size());
+  state.SetBytesProcessed(state.iterations() * (left.size() + right.size()));
+}
+BENCHMARK(BM_pathfinder_ingest)
+  ->ArgsProduct({{32, 1024}, {0, 1, 4}})
+  ->ArgNames({"waypoints", "threads"})
+  ->Unit(benchmark::kMillisecond)
+  ->UseRealTime();
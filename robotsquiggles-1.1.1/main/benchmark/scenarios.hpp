@@ -0,0 +1,68 @@
+#ifndef _BENCH_SCENARIOS_HPP_
+#define _BENCH_SCENARIOS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "squiggles.hpp"
+
+/**
+ * The constraints and robot width used by the tests.
+ */
+inline squiggles::Constraints bench_constraints() {
+  return squiggles::Constraints(2.0, 2.0, 10.0);
+}
+
+template <class Model> std::shared_ptr<Model> bench_model();
+
+template <>
+inline std::shared_ptr<squiggles::TankModel>
+bench_model<squiggles::TankModel>() {
+  return std::make_shared<squiggles::TankModel>(0.4, bench_constraints());
+}
+
+template <>
+inline std::shared_ptr<squiggles::PassthroughModel>
+bench_model<squiggles::PassthroughModel>() {
+  return std::make_shared<squiggles::PassthroughModel>();
+}
+
+/**
+ * The TankModel behind the PhysicalModel interface, as used by SplineGenerator.
+ */
+template <>
+inline std::shared_ptr<squiggles::PhysicalModel>
+bench_model<squiggles::PhysicalModel>() {
+  return bench_model<squiggles::TankModel>();
+}
+
+/**
+ * A path of the given number of waypoints that zigzags two meters forward and
+ * one meter sideways between each of them, so every segment has the length of
+ * the (0, 0) to (2, 2) test paths.
+ */
+inline std::vector<squiggles::Pose> zigzag(std::size_t waypoints) {
+  std::vector<squiggles::Pose> poses;
+  for (std::size_t i = 0; i < waypoints; ++i) {
+    poses.emplace_back(2.0 * i, i % 2 == 0 ? 0.0 : 1.0, 0.0);
+  }
+  return poses;
+}
+
+inline std::vector<squiggles::ControlVector>
+to_vectors(const std::vector<squiggles::Pose>& poses) {
+  std::vector<squiggles::ControlVector> vectors;
+  for (const auto& p : poses) {
+    vectors.emplace_back(p);
+  }
+  return vectors;
+}
+
+/**
+ * Waypoint counts from a single segment up to a tour of 127 segments.
+ */
+inline const std::vector<std::int64_t> WAYPOINT_COUNTS = {2, 8, 32, 128};
+
+#endif
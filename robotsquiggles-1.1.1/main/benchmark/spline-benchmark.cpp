@@ -0,0 +1,214 @@
+#include <cmath>
+
+#include "alloc-counter.hpp"
+#include "benchmark/benchmark.h"
+#include "scenarios.hpp"
+
+using namespace squiggles;
+
+/**
+ * A long-lived generator writing into the same Trajectory, as a robot that
+ * replans does.
+ */
+template <class Model> static void BM_generate_poses(benchmark::State& state) {
+  auto generator =
+    BasicSplineGenerator<Model>(bench_constraints(), bench_model<Model>());
+  const auto waypoints = zigzag(state.range(0));
+  const bool fast = state.range(1) != 0;
+  Trajectory path;
+  generator.generate(waypoints, path, fast);
+
+  const std::size_t allocations = allocation_count();
+  for (auto _ : state) {
+    generator.generate(waypoints, path, fast);
+    benchmark::DoNotOptimize(path.view().time);
+  }
+  report_allocations(state, allocations);
+  state.counters["states"] = static_cast<double>(path.size());
+}
+BENCHMARK_TEMPLATE(BM_generate_poses, TankModel)
+  ->ArgsProduct({WAYPOINT_COUNTS, {0, 1}})
+  ->ArgNames({"waypoints", "fast"})
+  ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_generate_poses, PassthroughModel)
+  ->ArgsProduct({WAYPOINT_COUNTS, {0, 1}})
+  ->ArgNames({"waypoints", "fast"})
+  ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_generate_poses, PhysicalModel)
+  ->ArgsProduct({WAYPOINT_COUNTS, {0, 1}})
+  ->ArgNames({"waypoints", "fast"})
+  ->Unit(benchmark::kMillisecond);
+
+/**
+ * A new generator and output for every path, as in the README example.
+ */
+static void BM_generate_poses_fresh(benchmark::State& state) {
+  const auto waypoints = zigzag(state.range(0));
+  const bool fast = state.range(1) != 0;
+
+  const std::size_t allocations = allocation_count();
+  for (auto _ : state) {
+    auto generator =
+      SplineGenerator(bench_constraints(), bench_model<PhysicalModel>());
+    auto path = generator.generate(waypoints, fast);
+    benchmark::DoNotOptimize(path.data());
+  }
+  report_allocations(state, allocations);
+}
+BENCHMARK(BM_generate_poses_fresh)
+  ->ArgsProduct({WAYPOINT_COUNTS, {0, 1}})
+  ->ArgNames({"waypoints", "fast"})
+  ->Unit(benchmark::kMillisecond);
+
+template <class Model>
+static void BM_generate_vectors(benchmark::State& state) {
+  auto generator =
+    BasicSplineGenerator<Model>(bench_constraints(), bench_model<Model>());
+  const auto waypoints = to_vectors(zigzag(state.range(0)));
+  std::vector<ProfilePoint> path;
+  generator.generate(waypoints, path);
+
+  const std::size_t allocations = allocation_count();
+  for (auto _ : state) {
+    generator.generate(waypoints, path);
+    benchmark::DoNotOptimize(path.data());
+  }
+  report_allocations(state, allocations);
+}
+BENCHMARK_TEMPLATE(BM_generate_vectors, TankModel)
+  ->ArgsProduct({WAYPOINT_COUNTS})
+  ->ArgNames({"waypoints"})
+  ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_generate_vectors, PassthroughModel)
+  ->ArgsProduct({WAYPOINT_COUNTS})
+  ->ArgNames({"waypoints"})
+  ->Unit(benchmark::kMillisecond);
+
+/**
+ * The motion profile pass alone, over a straight segment of the given length
+ * in decimeters.
+ */
+template <class Model> static void BM_parameterize(benchmark::State& state) {
+  auto generator =
+    BasicSplineGenerator<Model>(bench_constraints(), bench_model<Model>());
+  auto start = ControlVector(Pose(0, 0, 0));
+  auto end = ControlVector(Pose(state.range(0) / 10.0, 0, 0));
+  std::vector<typename BasicSplineGenerator<Model>::GeneratedPoint> raw;
+  generator.gen_raw_path(start, end, false, raw);
+  std::vector<ProfilePoint> path;
+  generator.parameterize(start, end, raw, 0.0, 0.0, 0.0, path);
+
+  const std::size_t allocations = allocation_count();
+  for (auto _ : state) {
+    generator.parameterize(start, end, raw, 0.0, 0.0, 0.0, path);
+    benchmark::DoNotOptimize(path.data());
+  }
+  report_allocations(state, allocations);
+  state.counters["states"] = static_cast<double>(path.size());
+}
+BENCHMARK_TEMPLATE(BM_parameterize, TankModel)
+  ->Arg(5)
+  ->Arg(20)
+  ->Arg(80)
+  ->ArgName("decimeters")
+  ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_parameterize, PassthroughModel)
+  ->Arg(5)
+  ->Arg(20)
+  ->Arg(80)
+  ->ArgName("decimeters")
+  ->Unit(benchmark::kMicrosecond);
+
+/**
+ * The time until the first segment of a tour can be followed.
+ */
+static void BM_stream_first_segment(benchmark::State& state) {
+  auto stream = BasicSplineStream<TankModel>(bench_constraints(),
+                                             bench_model<TankModel>());
+  const auto waypoints = zigzag(state.range(0));
+  Trajectory segment;
+
+  const std::size_t allocations = allocation_count();
+  for (auto _ : state) {
+    stream.start(waypoints);
+    stream.next(segment);
+    benchmark::DoNotOptimize(segment.view().time);
+    state.PauseTiming();
+    stream.cancel();
+    state.ResumeTiming();
+  }
+  report_allocations(state, allocations);
+}
+BENCHMARK(BM_stream_first_segment)
+  ->ArgsProduct({WAYPOINT_COUNTS})
+  ->ArgNames({"waypoints"})
+  ->Unit(benchmark::kMillisecond);
+
+/**
+ * Many what-if paths from one origin to goals around it, on one thread and on
+ * every core.
+ */
+static void BM_generate_batch(benchmark::State& state) {
+  const std::size_t count = state.range(0);
+  std::vector<double> requests;
+  for (std::size_t i = 0; i < count; ++i) {
+    const double angle = 0.1 * i;
+    const double nan = std::nan("");
+    requests.insert(requests.end(),
+                    {0, 0, 0, nan, 2 * std::cos(angle), 2 * std::sin(angle),
+                     angle, nan, 2.0, 2.0, 10.0, 0.4});
+  }
+  std::vector<double> states(count * 64 * BATCH_STATE_FIELDS);
+  std::vector<std::uint32_t> offsets(count + 1);
+  const unsigned int threads = static_cast<unsigned int>(state.range(1));
+
+  const std::size_t allocations = allocation_count();
+  for (auto _ : state) {
+    squiggles_generate_batch(requests.data(),
+                             count,
+                             0.1,
+                             threads,
+                             states.data(),
+                             count * 64,
+                             offsets.data());
+    benchmark::DoNotOptimize(states.data());
+  }
+  report_allocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_generate_batch)
+  ->ArgsProduct({{64, 1024}, {1, 0}})
+  ->ArgNames({"paths", "threads"})
+  ->Unit(benchmark::kMillisecond)
+  ->UseRealTime();
+
+/**
+ * A slow zone added over one segment in the middle of a tour whose curve was
+ * kept, against generating the tour again.
+ */
+static void BM_reprofile_zone(benchmark::State& state) {
+  auto generator = BasicSplineGenerator<TankModel>(bench_constraints(),
+                                                   bench_model<TankModel>());
+  const auto waypoints = zigzag(state.range(0));
+  BasicSplineGenerator<TankModel>::GeometricPath geometry;
+  Trajectory path;
+  generator.generate(waypoints, geometry, path);
+  const auto& middle = geometry.segments[geometry.segments.size() / 2];
+  const double from = middle.start_distance + 0.5;
+  const double to = from + 1.0;
+  const std::vector<std::vector<SpeedZone>> zones = {
+    {SpeedZone(from, to, 0.5)}, {}};
+  std::size_t toggle = 0;
+
+  const std::size_t allocations = allocation_count();
+  for (auto _ : state) {
+    generator.reprofile(geometry, zones[toggle ^= 1], from, to, path);
+    benchmark::DoNotOptimize(path.view().time);
+  }
+  report_allocations(state, allocations);
+  state.counters["states"] = static_cast<double>(path.size());
+}
+BENCHMARK(BM_reprofile_zone)
+  ->ArgsProduct({WAYPOINT_COUNTS})
+  ->ArgNames({"waypoints"})
+  ->Unit(benchmark::kMicrosecond);
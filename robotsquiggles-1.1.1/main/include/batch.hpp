@@ -0,0 +1,64 @@
+/**
+ * Copyright 2020 Jonathan Bayless
+ *
+ * Use of this source code is governed by an MIT-style license that can be found
+ * in the LICENSE file or at https://opensource.org/licenses/MIT.
+ */
+#ifndef _SQUIGGLES_BATCH_HPP_
+#define _SQUIGGLES_BATCH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace squiggles {
+/**
+ * The number of doubles describing each request to squiggles_generate_batch,
+ * in the order start x, start y, start yaw, start velocity, goal x, goal y,
+ * goal yaw, goal velocity, max velocity, max acceleration, max jerk and track
+ * width. A NaN velocity is left free, as for ControlVector.
+ */
+constexpr std::size_t BATCH_REQUEST_FIELDS = 12;
+
+/**
+ * The number of doubles written for each state by squiggles_generate_batch, in
+ * the order x, y, yaw, velocity, acceleration, jerk, curvature, time, left
+ * wheel velocity and right wheel velocity.
+ */
+constexpr std::size_t BATCH_STATE_FIELDS = 10;
+} // namespace squiggles
+
+extern "C" {
+/**
+ * Generates a tank drive path between the start and goal of each request and
+ * writes every path into one buffer.
+ *
+ * The paths are written one after another with BATCH_STATE_FIELDS doubles per
+ * state. Requests with the same constraints and track width in a row share a
+ * generator. When built with threads the requests are split across them,
+ * otherwise they are generated in turn.
+ *
+ * @param requests BATCH_REQUEST_FIELDS doubles for each request.
+ * @param count The number of requests.
+ * @param dt The time in seconds between each state.
+ * @param threads The number of threads to generate on, zero uses the hardware
+ *                concurrency.
+ * @param states Receives the states of every path.
+ * @param capacity The number of states that fit in the states buffer.
+ * @param offsets Receives count + 1 entries, the states of request i are
+ *                states [offsets[i], offsets[i + 1]). A request that no path
+ *                could be found for has no states.
+ *
+ * @return The number of requests no path was found for, or -1 if the paths do
+ *         not fit in the buffer. In that case offsets still holds the layout
+ *         they need but nothing is written to states.
+ */
+int squiggles_generate_batch(const double* requests,
+                             std::size_t count,
+                             double dt,
+                             unsigned int threads,
+                             double* states,
+                             std::size_t capacity,
+                             std::uint32_t* offsets);
+}
+
+#endif
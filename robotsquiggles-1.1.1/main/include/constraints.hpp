@@ -8,6 +8,7 @@
 #define _SQUIGGLES_CONSTRAINTS_HPP_
 
 #include <cmath>
+#include <limits>
 #include <string>
 
 namespace squiggles {
@@ -61,5 +62,26 @@ struct Constraints {
   double min_accel;
   double max_curvature;
 };
+
+/**
+ * A lower speed limit over a span of a path, such as a slow zone near
+ * something fragile.
+ */
+struct SpeedZone {
+  /**
+   * Defines a speed limit over a span of a path.
+   *
+   * @param istart The distance along the path where the zone starts in meters.
+   * @param iend The distance along the path where the zone ends in meters.
+   * @param imax_vel The maximum allowable velocity inside the zone in meters
+   *                 per second.
+   */
+  SpeedZone(double istart, double iend, double imax_vel)
+    : start(istart), end(iend), max_vel(imax_vel) {}
+
+  double start;
+  double end;
+  double max_vel;
+};
 } // namespace squiggles
 #endif
@@ -9,9 +9,9 @@
 
 #include <iostream>
 #include <string>
-#include <vector>
 
 #include "controlvector.hpp"
+#include "wheelvelocities.hpp"
 #include "math/utils.hpp"
 
 namespace squiggles {
@@ -28,7 +28,7 @@ struct ProfilePoint {
    *              path in seconds.
    */
   ProfilePoint(ControlVector ivector,
-               std::vector<double> iwheel_velocities,
+               WheelVelocities iwheel_velocities,
                double icurvature,
                double itime)
     : vector(ivector),
@@ -91,7 +91,7 @@ struct ProfilePoint {
   }
 
   ControlVector vector;
-  std::vector<double> wheel_velocities;
+  WheelVelocities wheel_velocities;
   double curvature;
   double time;
 };
@@ -0,0 +1,311 @@
+/**
+ * Copyright 2020 Jonathan Bayless
+ *
+ * Use of this source code is governed by an MIT-style license that can be found
+ * in the LICENSE file or at https://opensource.org/licenses/MIT.
+ */
+#ifndef _GEOMETRY_TRAJECTORY_HPP_
+#define _GEOMETRY_TRAJECTORY_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include "controlvector.hpp"
+#include "pose.hpp"
+#include "profilepoint.hpp"
+
+namespace squiggles {
+/**
+ * A read-only, non-owning view of a motion profiled path that is stored as one
+ * contiguous column per field.
+ *
+ * The wheel velocities are stored row by row, with wheel_count values for each
+ * state. A view is only valid for as long as the storage it points into is not
+ * modified.
+ */
+struct TrajectoryView {
+  /**
+   * Gets the pose of the state at the given index.
+   */
+  Pose pose(std::size_t i) const { return Pose(x[i], y[i], yaw[i]); }
+
+  /**
+   * Gets the pose and associated dynamics of the state at the given index.
+   */
+  ControlVector control_vector(std::size_t i) const {
+    return ControlVector(pose(i), vel[i], accel[i], jerk[i]);
+  }
+
+  /**
+   * Gets the velocity of one of the wheels at the given index.
+   */
+  double wheel_velocity(std::size_t i, std::size_t wheel) const {
+    return wheel_velocities[i * wheel_count + wheel];
+  }
+
+  /**
+   * Copies the state at the given index out into a ProfilePoint.
+   */
+  ProfilePoint point(std::size_t i) const {
+    return ProfilePoint(
+      control_vector(i),
+      WheelVelocities(wheel_velocities + i * wheel_count,
+                      wheel_velocities + (i + 1) * wheel_count),
+      curvature[i],
+      time[i]);
+  }
+
+  /**
+   * Copies every state out into a series of ProfilePoints.
+   */
+  std::vector<ProfilePoint> to_profile_points() const {
+    std::vector<ProfilePoint> out;
+    out.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+      out.emplace_back(point(i));
+    }
+    return out;
+  }
+
+  bool empty() const { return size == 0; }
+
+  std::size_t size = 0;
+  std::size_t wheel_count = 0;
+
+  const double* x = nullptr;
+  const double* y = nullptr;
+  const double* yaw = nullptr;
+  const double* vel = nullptr;
+  const double* accel = nullptr;
+  const double* jerk = nullptr;
+  const double* curvature = nullptr;
+  const double* time = nullptr;
+  const double* wheel_velocities = nullptr;
+};
+
+/**
+ * Owns a motion profiled path in structure-of-arrays form.
+ *
+ * This holds the same states as a std::vector<ProfilePoint> without a separate
+ * allocation for each state's wheel velocities, and a controller that only
+ * reads a few fields only touches those columns. The number of wheels is fixed
+ * by the first state added to an empty trajectory.
+ */
+class Trajectory {
+  public:
+  Trajectory() = default;
+
+  /**
+   * Copies a series of ProfilePoints into columns.
+   */
+  explicit Trajectory(const std::vector<ProfilePoint>& points) {
+    append(points.begin(), points.end());
+  }
+
+  /**
+   * Copies the columns of a view, such as one over a memory mapped file.
+   */
+  explicit Trajectory(const TrajectoryView& other)
+    : x(other.x, other.x + other.size),
+      y(other.y, other.y + other.size),
+      yaw(other.yaw, other.yaw + other.size),
+      vel(other.vel, other.vel + other.size),
+      accel(other.accel, other.accel + other.size),
+      jerk(other.jerk, other.jerk + other.size),
+      curvature(other.curvature, other.curvature + other.size),
+      time(other.time, other.time + other.size),
+      wheels(other.wheel_velocities,
+             other.wheel_velocities + other.size * other.wheel_count),
+      wheel_count(other.wheel_count) {}
+
+  /**
+   * Removes every state while keeping the allocated capacity.
+   */
+  void clear() {
+    for (auto* column : columns()) {
+      column->clear();
+    }
+    wheels.clear();
+    wheel_count = 0;
+  }
+
+  /**
+   * Allocates room for the given number of states.
+   */
+  void reserve(std::size_t n, std::size_t iwheel_count = 2) {
+    for (auto* column : columns()) {
+      column->reserve(n);
+    }
+    wheels.reserve(n * iwheel_count);
+  }
+
+  /**
+   * Resizes the trajectory to n states of the given number of wheels. States
+   * that are added are zero, and the wheel velocities of states that are kept
+   * are only meaningful if the wheel count is unchanged.
+   */
+  void resize(std::size_t n, std::size_t iwheel_count) {
+    for (auto* column : columns()) {
+      column->resize(n);
+    }
+    wheels.resize(n * iwheel_count);
+    wheel_count = iwheel_count;
+  }
+
+  /**
+   * Gets a column to be written in place, such as by several threads that each
+   * fill their own range of states. The columns are numbered as in the binary
+   * trajectory format: x, y, yaw, vel, accel, jerk, curvature, time and then
+   * the row-major wheel velocities. The pointer is invalidated by any change to
+   * the size of the trajectory.
+   */
+  double* column_data(std::size_t column) {
+    return column < 8 ? columns()[column]->data() : wheels.data();
+  }
+
+  /**
+   * Adds a state to the end of the trajectory.
+   *
+   * Wheel velocities beyond the trajectory's wheel count are dropped and
+   * missing ones are filled with zero.
+   */
+  void push_back(const ProfilePoint& p) {
+    if (empty()) {
+      wheel_count = p.wheel_velocities.size();
+    }
+    x.push_back(p.vector.pose.x);
+    y.push_back(p.vector.pose.y);
+    yaw.push_back(p.vector.pose.yaw);
+    vel.push_back(p.vector.vel);
+    accel.push_back(p.vector.accel);
+    jerk.push_back(p.vector.jerk);
+    curvature.push_back(p.curvature);
+    time.push_back(p.time);
+    const auto n = std::min(wheel_count, p.wheel_velocities.size());
+    wheels.insert(wheels.end(),
+                  p.wheel_velocities.begin(),
+                  p.wheel_velocities.begin() + n);
+    wheels.resize(wheels.size() + wheel_count - n, 0.0);
+  }
+
+  /**
+   * Adds a range of ProfilePoints to the end of the trajectory.
+   */
+  template <class Iter> void append(Iter first, Iter last) {
+    for (; first != last; ++first) {
+      push_back(*first);
+    }
+  }
+
+  /**
+   * Replaces the states in [first, last) with a range of ProfilePoints, which
+   * may hold a different number of states. Wheel velocities are fitted to the
+   * trajectory's wheel count as in push_back().
+   */
+  template <class Iter>
+  void replace(std::size_t first, std::size_t last, Iter ifirst, Iter ilast) {
+    const std::size_t n = std::distance(ifirst, ilast);
+    if (empty() && n > 0) {
+      wheel_count = ifirst->wheel_velocities.size();
+    }
+    // The columns are only resized in place, so a span replaced by one of the
+    // same or a smaller size never allocates
+    for (auto* column : columns()) {
+      resize_span(*column, first, last, n);
+    }
+    resize_span(
+      wheels, first * wheel_count, last * wheel_count, n * wheel_count);
+    for (std::size_t i = first; ifirst != ilast; ++ifirst, ++i) {
+      const ProfilePoint& p = *ifirst;
+      x[i] = p.vector.pose.x;
+      y[i] = p.vector.pose.y;
+      yaw[i] = p.vector.pose.yaw;
+      vel[i] = p.vector.vel;
+      accel[i] = p.vector.accel;
+      jerk[i] = p.vector.jerk;
+      curvature[i] = p.curvature;
+      time[i] = p.time;
+      const auto count = std::min(wheel_count, p.wheel_velocities.size());
+      auto row = wheels.begin() + i * wheel_count;
+      std::copy_n(p.wheel_velocities.begin(), count, row);
+      std::fill(row + count, row + wheel_count, 0.0);
+    }
+  }
+
+  /**
+   * Adds an offset to the timestamps of the states from first on.
+   */
+  void shift_time(std::size_t first, double offset) {
+    for (auto t = time.begin() + first; t != time.end(); ++t) {
+      *t += offset;
+    }
+  }
+
+  /**
+   * Gets a view of the columns. The view is invalidated by any change to the
+   * trajectory.
+   */
+  TrajectoryView view() const {
+    TrajectoryView out;
+    out.size = size();
+    out.wheel_count = wheel_count;
+    out.x = x.data();
+    out.y = y.data();
+    out.yaw = yaw.data();
+    out.vel = vel.data();
+    out.accel = accel.data();
+    out.jerk = jerk.data();
+    out.curvature = curvature.data();
+    out.time = time.data();
+    out.wheel_velocities = wheels.data();
+    return out;
+  }
+
+  operator TrajectoryView() const { return view(); }
+
+  ProfilePoint point(std::size_t i) const { return view().point(i); }
+
+  std::vector<ProfilePoint> to_profile_points() const {
+    return view().to_profile_points();
+  }
+
+  std::size_t size() const { return time.size(); }
+  bool empty() const { return time.empty(); }
+  std::size_t wheels_per_state() const { return wheel_count; }
+
+  private:
+  /**
+   * Grows or shrinks the span [first, last) of a column to n values.
+   */
+  static void resize_span(std::vector<double>& column,
+                          std::size_t first,
+                          std::size_t last,
+                          std::size_t n) {
+    if (n > last - first) {
+      column.insert(column.begin() + last, n - (last - first), 0.0);
+    } else {
+      column.erase(column.begin() + first + n, column.begin() + last);
+    }
+  }
+
+  std::array<std::vector<double>*, 8> columns() {
+    return {&x, &y, &yaw, &vel, &accel, &jerk, &curvature, &time};
+  }
+
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> yaw;
+  std::vector<double> vel;
+  std::vector<double> accel;
+  std::vector<double> jerk;
+  std::vector<double> curvature;
+  std::vector<double> time;
+  std::vector<double> wheels;
+  std::size_t wheel_count = 0;
+};
+} // namespace squiggles
+
+#endif
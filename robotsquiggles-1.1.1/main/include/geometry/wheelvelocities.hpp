@@ -0,0 +1,80 @@
+/**
+ * Copyright 2020 Jonathan Bayless
+ *
+ * Use of this source code is governed by an MIT-style license that can be found
+ * in the LICENSE file or at https://opensource.org/licenses/MIT.
+ */
+#ifndef _GEOMETRY_WHEEL_VELOCITIES_HPP_
+#define _GEOMETRY_WHEEL_VELOCITIES_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+namespace squiggles {
+/**
+ * The velocity of each wheel at one state of a path, stored inline.
+ *
+ * Every state of a generated path carries one of these, so they hold up to
+ * MAX_WHEELS values without a heap allocation of their own. Values past
+ * MAX_WHEELS are dropped.
+ */
+class WheelVelocities {
+  public:
+  /**
+   * The most wheels a physical model can report, enough for a four wheeled
+   * holonomic drive.
+   */
+  static constexpr std::size_t MAX_WHEELS = 4;
+
+  WheelVelocities() = default;
+
+  /**
+   * Defines the velocities of a set of wheels.
+   *
+   * @param ivalues The velocity of each wheel in meters per second.
+   */
+  WheelVelocities(std::initializer_list<double> ivalues)
+    : WheelVelocities(ivalues.begin(), ivalues.end()) {}
+
+  /**
+   * Copies the velocities of a set of wheels out of a range.
+   */
+  template <class Iter> WheelVelocities(Iter first, Iter last) {
+    for (; first != last && count < MAX_WHEELS; ++first) {
+      values[count++] = *first;
+    }
+  }
+
+  /**
+   * Copies the velocities of a set of wheels out of a vector, as the wheel
+   * velocities were stored before they were held inline.
+   */
+  WheelVelocities(const std::vector<double>& ivalues)
+    : WheelVelocities(ivalues.begin(), ivalues.end()) {}
+
+  std::size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  double& operator[](std::size_t i) { return values[i]; }
+  double operator[](std::size_t i) const { return values[i]; }
+
+  double* begin() { return values.data(); }
+  double* end() { return values.data() + count; }
+  const double* begin() const { return values.data(); }
+  const double* end() const { return values.data() + count; }
+
+  bool operator==(const WheelVelocities& other) const {
+    return count == other.count &&
+           std::equal(begin(), end(), other.begin());
+  }
+
+  private:
+  std::array<double, MAX_WHEELS> values{};
+  std::size_t count = 0;
+};
+} // namespace squiggles
+
+#endif
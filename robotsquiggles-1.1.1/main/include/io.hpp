@@ -7,10 +7,15 @@
 #ifndef _SQUIGGLES_IO_HPP_
 #define _SQUIGGLES_IO_HPP_
 
+#include <cstddef>
+#include <cstdint>
 #include <optional>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include "geometry/profilepoint.hpp"
+#include "geometry/trajectory.hpp"
 
 namespace squiggles {
 /**
@@ -51,6 +56,147 @@ std::optional<std::vector<ProfilePoint>> deserialize_path(std::istream& in);
  */
 std::optional<std::vector<ProfilePoint>>
 deserialize_pathfinder_path(std::istream& left, std::istream& right);
+
+/**
+ * Parses CSV data in the format written by serialize_path straight into the
+ * columns of a Trajectory.
+ *
+ * This reads the same paths as deserialize_path, much faster on long ones: the
+ * lines are split into chunks that are parsed on several threads with
+ * std::from_chars, each writing its own range of states, and nothing is
+ * allocated per line. The wheel count is set by the first state and the other
+ * states are fitted to it as in Trajectory::push_back().
+ *
+ * @param csv The CSV data, including its header line.
+ * @param threads The number of threads to parse on, zero uses the hardware
+ *                concurrency. Inputs too short to be worth splitting are
+ *                parsed on the calling thread.
+ *
+ * @return The path specified by the CSV data or std::nullopt if a line is
+ *         malformed.
+ */
+std::optional<Trajectory> parse_path(std::string_view csv,
+                                     unsigned int threads = 0);
+
+/**
+ * Reads the whole stream and parses it with parse_path above.
+ */
+std::optional<Trajectory> parse_path(std::istream& in,
+                                     unsigned int threads = 0);
+
+/**
+ * Parses CSV data from the Pathfinder library's format straight into the
+ * columns of a Trajectory, as deserialize_pathfinder_path does.
+ *
+ * Both wheels' data are split into chunks and parsed at once, in the same way
+ * as parse_path, and the states are combined in place.
+ *
+ * @param left The left wheels' CSV data, including its header line.
+ * @param right The right wheels' CSV data, with at least as many lines.
+ * @param threads The number of threads to parse on, zero uses the hardware
+ *                concurrency.
+ *
+ * @return The path specified by the CSV data or std::nullopt if either input
+ *         is empty or a line is malformed.
+ */
+std::optional<Trajectory> parse_pathfinder_path(std::string_view left,
+                                                std::string_view right,
+                                                unsigned int threads = 0);
+
+/**
+ * Reads both whole streams and parses them with parse_pathfinder_path above.
+ */
+std::optional<Trajectory> parse_pathfinder_path(std::istream& left,
+                                                std::istream& right,
+                                                unsigned int threads = 0);
+
+/**
+ * The binary trajectory format is a fixed 64 byte header followed by the
+ * columns of a TrajectoryView in the order x, y, yaw, vel, accel, jerk,
+ * curvature, time and then the row-major wheel velocities. Every value is a
+ * little-endian IEEE 754 double, so on little-endian machines the file can be
+ * mapped and read in place.
+ */
+struct BinaryTrajectoryHeader {
+  char magic[4];          // "SQGT"
+  std::uint32_t version;  // BINARY_TRAJECTORY_VERSION
+  std::uint64_t size;     // number of states
+  std::uint32_t wheel_count;
+  std::uint32_t header_size; // byte offset of the first column
+  std::uint8_t reserved[40];
+};
+static_assert(sizeof(BinaryTrajectoryHeader) == 64,
+              "the binary trajectory header must stay 64 bytes");
+
+constexpr std::uint32_t BINARY_TRAJECTORY_VERSION = 1;
+
+/**
+ * Writes a path in the binary trajectory format.
+ *
+ * @return 0 on success, -1 if the stream is bad or the path is empty.
+ */
+int serialize_binary_path(std::ostream& out, const TrajectoryView& path);
+
+/**
+ * Reads a path in the binary trajectory format into owned storage.
+ */
+std::optional<Trajectory> deserialize_binary_path(std::istream& in);
+
+/**
+ * Checks a buffer holding the binary trajectory format and returns a view into
+ * it without copying. This fails on big-endian machines, or if the buffer is
+ * truncated or not 8 byte aligned.
+ */
+std::optional<TrajectoryView> view_binary_path(const void* data,
+                                               std::size_t size);
+
+/**
+ * A read-only binary trajectory file mapped into memory.
+ *
+ * On platforms without mmap the file is read into a buffer instead.
+ */
+class MappedTrajectory {
+  public:
+  /**
+   * Maps the file at the given path.
+   *
+   * @return The mapped file, or std::nullopt if it could not be opened or is
+   *         not a valid binary trajectory.
+   */
+  static std::optional<MappedTrajectory> open(const std::string& filename);
+
+  MappedTrajectory(MappedTrajectory&& other) noexcept;
+  MappedTrajectory& operator=(MappedTrajectory&& other) noexcept;
+  MappedTrajectory(const MappedTrajectory&) = delete;
+  MappedTrajectory& operator=(const MappedTrajectory&) = delete;
+  ~MappedTrajectory();
+
+  /**
+   * A view of the states in the file, valid while this object is alive.
+   */
+  const TrajectoryView& view() const { return trajectory; }
+
+  private:
+  MappedTrajectory() = default;
+  void release();
+
+  void* data = nullptr;
+  std::size_t length = 0;
+  std::vector<double> buffer;
+  TrajectoryView trajectory;
+};
+
+/**
+ * Converts between the binary trajectory format and the CSV and Pathfinder
+ * formats above. CSV input is read with parse_path and parse_pathfinder_path.
+ *
+ * @return 0 on success, -1 if the input could not be read or written.
+ */
+int csv_to_binary_path(std::istream& csv, std::ostream& out);
+int binary_to_csv_path(std::istream& in, std::ostream& csv);
+int pathfinder_to_binary_path(std::istream& left,
+                              std::istream& right,
+                              std::ostream& out);
 } // namespace squiggles
 
 #endif
@@ -7,6 +7,7 @@
 #ifndef _MATH_QUINTIC_POLYNOMIAL_HPP_
 #define _MATH_QUINTIC_POLYNOMIAL_HPP_
 
+#include <cstddef>
 #include <string>
 
 namespace squiggles {
@@ -37,10 +38,52 @@ class QuinticPolynomial {
    * Calculates the values of the polynomial and its derivatives at the given
    * time stamp.
    */
-  double calc_point(double t);
-  double calc_first_derivative(double t);
-  double calc_second_derivative(double t);
-  double calc_third_derivative(double t);
+  double calc_point(double t) const;
+  double calc_first_derivative(double t) const;
+  double calc_second_derivative(double t) const;
+  double calc_third_derivative(double t) const;
+
+  /**
+   * Destination arrays for the value and first three derivatives of the
+   * polynomial at a run of time stamps. Each must hold at least as many values
+   * as there are stamps and none may overlap.
+   */
+  struct Samples {
+    double* p;
+    double* v;
+    double* a;
+    double* j;
+  };
+
+  /**
+   * Calculates the value and first three derivatives at every time stamp in
+   * one Horner pass per stamp. The stamps and the output arrays must not
+   * overlap, which lets the compiler evaluate several stamps at once.
+   *
+   * @param t The time stamps.
+   * @param count The number of time stamps.
+   * @param out Filled with the values at each stamp.
+   */
+  void calc_all(const double* t, std::size_t count, const Samples& out) const;
+
+  /**
+   * Calculates the value and first three derivatives of an x and a y
+   * polynomial together in a single pass over the time stamps. None of the
+   * arrays may overlap.
+   *
+   * @param x The x polynomial.
+   * @param y The y polynomial.
+   * @param t The time stamps.
+   * @param count The number of time stamps.
+   * @param x_out Filled with the values of x at each stamp.
+   * @param y_out Filled with the values of y at each stamp.
+   */
+  static void calc_all(const QuinticPolynomial& x,
+                       const QuinticPolynomial& y,
+                       const double* t,
+                       std::size_t count,
+                       const Samples& x_out,
+                       const Samples& y_out);
 
   /**
    * Serializes the Quintic Polynomial data for debugging.
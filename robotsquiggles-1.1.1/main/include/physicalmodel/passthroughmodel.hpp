@@ -10,7 +10,7 @@
 #include "physicalmodel/physicalmodel.hpp"
 
 namespace squiggles {
-class PassthroughModel : public PhysicalModel {
+class PassthroughModel final : public PhysicalModel {
   public:
   /**
    * Defines a Physical Model that imposes no constraints of its own.
@@ -23,10 +23,10 @@ class PassthroughModel : public PhysicalModel {
     return Constraints(vel);
   };
 
-  std::vector<double>
+  WheelVelocities
   linear_to_wheel_vels([[maybe_unused]] double lin_vel,
                        [[maybe_unused]] double curvature) override {
-    return std::vector<double>{};
+    return WheelVelocities();
   }
 
   std::string to_string() const override {
@@ -7,8 +7,11 @@
 #ifndef _PHYSICAL_MODEL_PHYSICAL_MODEL_HPP_
 #define _PHYSICAL_MODEL_PHYSICAL_MODEL_HPP_
 
+#include <string>
+
 #include "constraints.hpp"
 #include "geometry/pose.hpp"
+#include "geometry/wheelvelocities.hpp"
 
 namespace squiggles {
 class PhysicalModel {
@@ -32,9 +35,12 @@ class PhysicalModel {
    *
    * @param linear The linear velocity for the robot in meters per second.
    * @param curvature The change in heading for the robot in 1 / meters.
+   *
+   * @return The velocity of each wheel, stored inline so that generating a
+   *         path does not allocate for every state.
    */
-  virtual std::vector<double> linear_to_wheel_vels(double linear,
-                                                   double curvature) = 0;
+  virtual WheelVelocities linear_to_wheel_vels(double linear,
+                                               double curvature) = 0;
 
   virtual std::string to_string() const = 0;
 };
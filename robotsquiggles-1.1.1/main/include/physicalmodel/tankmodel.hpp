@@ -7,13 +7,14 @@
 #ifndef _PHYSICAL_MODEL_TANK_MODEL_HPP_
 #define _PHYSICAL_MODEL_TANK_MODEL_HPP_
 
+#include <cmath>
 #include <tuple>
-#include <vector>
 
+#include "math/utils.hpp"
 #include "physicalmodel/physicalmodel.hpp"
 
 namespace squiggles {
-class TankModel : public PhysicalModel {
+class TankModel final : public PhysicalModel {
   public:
   /**
    * Defines a model of a tank drive or differential drive robot.
@@ -27,19 +28,123 @@ class TankModel : public PhysicalModel {
   Constraints
   constraints(const Pose pose, double curvature, double vel) override;
 
-  std::vector<double> linear_to_wheel_vels(double lin_vel,
-                                           double curvature) override;
+  WheelVelocities linear_to_wheel_vels(double lin_vel,
+                                       double curvature) override;
 
   std::string to_string() const override;
 
   private:
   double vel_constraint(const Pose pose, double curvature, double vel);
+  std::tuple<double, double> wheel_vels(double lin_vel, double curvature) const;
   std::tuple<double, double>
   accel_constraint(const Pose pose, double curvature, double vel) const;
 
   double track_width;
   Constraints linear_constraints;
 };
+
+// The per-state methods are defined in the header so that
+// BasicSplineGenerator<TankModel> can inline them into its profiling passes.
+inline Constraints TankModel::constraints([[maybe_unused]] const Pose pose,
+                                          double curvature,
+                                          double vel) {
+  auto max_vel = vel_constraint(pose, curvature, vel);
+  auto [min_accel, max_accel] = accel_constraint(pose, curvature, vel);
+  return Constraints(max_vel, max_accel, 0.0, min_accel);
+}
+
+inline double TankModel::vel_constraint([[maybe_unused]] const Pose pose,
+                                        double curvature,
+                                        double vel) {
+  auto [left, right] = wheel_vels(vel, curvature);
+  auto max_wheel_vel = std::max(std::abs(left), std::abs(right));
+
+  if (max_wheel_vel > linear_constraints.max_vel) {
+    // normalize the wheel velocities
+    left = left / max_wheel_vel * linear_constraints.max_vel;
+    right = right / max_wheel_vel * linear_constraints.max_vel;
+  }
+
+  return ((left + right) / 2.0);
+}
+
+inline std::tuple<double, double>
+TankModel::accel_constraint([[maybe_unused]] const Pose pose,
+                            double curvature,
+                            double vel) const {
+  // auto [left, right] = linear_to_wheel_vels(vel, curvature);
+  // auto max_wheel_speed = std::max(left, right);
+  // auto min_wheel_speed = std::min(left, right);
+
+  // TODO: calculate the possible accelerations as a factor of current velocity
+  // to account for back-emf?
+
+  // Robot chassis turning on radius = 1/|curvature|.  Outer wheel has radius
+  // increased by half of the trackwidth T.  Inner wheel has radius decreased
+  // by half of the trackwidth.  Achassis / radius = Aouter / (radius + T/2), so
+  // Achassis = Aouter * radius / (radius + T/2) = Aouter / (1 +
+  // |curvature|T/2). Inner wheel is similar.
+
+  // sgn(speed) term added to correctly account for which wheel is on
+  // outside of turn:
+  // If moving forward, max acceleration constraint corresponds to wheel on
+  // outside of turn If moving backward, max acceleration constraint corresponds
+  // to wheel on inside of turn
+
+  // When velocity is zero, then wheel velocities are uniformly zero (robot
+  // cannot be turning on its center) - we have to treat this as a special case,
+  // as it breaks the signum function.  Both max and min acceleration are
+  // *reduced in magnitude* in this case.
+
+  double max_chassis_accel, min_chassis_accel;
+
+  if (!vel) {
+    max_chassis_accel = linear_constraints.max_accel /
+                        (1 + track_width * std::abs(curvature) / 2);
+    min_chassis_accel = linear_constraints.min_accel /
+                        (1 + track_width * std::abs(curvature) / 2);
+  } else {
+    max_chassis_accel = linear_constraints.max_accel /
+                        (1 + track_width * std::abs(curvature) * sgn(vel) / 2);
+    min_chassis_accel = linear_constraints.min_accel /
+                        (1 - track_width * std::abs(curvature) * sgn(vel) / 2);
+  }
+
+  // When turning about a point inside of the wheelbase (i.e. radius less than
+  // half the trackwidth), the inner wheel's direction changes, but the
+  // magnitude remains the same.  The formula above changes sign for the inner
+  // wheel when this happens. We can accurately account for this by simply
+  // negating the inner wheel.
+
+  if ((track_width / 2) > 1 / std::abs(curvature)) {
+    if (vel > 0) {
+      min_chassis_accel = -min_chassis_accel;
+    } else if (vel < 0) {
+      max_chassis_accel = -max_chassis_accel;
+    }
+  }
+
+  return std::make_tuple(min_chassis_accel, max_chassis_accel);
+}
+
+inline std::tuple<double, double>
+TankModel::wheel_vels(double lin_vel, double curvature) const {
+  if (std::abs(lin_vel) < 1e-5) {
+    return std::make_tuple(0.0, 0.0);
+  } else if (std::abs(curvature) < 1e-5) {
+    return std::make_tuple(lin_vel, lin_vel);
+  }
+
+  double omega = lin_vel * curvature;
+  return std::make_tuple(lin_vel - (track_width / 2) * omega,
+                         lin_vel + (track_width / 2) * omega);
+}
+
+inline WheelVelocities TankModel::linear_to_wheel_vels(double lin_vel,
+                                                       double curvature) {
+  auto [left, right] = wheel_vels(lin_vel, curvature);
+  return WheelVelocities{left, right};
+}
 } // namespace squiggles
 
 #endif
\ No newline at end of file
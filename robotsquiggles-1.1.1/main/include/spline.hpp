@@ -14,12 +14,22 @@
 #include "constraints.hpp"
 #include "geometry/controlvector.hpp"
 #include "geometry/profilepoint.hpp"
+#include "geometry/trajectory.hpp"
 #include "math/quinticpolynomial.hpp"
 #include "physicalmodel/passthroughmodel.hpp"
 #include "physicalmodel/physicalmodel.hpp"
+#include "physicalmodel/tankmodel.hpp"
 
 namespace squiggles {
-class SplineGenerator {
+/**
+ * Generates motion profiled paths for a robot described by Model.
+ *
+ * Model is either PhysicalModel, which accepts any model through virtual
+ * calls, or a final model type such as TankModel whose constraints can then be
+ * inlined into the profiling passes. The generator is instantiated for
+ * PhysicalModel, TankModel and PassthroughModel.
+ */
+template <class Model> class BasicSplineGenerator {
   public:
   /**
    * Generates curves that match the given motion constraints.
@@ -28,11 +38,15 @@ class SplineGenerator {
    * @param imodel The robot's physical characteristics and constraints
    * @param idt The difference in time in seconds between each state for the
    *            generated paths.
+   * @param ithreads The number of threads used to try candidate path durations
+   *                 concurrently. Zero uses the hardware concurrency. Short
+   *                 candidate paths are always tried on the calling thread.
    */
-  SplineGenerator(Constraints iconstraints,
-                  std::shared_ptr<PhysicalModel> imodel =
-                    std::make_shared<PassthroughModel>(),
-                  double idt = 0.1);
+  BasicSplineGenerator(Constraints iconstraints,
+                       std::shared_ptr<Model> imodel =
+                         std::make_shared<PassthroughModel>(),
+                       double idt = 0.1,
+                       unsigned int ithreads = 0);
 
   /**
    * Creates a motion profiled path between the given waypoints.
@@ -62,6 +76,113 @@ class SplineGenerator {
   std::vector<ProfilePoint>
   generate(std::initializer_list<ControlVector> iwaypoints);
 
+  /**
+   * Creates a motion profiled path between the given waypoints and writes it
+   * into an existing vector.
+   *
+   * The generator keeps its intermediate buffers between calls and the
+   * capacity of the output vector is reused, so a long-lived generator stops
+   * allocating for these once it has seen its longest path. A generator that
+   * is used this way must not be shared between threads.
+   *
+   * @param iwaypoints The list of poses that the robot should reach along the
+   *                   path.
+   * @param out Receives the series of robot states, replacing its contents.
+   * @param fast If true, the path optimization process will stop as soon as the
+   *             constraints are met. If false, the optimizer will find the
+   *             smoothest possible path between the points.
+   */
+  void generate(const std::vector<Pose>& iwaypoints,
+                std::vector<ProfilePoint>& out,
+                bool fast = false);
+  void generate(const std::vector<ControlVector>& iwaypoints,
+                std::vector<ProfilePoint>& out);
+
+  /**
+   * Creates a motion profiled path between the given waypoints and writes it
+   * into a Trajectory, reusing its capacity as above.
+   */
+  void generate(const std::vector<Pose>& iwaypoints,
+                Trajectory& out,
+                bool fast = false);
+  void generate(const std::vector<ControlVector>& iwaypoints, Trajectory& out);
+
+  /**
+   * Creates the motion profiled path between two consecutive waypoints and
+   * appends it to a path. The last state of the segment is left off since it
+   * is also the first state of the next segment, so appending every segment of
+   * a path in turn gives the same states as generate().
+   *
+   * @param start The waypoint the segment starts at.
+   * @param end The waypoint the segment ends at.
+   * @param fast As for generate().
+   * @param start_time The timestamp of the first state of the segment.
+   * @param out Receives the states of the segment after its existing states.
+   *
+   * @return The timestamp at the end of the segment, which is the start time of
+   *         the next segment.
+   */
+  double generate_segment(const ControlVector& start,
+                          const ControlVector& end,
+                          bool fast,
+                          double start_time,
+                          std::vector<ProfilePoint>& out);
+  double generate_segment(const ControlVector& start,
+                          const ControlVector& end,
+                          bool fast,
+                          double start_time,
+                          Trajectory& out);
+
+  struct GeometricPath;
+
+  /**
+   * Creates a motion profiled path between the given waypoints as above and
+   * keeps the curve of every segment, so reprofile() can change its speed
+   * limits without generating the curve again.
+   *
+   * @param iwaypoints The list of poses that the robot should reach along the
+   *                   path.
+   * @param geometry Receives the curve of each segment, replacing its contents.
+   * @param out Receives the series of robot states, replacing its contents.
+   * @param fast As for generate().
+   */
+  void generate(const std::vector<Pose>& iwaypoints,
+                GeometricPath& geometry,
+                std::vector<ProfilePoint>& out,
+                bool fast = false);
+  void generate(const std::vector<Pose>& iwaypoints,
+                GeometricPath& geometry,
+                Trajectory& out,
+                bool fast = false);
+
+  /**
+   * Redoes the motion profile of the segments of a path that overlap a span,
+   * under speed zones, and shifts the timestamps of the states after them.
+   *
+   * Only the forward and backward passes and the time integration run again,
+   * over the states of the overlapping segments. A segment starts and ends at
+   * its waypoints' velocities, so the segments outside the span keep their
+   * profile. Every zone overlapping a reprofiled segment applies to it, so the
+   * span only has to hold the zones that changed. Reprofiling to the same
+   * zones the path was last profiled with changes nothing.
+   *
+   * @param geometry The curve kept by generate(), updated with the new profile.
+   * @param zones The speed zones along the whole path, in distance along it.
+   * @param from The distance along the path where the span starts in meters.
+   * @param to The distance along the path where the span ends in meters.
+   * @param out The states generate() gave for geometry, updated in place.
+   */
+  void reprofile(GeometricPath& geometry,
+                 const std::vector<SpeedZone>& zones,
+                 double from,
+                 double to,
+                 std::vector<ProfilePoint>& out);
+  void reprofile(GeometricPath& geometry,
+                 const std::vector<SpeedZone>& zones,
+                 double from,
+                 double to,
+                 Trajectory& out);
+
   protected:
   /**
    * The maximum allowable values for the robot's motion.
@@ -72,13 +193,18 @@ class SplineGenerator {
    * Defines the physical structure of the robot and translates the linear
    * kinematics to wheel velocities.
    */
-  std::shared_ptr<PhysicalModel> model;
+  std::shared_ptr<Model> model;
 
   /**
    * The time difference between each value in the generated path.
    */
   double dt;
 
+  /**
+   * The number of threads used to try candidate path durations.
+   */
+  unsigned int threads;
+
   /**
    * The minimum and maximum durations for a path to take. A larger range allows
    * for longer possible paths at the expense of a longer path generation time.
@@ -87,6 +213,12 @@ class SplineGenerator {
   const int T_MAX = 15;
   const int MAX_GRAD_DESCENT_ITERATIONS = 10;
 
+  /**
+   * Candidate paths with fewer states than this are tried on the calling
+   * thread, where starting the worker threads would cost more than it saves.
+   */
+  static constexpr double K_PARALLEL_MIN_STATES = 400;
+
   /**
    * This is factor is used to create a "dummy velocity" in the initial path
    * generation step one or both of the preferred start or end velocities is
@@ -148,6 +280,12 @@ class SplineGenerator {
                                                    int duration,
                                                    double start_vel,
                                                    double end_vel);
+  void gen_single_raw_path(ControlVector start,
+                           ControlVector end,
+                           int duration,
+                           double start_vel,
+                           double end_vel,
+                           std::vector<GeneratedVector>& vectors);
   /**
    * Runs a Gradient Descent algorithm to minimize the linear acceleration,
    * linear jerk, and curvature for the generated path.
@@ -157,6 +295,10 @@ class SplineGenerator {
    */
   std::vector<GeneratedPoint>
   gradient_descent(ControlVector& start, ControlVector& end, bool fast);
+  void gradient_descent(ControlVector& start,
+                        ControlVector& end,
+                        bool fast,
+                        std::vector<GeneratedPoint>& out);
 
   /**
    * An intermediate value used in the parameterization step. Adds the
@@ -198,6 +340,53 @@ class SplineGenerator {
     }
   };
 
+  /**
+   * The curve of a generated path without its motion profile, one entry per
+   * segment between two waypoints.
+   */
+  struct GeometricPath {
+    struct Segment {
+      /**
+       * The waypoints with the velocities the curve was generated with.
+       */
+      ControlVector start;
+      ControlVector end;
+      /**
+       * The velocities the profile starts and ends the segment at.
+       */
+      double start_vel = 0;
+      double end_vel = 0;
+      /**
+       * The distance along the path to the start of the segment.
+       */
+      double start_distance = 0;
+      /**
+       * The states of the curve, with the distance from the segment start and
+       * the limits of the last profile.
+       */
+      std::vector<ConstrainedState> states;
+      /**
+       * Where the segment's states are in the profiled path and when they
+       * start. The state the segment shares with the next one is not counted.
+       */
+      std::size_t first = 0;
+      std::size_t count = 0;
+      double start_time = 0;
+      double duration = 0;
+    };
+
+    std::vector<Segment> segments;
+
+    /**
+     * The distance along the whole path.
+     */
+    double length() const {
+      return segments.empty() ? 0.0
+                              : segments.back().start_distance +
+                                  segments.back().states.back().distance;
+    }
+  };
+
   /**
    * The actual function called by the "generate" functions.
    *
@@ -206,8 +395,30 @@ class SplineGenerator {
    *
    * @return The points from each path concatenated together
    */
-  template <class Iter>
-  std::vector<ProfilePoint> _generate(Iter start, Iter end, bool fast);
+  template <class Iter, class Path>
+  void _generate(Iter start, Iter end, bool fast, Path& path);
+
+  template <class Path>
+  double _generate_segment(const ControlVector& start,
+                           const ControlVector& end,
+                           bool fast,
+                           double start_time,
+                           Path& path,
+                           typename GeometricPath::Segment* keep = nullptr);
+
+  template <class Iter, class Path>
+  void _generate(Iter start,
+                 Iter end,
+                 bool fast,
+                 GeometricPath& geometry,
+                 Path& path);
+
+  template <class Path>
+  void _reprofile(GeometricPath& geometry,
+                  const std::vector<SpeedZone>& zones,
+                  double from,
+                  double to,
+                  Path& path);
 
   public:
   /**
@@ -219,6 +430,10 @@ class SplineGenerator {
    */
   std::vector<GeneratedPoint>
   gen_raw_path(ControlVector& start, ControlVector& end, bool fast);
+  void gen_raw_path(ControlVector& start,
+                    ControlVector& end,
+                    bool fast,
+                    std::vector<GeneratedPoint>& out);
 
   /**
    * Imposes a linear motion profile on the raw path.
@@ -233,13 +448,47 @@ class SplineGenerator {
                const double preferred_start_vel,
                const double preferred_end_vel,
                const double start_time);
+  void parameterize(const ControlVector start,
+                    const ControlVector end,
+                    const std::vector<GeneratedPoint>& raw_path,
+                    const double preferred_start_vel,
+                    const double preferred_end_vel,
+                    const double start_time,
+                    std::vector<ProfilePoint>& out);
+
+  /**
+   * Runs the forward and backward passes over states that hold the pose and
+   * curvature of a curve.
+   *
+   * @param zones Speed zones capping the velocity, or null for none.
+   * @param start_distance The distance along the path to the first state,
+   *                       which the zones are measured in.
+   */
+  void profile_states(std::vector<ConstrainedState>& states,
+                      double preferred_start_vel,
+                      double preferred_end_vel,
+                      const std::vector<SpeedZone>* zones,
+                      double start_distance);
+
+  /**
+   * Integrates profiled states in time and samples the segment's splines
+   * every dt into out.
+   */
+  void sample_profile(const ControlVector& start,
+                      const ControlVector& end,
+                      const std::vector<ConstrainedState>& states,
+                      double start_time,
+                      std::vector<ProfilePoint>& out);
 
   /**
    * Finds the new timestamps for each point along the curve based on the motion
    * profile.
    */
-  std::vector<ProfilePoint>
-  integrate_constrained_states(std::vector<ConstrainedState> constrainedStates);
+  std::vector<ProfilePoint> integrate_constrained_states(
+    const std::vector<ConstrainedState>& constrainedStates);
+  void integrate_constrained_states(
+    const std::vector<ConstrainedState>& constrainedStates,
+    std::vector<ProfilePoint>& out);
 
   /**
    * Finds the ProfilePoint on the profiled curve for the given timestamp.
@@ -249,16 +498,30 @@ class SplineGenerator {
    */
   ProfilePoint get_point_at_time(const ControlVector start,
                                  const ControlVector end,
-                                 std::vector<ProfilePoint> points,
+                                 const std::vector<ProfilePoint>& points,
                                  double t);
 
+  /**
+   * Finds the ProfilePoint on the profiled curve for the given timestamp using
+   * splines that have already been built for the curve.
+   *
+   * @param cursor The index to start searching forward from. It is advanced to
+   *               the first point with a timestamp no less than t, so calls
+   *               with nondecreasing timestamps sweep the points only once.
+   */
+  ProfilePoint get_point_at_time(const QuinticPolynomial& x_qp,
+                                 const QuinticPolynomial& y_qp,
+                                 const std::vector<ProfilePoint>& points,
+                                 double t,
+                                 std::size_t& cursor);
+
   /**
    * Linearly interpolates between points along the profiled curve.
    */
-  ProfilePoint lerp_point(QuinticPolynomial x_qp,
-                          QuinticPolynomial y_qp,
-                          ProfilePoint start,
-                          ProfilePoint end,
+  ProfilePoint lerp_point(const QuinticPolynomial& x_qp,
+                          const QuinticPolynomial& y_qp,
+                          const ProfilePoint& start,
+                          const ProfilePoint& end,
                           double i);
 
   /**
@@ -282,6 +545,14 @@ class SplineGenerator {
    */
   void forward_pass(ConstrainedState* predecessor, ConstrainedState* successor);
 
+  /**
+   * As above with the successor's velocity capped at max_vel rather than the
+   * constraints' maximum velocity.
+   */
+  void forward_pass(ConstrainedState* predecessor,
+                    ConstrainedState* successor,
+                    double max_vel);
+
   /**
    * Imposes the motion profile constraints on a segment of the path from the
    * perspective of iterating backwards through the path.
@@ -304,7 +575,35 @@ class SplineGenerator {
    * Values that are closer to each other than this value are considered equal.
    */
   static constexpr double K_EPSILON = 1e-5;
+
+  protected:
+  /**
+   * Working storage for generate(), kept between calls so that replanning with
+   * the same generator reuses the capacity from earlier paths.
+   */
+  std::vector<ControlVector> waypoint_buffer;
+  std::vector<GeneratedVector> raw_vectors;
+  std::vector<GeneratedPoint> raw_points;
+  std::vector<ConstrainedState> constrained_states;
+  std::vector<ProfilePoint> time_adjusted;
+  std::vector<ProfilePoint> segment_path;
+
+  /**
+   * One raw path buffer and the passing duration for each worker thread when
+   * candidate durations are tried concurrently.
+   */
+  std::vector<std::vector<GeneratedVector>> candidate_vectors;
+  std::vector<int> candidate_durations;
 };
+
+extern template class BasicSplineGenerator<PhysicalModel>;
+extern template class BasicSplineGenerator<TankModel>;
+extern template class BasicSplineGenerator<PassthroughModel>;
+
+/**
+ * The generator that accepts any PhysicalModel at runtime.
+ */
+using SplineGenerator = BasicSplineGenerator<PhysicalModel>;
 } // namespace squiggles
 
 #endif
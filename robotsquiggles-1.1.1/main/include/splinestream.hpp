@@ -0,0 +1,138 @@
+/**
+ * Copyright 2020 Jonathan Bayless
+ *
+ * Use of this source code is governed by an MIT-style license that can be found
+ * in the LICENSE file or at https://opensource.org/licenses/MIT.
+ */
+#ifndef _SQUIGGLES_SPLINESTREAM_HPP_
+#define _SQUIGGLES_SPLINESTREAM_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "spline.hpp"
+
+namespace squiggles {
+/**
+ * Generates a motion profiled path through many waypoints one segment at a
+ * time.
+ *
+ * The first segment is generated before start() returns and the rest are
+ * generated in order on a background thread, so the time until the first
+ * segment can be followed does not grow with the number of waypoints. The
+ * segments returned by next() joined together hold the same states as
+ * BasicSplineGenerator::generate() gives for the same waypoints.
+ *
+ * A stream is driven from one thread, only the generation runs in the
+ * background.
+ */
+template <class Model> class BasicSplineStream {
+  public:
+  /**
+   * Streams curves that match the given motion constraints.
+   *
+   * The parameters are those of BasicSplineGenerator.
+   */
+  BasicSplineStream(Constraints iconstraints,
+                    std::shared_ptr<Model> imodel =
+                      std::make_shared<PassthroughModel>(),
+                    double idt = 0.1,
+                    unsigned int ithreads = 0);
+
+  /**
+   * Cancels the segments that are still being generated.
+   */
+  ~BasicSplineStream();
+
+  BasicSplineStream(const BasicSplineStream&) = delete;
+  BasicSplineStream& operator=(const BasicSplineStream&) = delete;
+
+  /**
+   * Starts streaming the path between the given waypoints, cancelling the
+   * previous stream.
+   *
+   * @param iwaypoints The poses that the robot should reach along the path.
+   * @param fast As for BasicSplineGenerator::generate().
+   */
+  void start(const std::vector<Pose>& iwaypoints, bool fast = false);
+  void start(const std::vector<ControlVector>& iwaypoints, bool fast = false);
+
+  /**
+   * Gets the next segment of the path, waiting for it to be generated.
+   *
+   * The storage of out is handed back to the stream and reused for a later
+   * segment. An exception thrown while generating a segment is rethrown here
+   * once the segments before it have been returned.
+   *
+   * @param out Receives the states of the segment, replacing its contents.
+   *
+   * @return false if every segment has already been returned.
+   */
+  bool next(Trajectory& out);
+
+  /**
+   * Stops generating the segments that have not been returned yet.
+   */
+  void cancel();
+
+  /**
+   * The number of segments in the current path, one fewer than its waypoints.
+   */
+  std::size_t segment_count() const;
+
+  /**
+   * The number of segments that next() has not returned yet.
+   */
+  std::size_t remaining() const;
+
+  protected:
+  /**
+   * Generates the segments after the first, run on the background thread.
+   */
+  void run();
+
+  /**
+   * Generates the next segment that has not been generated into out.
+   *
+   * @return false if the stream was cancelled or a segment failed.
+   */
+  bool generate_next(Trajectory& out);
+
+  BasicSplineGenerator<Model> generator;
+
+  std::vector<ControlVector> waypoints;
+  bool fast = false;
+  double end_time = 0.0;
+
+  /**
+   * Guards the members below, which are shared with the background thread.
+   */
+  mutable std::mutex mutex;
+  std::condition_variable ready_cv;
+  std::deque<Trajectory> ready;
+  std::vector<Trajectory> spare;
+  std::size_t generated = 0;
+  std::size_t returned = 0;
+  bool cancelled = false;
+  std::exception_ptr error;
+
+  std::thread worker;
+};
+
+extern template class BasicSplineStream<PhysicalModel>;
+extern template class BasicSplineStream<TankModel>;
+extern template class BasicSplineStream<PassthroughModel>;
+
+/**
+ * The stream that accepts any PhysicalModel at runtime.
+ */
+using SplineStream = BasicSplineStream<PhysicalModel>;
+} // namespace squiggles
+
+#endif
@@ -10,13 +10,17 @@
 #include "geometry/controlvector.hpp"
 #include "geometry/pose.hpp"
 #include "geometry/profilepoint.hpp"
+#include "geometry/trajectory.hpp"
+#include "geometry/wheelvelocities.hpp"
 
 #include "physicalmodel/passthroughmodel.hpp"
 #include "physicalmodel/physicalmodel.hpp"
 #include "physicalmodel/tankmodel.hpp"
 
+#include "batch.hpp"
 #include "constraints.hpp"
 #include "io.hpp"
 #include "spline.hpp"
+#include "splinestream.hpp"
 
 #endif
\ No newline at end of file
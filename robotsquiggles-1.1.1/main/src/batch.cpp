@@ -0,0 +1,132 @@
+/**
+ * Copyright 2020 Jonathan Bayless
+ *
+ * Use of this source code is governed by an MIT-style license that can be found
+ * in the LICENSE file or at https://opensource.org/licenses/MIT.
+ */
+#include "batch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "spline.hpp"
+
+using namespace squiggles;
+
+namespace {
+using BatchGenerator = BasicSplineGenerator<TankModel>;
+
+/**
+ * Checks if two requests have the same constraints and track width.
+ */
+bool same_robot(const double* a, const double* b) {
+  return std::equal(a + 8, a + BATCH_REQUEST_FIELDS, b + 8);
+}
+
+/**
+ * Generates the requests taken from next until none are left. Each caller
+ * keeps its own generator, so the requests can be split across threads.
+ */
+void generate_requests(const double* requests,
+                       std::size_t count,
+                       double dt,
+                       std::atomic<std::size_t>& next,
+                       std::vector<Trajectory>& paths) {
+  std::unique_ptr<BatchGenerator> generator;
+  const double* robot = nullptr;
+  std::vector<ControlVector> waypoints(2);
+  for (std::size_t i = next++; i < count; i = next++) {
+    const double* request = requests + i * BATCH_REQUEST_FIELDS;
+    if (!generator || !same_robot(request, robot)) {
+      auto constraints = Constraints(request[8], request[9], request[10]);
+      // one thread per generator, the batch is already split across threads
+      generator = std::make_unique<BatchGenerator>(
+        constraints,
+        std::make_shared<TankModel>(request[11], constraints),
+        dt,
+        1);
+      robot = request;
+    }
+    waypoints[0] =
+      ControlVector(Pose(request[0], request[1], request[2]), request[3]);
+    waypoints[1] =
+      ControlVector(Pose(request[4], request[5], request[6]), request[7]);
+    try {
+      generator->generate(waypoints, paths[i]);
+    } catch (const std::exception&) {
+      paths[i].clear();
+    }
+  }
+}
+} // namespace
+
+extern "C" int squiggles_generate_batch(const double* requests,
+                                        std::size_t count,
+                                        double dt,
+                                        unsigned int threads,
+                                        double* states,
+                                        std::size_t capacity,
+                                        std::uint32_t* offsets) {
+  std::vector<Trajectory> paths(count);
+  std::atomic<std::size_t> next{0};
+#ifndef __EMSCRIPTEN__
+  std::size_t workers =
+    threads == 0 ? std::thread::hardware_concurrency() : threads;
+  workers = std::max<std::size_t>(1, std::min(workers, count));
+  std::vector<std::thread> pool;
+  for (std::size_t w = 1; w < workers; ++w) {
+    pool.emplace_back(generate_requests,
+                      requests,
+                      count,
+                      dt,
+                      std::ref(next),
+                      std::ref(paths));
+  }
+#else
+  (void)threads;
+#endif
+  generate_requests(requests, count, dt, next, paths);
+#ifndef __EMSCRIPTEN__
+  for (auto& worker : pool) {
+    worker.join();
+  }
+#endif
+
+  int failed = 0;
+  std::size_t total = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    offsets[i] = static_cast<std::uint32_t>(total);
+    if (paths[i].empty()) {
+      ++failed;
+    }
+    total += paths[i].size();
+  }
+  offsets[count] = static_cast<std::uint32_t>(total);
+  if (total > capacity || total > std::numeric_limits<std::uint32_t>::max()) {
+    return -1;
+  }
+
+  for (std::size_t i = 0; i < count; ++i) {
+    const TrajectoryView path = paths[i].view();
+    double* row = states + std::size_t(offsets[i]) * BATCH_STATE_FIELDS;
+    for (std::size_t s = 0; s < path.size; ++s, row += BATCH_STATE_FIELDS) {
+      row[0] = path.x[s];
+      row[1] = path.y[s];
+      row[2] = path.yaw[s];
+      row[3] = path.vel[s];
+      row[4] = path.accel[s];
+      row[5] = path.jerk[s];
+      row[6] = path.curvature[s];
+      row[7] = path.time[s];
+      row[8] = path.wheel_count > 0 ? path.wheel_velocity(s, 0) : 0.0;
+      row[9] = path.wheel_count > 1 ? path.wheel_velocity(s, 1) : 0.0;
+    }
+  }
+  return failed;
+}
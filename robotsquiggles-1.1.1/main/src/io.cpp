@@ -4,9 +4,25 @@
  * Use of this source code is governed by an MIT-style license that can be found
  * in the LICENSE file or at https://opensource.org/licenses/MIT.
  */
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <string.h>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SQUIGGLES_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "io.hpp"
 
@@ -59,11 +75,12 @@ std::optional<std::vector<ProfilePoint>> deserialize_path(std::istream& in) {
     double jerk = contents[5];
     double curv = contents[6];
     double time = contents[7];
-    // put the remaining items into the wheel velocities vector
-    std::vector<double> wheels;
-    if (contents.size() > 8) {
-      wheels = std::vector<double>(contents.begin() + 8, contents.end());
+    // put the remaining items into the wheel velocities
+    if (contents.size() > 8 + WheelVelocities::MAX_WHEELS) {
+      std::cout << "Error parsing Squiggles path: too many wheel velocities";
+      return std::nullopt;
     }
+    WheelVelocities wheels(contents.begin() + 8, contents.end());
 
     path.emplace_back(ProfilePoint(
       ControlVector(Pose(x, y, yaw), vel, acc, jerk), wheels, curv, time));
@@ -165,4 +182,745 @@ deserialize_pathfinder_path(std::istream& left, std::istream& right) {
 
   return path;
 }
+
+// Inputs shorter than this are parsed on one thread, splitting them costs more
+// than the threads save
+static constexpr std::size_t MIN_CHUNK_BYTES = 64 * 1024;
+
+// x, y, yaw, vel, accel, jerk, curvature, time and up to MAX_WHEELS wheels
+static constexpr std::size_t CSV_FIELDS = 8 + WheelVelocities::MAX_WHEELS;
+
+// dt, x, y, pos, vel, acc, jerk and yaw
+static constexpr std::size_t PATHFINDER_FIELDS = 8;
+
+/**
+ * A run of whole lines of one input and the index of its first line among the
+ * lines of that input.
+ */
+struct LineChunk {
+  const char* first;
+  const char* last;
+  std::size_t input;
+  std::size_t row;
+  std::size_t rows;
+};
+
+static bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+static const char* skip_blanks(const char* first, const char* last) {
+  while (first != last && is_blank(*first)) {
+    ++first;
+  }
+  return first;
+}
+
+/**
+ * Parses the number at the start of [first, last) and the blanks around it.
+ *
+ * @return One past the blanks after the number, or nullptr if there is none.
+ */
+static const char* parse_number(const char* first,
+                                const char* last,
+                                double& value) {
+  first = skip_blanks(first, last);
+  // from_chars does not take the leading plus that stod does
+  if (first != last && *first == '+') {
+    ++first;
+  }
+#if defined(__cpp_lib_to_chars)
+  const auto result = std::from_chars(first, last, value);
+  if (result.ec != std::errc()) {
+    return nullptr;
+  }
+  return skip_blanks(result.ptr, last);
+#else
+  // without floating point from_chars the field is copied out so strtod stops
+  // at its end
+  char field[64];
+  std::size_t length = 0;
+  while (first + length != last && first[length] != ',' &&
+         length + 1 < sizeof(field)) {
+    field[length] = first[length];
+    ++length;
+  }
+  field[length] = '\0';
+  char* end;
+  value = std::strtod(field, &end);
+  if (end == field) {
+    return nullptr;
+  }
+  return skip_blanks(first + (end - field), last);
+#endif
+}
+
+/**
+ * Parses the comma separated numbers of the line [first, last) into fields.
+ *
+ * @return The number of fields on the line, capacity + 1 if there are more than
+ *         capacity, which are not parsed, or zero if a field is not a number.
+ */
+static std::size_t parse_line(const char* first,
+                              const char* last,
+                              double* fields,
+                              std::size_t capacity) {
+  std::size_t count = 0;
+  while (true) {
+    if (count == capacity) {
+      return count + 1;
+    }
+    first = parse_number(first, last, fields[count]);
+    if (first == nullptr) {
+      return 0;
+    }
+    ++count;
+    if (first == last) {
+      return count;
+    }
+    if (*first != ',') {
+      return 0;
+    }
+    ++first;
+  }
+}
+
+/**
+ * Gets the end of the line starting at first, without its newline.
+ */
+static const char* line_end(const char* first, const char* last) {
+  const void* newline =
+    memchr(first, '\n', static_cast<std::size_t>(last - first));
+  return newline == nullptr ? last : static_cast<const char*>(newline);
+}
+
+/**
+ * Gets the content of a CSV input after its header line.
+ */
+static std::string_view csv_body(std::string_view csv) {
+  const auto header_end = csv.find('\n');
+  return header_end == std::string_view::npos ? std::string_view()
+                                              : csv.substr(header_end + 1);
+}
+
+/**
+ * Splits an input into at most the given number of chunks that end on a line
+ * boundary.
+ */
+static void split_lines(std::string_view body,
+                        std::size_t input,
+                        std::size_t chunks,
+                        std::vector<LineChunk>& out) {
+  chunks = std::max<std::size_t>(
+    1, std::min(chunks, body.size() / MIN_CHUNK_BYTES));
+  const char* first = body.data();
+  const char* last = body.data() + body.size();
+  for (std::size_t c = 0; c < chunks && first != last; ++c) {
+    const char* end = c + 1 == chunks
+                        ? last
+                        : body.data() + body.size() * (c + 1) / chunks;
+    if (end < first) {
+      end = first;
+    }
+    end = end == last ? last : std::min(last, line_end(end, last) + 1);
+    out.push_back({first, end, input, 0, 0});
+    first = end;
+  }
+}
+
+/**
+ * Runs task(i) for every i in [0, count), split across threads that each take
+ * the next i until none are left.
+ */
+template <class Task>
+static void
+run_parallel(std::size_t count, std::size_t threads, const Task& task) {
+  std::atomic<std::size_t> next{0};
+  auto worker = [&]() {
+    for (std::size_t i = next++; i < count; i = next++) {
+      task(i);
+    }
+  };
+#ifndef __EMSCRIPTEN__
+  std::vector<std::thread> pool;
+  for (std::size_t t = 1; t < std::min(threads, count); ++t) {
+    pool.emplace_back(worker);
+  }
+#else
+  (void)threads;
+#endif
+  worker();
+#ifndef __EMSCRIPTEN__
+  for (auto& thread : pool) {
+    thread.join();
+  }
+#endif
+}
+
+static std::size_t worker_count(unsigned int threads) {
+  const std::size_t workers =
+    threads == 0 ? std::thread::hardware_concurrency() : threads;
+  return std::max<std::size_t>(1, workers);
+}
+
+/**
+ * Counts the lines of every chunk and numbers the chunks' first lines, in
+ * order within each input.
+ *
+ * @return The number of lines of each input.
+ */
+static std::vector<std::size_t>
+number_lines(std::vector<LineChunk>& chunks,
+             std::size_t inputs,
+             std::size_t threads) {
+  run_parallel(chunks.size(), threads, [&](std::size_t c) {
+    auto& chunk = chunks[c];
+    chunk.rows = static_cast<std::size_t>(
+      std::count(chunk.first, chunk.last, '\n'));
+    if (chunk.first != chunk.last && chunk.last[-1] != '\n') {
+      ++chunk.rows;
+    }
+  });
+  std::vector<std::size_t> rows(inputs, 0);
+  for (auto& chunk : chunks) {
+    chunk.row = rows[chunk.input];
+    rows[chunk.input] += chunk.rows;
+  }
+  return rows;
+}
+
+/**
+ * Calls row(index, first, last) for every line of a chunk.
+ *
+ * @return false as soon as row does.
+ */
+template <class Row>
+static bool for_each_line(const LineChunk& chunk, const Row& row) {
+  const char* first = chunk.first;
+  for (std::size_t i = 0; i < chunk.rows; ++i) {
+    const char* end = line_end(first, chunk.last);
+    if (!row(chunk.row + i, first, end)) {
+      return false;
+    }
+    first = end == chunk.last ? end : end + 1;
+  }
+  return true;
+}
+
+/**
+ * Reads the rest of a stream into a string, with one read if it can seek.
+ */
+static bool read_stream(std::istream& in, std::string& out) {
+  if (!in) {
+    std::cout << "File does not exist!" << std::endl;
+    return false;
+  }
+  const auto start = in.tellg();
+  if (start != std::streampos(-1) && in.seekg(0, std::ios::end)) {
+    const auto end = in.tellg();
+    in.seekg(start);
+    out.resize(static_cast<std::size_t>(end - start));
+    in.read(out.data(), static_cast<std::streamsize>(out.size()));
+    out.resize(static_cast<std::size_t>(in.gcount()));
+    return true;
+  }
+  in.clear();
+  std::ostringstream buffer;
+  buffer << in.rdbuf();
+  out = buffer.str();
+  return true;
+}
+
+std::optional<Trajectory> parse_path(std::string_view csv,
+                                     unsigned int threads) {
+  const std::string_view body = csv_body(csv);
+  Trajectory path;
+  if (body.empty()) {
+    return path;
+  }
+
+  // the first state sets the wheel count the others are fitted to
+  double fields[CSV_FIELDS];
+  const std::size_t first_count =
+    parse_line(body.data(), line_end(body.data(), body.data() + body.size()),
+               fields, CSV_FIELDS);
+  if (first_count < 8 || first_count > CSV_FIELDS) {
+    std::cout << "Error parsing Squiggles path: malformed CSV content";
+    return std::nullopt;
+  }
+  const std::size_t wheel_count = first_count - 8;
+
+  const std::size_t workers = worker_count(threads);
+  std::vector<LineChunk> chunks;
+  split_lines(body, 0, workers, chunks);
+  const std::size_t rows = number_lines(chunks, 1, workers)[0];
+
+  path.resize(rows, wheel_count);
+  double* columns[9];
+  for (std::size_t c = 0; c < 9; ++c) {
+    columns[c] = path.column_data(c);
+  }
+  std::atomic<bool> malformed{false};
+  run_parallel(chunks.size(), workers, [&](std::size_t c) {
+    double row_fields[CSV_FIELDS];
+    const bool parsed = for_each_line(
+      chunks[c], [&](std::size_t i, const char* first, const char* last) {
+        const std::size_t count =
+          parse_line(first, last, row_fields, CSV_FIELDS);
+        if (count < 8 || count > CSV_FIELDS) {
+          return false;
+        }
+        for (std::size_t f = 0; f < 8; ++f) {
+          columns[f][i] = row_fields[f];
+        }
+        double* wheels = columns[8] + i * wheel_count;
+        const std::size_t present = std::min(wheel_count, count - 8);
+        std::copy_n(row_fields + 8, present, wheels);
+        std::fill(wheels + present, wheels + wheel_count, 0.0);
+        return true;
+      });
+    if (!parsed) {
+      malformed = true;
+    }
+  });
+  if (malformed) {
+    std::cout << "Error parsing Squiggles path: malformed CSV content";
+    return std::nullopt;
+  }
+  return path;
+}
+
+std::optional<Trajectory> parse_path(std::istream& in, unsigned int threads) {
+  std::string csv;
+  if (!read_stream(in, csv)) {
+    return std::nullopt;
+  }
+  return parse_path(std::string_view(csv), threads);
+}
+
+std::optional<Trajectory> parse_pathfinder_path(std::string_view left,
+                                                std::string_view right,
+                                                unsigned int threads) {
+  const std::string_view bodies[2] = {csv_body(left), csv_body(right)};
+  // the track width is the distance between the wheels' first poses
+  Pose first_poses[2];
+  for (std::size_t side = 0; side < 2; ++side) {
+    const char* first = bodies[side].data();
+    double fields[PATHFINDER_FIELDS];
+    if (bodies[side].empty() ||
+        parse_line(first, line_end(first, first + bodies[side].size()), fields,
+                   PATHFINDER_FIELDS) < PATHFINDER_FIELDS) {
+      std::cout << "Error parsing Squiggles path: malformed CSV content";
+      return std::nullopt;
+    }
+    first_poses[side] = Pose(fields[1], fields[2], fields[7]);
+  }
+  const double track_width = first_poses[0].dist(first_poses[1]);
+
+  // both wheels are split into chunks for the same threads
+  const std::size_t workers = worker_count(threads);
+  std::vector<LineChunk> chunks;
+  split_lines(bodies[0], 0, workers, chunks);
+  split_lines(bodies[1], 1, workers, chunks);
+  const auto rows = number_lines(chunks, 2, workers);
+  if (rows[1] < rows[0]) {
+    std::cout << "Error parsing Squiggles path: the right wheels' CSV content "
+                 "is shorter than the left";
+    return std::nullopt;
+  }
+  const std::size_t size = rows[0];
+
+  Trajectory path;
+  path.resize(size, 2);
+  double* x = path.column_data(0);
+  double* y = path.column_data(1);
+  double* yaw = path.column_data(2);
+  double* vel = path.column_data(3);
+  double* accel = path.column_data(4);
+  double* jerk = path.column_data(5);
+  double* curvature = path.column_data(6);
+  double* time = path.column_data(7);
+  double* wheels = path.column_data(8);
+
+  // Each wheel's lines only write their own values, the right wheel's
+  // acceleration and jerk wait in vel and curvature until both are parsed
+  std::atomic<bool> malformed{false};
+  run_parallel(chunks.size(), workers, [&](std::size_t c) {
+    const bool is_left = chunks[c].input == 0;
+    double fields[PATHFINDER_FIELDS];
+    const bool parsed = for_each_line(
+      chunks[c], [&](std::size_t i, const char* first, const char* last) {
+        if (i >= size) {
+          return true;
+        }
+        if (parse_line(first, last, fields, PATHFINDER_FIELDS) <
+            PATHFINDER_FIELDS) {
+          return false;
+        }
+        if (is_left) {
+          time[i] = fields[0];
+          wheels[2 * i] = fields[4];
+          accel[i] = fields[5];
+          jerk[i] = fields[6];
+        } else {
+          const Pose pose = wheels_to_pose(
+            Pose(fields[1], fields[2], fields[7]), track_width);
+          x[i] = pose.x;
+          y[i] = pose.y;
+          yaw[i] = pose.yaw;
+          wheels[2 * i + 1] = fields[4];
+          vel[i] = fields[5];
+          curvature[i] = fields[6];
+        }
+        return true;
+      });
+    if (!parsed) {
+      malformed = true;
+    }
+  });
+  if (malformed) {
+    std::cout << "Error parsing Squiggles path: malformed CSV content";
+    return std::nullopt;
+  }
+
+  const std::size_t blocks =
+    std::max<std::size_t>(1, std::min(workers, size / 4096));
+  run_parallel(blocks, workers, [&](std::size_t b) {
+    for (std::size_t i = size * b / blocks; i < size * (b + 1) / blocks; ++i) {
+      const double l_v = wheels[2 * i];
+      const double r_v = wheels[2 * i + 1];
+      accel[i] = wheel_vels_to_linear(accel[i], vel[i]);
+      jerk[i] = wheel_vels_to_linear(jerk[i], curvature[i]);
+      vel[i] = wheel_vels_to_linear(l_v, r_v);
+      curvature[i] = wheel_vels_to_curvature(l_v, r_v, track_width);
+    }
+  });
+  return path;
+}
+
+std::optional<Trajectory> parse_pathfinder_path(std::istream& left,
+                                                std::istream& right,
+                                                unsigned int threads) {
+  std::string left_csv, right_csv;
+  if (!read_stream(left, left_csv) || !read_stream(right, right_csv)) {
+    return std::nullopt;
+  }
+  return parse_pathfinder_path(
+    std::string_view(left_csv), std::string_view(right_csv), threads);
+}
+
+static const char BINARY_TRAJECTORY_MAGIC[4] = {'S', 'Q', 'G', 'T'};
+
+// x, y, yaw, vel, accel, jerk, curvature and time
+static constexpr std::size_t BINARY_TRAJECTORY_COLUMNS = 8;
+
+// The most doubles read from a stream of unknown length at once
+static constexpr std::size_t BINARY_READ_CHUNK = std::size_t(1) << 16;
+
+static bool host_is_little_endian() {
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+  return __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+#else
+  const std::uint16_t probe = 1;
+  unsigned char first_byte;
+  memcpy(&first_byte, &probe, 1);
+  return first_byte == 1;
+#endif
+}
+
+template <class T> static void write_little_endian(std::ostream& out, T value) {
+  unsigned char bytes[sizeof(T)];
+  memcpy(bytes, &value, sizeof(T));
+  if (!host_is_little_endian()) {
+    std::reverse(bytes, bytes + sizeof(T));
+  }
+  out.write(reinterpret_cast<const char*>(bytes), sizeof(T));
+}
+
+template <class T> static bool read_little_endian(std::istream& in, T& value) {
+  unsigned char bytes[sizeof(T)];
+  if (!in.read(reinterpret_cast<char*>(bytes), sizeof(T))) {
+    return false;
+  }
+  if (!host_is_little_endian()) {
+    std::reverse(bytes, bytes + sizeof(T));
+  }
+  memcpy(&value, bytes, sizeof(T));
+  return true;
+}
+
+static void
+write_column(std::ostream& out, const double* column, std::size_t count) {
+  if (host_is_little_endian()) {
+    out.write(reinterpret_cast<const char*>(column),
+              static_cast<std::streamsize>(count * sizeof(double)));
+    return;
+  }
+  for (std::size_t i = 0; i < count; ++i) {
+    write_little_endian(out, column[i]);
+  }
+}
+
+/**
+ * Gets the number of doubles after the header, or zero if the header does not
+ * describe a trajectory that can be addressed on this machine.
+ */
+static std::size_t column_values(const BinaryTrajectoryHeader& header) {
+  const std::uint64_t per_state =
+    BINARY_TRAJECTORY_COLUMNS + std::uint64_t(header.wheel_count);
+  const std::uint64_t limit =
+    std::numeric_limits<std::size_t>::max() / sizeof(double) / per_state;
+  if (header.size > limit) {
+    return 0;
+  }
+  return static_cast<std::size_t>(header.size * per_state);
+}
+
+static bool valid_header(const BinaryTrajectoryHeader& header) {
+  return memcmp(header.magic, BINARY_TRAJECTORY_MAGIC, 4) == 0 &&
+         header.version == BINARY_TRAJECTORY_VERSION &&
+         header.header_size >= sizeof(BinaryTrajectoryHeader) &&
+         header.header_size % sizeof(double) == 0 &&
+         (header.size == 0 || column_values(header) > 0);
+}
+
+/**
+ * Gets the number of bytes left in a stream, or -1 if it cannot seek.
+ */
+static std::streamoff remaining_bytes(std::istream& in) {
+  const std::istream::pos_type here = in.tellg();
+  if (here == std::istream::pos_type(-1)) {
+    return -1;
+  }
+  in.seekg(0, std::ios::end);
+  const std::istream::pos_type end = in.tellg();
+  in.seekg(here);
+  if (!in || end == std::istream::pos_type(-1)) {
+    in.clear();
+    in.seekg(here);
+    return -1;
+  }
+  return end - here;
+}
+
+static TrajectoryView columns_view(const double* columns,
+                                   std::size_t size,
+                                   std::size_t wheel_count) {
+  TrajectoryView view;
+  view.size = size;
+  view.wheel_count = wheel_count;
+  view.x = columns;
+  view.y = columns + size;
+  view.yaw = columns + 2 * size;
+  view.vel = columns + 3 * size;
+  view.accel = columns + 4 * size;
+  view.jerk = columns + 5 * size;
+  view.curvature = columns + 6 * size;
+  view.time = columns + 7 * size;
+  view.wheel_velocities = columns + BINARY_TRAJECTORY_COLUMNS * size;
+  return view;
+}
+
+int serialize_binary_path(std::ostream& out, const TrajectoryView& path) {
+  if (!out || path.size == 0) {
+    return -1;
+  }
+
+  out.write(BINARY_TRAJECTORY_MAGIC, 4);
+  write_little_endian(out, BINARY_TRAJECTORY_VERSION);
+  write_little_endian(out, std::uint64_t(path.size));
+  write_little_endian(out, std::uint32_t(path.wheel_count));
+  write_little_endian(out, std::uint32_t(sizeof(BinaryTrajectoryHeader)));
+  const char reserved[sizeof(BinaryTrajectoryHeader::reserved)] = {};
+  out.write(reserved, sizeof(reserved));
+
+  for (const double* column : {path.x,
+                               path.y,
+                               path.yaw,
+                               path.vel,
+                               path.accel,
+                               path.jerk,
+                               path.curvature,
+                               path.time}) {
+    write_column(out, column, path.size);
+  }
+  write_column(out, path.wheel_velocities, path.size * path.wheel_count);
+  return out ? 0 : -1;
+}
+
+std::optional<Trajectory> deserialize_binary_path(std::istream& in) {
+  if (!in) {
+    std::cout << "File does not exist!" << std::endl;
+    return std::nullopt;
+  }
+
+  BinaryTrajectoryHeader header;
+  if (!in.read(header.magic, 4) || !read_little_endian(in, header.version) ||
+      !read_little_endian(in, header.size) ||
+      !read_little_endian(in, header.wheel_count) ||
+      !read_little_endian(in, header.header_size) || !valid_header(header) ||
+      !in.ignore(header.header_size - 24)) {
+    std::cout << "Error parsing Squiggles path: malformed binary header";
+    return std::nullopt;
+  }
+
+  // The header is not trusted to size the allocation: a seekable stream is
+  // checked against its length up front, and any other stream is read in
+  // chunks so that the buffer never grows far past what was actually read
+  const std::size_t total = column_values(header);
+  const std::streamoff available = remaining_bytes(in);
+  if (available >= 0 &&
+      static_cast<std::uint64_t>(available) / sizeof(double) < total) {
+    std::cout << "Error parsing Squiggles path: truncated binary content";
+    return std::nullopt;
+  }
+  std::vector<double> columns;
+  while (in && columns.size() < total) {
+    const std::size_t first = columns.size();
+    columns.resize(first + std::min(total - first, BINARY_READ_CHUNK));
+    if (host_is_little_endian()) {
+      in.read(reinterpret_cast<char*>(columns.data() + first),
+              static_cast<std::streamsize>((columns.size() - first) *
+                                           sizeof(double)));
+    } else {
+      for (auto value = columns.begin() + first; value != columns.end();
+           ++value) {
+        read_little_endian(in, *value);
+      }
+    }
+  }
+  if (!in) {
+    std::cout << "Error parsing Squiggles path: truncated binary content";
+    return std::nullopt;
+  }
+  return Trajectory(columns_view(columns.data(),
+                                 static_cast<std::size_t>(header.size),
+                                 header.wheel_count));
+}
+
+std::optional<TrajectoryView> view_binary_path(const void* data,
+                                               std::size_t size) {
+  if (!host_is_little_endian() || data == nullptr ||
+      size < sizeof(BinaryTrajectoryHeader) ||
+      reinterpret_cast<std::uintptr_t>(data) % alignof(double) != 0) {
+    return std::nullopt;
+  }
+
+  BinaryTrajectoryHeader header;
+  memcpy(&header, data, sizeof(header));
+  if (!valid_header(header) || header.header_size > size ||
+      (size - header.header_size) / sizeof(double) < column_values(header)) {
+    return std::nullopt;
+  }
+  const auto* columns = reinterpret_cast<const double*>(
+    static_cast<const char*>(data) + header.header_size);
+  return columns_view(
+    columns, static_cast<std::size_t>(header.size), header.wheel_count);
+}
+
+std::optional<MappedTrajectory>
+MappedTrajectory::open(const std::string& filename) {
+  MappedTrajectory out;
+#ifdef SQUIGGLES_HAS_MMAP
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return std::nullopt;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    ::close(fd);
+    return std::nullopt;
+  }
+  out.length = static_cast<std::size_t>(info.st_size);
+  out.data = mmap(nullptr, out.length, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (out.data == MAP_FAILED) {
+    out.data = nullptr;
+    return std::nullopt;
+  }
+  auto view = view_binary_path(out.data, out.length);
+#else
+  std::ifstream in(filename, std::ios::binary | std::ios::ate);
+  if (!in) {
+    return std::nullopt;
+  }
+  const auto bytes = static_cast<std::size_t>(in.tellg());
+  out.buffer.resize((bytes + sizeof(double) - 1) / sizeof(double));
+  in.seekg(0);
+  in.read(reinterpret_cast<char*>(out.buffer.data()),
+          static_cast<std::streamsize>(bytes));
+  if (!in) {
+    return std::nullopt;
+  }
+  auto view = view_binary_path(out.buffer.data(), bytes);
+#endif
+  if (!view) {
+    return std::nullopt;
+  }
+  out.trajectory = *view;
+  return out;
+}
+
+MappedTrajectory::MappedTrajectory(MappedTrajectory&& other) noexcept
+  : data(other.data),
+    length(other.length),
+    buffer(std::move(other.buffer)),
+    trajectory(other.trajectory) {
+  other.data = nullptr;
+  other.length = 0;
+  other.trajectory = TrajectoryView();
+}
+
+MappedTrajectory&
+MappedTrajectory::operator=(MappedTrajectory&& other) noexcept {
+  if (this != &other) {
+    release();
+    data = other.data;
+    length = other.length;
+    buffer = std::move(other.buffer);
+    trajectory = other.trajectory;
+    other.data = nullptr;
+    other.length = 0;
+    other.trajectory = TrajectoryView();
+  }
+  return *this;
+}
+
+MappedTrajectory::~MappedTrajectory() { release(); }
+
+void MappedTrajectory::release() {
+#ifdef SQUIGGLES_HAS_MMAP
+  if (data != nullptr) {
+    munmap(data, length);
+  }
+#endif
+  data = nullptr;
+  length = 0;
+  buffer.clear();
+  trajectory = TrajectoryView();
+}
+
+int csv_to_binary_path(std::istream& csv, std::ostream& out) {
+  auto path = parse_path(csv);
+  if (!path) {
+    return -1;
+  }
+  return serialize_binary_path(out, path->view());
+}
+
+int binary_to_csv_path(std::istream& in, std::ostream& csv) {
+  auto path = deserialize_binary_path(in);
+  if (!path) {
+    return -1;
+  }
+  return serialize_path(csv, path->to_profile_points());
+}
+
+int pathfinder_to_binary_path(std::istream& left,
+                              std::istream& right,
+                              std::ostream& out) {
+  auto path = parse_pathfinder_path(left, right);
+  if (!path) {
+    return -1;
+  }
+  return serialize_binary_path(out, path->view());
+}
 } // namespace squiggles
\ No newline at end of file
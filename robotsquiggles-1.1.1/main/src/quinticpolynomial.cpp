@@ -61,22 +61,138 @@ QuinticPolynomial::QuinticPolynomial(double s_p,
   a5 = A_31 * B_11 + A_32 * B_21 + A_33 * B_31;
 }
 
-double QuinticPolynomial::calc_point(double t) {
+double QuinticPolynomial::calc_point(double t) const {
   return a0 + a1 * t + a2 * t * t + a3 * t * t * t + a4 * t * t * t * t +
          a5 * t * t * t * t * t;
 }
 
-double QuinticPolynomial::calc_first_derivative(double t) {
+double QuinticPolynomial::calc_first_derivative(double t) const {
   return a1 + 2 * a2 * t + 3 * a3 * t * t + 4 * a4 * t * t * t +
          5 * a5 * t * t * t * t;
 }
 
-double QuinticPolynomial::calc_second_derivative(double t) {
+double QuinticPolynomial::calc_second_derivative(double t) const {
   return 2 * a2 + 6 * a3 * t + 12 * a4 * t * t + 20 * a5 * t * t * t;
 }
 
-double QuinticPolynomial::calc_third_derivative(double t) {
+double QuinticPolynomial::calc_third_derivative(double t) const {
   return 6 * a3 + 24 * a4 * t + 60 * a5 * t * t;
 }
 
-} // namespace squiggles
\ No newline at end of file
+namespace {
+/**
+ * The coefficients of a polynomial and of its derivatives in Horner order.
+ */
+struct HornerCoefficients {
+  explicit HornerCoefficients(double a0,
+                              double a1,
+                              double a2,
+                              double a3,
+                              double a4,
+                              double a5)
+    : p{a0, a1, a2, a3, a4, a5},
+      v{a1, 2 * a2, 3 * a3, 4 * a4, 5 * a5},
+      a{2 * a2, 6 * a3, 12 * a4, 20 * a5},
+      j{6 * a3, 24 * a4, 60 * a5} {}
+
+  double p[6];
+  double v[5];
+  double a[4];
+  double j[3];
+
+  void eval(double t, double& op, double& ov, double& oa, double& oj) const {
+    op = p[0] + t * (p[1] + t * (p[2] + t * (p[3] + t * (p[4] + t * p[5]))));
+    ov = v[0] + t * (v[1] + t * (v[2] + t * (v[3] + t * v[4])));
+    oa = a[0] + t * (a[1] + t * (a[2] + t * a[3]));
+    oj = j[0] + t * (j[1] + t * j[2]);
+  }
+};
+
+/**
+ * Evaluates one polynomial at every stamp. The arrays are restrict
+ * parameters and each result is stored straight from a local, so the loop is
+ * vectorised without a runtime check that the arrays do not overlap.
+ */
+void eval_all(const HornerCoefficients c,
+              const double* __restrict t,
+              std::size_t count,
+              double* __restrict p,
+              double* __restrict v,
+              double* __restrict a,
+              double* __restrict j) {
+  for (std::size_t i = 0; i < count; ++i) {
+    double op, ov, oa, oj;
+    c.eval(t[i], op, ov, oa, oj);
+    p[i] = op;
+    v[i] = ov;
+    a[i] = oa;
+    j[i] = oj;
+  }
+}
+
+/**
+ * Evaluates two polynomials at every stamp in one pass. Without restrict
+ * there are too many arrays to check for overlap at runtime and the loop is
+ * not vectorised at all.
+ */
+void eval_all(const HornerCoefficients cx,
+              const HornerCoefficients cy,
+              const double* __restrict t,
+              std::size_t count,
+              double* __restrict xp,
+              double* __restrict xv,
+              double* __restrict xa,
+              double* __restrict xj,
+              double* __restrict yp,
+              double* __restrict yv,
+              double* __restrict ya,
+              double* __restrict yj) {
+  for (std::size_t i = 0; i < count; ++i) {
+    double op, ov, oa, oj;
+    cx.eval(t[i], op, ov, oa, oj);
+    xp[i] = op;
+    xv[i] = ov;
+    xa[i] = oa;
+    xj[i] = oj;
+    cy.eval(t[i], op, ov, oa, oj);
+    yp[i] = op;
+    yv[i] = ov;
+    ya[i] = oa;
+    yj[i] = oj;
+  }
+}
+} // namespace
+
+void QuinticPolynomial::calc_all(const double* t,
+                                 std::size_t count,
+                                 const Samples& out) const {
+  eval_all(HornerCoefficients(a0, a1, a2, a3, a4, a5),
+           t,
+           count,
+           out.p,
+           out.v,
+           out.a,
+           out.j);
+}
+
+void QuinticPolynomial::calc_all(const QuinticPolynomial& x,
+                                 const QuinticPolynomial& y,
+                                 const double* t,
+                                 std::size_t count,
+                                 const Samples& x_out,
+                                 const Samples& y_out) {
+  eval_all(HornerCoefficients(x.a0, x.a1, x.a2, x.a3, x.a4, x.a5),
+           HornerCoefficients(y.a0, y.a1, y.a2, y.a3, y.a4, y.a5),
+           t,
+           count,
+           x_out.p,
+           x_out.v,
+           x_out.a,
+           x_out.j,
+           y_out.p,
+           y_out.v,
+           y_out.a,
+           y_out.j);
+}
+
+} // namespace squiggles
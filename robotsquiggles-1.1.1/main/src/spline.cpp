@@ -6,77 +6,349 @@
  */
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
 #include <iostream>
 #include <numeric>
 #include <tuple>
+#ifndef __EMSCRIPTEN__
+#include <thread>
+#endif
 
 #include "spline.hpp"
 
 namespace squiggles {
-SplineGenerator::SplineGenerator(Constraints iconstraints,
-                                 std::shared_ptr<PhysicalModel> imodel,
-                                 double idt)
-  : constraints(iconstraints), model(std::move(imodel)), dt(idt) {}
-
-std::vector<ProfilePoint>
-SplineGenerator::generate(std::vector<Pose> iwaypoints, bool fast) {
-  std::vector<Pose> points = iwaypoints;
-  std::vector<ControlVector> vectors;
-  for (auto p : points) {
-    vectors.emplace_back(ControlVector(p));
-  }
-  return _generate(vectors.begin(), vectors.end(), fast);
+template <class Model>
+BasicSplineGenerator<Model>::BasicSplineGenerator(Constraints iconstraints,
+                                                  std::shared_ptr<Model> imodel,
+                                                  double idt,
+                                                  unsigned int ithreads)
+  : constraints(iconstraints), model(std::move(imodel)), dt(idt) {
+#ifdef __EMSCRIPTEN__
+  threads = 1;
+#else
+  threads = ithreads ? ithreads : std::thread::hardware_concurrency();
+#endif
+  threads = std::max(threads, 1u);
 }
 
+template <class Model>
 std::vector<ProfilePoint>
-SplineGenerator::generate(std::initializer_list<Pose> iwaypoints, bool fast) {
-  std::vector<Pose> points = iwaypoints;
-  std::vector<ControlVector> vectors;
-  for (auto p : points) {
-    vectors.emplace_back(ControlVector(p));
-  }
-  return _generate(vectors.begin(), vectors.end(), fast);
+BasicSplineGenerator<Model>::generate(std::vector<Pose> iwaypoints,
+                                      bool fast) {
+  std::vector<ProfilePoint> path;
+  generate(iwaypoints, path, fast);
+  return path;
 }
 
+template <class Model>
 std::vector<ProfilePoint>
-SplineGenerator::generate(std::vector<ControlVector> iwaypoints) {
-  return _generate(iwaypoints.begin(), iwaypoints.end(), false);
+BasicSplineGenerator<Model>::generate(std::initializer_list<Pose> iwaypoints,
+                                      bool fast) {
+  std::vector<ProfilePoint> path;
+  generate(std::vector<Pose>(iwaypoints), path, fast);
+  return path;
 }
 
+template <class Model>
 std::vector<ProfilePoint>
-SplineGenerator::generate(std::initializer_list<ControlVector> iwaypoints) {
-  return _generate(iwaypoints.begin(), iwaypoints.end(), false);
+BasicSplineGenerator<Model>::generate(std::vector<ControlVector> iwaypoints) {
+  std::vector<ProfilePoint> path;
+  _generate(iwaypoints.begin(), iwaypoints.end(), false, path);
+  return path;
 }
 
-template <class Iter>
-std::vector<ProfilePoint>
-SplineGenerator::_generate(Iter start, Iter end, bool fast) {
+template <class Model>
+std::vector<ProfilePoint> BasicSplineGenerator<Model>::generate(
+  std::initializer_list<ControlVector> iwaypoints) {
   std::vector<ProfilePoint> path;
+  _generate(iwaypoints.begin(), iwaypoints.end(), false, path);
+  return path;
+}
+
+template <class Model>
+void BasicSplineGenerator<Model>::generate(const std::vector<Pose>& iwaypoints,
+                                           std::vector<ProfilePoint>& out,
+                                           bool fast) {
+  waypoint_buffer.clear();
+  for (const auto& p : iwaypoints) {
+    waypoint_buffer.emplace_back(ControlVector(p));
+  }
+  _generate(waypoint_buffer.begin(), waypoint_buffer.end(), fast, out);
+}
+
+template <class Model>
+void BasicSplineGenerator<Model>::generate(
+  const std::vector<ControlVector>& iwaypoints,
+  std::vector<ProfilePoint>& out) {
+  _generate(iwaypoints.begin(), iwaypoints.end(), false, out);
+}
+
+template <class Model>
+void BasicSplineGenerator<Model>::generate(const std::vector<Pose>& iwaypoints,
+                                           Trajectory& out,
+                                           bool fast) {
+  waypoint_buffer.clear();
+  for (const auto& p : iwaypoints) {
+    waypoint_buffer.emplace_back(ControlVector(p));
+  }
+  _generate(waypoint_buffer.begin(), waypoint_buffer.end(), fast, out);
+}
+
+template <class Model>
+void BasicSplineGenerator<Model>::generate(
+  const std::vector<ControlVector>& iwaypoints,
+  Trajectory& out) {
+  _generate(iwaypoints.begin(), iwaypoints.end(), false, out);
+}
+
+static void append_points(std::vector<ProfilePoint>& path,
+                          std::vector<ProfilePoint>::const_iterator first,
+                          std::vector<ProfilePoint>::const_iterator last) {
+  path.insert(path.end(), first, last);
+}
+
+static void append_points(Trajectory& path,
+                          std::vector<ProfilePoint>::const_iterator first,
+                          std::vector<ProfilePoint>::const_iterator last) {
+  path.append(first, last);
+}
+
+static void replace_points(std::vector<ProfilePoint>& path,
+                           std::size_t first,
+                           std::size_t last,
+                           std::vector<ProfilePoint>::const_iterator ifirst,
+                           std::vector<ProfilePoint>::const_iterator ilast) {
+  path.erase(path.begin() + first, path.begin() + last);
+  path.insert(path.begin() + first, ifirst, ilast);
+}
+
+static void replace_points(Trajectory& path,
+                           std::size_t first,
+                           std::size_t last,
+                           std::vector<ProfilePoint>::const_iterator ifirst,
+                           std::vector<ProfilePoint>::const_iterator ilast) {
+  path.replace(first, last, ifirst, ilast);
+}
+
+static void shift_times(std::vector<ProfilePoint>& path,
+                        std::size_t first,
+                        double offset) {
+  for (auto p = path.begin() + first; p != path.end(); ++p) {
+    p->time += offset;
+  }
+}
+
+static void shift_times(Trajectory& path, std::size_t first, double offset) {
+  path.shift_time(first, offset);
+}
+
+template <class Model>
+template <class Iter, class Path>
+void BasicSplineGenerator<Model>::_generate(Iter start,
+                                            Iter end,
+                                            bool fast,
+                                            Path& path) {
+  path.clear();
   double start_time = 0.0;
   for (auto vec = std::next(start); vec != end; ++vec) {
-    // create copies of the values
-    auto spline_start = *std::prev(vec);
-    auto spline_end = *vec;
-
-    auto preferred_start_vel =
-      std::isnan(spline_start.vel) ? 0 : spline_start.vel;
-    auto preferred_end_vel = std::isnan(spline_end.vel) ? 0 : spline_end.vel;
-
-    auto raw_path = gen_raw_path(spline_start, spline_end, fast);
-    // TODO: check if the vel or accel constraints are actually hit by the raw
-    // path and return the raw path if not?
-    auto profiled_path = parameterize(spline_start,
-                                      spline_end,
-                                      raw_path,
-                                      preferred_start_vel,
-                                      preferred_end_vel,
-                                      start_time);
-    start_time = (profiled_path.end() - 1)->time;
-    //subtract one from the last point since the end of the prev segment is exactly the beginning of the next segment 
-    path.insert(path.end(), profiled_path.begin(), profiled_path.end() - 1);
+    start_time =
+      _generate_segment(*std::prev(vec), *vec, fast, start_time, path);
+  }
+}
+
+template <class Model>
+double
+BasicSplineGenerator<Model>::generate_segment(const ControlVector& start,
+                                              const ControlVector& end,
+                                              bool fast,
+                                              double start_time,
+                                              std::vector<ProfilePoint>& out) {
+  return _generate_segment(start, end, fast, start_time, out);
+}
+
+template <class Model>
+double BasicSplineGenerator<Model>::generate_segment(const ControlVector& start,
+                                                     const ControlVector& end,
+                                                     bool fast,
+                                                     double start_time,
+                                                     Trajectory& out) {
+  return _generate_segment(start, end, fast, start_time, out);
+}
+
+template <class Model>
+template <class Path>
+double BasicSplineGenerator<Model>::_generate_segment(
+  const ControlVector& start,
+  const ControlVector& end,
+  bool fast,
+  double start_time,
+  Path& path,
+  typename GeometricPath::Segment* keep) {
+  // create copies of the values
+  auto spline_start = start;
+  auto spline_end = end;
+
+  auto preferred_start_vel =
+    std::isnan(spline_start.vel) ? 0 : spline_start.vel;
+  auto preferred_end_vel = std::isnan(spline_end.vel) ? 0 : spline_end.vel;
+
+  gen_raw_path(spline_start, spline_end, fast, raw_points);
+  // TODO: check if the vel or accel constraints are actually hit by the raw
+  // path and return the raw path if not?
+  if (keep == nullptr) {
+    parameterize(spline_start,
+                 spline_end,
+                 raw_points,
+                 preferred_start_vel,
+                 preferred_end_vel,
+                 start_time,
+                 segment_path);
+  } else {
+    // The same steps as parameterize(), with the states kept for reprofile()
+    keep->start = spline_start;
+    keep->end = spline_end;
+    keep->start_vel = preferred_start_vel;
+    keep->end_vel = preferred_end_vel;
+    keep->states.resize(raw_points.size());
+    for (std::size_t i = 0; i < raw_points.size(); ++i) {
+      keep->states[i].pose = raw_points[i].pose;
+      keep->states[i].curvature = raw_points[i].curvature;
+    }
+    profile_states(keep->states,
+                   preferred_start_vel,
+                   preferred_end_vel,
+                   nullptr,
+                   keep->start_distance);
+    sample_profile(
+      spline_start, spline_end, keep->states, start_time, segment_path);
+    keep->first = path.size();
+    keep->count = segment_path.size() - 1;
+    keep->start_time = start_time;
+    keep->duration = segment_path.back().time - start_time;
+  }
+  //subtract one from the last point since the end of the prev segment is exactly the beginning of the next segment 
+  append_points(path, segment_path.cbegin(), segment_path.cend() - 1);
+  return (segment_path.end() - 1)->time;
+}
+
+template <class Model>
+void BasicSplineGenerator<Model>::generate(const std::vector<Pose>& iwaypoints,
+                                           GeometricPath& geometry,
+                                           std::vector<ProfilePoint>& out,
+                                           bool fast) {
+  waypoint_buffer.clear();
+  for (const auto& p : iwaypoints) {
+    waypoint_buffer.emplace_back(ControlVector(p));
+  }
+  _generate(
+    waypoint_buffer.begin(), waypoint_buffer.end(), fast, geometry, out);
+}
+
+template <class Model>
+void BasicSplineGenerator<Model>::generate(const std::vector<Pose>& iwaypoints,
+                                           GeometricPath& geometry,
+                                           Trajectory& out,
+                                           bool fast) {
+  waypoint_buffer.clear();
+  for (const auto& p : iwaypoints) {
+    waypoint_buffer.emplace_back(ControlVector(p));
+  }
+  _generate(
+    waypoint_buffer.begin(), waypoint_buffer.end(), fast, geometry, out);
+}
+
+template <class Model>
+template <class Iter, class Path>
+void BasicSplineGenerator<Model>::_generate(Iter start,
+                                            Iter end,
+                                            bool fast,
+                                            GeometricPath& geometry,
+                                            Path& path) {
+  path.clear();
+  // Resized rather than cleared, so the states of each segment keep their
+  // capacity when the same geometry is generated into again
+  const auto count = std::distance(start, end);
+  geometry.segments.resize(count > 1 ? count - 1 : 0);
+  double start_time = 0.0;
+  double distance = 0.0;
+  auto segment = geometry.segments.begin();
+  for (auto vec = std::next(start); vec != end; ++vec, ++segment) {
+    segment->start_distance = distance;
+    start_time = _generate_segment(
+      *std::prev(vec), *vec, fast, start_time, path, &*segment);
+    distance += segment->states.back().distance;
+  }
+}
+
+template <class Model>
+void BasicSplineGenerator<Model>::reprofile(GeometricPath& geometry,
+                                            const std::vector<SpeedZone>& zones,
+                                            double from,
+                                            double to,
+                                            std::vector<ProfilePoint>& out) {
+  _reprofile(geometry, zones, from, to, out);
+}
+
+template <class Model>
+void BasicSplineGenerator<Model>::reprofile(GeometricPath& geometry,
+                                            const std::vector<SpeedZone>& zones,
+                                            double from,
+                                            double to,
+                                            Trajectory& out) {
+  _reprofile(geometry, zones, from, to, out);
+}
+
+template <class Model>
+template <class Path>
+void BasicSplineGenerator<Model>::_reprofile(
+  GeometricPath& geometry,
+  const std::vector<SpeedZone>& zones,
+  double from,
+  double to,
+  Path& path) {
+  // The segments overlapping the span are consecutive, every state after the
+  // last of them is shifted once by the time they gained or lost
+  double offset = 0.0;
+  std::ptrdiff_t moved = 0;
+  std::size_t tail = path.size();
+  bool reprofiled = false;
+  for (auto& segment : geometry.segments) {
+    segment.first += moved;
+    segment.start_time += offset;
+    const double segment_end =
+      segment.start_distance + segment.states.back().distance;
+    if (segment_end < from || segment.start_distance > to) {
+      continue;
+    }
+
+    profile_states(segment.states,
+                   segment.start_vel,
+                   segment.end_vel,
+                   &zones,
+                   segment.start_distance);
+    sample_profile(segment.start,
+                   segment.end,
+                   segment.states,
+                   segment.start_time,
+                   segment_path);
+    replace_points(path,
+                   segment.first,
+                   segment.first + segment.count,
+                   segment_path.cbegin(),
+                   segment_path.cend() - 1);
+    const double duration = segment_path.back().time - segment.start_time;
+    offset += duration - segment.duration;
+    moved += static_cast<std::ptrdiff_t>(segment_path.size() - 1) -
+             static_cast<std::ptrdiff_t>(segment.count);
+    segment.count = segment_path.size() - 1;
+    segment.duration = duration;
+    tail = segment.first + segment.count;
+    reprofiled = true;
+  }
+  if (reprofiled && offset != 0.0) {
+    shift_times(path, tail, offset);
   }
-  return path;
 }
 
 // TODO: Seek to minimize peak curvature, we will want a curved path so
@@ -86,115 +358,156 @@ SplineGenerator::_generate(Iter start, Iter end, bool fast) {
 // Two variables affect the curvature -- the path duration (d) and the
 // starting/ending velocity (K_DEFAULT_VEL). If we have the freedom to
 // mess with the dummy velocities then we can change the
-std::vector<SplineGenerator::GeneratedVector>
-SplineGenerator::gen_single_raw_path(ControlVector start,
-                                     ControlVector end,
-                                     int duration,
-                                     double start_vel,
-                                     double end_vel) {
+template <class Model>
+std::vector<typename BasicSplineGenerator<Model>::GeneratedVector>
+BasicSplineGenerator<Model>::gen_single_raw_path(ControlVector start,
+                                                 ControlVector end,
+                                                 int duration,
+                                                 double start_vel,
+                                                 double end_vel) {
+  std::vector<GeneratedVector> vectors;
+  gen_single_raw_path(start, end, duration, start_vel, end_vel, vectors);
+  return vectors;
+}
+
+template <class Model>
+void BasicSplineGenerator<Model>::gen_single_raw_path(
+  ControlVector start,
+  ControlVector end,
+  int duration,
+  double start_vel,
+  double end_vel,
+  std::vector<GeneratedVector>& vectors) {
   start.vel = start_vel;
   end.vel = end_vel;
   auto x_qp = get_x_spline(start, end, duration);
   auto y_qp = get_y_spline(start, end, duration);
 
-  std::vector<GeneratedVector> vectors;
-
-  std::vector<double> times(round(duration / dt) + 1);
-  std::iota(std::begin(times), std::end(times), 0.0);
-  for (auto time : times) {
-    double t = time * dt;
-
-    double x_p = x_qp.calc_point(t);
-    double y_p = y_qp.calc_point(t);
-    double x_v = x_qp.calc_first_derivative(t);
-    double y_v = y_qp.calc_first_derivative(t);
-    double x_a = x_qp.calc_second_derivative(t);
-    double y_a = y_qp.calc_second_derivative(t);
-    double x_j = x_qp.calc_third_derivative(t);
-    double y_j = y_qp.calc_third_derivative(t);
-
-    double linear_vel = sqrt(x_v * x_v + y_v * y_v);
-    double linear_accel = sqrt(x_a * x_a + y_a * y_a);
-    double linear_jerk = sqrt(x_j * x_j + y_j * y_j);
-    double yaw = atan2(y_v, x_v);
-
-    if (vectors.size() > 2 &&
-        vectors.rbegin()[0].vel - vectors.rbegin()[1].vel < 0.0) {
-      linear_accel *= -1;
+  vectors.clear();
+
+  // The polynomials are evaluated a chunk of stamps at a time into buffers on
+  // the stack, so concurrent candidates share no storage and nothing allocates
+  constexpr std::size_t CHUNK = 64;
+  double ts[CHUNK];
+  double xs[4][CHUNK];
+  double ys[4][CHUNK];
+  const QuinticPolynomial::Samples x_out{xs[0], xs[1], xs[2], xs[3]};
+  const QuinticPolynomial::Samples y_out{ys[0], ys[1], ys[2], ys[3]};
+
+  const long num_times = std::lround(duration / dt) + 1;
+  vectors.reserve(num_times);
+  for (long first = 0; first < num_times; first += CHUNK) {
+    const std::size_t count =
+      static_cast<std::size_t>(std::min<long>(CHUNK, num_times - first));
+    for (std::size_t i = 0; i < count; ++i) {
+      ts[i] = (first + static_cast<long>(i)) * dt;
     }
-    if (vectors.size() > 2 &&
-        vectors.rbegin()[0].accel - vectors.rbegin()[1].accel < 0.0) {
-      linear_jerk *= -1;
+    QuinticPolynomial::calc_all(x_qp, y_qp, ts, count, x_out, y_out);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      double x_p = xs[0][i];
+      double y_p = ys[0][i];
+      double x_v = xs[1][i];
+      double y_v = ys[1][i];
+      double x_a = xs[2][i];
+      double y_a = ys[2][i];
+      double x_j = xs[3][i];
+      double y_j = ys[3][i];
+
+      double linear_vel = sqrt(x_v * x_v + y_v * y_v);
+      double linear_accel = sqrt(x_a * x_a + y_a * y_a);
+      double linear_jerk = sqrt(x_j * x_j + y_j * y_j);
+      double yaw = atan2(y_v, x_v);
+
+      if (vectors.size() > 2 &&
+          vectors.rbegin()[0].vel - vectors.rbegin()[1].vel < 0.0) {
+        linear_accel *= -1;
+      }
+      if (vectors.size() > 2 &&
+          vectors.rbegin()[0].accel - vectors.rbegin()[1].accel < 0.0) {
+        linear_jerk *= -1;
+      }
+
+      double curvature = (x_v * y_a - x_a * y_v) /
+                         ((x_v * x_v + y_v * y_v) * std::hypot(x_v, y_v));
+
+      vectors.push_back(
+        GeneratedVector(GeneratedPoint(Pose(x_p, y_p, yaw), curvature),
+                        linear_vel,
+                        linear_accel,
+                        linear_jerk));
     }
+  }
+}
 
-    double curvature = (x_v * y_a - x_a * y_v) /
-                       ((x_v * x_v + y_v * y_v) * std::hypot(x_v, y_v));
+namespace {
+/**
+ * The peak values of a raw path that are checked against the constraints.
+ */
+struct RawPathMaxima {
+  double accel;
+  double jerk;
+  double curvature;
+};
 
-    vectors.push_back(
-      GeneratedVector(GeneratedPoint(Pose(x_p, y_p, yaw), curvature),
-                      linear_vel,
-                      linear_accel,
-                      linear_jerk));
+/**
+ * Finds the maximum acceleration, jerk and curvature in a single pass. Like
+ * std::max_element, each maximum only moves when a later value compares
+ * greater, so a NaN in the first state is kept.
+ */
+template <class GeneratedVector>
+RawPathMaxima find_maxima(const std::vector<GeneratedVector>& vectors) {
+  RawPathMaxima out{vectors.front().accel,
+                    vectors.front().jerk,
+                    vectors.front().point.curvature};
+  for (const auto& v : vectors) {
+    if (out.accel < v.accel)
+      out.accel = v.accel;
+    if (out.jerk < v.jerk)
+      out.jerk = v.jerk;
+    if (out.curvature < v.point.curvature)
+      out.curvature = v.point.curvature;
   }
-  return vectors;
+  return out;
 }
+} // namespace
 
-static double
-find_max_accel(std::vector<SplineGenerator::GeneratedVector> vectors) {
-  return std::max_element(vectors.begin(),
-                          vectors.end(),
-                          [](const SplineGenerator::GeneratedVector& a,
-                             const SplineGenerator::GeneratedVector& b) {
-                            return a.accel < b.accel;
-                          })
-    ->accel;
-}
-
-static double
-find_max_jerk(std::vector<SplineGenerator::GeneratedVector> vectors) {
-  return std::max_element(vectors.begin(),
-                          vectors.end(),
-                          [](const SplineGenerator::GeneratedVector& a,
-                             const SplineGenerator::GeneratedVector& b) {
-                            return a.jerk < b.jerk;
-                          })
-    ->jerk;
-}
-
-static double
-find_max_curvature(std::vector<SplineGenerator::GeneratedVector> vectors) {
-  return std::max_element(vectors.begin(),
-                          vectors.end(),
-                          [](const SplineGenerator::GeneratedVector& a,
-                             const SplineGenerator::GeneratedVector& b) {
-                            return a.point.curvature < b.point.curvature;
-                          })
-    ->point.curvature;
-}
-
-std::vector<SplineGenerator::GeneratedPoint>
-SplineGenerator::gradient_descent(ControlVector& start,
-                                  ControlVector& end,
-                                  bool fast) {
+template <class Model>
+std::vector<typename BasicSplineGenerator<Model>::GeneratedPoint>
+BasicSplineGenerator<Model>::gradient_descent(ControlVector& start,
+                                              ControlVector& end,
+                                              bool fast) {
+  std::vector<GeneratedPoint> out;
+  gradient_descent(start, end, fast, out);
+  return out;
+}
+
+template <class Model>
+void BasicSplineGenerator<Model>::gradient_descent(
+  ControlVector& start,
+  ControlVector& end,
+  bool fast,
+  std::vector<GeneratedPoint>& out) {
   auto start_vel = 0.2;
   auto end_vel = 0.2;
 
-  std::vector<GeneratedVector> vectors;
-  double a_max, j_max, k_max;
+  auto& vectors = raw_vectors;
+  double a_max = 0.0, j_max = 0.0, k_max = 0.0;
 
   auto d = T_MIN;
   auto prev_lin_cost = 0.0, prev_curv_cost = 0.0;
   int counter = 0;
   bool lin_hit_min = false;
   while (counter++ < MAX_GRAD_DESCENT_ITERATIONS) {
-    vectors = gen_single_raw_path(start, end, d, start_vel, end_vel);
+    gen_single_raw_path(start, end, d, start_vel, end_vel, vectors);
 
-    a_max = find_max_accel(vectors);
-    j_max = find_max_jerk(vectors);
+    const auto maxima = find_maxima(vectors);
+    a_max = maxima.accel;
+    j_max = maxima.jerk;
     auto lin_cost = std::abs(a_max - constraints.max_accel) +
                     std::abs(j_max - constraints.max_jerk);
 
-    k_max = find_max_curvature(vectors);
+    k_max = maxima.curvature;
     auto curv_cost = std::abs(k_max);
     if (std::isnan(curv_cost)) {
       // we might get a curvature of NaN with small start/end velocities
@@ -255,119 +568,251 @@ SplineGenerator::gradient_descent(ControlVector& start,
   // We need to update the control vectors for the parameterization step
   start.vel = start_vel;
   end.vel = end_vel;
-  std::vector<GeneratedPoint> out;
+  out.clear();
   std::transform(vectors.begin(),
                  vectors.end(),
                  std::back_inserter(out),
-                 [](GeneratedVector v) { return v.point; });
-  return out;
+                 [](const GeneratedVector& v) { return v.point; });
 }
 
 /**
  * NOTE: the time value here is meaningless since we'll remap it completely
  * when imposing the constraints
  */
-std::vector<SplineGenerator::GeneratedPoint>
-SplineGenerator::gen_raw_path(ControlVector& start,
-                              ControlVector& end,
-                              bool fast) {
+template <class Model>
+std::vector<typename BasicSplineGenerator<Model>::GeneratedPoint>
+BasicSplineGenerator<Model>::gen_raw_path(ControlVector& start,
+                                          ControlVector& end,
+                                          bool fast) {
+  std::vector<GeneratedPoint> out;
+  gen_raw_path(start, end, fast, out);
+  return out;
+}
+
+template <class Model>
+void
+BasicSplineGenerator<Model>::gen_raw_path(ControlVector& start,
+                                          ControlVector& end,
+                                          bool fast,
+                                          std::vector<GeneratedPoint>& out) {
   if (std::isnan(start.vel) || std::abs(start.vel) < K_EPSILON ||
       std::isnan(end.vel) || std::abs(end.vel) < K_EPSILON) {
     // We don't have user-specified velocities to use.
-    return gradient_descent(start, end, fast);
+    gradient_descent(start, end, fast, out);
+    return;
   }
 
-  // iterate through possible path durations until we find one that fits
-  // our kinematic constraints
-  std::vector<int> durations(T_MAX - T_MIN + 1);
-  std::iota(std::begin(durations), std::end(durations), T_MIN);
-  for (auto d : durations) {
-    std::vector<GeneratedVector> vectors =
-      gen_single_raw_path(start, end, d, start.vel, end.vel);
-
-    auto a_max = find_max_accel(vectors);
-    auto j_max = find_max_jerk(vectors);
-    auto k_max = find_max_curvature(vectors);
-    if (std::isnan(k_max) || std::abs(k_max) < 0.01) {
-      k_max = std::numeric_limits<double>::max();
+  auto meets_constraints = [this](const std::vector<GeneratedVector>& vectors) {
+    const auto maxima = find_maxima(vectors);
+    auto k_max = maxima.curvature;
+    if (std::isnan(k_max)) {
+      // the curvature could not be evaluated, so it cannot be shown to pass
+      return false;
+    }
+    if (std::abs(k_max) < 0.01) {
+      // a straight path has no curvature to limit
+      k_max = 0.0;
+    }
+    return !(maxima.accel > constraints.max_accel ||
+             maxima.jerk > constraints.max_jerk ||
+             (k_max > constraints.max_curvature));
+  };
+  auto copy_points = [&out](const std::vector<GeneratedVector>& vectors) {
+    out.clear();
+    std::transform(vectors.begin(),
+                   vectors.end(),
+                   std::back_inserter(out),
+                   [](const GeneratedVector& v) { return v.point; });
+  };
+
+#ifndef __EMSCRIPTEN__
+  const unsigned int workers =
+    std::min<unsigned int>(threads, T_MAX - T_MIN + 1);
+  if (workers > 1 && T_MAX / dt >= K_PARALLEL_MIN_STATES) {
+    // Each worker takes the next untried duration until one that is no
+    // shorter than the best passing duration so far would be next. Every
+    // duration below the final best is still tried, so the result is the same
+    // as trying them in order.
+    candidate_vectors.resize(workers);
+    candidate_durations.assign(workers, T_MAX + 1);
+    std::atomic<int> next_duration(T_MIN);
+    std::atomic<int> best_duration(T_MAX + 1);
+    auto work = [&](unsigned int w) {
+      for (int d = next_duration++; d <= T_MAX && d < best_duration;
+           d = next_duration++) {
+        gen_single_raw_path(
+          start, end, d, start.vel, end.vel, candidate_vectors[w]);
+        if (meets_constraints(candidate_vectors[w])) {
+          candidate_durations[w] = d;
+          int best = best_duration;
+          while (d < best && !best_duration.compare_exchange_weak(best, d)) {
+          }
+          // any later duration this worker takes would be longer
+          return;
+        }
+      }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (unsigned int w = 1; w < workers; ++w) {
+      pool.emplace_back(work, w);
+    }
+    work(0);
+    for (auto& thread : pool) {
+      thread.join();
     }
 
-    if (a_max > constraints.max_accel || j_max > constraints.max_jerk ||
-        (k_max > constraints.max_curvature)) {
-      continue;
-    } else {
+    const int best = best_duration;
+    for (unsigned int w = 0; best <= T_MAX && w < workers; ++w) {
+      if (candidate_durations[w] == best) {
+        copy_points(candidate_vectors[w]);
+        return;
+      }
+    }
+    throw std::runtime_error(
+      "Could not find a valid path within the constraints");
+  }
+#endif
+
+  // iterate through possible path durations until we find one that fits
+  // our kinematic constraints
+  auto& vectors = raw_vectors;
+  for (int d = T_MIN; d <= T_MAX; ++d) {
+    gen_single_raw_path(start, end, d, start.vel, end.vel, vectors);
+    if (meets_constraints(vectors)) {
       // all of the constraints are met
-      std::vector<GeneratedPoint> out;
-      std::transform(vectors.begin(),
-                     vectors.end(),
-                     std::back_inserter(out),
-                     [](GeneratedVector v) { return v.point; });
-      return out;
+      copy_points(vectors);
+      return;
     }
   }
   throw std::runtime_error(
     "Could not find a valid path within the constraints");
 }
 
-std::vector<ProfilePoint>
-SplineGenerator::parameterize(const ControlVector start,
-                              const ControlVector end,
-                              const std::vector<GeneratedPoint>& raw_path,
-                              const double preferred_start_vel,
-                              const double preferred_end_vel,
-                              const double start_time) {
-  std::vector<ConstrainedState> constrainedStates(raw_path.size());
+template <class Model>
+std::vector<ProfilePoint> BasicSplineGenerator<Model>::parameterize(
+  const ControlVector start,
+  const ControlVector end,
+  const std::vector<GeneratedPoint>& raw_path,
+  const double preferred_start_vel,
+  const double preferred_end_vel,
+  const double start_time) {
+  std::vector<ProfilePoint> out;
+  parameterize(start,
+               end,
+               raw_path,
+               preferred_start_vel,
+               preferred_end_vel,
+               start_time,
+               out);
+  return out;
+}
+
+template <class Model>
+void BasicSplineGenerator<Model>::parameterize(
+  const ControlVector start,
+  const ControlVector end,
+  const std::vector<GeneratedPoint>& raw_path,
+  const double preferred_start_vel,
+  const double preferred_end_vel,
+  const double start_time,
+  std::vector<ProfilePoint>& out) {
+  auto& constrainedStates = constrained_states;
+  constrainedStates.resize(raw_path.size());
+  for (std::size_t i = 0; i < raw_path.size(); ++i) {
+    constrainedStates[i].pose = raw_path[i].pose;
+    constrainedStates[i].curvature = raw_path[i].curvature;
+  }
+  profile_states(
+    constrainedStates, preferred_start_vel, preferred_end_vel, nullptr, 0.0);
+  sample_profile(start, end, constrainedStates, start_time, out);
+}
 
+template <class Model>
+void BasicSplineGenerator<Model>::profile_states(
+  std::vector<ConstrainedState>& constrainedStates,
+  double preferred_start_vel,
+  double preferred_end_vel,
+  const std::vector<SpeedZone>* zones,
+  double start_distance) {
   // Forward Pass
-  ConstrainedState predecessor(raw_path.front().pose,
+  ConstrainedState predecessor(constrainedStates.front().pose,
                                0,
                                0,
                                preferred_start_vel,
                                constraints.min_accel,
                                constraints.max_accel);
-  constrainedStates[0] = predecessor;
-  for (std::size_t i = 0; i < raw_path.size(); ++i) {
+  for (std::size_t i = 0; i < constrainedStates.size(); ++i) {
     auto& constrainedState = constrainedStates[i];
-    constrainedState.pose = raw_path[i].pose;
-    constrainedState.curvature = raw_path[i].curvature;
-    forward_pass(&predecessor, &constrainedState);
+    double max_vel = constraints.max_vel;
+    if (zones != nullptr) {
+      // The zones are looked up at the distance the pass gives the state
+      const double distance = start_distance + predecessor.distance +
+                              constrainedState.pose.dist(predecessor.pose);
+      for (const auto& zone : *zones) {
+        if (zone.start <= distance && distance <= zone.end) {
+          max_vel = std::min(max_vel, zone.max_vel);
+        }
+      }
+    }
+    forward_pass(&predecessor, &constrainedState, max_vel);
     predecessor = constrainedState;
   }
 
   // Backward pass
-  ConstrainedState successor(raw_path.back().pose,
+  ConstrainedState successor(constrainedStates.back().pose,
                              0,
                              constrainedStates.back().distance,
                              preferred_end_vel,
                              constraints.min_accel,
                              constraints.max_accel);
-  for (int i = raw_path.size() - 1; i >= 0; i--) {
+  for (int i = constrainedStates.size() - 1; i >= 0; i--) {
     backward_pass(&constrainedStates[i], &successor);
     successor = constrainedStates[i];
   }
+}
 
+template <class Model>
+void BasicSplineGenerator<Model>::sample_profile(
+  const ControlVector& start,
+  const ControlVector& end,
+  const std::vector<ConstrainedState>& constrainedStates,
+  double start_time,
+  std::vector<ProfilePoint>& out) {
   // Now we can integrate the constrained states forward in time to obtain our
   // trajectory states.
-  auto time_adjusted = integrate_constrained_states(constrainedStates);
-
-  const auto num_time_steps = std::round(time_adjusted.back().time / dt) + 1;
-  std::vector<double> times(num_time_steps);
-  std::iota(std::begin(times), std::end(times), 0.0);
-  std::vector<ProfilePoint> out;
-  for (auto t : times) {
-    auto point = get_point_at_time(start, end, time_adjusted, t * dt);
+  integrate_constrained_states(constrainedStates, time_adjusted);
+
+  // The splines only depend on the segment's duration so they are built once
+  // and the output timestamps are swept forward through the profile.
+  const auto duration = time_adjusted.back().time;
+  const auto x_qp = get_x_spline(start, end, duration);
+  const auto y_qp = get_y_spline(start, end, duration);
+  std::size_t cursor = 1;
+
+  const long num_time_steps = std::lround(duration / dt) + 1;
+  out.clear();
+  for (long t = 0; t < num_time_steps; ++t) {
+    auto point = get_point_at_time(x_qp, y_qp, time_adjusted, t * dt, cursor);
     point.time = point.time + start_time;
     out.emplace_back(point);
   }
-  return out;
 }
 
 /**
  * We may need to iterate to find the maximum end vel and common accel, since
  * accel limits may be a function of vel.
  */
-void SplineGenerator::forward_pass(ConstrainedState* predecessor,
-                                   ConstrainedState* successor) {
+template <class Model>
+void BasicSplineGenerator<Model>::forward_pass(ConstrainedState* predecessor,
+                                               ConstrainedState* successor) {
+  forward_pass(predecessor, successor, constraints.max_vel);
+}
+
+template <class Model>
+void BasicSplineGenerator<Model>::forward_pass(ConstrainedState* predecessor,
+                                               ConstrainedState* successor,
+                                               double max_vel) {
   double ds = successor->pose.dist(predecessor->pose);
   successor->distance = predecessor->distance + ds;
 
@@ -376,8 +821,7 @@ void SplineGenerator::forward_pass(ConstrainedState* predecessor,
     // vf = std::sqrt(vi^2 + 2*a*d).
 
     successor->max_vel =
-      std::min(constraints.max_vel,
-               vf(predecessor->max_vel, predecessor->max_accel, ds));
+      std::min(max_vel, vf(predecessor->max_vel, predecessor->max_accel, ds));
 
     successor->min_accel = -constraints.max_accel;
     successor->max_accel = constraints.max_accel;
@@ -423,8 +867,9 @@ void SplineGenerator::forward_pass(ConstrainedState* predecessor,
  * Enforce the max velocity on the predecessor point and the min
  * acceleration on the successor point.
  */
-void SplineGenerator::backward_pass(ConstrainedState* predecessor,
-                                    ConstrainedState* successor) {
+template <class Model>
+void BasicSplineGenerator<Model>::backward_pass(ConstrainedState* predecessor,
+                                                ConstrainedState* successor) {
   double ds = predecessor->distance - successor->distance; // negative
 
   while (predecessor->max_vel >
@@ -455,15 +900,26 @@ void SplineGenerator::backward_pass(ConstrainedState* predecessor,
   }
 }
 
-std::vector<ProfilePoint> SplineGenerator::integrate_constrained_states(
-  std::vector<ConstrainedState> constrainedStates) {
-  std::vector<ProfilePoint> out(constrainedStates.size());
+template <class Model>
+std::vector<ProfilePoint>
+BasicSplineGenerator<Model>::integrate_constrained_states(
+  const std::vector<ConstrainedState>& constrainedStates) {
+  std::vector<ProfilePoint> out;
+  integrate_constrained_states(constrainedStates, out);
+  return out;
+}
+
+template <class Model>
+void BasicSplineGenerator<Model>::integrate_constrained_states(
+  const std::vector<ConstrainedState>& constrainedStates,
+  std::vector<ProfilePoint>& out) {
+  out.resize(constrainedStates.size());
   double t = 0;
   double s = 0;
   double v = 0;
 
   for (unsigned int i = 0; i < constrainedStates.size(); i++) {
-    auto state = constrainedStates[i];
+    const auto& state = constrainedStates[i];
 
     // Calculate the change in position between the current state and the
     // previous state.
@@ -501,18 +957,20 @@ std::vector<ProfilePoint> SplineGenerator::integrate_constrained_states(
     out[i] =
       ProfilePoint(ControlVector(state.pose, v, accel, 0), wheel_vels, k, t);
   }
-  return out;
 }
 
-double SplineGenerator::vf(double vi, double a, double ds) {
+template <class Model>
+double BasicSplineGenerator<Model>::vf(double vi, double a, double ds) {
   return std::sqrt(vi * vi + a * ds * 2.0);
 }
 
-double SplineGenerator::ai(double vf, double vi, double ds) {
+template <class Model>
+double BasicSplineGenerator<Model>::ai(double vf, double vi, double ds) {
   return vf * vf - vi * vi / (ds * 2.0);
 }
 
-void SplineGenerator::enforce_accel_lims(ConstrainedState* state) {
+template <class Model>
+void BasicSplineGenerator<Model>::enforce_accel_lims(ConstrainedState* state) {
   // for (auto&& constraint : constraints) {
   //   double factor = reverse ? -1.0 : 1.0;
 
@@ -537,25 +995,44 @@ void SplineGenerator::enforce_accel_lims(ConstrainedState* state) {
              model_constraints.max_accel);
 }
 
-ProfilePoint
-SplineGenerator::get_point_at_time(const ControlVector start,
-                                   const ControlVector end,
-                                   std::vector<ProfilePoint> points,
-                                   double t) {
+template <class Model>
+ProfilePoint BasicSplineGenerator<Model>::get_point_at_time(
+  const ControlVector start,
+  const ControlVector end,
+  const std::vector<ProfilePoint>& points,
+  double t) {
+  const auto duration = points.back().time;
+  std::size_t cursor = 1;
+  return get_point_at_time(get_x_spline(start, end, duration),
+                           get_y_spline(start, end, duration),
+                           points,
+                           t,
+                           cursor);
+}
+
+template <class Model>
+ProfilePoint BasicSplineGenerator<Model>::get_point_at_time(
+  const QuinticPolynomial& x_qp,
+  const QuinticPolynomial& y_qp,
+  const std::vector<ProfilePoint>& points,
+  double t,
+  std::size_t& cursor) {
   if (t <= points.front().time)
     return points.front();
   if (t >= points.back().time)
     return points.back();
 
-  // Use binary search to get the element with a timestamp no less than the
-  // requested timestamp. This starts at 1 because we use the previous state
-  // later on for interpolation.
-  auto sample = std::lower_bound(
-    points.cbegin() + 1, points.cend(), t, [](const auto& a, const auto& b) {
-      return a.time < b;
-    });
+  // Walk forward to the element with a timestamp no less than the requested
+  // timestamp. This starts at 1 because we use the previous state later on
+  // for interpolation, and it cannot run off the end since t is less than the
+  // last timestamp.
+  cursor = std::max<std::size_t>(cursor, 1);
+  while (points[cursor].time < t) {
+    ++cursor;
+  }
 
-  auto prev_sample = sample - 1;
+  const auto sample = points.cbegin() + cursor;
+  const auto prev_sample = sample - 1;
 
   // The sample's timestamp is now greater than or equal to the requested
   // timestamp. If it is greater, we need to interpolate between the
@@ -567,20 +1044,17 @@ SplineGenerator::get_point_at_time(const ControlVector start,
     return *sample;
   }
   const auto i = (t - prev_sample->time) / (sample->time - prev_sample->time);
-  const auto duration = points.back().time;
   // Interpolate between the two states for the state that we want.
-  return lerp_point(get_x_spline(start, end, duration),
-                    get_y_spline(start, end, duration),
-                    *prev_sample,
-                    *sample,
-                    i);
-}
-
-ProfilePoint SplineGenerator::lerp_point(QuinticPolynomial x_qp,
-                                         QuinticPolynomial y_qp,
-                                         ProfilePoint p_start,
-                                         ProfilePoint p_end,
-                                         double i) {
+  return lerp_point(x_qp, y_qp, *prev_sample, *sample, i);
+}
+
+template <class Model>
+ProfilePoint
+BasicSplineGenerator<Model>::lerp_point(const QuinticPolynomial& x_qp,
+                                        const QuinticPolynomial& y_qp,
+                                        const ProfilePoint& p_start,
+                                        const ProfilePoint& p_end,
+                                        double i) {
   // Find the new [t] value.
   const auto new_t = std::lerp(p_start.time, p_end.time, i);
 
@@ -615,8 +1089,7 @@ ProfilePoint SplineGenerator::lerp_point(QuinticPolynomial x_qp,
 
   const auto new_curvature =
     std::lerp(p_start.curvature, p_end.curvature, interpolationFrac);
-  std::vector<double> new_wheel_vels =
-    model->linear_to_wheel_vels(new_v, new_curvature);
+  const auto new_wheel_vels = model->linear_to_wheel_vels(new_v, new_curvature);
   const auto new_x = x_qp.calc_point(new_t);
   const auto new_y = y_qp.calc_point(new_t);
   const auto new_yaw = std::atan2(y_qp.calc_first_derivative(new_t),
@@ -633,9 +1106,11 @@ ProfilePoint SplineGenerator::lerp_point(QuinticPolynomial x_qp,
                       new_t);
 }
 
-QuinticPolynomial SplineGenerator::get_x_spline(const ControlVector start,
-                                                const ControlVector end,
-                                                const double duration) {
+template <class Model>
+QuinticPolynomial
+BasicSplineGenerator<Model>::get_x_spline(const ControlVector start,
+                                          const ControlVector end,
+                                          const double duration) {
   // break the starting/goal velocities and accels into their
   // axis-specific components
   double s_x = start.pose.x;
@@ -656,9 +1131,11 @@ QuinticPolynomial SplineGenerator::get_x_spline(const ControlVector start,
   return QuinticPolynomial(s_x, s_vx, s_ax, g_x, g_vx, g_ax, duration);
 }
 
-QuinticPolynomial SplineGenerator::get_y_spline(const ControlVector start,
-                                                const ControlVector end,
-                                                const double duration) {
+template <class Model>
+QuinticPolynomial
+BasicSplineGenerator<Model>::get_y_spline(const ControlVector start,
+                                          const ControlVector end,
+                                          const double duration) {
   // break the starting/goal velocities and accels into their
   // axis-specific components
   double s_y = start.pose.y;
@@ -678,4 +1155,8 @@ QuinticPolynomial SplineGenerator::get_y_spline(const ControlVector start,
 
   return QuinticPolynomial(s_y, s_vy, s_ay, g_y, g_vy, g_ay, duration);
 }
+
+template class BasicSplineGenerator<PhysicalModel>;
+template class BasicSplineGenerator<TankModel>;
+template class BasicSplineGenerator<PassthroughModel>;
 } // namespace squiggles
@@ -0,0 +1,187 @@
+/**
+ * Copyright 2020 Jonathan Bayless
+ *
+ * Use of this source code is governed by an MIT-style license that can be found
+ * in the LICENSE file or at https://opensource.org/licenses/MIT.
+ */
+#include "splinestream.hpp"
+
+namespace squiggles {
+template <class Model>
+BasicSplineStream<Model>::BasicSplineStream(Constraints iconstraints,
+                                            std::shared_ptr<Model> imodel,
+                                            double idt,
+                                            unsigned int ithreads)
+  : generator(iconstraints, imodel, idt, ithreads) {}
+
+template <class Model> BasicSplineStream<Model>::~BasicSplineStream() {
+  cancel();
+}
+
+template <class Model>
+void BasicSplineStream<Model>::start(const std::vector<Pose>& iwaypoints,
+                                     bool ifast) {
+  std::vector<ControlVector> vectors;
+  vectors.reserve(iwaypoints.size());
+  for (const auto& p : iwaypoints) {
+    vectors.emplace_back(ControlVector(p));
+  }
+  start(vectors, ifast);
+}
+
+template <class Model>
+void BasicSplineStream<Model>::start(
+  const std::vector<ControlVector>& iwaypoints,
+  bool ifast) {
+  cancel();
+  waypoints = iwaypoints;
+  fast = ifast;
+  cancelled = false;
+  error = nullptr;
+  end_time = 0.0;
+  if (segment_count() == 0) {
+    return;
+  }
+
+  // The first segment is generated here so it can be followed straight away
+  Trajectory first;
+  if (!spare.empty()) {
+    first = std::move(spare.back());
+    spare.pop_back();
+  }
+  if (!generate_next(first)) {
+    waypoints.clear();
+    std::rethrow_exception(error);
+  }
+  ready.push_back(std::move(first));
+  generated = 1;
+
+#ifndef __EMSCRIPTEN__
+  if (generated < segment_count()) {
+    worker = std::thread(&BasicSplineStream::run, this);
+  }
+#endif
+}
+
+template <class Model> bool BasicSplineStream<Model>::next(Trajectory& out) {
+  std::unique_lock<std::mutex> lock(mutex);
+  if (returned >= segment_count()) {
+    return false;
+  }
+
+  // Without a background thread the segments are generated as they are needed
+  if (ready.empty() && !worker.joinable() && !error) {
+    Trajectory segment;
+    if (!spare.empty()) {
+      segment = std::move(spare.back());
+      spare.pop_back();
+    }
+    lock.unlock();
+    const bool ok = generate_next(segment);
+    lock.lock();
+    if (ok) {
+      ready.push_back(std::move(segment));
+      ++generated;
+    }
+  }
+
+  ready_cv.wait(lock, [this] { return !ready.empty() || error || cancelled; });
+  if (ready.empty()) {
+    returned = segment_count();
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    return false;
+  }
+  std::swap(out, ready.front());
+  spare.push_back(std::move(ready.front()));
+  ready.pop_front();
+  ++returned;
+  return true;
+}
+
+template <class Model> void BasicSplineStream<Model>::cancel() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    cancelled = true;
+  }
+  ready_cv.notify_all();
+  if (worker.joinable()) {
+    worker.join();
+  }
+  for (auto& segment : ready) {
+    spare.push_back(std::move(segment));
+  }
+  ready.clear();
+  waypoints.clear();
+  generated = 0;
+  returned = 0;
+}
+
+template <class Model>
+std::size_t BasicSplineStream<Model>::segment_count() const {
+  return waypoints.size() < 2 ? 0 : waypoints.size() - 1;
+}
+
+template <class Model> std::size_t BasicSplineStream<Model>::remaining() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return segment_count() - returned;
+}
+
+template <class Model> void BasicSplineStream<Model>::run() {
+  for (;;) {
+    Trajectory segment;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (cancelled || generated >= segment_count()) {
+        return;
+      }
+      if (!spare.empty()) {
+        segment = std::move(spare.back());
+        spare.pop_back();
+      }
+    }
+    if (!generate_next(segment)) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ready.push_back(std::move(segment));
+      ++generated;
+    }
+    ready_cv.notify_all();
+  }
+}
+
+template <class Model>
+bool BasicSplineStream<Model>::generate_next(Trajectory& out) {
+  std::size_t i;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cancelled || error) {
+      return false;
+    }
+    i = generated;
+  }
+
+  // Only one thread generates at a time, so the generator and end_time are not
+  // guarded
+  out.clear();
+  try {
+    end_time = generator.generate_segment(
+      waypoints[i], waypoints[i + 1], fast, end_time, out);
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      error = std::current_exception();
+    }
+    ready_cv.notify_all();
+    return false;
+  }
+  return true;
+}
+
+template class BasicSplineStream<PhysicalModel>;
+template class BasicSplineStream<TankModel>;
+template class BasicSplineStream<PassthroughModel>;
+} // namespace squiggles
@@ -0,0 +1,76 @@
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "batch.hpp"
+#include "spline.hpp"
+
+using namespace squiggles;
+
+static std::vector<double> batch_requests() {
+  const double nan = std::nan("");
+  return {0, 0, 1, nan, 2, 2, 1, nan, 2.0, 2.0, 10.0, 0.4,
+          0, 0, 0, nan, 3, 1, 0, nan, 2.0, 2.0, 10.0, 0.4,
+          1, 2, 0, 0.5, 4, 0, -1, nan, 1.5, 3.0, 8.0, 0.3};
+}
+
+TEST(batch_test, matches_generate) {
+  auto requests = batch_requests();
+  const std::size_t count = requests.size() / BATCH_REQUEST_FIELDS;
+  std::vector<double> states(10000 * BATCH_STATE_FIELDS);
+  std::vector<std::uint32_t> offsets(count + 1);
+  ASSERT_EQ(squiggles_generate_batch(requests.data(),
+                                     count,
+                                     0.1,
+                                     2,
+                                     states.data(),
+                                     10000,
+                                     offsets.data()),
+            0);
+
+  for (std::size_t i = 0; i < count; ++i) {
+    const double* r = requests.data() + i * BATCH_REQUEST_FIELDS;
+    auto constraints = Constraints(r[8], r[9], r[10]);
+    auto spline = SplineGenerator(
+      constraints, std::make_shared<TankModel>(r[11], constraints));
+    auto expected =
+      spline.generate({ControlVector(Pose(r[0], r[1], r[2]), r[3]),
+                       ControlVector(Pose(r[4], r[5], r[6]), r[7])});
+    ASSERT_EQ(offsets[i + 1] - offsets[i], expected.size());
+    for (std::size_t s = 0; s < expected.size(); ++s) {
+      const double* row =
+        states.data() + (offsets[i] + s) * BATCH_STATE_FIELDS;
+      ASSERT_EQ(row[0], expected[s].vector.pose.x);
+      ASSERT_EQ(row[3], expected[s].vector.vel);
+      ASSERT_EQ(row[7], expected[s].time);
+      ASSERT_EQ(row[9], expected[s].wheel_velocities[1]);
+    }
+  }
+}
+
+TEST(batch_test, reports_failures_and_small_buffers) {
+  auto requests = batch_requests();
+  // far enough that no duration can meet the constraints
+  requests[BATCH_REQUEST_FIELDS + 4] = 1000;
+  const std::size_t count = requests.size() / BATCH_REQUEST_FIELDS;
+  std::vector<std::uint32_t> offsets(count + 1);
+
+  std::vector<double> small(BATCH_STATE_FIELDS);
+  ASSERT_EQ(squiggles_generate_batch(
+              requests.data(), count, 0.1, 1, small.data(), 1, offsets.data()),
+            -1);
+  ASSERT_GT(offsets[count], 1u);
+
+  std::vector<double> states(offsets[count] * BATCH_STATE_FIELDS);
+  ASSERT_EQ(squiggles_generate_batch(requests.data(),
+                                     count,
+                                     0.1,
+                                     1,
+                                     states.data(),
+                                     offsets[count],
+                                     offsets.data()),
+            1);
+  ASSERT_EQ(offsets[1], offsets[2]);
+  ASSERT_GT(offsets[3], offsets[2]);
+}
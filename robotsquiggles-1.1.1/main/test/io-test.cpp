@@ -1,3 +1,7 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
 #include "gtest/gtest.h"
 
 #include "io.hpp"
@@ -1611,3 +1615,234 @@ TEST(io_test, pathfinder) {
     ASSERT_EQ(path.value()[i], pathfinder_path[i]);
   }
 }
+
+TEST(io_test, binary_round_trip) {
+  auto constraints = Constraints(20.0, 2.0, 10.0);
+  auto model = std::make_shared<TankModel>(0.4, constraints);
+  auto spline = SplineGenerator(constraints, model);
+  Trajectory path;
+  spline.generate({ControlVector(Pose(0, 0, 1), 1.0, 2.0),
+                   ControlVector(Pose(2, 2, 1), 1.0, -2.0)},
+                  path);
+  std::stringstream stream;
+  ASSERT_EQ(serialize_binary_path(stream, path), 0);
+
+  auto parsed_path = deserialize_binary_path(stream);
+  ASSERT_TRUE(parsed_path.has_value());
+  ASSERT_EQ(parsed_path->to_profile_points(), path.to_profile_points());
+
+  // the same bytes can be used in place once they are 8 byte aligned
+  const auto bytes = stream.str();
+  std::vector<double> aligned(bytes.size() / sizeof(double) + 1);
+  memcpy(aligned.data(), bytes.data(), bytes.size());
+  auto view = view_binary_path(aligned.data(), bytes.size());
+  ASSERT_TRUE(view.has_value());
+  ASSERT_EQ(view->size, path.size());
+  ASSERT_EQ(view->wheel_count, 2u);
+  for (std::size_t i = 0; i < path.size(); ++i) {
+    ASSERT_EQ(view->point(i), path.point(i));
+  }
+
+  // truncated content is rejected
+  ASSERT_FALSE(view_binary_path(aligned.data(), bytes.size() - 8));
+  std::istringstream truncated(bytes.substr(0, bytes.size() - 8));
+  ASSERT_FALSE(deserialize_binary_path(truncated));
+}
+
+TEST(io_test, binary_rejects_bad_header) {
+  std::istringstream csv(example_path);
+  std::stringstream binary;
+  ASSERT_EQ(csv_to_binary_path(csv, binary), 0);
+  auto bytes = binary.str();
+  bytes[0] = 'X';
+  std::istringstream corrupted(bytes);
+  ASSERT_FALSE(deserialize_binary_path(corrupted));
+}
+
+/**
+ * A stream buffer over a string that cannot seek, like a pipe.
+ */
+struct UnseekableBuffer : std::streambuf {
+  explicit UnseekableBuffer(std::string ibytes) : bytes(std::move(ibytes)) {
+    setg(&bytes[0], &bytes[0], &bytes[0] + bytes.size());
+  }
+
+  std::string bytes;
+};
+
+TEST(io_test, binary_rejects_oversized_header) {
+  std::istringstream csv(example_path);
+  std::stringstream binary;
+  ASSERT_EQ(csv_to_binary_path(csv, binary), 0);
+  auto bytes = binary.str();
+  // claim far more states than the stream holds
+  const std::uint64_t size = std::uint64_t(1) << 40;
+  memcpy(&bytes[8], &size, sizeof(size));
+
+  std::istringstream seekable(bytes);
+  ASSERT_FALSE(deserialize_binary_path(seekable));
+
+  UnseekableBuffer buffer(bytes);
+  std::istream unseekable(&buffer);
+  ASSERT_FALSE(deserialize_binary_path(unseekable));
+}
+
+TEST(io_test, binary_reads_unseekable_stream) {
+  std::istringstream csv(example_path);
+  std::stringstream binary;
+  ASSERT_EQ(csv_to_binary_path(csv, binary), 0);
+  std::istringstream seekable(binary.str());
+  auto expected = deserialize_binary_path(seekable);
+  ASSERT_TRUE(expected.has_value());
+
+  UnseekableBuffer buffer(binary.str());
+  std::istream unseekable(&buffer);
+  auto parsed = deserialize_binary_path(unseekable);
+  ASSERT_TRUE(parsed.has_value());
+  ASSERT_EQ(parsed->to_profile_points(), expected->to_profile_points());
+}
+
+TEST(io_test, binary_csv_conversion) {
+  std::istringstream csv(example_path);
+  std::stringstream binary;
+  ASSERT_EQ(csv_to_binary_path(csv, binary), 0);
+  std::stringstream round_trip;
+  ASSERT_EQ(binary_to_csv_path(binary, round_trip), 0);
+  ASSERT_STREQ(round_trip.str().c_str(), example_path.c_str());
+}
+
+TEST(io_test, binary_pathfinder_conversion) {
+  std::stringstream left_stream(left);
+  std::stringstream right_stream(right);
+  std::stringstream binary;
+  ASSERT_EQ(pathfinder_to_binary_path(left_stream, right_stream, binary), 0);
+  auto path = deserialize_binary_path(binary);
+  ASSERT_TRUE(path.has_value());
+  ASSERT_EQ(path->size(), pathfinder_path.size());
+  for (std::size_t i = 0; i < path->size(); ++i) {
+    ASSERT_EQ(path->point(i), pathfinder_path[i]);
+  }
+}
+
+TEST(io_test, mapped_binary_file) {
+  std::istringstream csv(example_path);
+  const std::string filename = testing::TempDir() + "squiggles_mapped.sqgt";
+  {
+    std::ofstream file(filename, std::ios::binary);
+    ASSERT_EQ(csv_to_binary_path(csv, file), 0);
+  }
+  auto mapped = MappedTrajectory::open(filename);
+  ASSERT_TRUE(mapped.has_value());
+  std::istringstream expected_csv(example_path);
+  auto expected = deserialize_path(expected_csv);
+  ASSERT_EQ(mapped->view().to_profile_points(), expected.value());
+
+  auto moved = std::move(*mapped);
+  ASSERT_EQ(moved.view().size, expected->size());
+  ASSERT_EQ(mapped->view().size, 0u);
+  std::remove(filename.c_str());
+
+  ASSERT_FALSE(MappedTrajectory::open(filename));
+}
+
+/**
+ * Checks that two paths hold exactly the same values, as from_chars and stod
+ * both round to the nearest double.
+ */
+static void expect_same_columns(const TrajectoryView& a,
+                                const TrajectoryView& b) {
+  ASSERT_EQ(a.size, b.size);
+  ASSERT_EQ(a.wheel_count, b.wheel_count);
+  for (std::size_t i = 0; i < a.size; ++i) {
+    ASSERT_EQ(a.x[i], b.x[i]);
+    ASSERT_EQ(a.y[i], b.y[i]);
+    ASSERT_EQ(a.yaw[i], b.yaw[i]);
+    ASSERT_EQ(a.vel[i], b.vel[i]);
+    ASSERT_EQ(a.accel[i], b.accel[i]);
+    ASSERT_EQ(a.jerk[i], b.jerk[i]);
+    ASSERT_EQ(a.curvature[i], b.curvature[i]);
+    ASSERT_EQ(a.time[i], b.time[i]);
+    for (std::size_t w = 0; w < a.wheel_count; ++w) {
+      ASSERT_EQ(a.wheel_velocity(i, w), b.wheel_velocity(i, w));
+    }
+  }
+}
+
+/**
+ * Repeats the lines after the header until the CSV data is long enough to be
+ * split across several threads.
+ */
+static std::string repeat_body(const std::string& csv, std::size_t bytes) {
+  const auto body_start = csv.find('\n') + 1;
+  std::string out = csv;
+  while (out.size() < bytes) {
+    out.append(csv, body_start, std::string::npos);
+  }
+  return out;
+}
+
+TEST(io_test, parse_path) {
+  std::istringstream stream(example_path);
+  const Trajectory expected(deserialize_path(stream).value());
+  for (unsigned int threads : {1u, 4u}) {
+    auto path = parse_path(std::string_view(example_path), threads);
+    ASSERT_TRUE(path.has_value());
+    expect_same_columns(path->view(), expected.view());
+  }
+
+  auto constraints = Constraints(20.0, 2.0, 10.0);
+  auto model = std::make_shared<TankModel>(0.4, constraints);
+  auto spline = SplineGenerator(constraints, model);
+  auto points = spline.generate({ControlVector(Pose(0, 0, 1), 1.0, 2.0),
+                                 ControlVector(Pose(2, 2, 1), 1.0, -2.0)});
+  std::stringstream wheel_stream;
+  ASSERT_EQ(serialize_path(wheel_stream, points), 0);
+  auto path = parse_path(wheel_stream);
+  ASSERT_TRUE(path.has_value());
+  ASSERT_EQ(path->wheels_per_state(), 2u);
+  ASSERT_EQ(path->to_profile_points(), points);
+
+  // only the header is an empty path, a line that is not numbers is rejected
+  ASSERT_TRUE(parse_path(std::string_view("x, y\n"))->empty());
+  ASSERT_FALSE(parse_path(std::string_view("x\n1,2,3,4,5,6,7,oops\n")));
+  ASSERT_FALSE(parse_path(std::string_view("x\n1,2,3\n")));
+}
+
+TEST(io_test, parse_path_chunks) {
+  const std::string csv = repeat_body(example_path, 512 * 1024);
+  std::istringstream stream(csv);
+  const Trajectory expected(deserialize_path(stream).value());
+  auto path = parse_path(std::string_view(csv), 4);
+  ASSERT_TRUE(path.has_value());
+  expect_same_columns(path->view(), expected.view());
+
+  // a malformed line in any chunk fails the whole path
+  std::string corrupted = csv;
+  corrupted[corrupted.size() * 3 / 4] = 'x';
+  ASSERT_FALSE(parse_path(std::string_view(corrupted), 4));
+}
+
+TEST(io_test, parse_pathfinder_path) {
+  auto path = parse_pathfinder_path(std::string_view(left),
+                                    std::string_view(right),
+                                    1);
+  ASSERT_TRUE(path.has_value());
+  ASSERT_EQ(path->to_profile_points(), pathfinder_path);
+
+  const std::string long_left = repeat_body(left, 512 * 1024);
+  const std::string long_right = repeat_body(right, 512 * 1024);
+  std::istringstream left_stream(long_left);
+  std::istringstream right_stream(long_right);
+  const Trajectory expected(
+    deserialize_pathfinder_path(left_stream, right_stream).value());
+  auto long_path = parse_pathfinder_path(
+    std::string_view(long_left), std::string_view(long_right), 4);
+  ASSERT_TRUE(long_path.has_value());
+  expect_same_columns(long_path->view(), expected.view());
+
+  // the right wheels cannot have fewer states than the left
+  ASSERT_FALSE(parse_pathfinder_path(std::string_view(long_left),
+                                     std::string_view(right)));
+  ASSERT_FALSE(parse_pathfinder_path(std::string_view(""),
+                                     std::string_view(right)));
+}
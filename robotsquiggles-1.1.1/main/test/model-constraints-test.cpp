@@ -5,6 +5,7 @@
 #include "shared.hpp"
 #include "gtest/gtest.h"
 
+#include "physicalmodel/passthroughmodel.hpp"
 #include "physicalmodel/tankmodel.hpp"
 #include "spline.hpp"
 
@@ -74,3 +75,17 @@ TEST(model_constraints_test, smooth_arc) {
     // std::cout << p.to_string() << std::endl;
   }
 }
+
+TEST(model_constraints_test, wheel_velocities_inline) {
+  auto model = TankModel(0.4, Constraints(2.0));
+  auto wheels = model.linear_to_wheel_vels(1.0, 1.0);
+  ASSERT_EQ(wheels.size(), 2u);
+  ASSERT_NEAR(wheels[0], 0.8, TEST_EPSILON);
+  ASSERT_NEAR(wheels[1], 1.2, TEST_EPSILON);
+
+  ASSERT_TRUE(PassthroughModel().linear_to_wheel_vels(1.0, 1.0).empty());
+
+  const double many[] = {1, 2, 3, 4, 5, 6};
+  ASSERT_EQ(WheelVelocities(many, many + 6).size(),
+            WheelVelocities::MAX_WHEELS);
+}
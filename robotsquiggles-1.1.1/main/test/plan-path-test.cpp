@@ -65,3 +65,85 @@ TEST(plan_path_test, three_points_zero) {
     prev_time = p.time;
   }
 }
+
+TEST(plan_path_test, reused_generator_matches_fresh) {
+  auto spline = SplineGenerator(Constraints(2.0, 2.0, 10.0));
+  std::vector<Pose> long_leg = {Pose(0, 0, 1), Pose(1, 1, 1), Pose(2, 2, 1)};
+  std::vector<Pose> short_leg = {Pose(0, 0, 0), Pose(1, 0.5, 0.5)};
+  std::vector<ProfilePoint> path;
+  spline.generate(long_leg, path);
+  const auto capacity = path.capacity();
+  const auto* data = path.data();
+
+  spline.generate(short_leg, path);
+  auto fresh = SplineGenerator(Constraints(2.0, 2.0, 10.0)).generate(short_leg);
+  ASSERT_EQ(path.size(), fresh.size());
+  for (std::size_t i = 0; i < path.size(); ++i) {
+    ASSERT_EQ(path[i], fresh[i]);
+  }
+  ASSERT_EQ(path.capacity(), capacity);
+  ASSERT_EQ(path.data(), data);
+}
+
+TEST(plan_path_test, sweep_matches_point_lookup) {
+  auto spline = SplineGenerator(Constraints(2.0, 2.0, 10.0));
+  const auto start = ControlVector(Pose(0, 0, 1), 1.0, 0.0);
+  const auto end = ControlVector(Pose(2, 2, 1), 1.0, 0.0);
+  std::vector<ProfilePoint> points;
+  for (int i = 0; i <= 20; ++i) {
+    points.emplace_back(ControlVector(Pose(0.1 * i, 0.1 * i, 1), 1.0, 0.0),
+                        std::vector<double>{1.0},
+                        0.0,
+                        0.14 * i);
+  }
+  const auto duration = points.back().time;
+  const auto x_qp = spline.get_x_spline(start, end, duration);
+  const auto y_qp = spline.get_y_spline(start, end, duration);
+  std::size_t cursor = 1;
+  for (double t = -0.05; t < duration + 0.1; t += 0.05) {
+    ASSERT_EQ(spline.get_point_at_time(x_qp, y_qp, points, t, cursor),
+              spline.get_point_at_time(start, end, points, t));
+  }
+}
+
+TEST(plan_path_test, parallel_durations_match_sequential) {
+  const auto constraints = Constraints(20.0, 2.0, 10.0);
+  auto model = std::make_shared<PassthroughModel>();
+  auto sequential = SplineGenerator(constraints, model, 0.01, 1);
+  auto parallel = SplineGenerator(constraints, model, 0.01, 4);
+  for (double x = 1.0; x < 6.0; x += 1.0) {
+    const auto start = ControlVector(Pose(0, 0, 1), 1.0, 0.0);
+    const auto end = ControlVector(Pose(x, 2, 0.5), 1.0, 0.0);
+    auto expected = sequential.generate({start, end});
+    auto path = parallel.generate({start, end});
+    ASSERT_EQ(path.size(), expected.size());
+    for (std::size_t i = 0; i < path.size(); ++i) {
+      ASSERT_EQ(path[i], expected[i]);
+    }
+  }
+}
+
+TEST(plan_path_test, static_model_matches_runtime_model) {
+  const auto constraints = Constraints(2.0, 2.0, 10.0);
+  auto model = std::make_shared<TankModel>(0.4, constraints);
+  auto runtime = SplineGenerator(constraints, model, 0.05);
+  auto compiled = BasicSplineGenerator<TankModel>(constraints, model, 0.05);
+  std::vector<Pose> waypoints = {Pose(0, 0, 1), Pose(1, 1, 1), Pose(2, 2, 1)};
+  auto expected = runtime.generate(waypoints);
+  auto path = compiled.generate(waypoints);
+  ASSERT_EQ(path.size(), expected.size());
+  for (std::size_t i = 0; i < path.size(); ++i) {
+    ASSERT_EQ(path[i], expected[i]);
+  }
+}
+
+TEST(plan_path_test, straight_with_velocities) {
+  // a straight segment has no curvature, which must not count against it
+  auto spline = SplineGenerator(Constraints(0.26, 0.43, 1.0));
+  auto path = spline.generate({ControlVector(Pose(0, 0, 0), 0.26),
+                               ControlVector(Pose(0.4, 0, 0), 0.26)});
+  ASSERT_NEAR(path.back().vector.pose.x, 0.4, TEST_EPSILON);
+  for (const auto& point : path) {
+    ASSERT_NEAR(point.vector.pose.y, 0, TEST_EPSILON);
+  }
+}
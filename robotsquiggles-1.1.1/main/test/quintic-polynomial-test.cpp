@@ -0,0 +1,63 @@
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "math/quinticpolynomial.hpp"
+
+using namespace squiggles;
+
+// Horner evaluation rounds differently from the expanded powers
+static constexpr double HORNER_EPSILON = 1e-9;
+
+TEST(quintic_polynomial_test, calc_all_matches_scalar) {
+  const QuinticPolynomial qp(0.5, 1.2, -0.3, 4.0, 0.0, 0.0, 3.7);
+  std::vector<double> t;
+  for (int i = 0; i <= 100; ++i) {
+    t.push_back(i * 0.037);
+  }
+  std::vector<double> p(t.size()), v(t.size()), a(t.size()), j(t.size());
+  qp.calc_all(t.data(), t.size(), {p.data(), v.data(), a.data(), j.data()});
+
+  for (std::size_t i = 0; i < t.size(); ++i) {
+    EXPECT_NEAR(p[i], qp.calc_point(t[i]), HORNER_EPSILON);
+    EXPECT_NEAR(v[i], qp.calc_first_derivative(t[i]), HORNER_EPSILON);
+    EXPECT_NEAR(a[i], qp.calc_second_derivative(t[i]), HORNER_EPSILON);
+    EXPECT_NEAR(j[i], qp.calc_third_derivative(t[i]), HORNER_EPSILON);
+  }
+}
+
+TEST(quintic_polynomial_test, calc_all_pair_matches_each) {
+  const QuinticPolynomial x(0.0, 0.0, 0.0, 2.0, 1.0, 0.0, 2.0);
+  const QuinticPolynomial y(1.0, -0.5, 0.2, -3.0, 0.0, 0.1, 2.0);
+  const std::vector<double> t = {0.0, 0.1, 0.5, 1.0, 1.9, 2.0, 2.5};
+  const std::size_t n = t.size();
+
+  std::vector<double> xs(4 * n), ys(4 * n), xe(4 * n), ye(4 * n);
+  QuinticPolynomial::calc_all(
+    x,
+    y,
+    t.data(),
+    n,
+    {&xs[0], &xs[n], &xs[2 * n], &xs[3 * n]},
+    {&ys[0], &ys[n], &ys[2 * n], &ys[3 * n]});
+  x.calc_all(t.data(), n, {&xe[0], &xe[n], &xe[2 * n], &xe[3 * n]});
+  y.calc_all(t.data(), n, {&ye[0], &ye[n], &ye[2 * n], &ye[3 * n]});
+
+  EXPECT_EQ(xs, xe);
+  EXPECT_EQ(ys, ye);
+}
+
+TEST(quintic_polynomial_test, calc_all_meets_boundary_conditions) {
+  const QuinticPolynomial qp(1.0, 0.5, 0.0, 3.0, -0.5, 0.2, 2.5);
+  const double t[2] = {0.0, 2.5};
+  double p[2], v[2], a[2], j[2];
+  qp.calc_all(t, 2, {p, v, a, j});
+
+  EXPECT_NEAR(p[0], 1.0, HORNER_EPSILON);
+  EXPECT_NEAR(v[0], 0.5, HORNER_EPSILON);
+  EXPECT_NEAR(a[0], 0.0, HORNER_EPSILON);
+  EXPECT_NEAR(p[1], 3.0, HORNER_EPSILON);
+  EXPECT_NEAR(v[1], -0.5, HORNER_EPSILON);
+  EXPECT_NEAR(a[1], 0.2, HORNER_EPSILON);
+}
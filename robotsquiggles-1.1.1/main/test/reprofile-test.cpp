@@ -0,0 +1,105 @@
+#include "gtest/gtest.h"
+
+#include "physicalmodel/tankmodel.hpp"
+#include "spline.hpp"
+
+using namespace squiggles;
+
+static const std::vector<Pose> TOUR = {Pose(0, 0, 1),
+                                       Pose(2, 2, 1),
+                                       Pose(4, 2, 0),
+                                       Pose(5, 0, -1.5),
+                                       Pose(3, -2, 3.1)};
+
+TEST(reprofile_test, kept_geometry_matches_generate) {
+  auto constraints = Constraints(2.0, 2.0, 10.0);
+  auto model = std::make_shared<TankModel>(0.4, constraints);
+  auto expected = SplineGenerator(constraints, model).generate(TOUR);
+
+  auto generator = SplineGenerator(constraints, model);
+  SplineGenerator::GeometricPath geometry;
+  std::vector<ProfilePoint> path;
+  generator.generate(TOUR, geometry, path);
+  ASSERT_EQ(path, expected);
+  ASSERT_EQ(geometry.segments.size(), TOUR.size() - 1);
+  ASSERT_EQ(geometry.segments.back().first + geometry.segments.back().count,
+            path.size());
+
+  // Without zones the profile comes out as it went in
+  generator.reprofile(geometry, {}, 0.0, geometry.length(), path);
+  ASSERT_EQ(path, expected);
+}
+
+TEST(reprofile_test, zone_caps_only_its_segments) {
+  auto constraints = Constraints(2.0, 2.0, 10.0);
+  auto model = std::make_shared<TankModel>(0.4, constraints);
+  auto generator = SplineGenerator(constraints, model);
+  SplineGenerator::GeometricPath geometry;
+  std::vector<ProfilePoint> path;
+  generator.generate(TOUR, geometry, path);
+  const auto before = path;
+  const auto segments = geometry.segments;
+
+  // A slow zone inside the third segment
+  const auto& third = geometry.segments[2];
+  const double length = third.states.back().distance;
+  const double from = third.start_distance + 0.25 * length;
+  const double to = third.start_distance + 0.75 * length;
+  const std::vector<SpeedZone> zones = {SpeedZone(from, to, 0.3)};
+  generator.reprofile(geometry, zones, from, to, path);
+
+  // The segments before it are untouched
+  for (std::size_t i = 0; i < segments[2].first; ++i) {
+    ASSERT_EQ(path[i], before[i]);
+  }
+  // The zone is driven no faster than its limit and the segment takes longer
+  const auto& slowed = geometry.segments[2];
+  ASSERT_GT(slowed.duration, segments[2].duration);
+  for (const auto& state : slowed.states) {
+    const double distance = slowed.start_distance + state.distance;
+    if (distance >= from && distance <= to) {
+      ASSERT_LE(state.max_vel, 0.3 + 1e-9);
+    }
+  }
+  // The last segment keeps its states, later by the time the zone added
+  const double offset = slowed.duration - segments[2].duration;
+  const auto& last = geometry.segments[3];
+  ASSERT_EQ(last.count, segments[3].count);
+  ASSERT_EQ(last.first + last.count, path.size());
+  for (std::size_t i = 0; i < last.count; ++i) {
+    const auto& moved = path[last.first + i];
+    const auto& original = before[segments[3].first + i];
+    ASSERT_EQ(moved.vector, original.vector);
+    ASSERT_NEAR(moved.time, original.time + offset, 1e-9);
+  }
+
+  // Lifting the zone brings back the first profile
+  generator.reprofile(geometry, {}, from, to, path);
+  ASSERT_EQ(path.size(), before.size());
+  for (std::size_t i = 0; i < path.size(); ++i) {
+    ASSERT_EQ(path[i].vector, before[i].vector);
+    ASSERT_NEAR(path[i].time, before[i].time, 1e-9);
+  }
+}
+
+TEST(reprofile_test, trajectory_matches_points) {
+  auto constraints = Constraints(2.0, 2.0, 10.0);
+  auto model = std::make_shared<TankModel>(0.4, constraints);
+  auto generator = SplineGenerator(constraints, model);
+  SplineGenerator::GeometricPath point_geometry;
+  SplineGenerator::GeometricPath trajectory_geometry;
+  std::vector<ProfilePoint> points;
+  Trajectory trajectory;
+  generator.generate(TOUR, point_geometry, points);
+  generator.generate(TOUR, trajectory_geometry, trajectory);
+
+  // A zone over the end of the first segment and the start of the second
+  const double boundary = point_geometry.segments[1].start_distance;
+  const std::vector<SpeedZone> zones = {
+    SpeedZone(boundary - 0.5, boundary + 0.5, 0.5)};
+  generator.reprofile(
+    point_geometry, zones, boundary - 0.5, boundary + 0.5, points);
+  generator.reprofile(
+    trajectory_geometry, zones, boundary - 0.5, boundary + 0.5, trajectory);
+  ASSERT_EQ(trajectory.to_profile_points(), points);
+}
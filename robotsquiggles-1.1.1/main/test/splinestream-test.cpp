@@ -0,0 +1,59 @@
+#include "gtest/gtest.h"
+
+#include "physicalmodel/tankmodel.hpp"
+#include "spline.hpp"
+#include "splinestream.hpp"
+
+using namespace squiggles;
+
+static const std::vector<Pose> TOUR = {Pose(0, 0, 1),
+                                       Pose(2, 2, 1),
+                                       Pose(4, 2, 0),
+                                       Pose(5, 0, -1.5),
+                                       Pose(3, -2, 3.1)};
+
+TEST(splinestream_test, segments_match_generate) {
+  auto constraints = Constraints(2.0, 2.0, 10.0);
+  auto model = std::make_shared<TankModel>(0.4, constraints);
+  auto expected = SplineGenerator(constraints, model).generate(TOUR);
+
+  auto stream = SplineStream(constraints, model);
+  stream.start(TOUR);
+  ASSERT_EQ(stream.segment_count(), TOUR.size() - 1);
+  ASSERT_EQ(stream.remaining(), TOUR.size() - 1);
+
+  std::vector<ProfilePoint> streamed;
+  Trajectory segment;
+  std::size_t segments = 0;
+  while (stream.next(segment)) {
+    auto points = segment.to_profile_points();
+    streamed.insert(streamed.end(), points.begin(), points.end());
+    ++segments;
+  }
+  ASSERT_EQ(segments, TOUR.size() - 1);
+  ASSERT_EQ(stream.remaining(), 0u);
+  ASSERT_EQ(streamed, expected);
+}
+
+TEST(splinestream_test, restart_cancels_previous_path) {
+  auto constraints = Constraints(2.0, 2.0, 10.0);
+  auto model = std::make_shared<TankModel>(0.4, constraints);
+  auto generator = BasicSplineGenerator<TankModel>(constraints, model);
+  std::vector<Pose> leg = {TOUR[2], TOUR[3]};
+  auto expected = generator.generate(leg);
+
+  auto stream = BasicSplineStream<TankModel>(constraints, model);
+  Trajectory segment;
+  stream.start(TOUR);
+  ASSERT_TRUE(stream.next(segment));
+
+  stream.start(leg);
+  ASSERT_EQ(stream.segment_count(), 1u);
+  ASSERT_TRUE(stream.next(segment));
+  ASSERT_EQ(segment.to_profile_points(), expected);
+  ASSERT_FALSE(stream.next(segment));
+
+  stream.cancel();
+  ASSERT_EQ(stream.segment_count(), 0u);
+  ASSERT_FALSE(stream.next(segment));
+}
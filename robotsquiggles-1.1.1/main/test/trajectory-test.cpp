@@ -0,0 +1,47 @@
+#include "gtest/gtest.h"
+
+#include "geometry/trajectory.hpp"
+#include "physicalmodel/tankmodel.hpp"
+#include "spline.hpp"
+
+using namespace squiggles;
+
+TEST(trajectory_test, round_trip_profile_points) {
+  std::vector<ProfilePoint> points = {
+    ProfilePoint(ControlVector(Pose(0, 0, 1), 1.0, 2.0, 0.0), {0.8, 1.2}, 0.5,
+                 0.0),
+    ProfilePoint(ControlVector(Pose(1, 2, 0.5), 1.5, -1.0, 3.0), {1.4, 1.6},
+                 0.1, 0.1),
+  };
+  auto trajectory = Trajectory(points);
+  ASSERT_EQ(trajectory.size(), 2u);
+  ASSERT_EQ(trajectory.wheels_per_state(), 2u);
+
+  const TrajectoryView view = trajectory;
+  ASSERT_DOUBLE_EQ(view.x[1], 1.0);
+  ASSERT_DOUBLE_EQ(view.vel[1], 1.5);
+  ASSERT_DOUBLE_EQ(view.wheel_velocity(1, 1), 1.6);
+  ASSERT_EQ(view.pose(1), Pose(1, 2, 0.5));
+  ASSERT_EQ(trajectory.to_profile_points(), points);
+}
+
+TEST(trajectory_test, generate_matches_profile_points) {
+  auto constraints = Constraints(2.0, 2.0, 10.0);
+  auto spline = SplineGenerator(constraints,
+                                std::make_shared<TankModel>(0.4, constraints));
+  std::vector<Pose> waypoints = {Pose(0, 0, 1), Pose(2, 2, 1)};
+  auto expected = spline.generate(waypoints);
+
+  Trajectory trajectory;
+  spline.generate(waypoints, trajectory);
+  ASSERT_EQ(trajectory.size(), expected.size());
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(trajectory.point(i), expected[i]);
+  }
+
+  // regenerating reuses the columns that are already allocated
+  const auto* x = trajectory.view().x;
+  spline.generate(waypoints, trajectory);
+  ASSERT_EQ(trajectory.view().x, x);
+  ASSERT_EQ(trajectory.size(), expected.size());
+}
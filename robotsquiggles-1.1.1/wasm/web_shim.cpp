@@ -81,4 +81,21 @@ int generate(double sx,
   // }
   return 0;
 }
+
+// Generates many paths into one buffer allocated by the caller on the wasm
+// heap, see squiggles_generate_batch for the layout of each argument. Returns
+// -2 without touching the buffers if count or capacity is negative, which
+// would otherwise wrap to a huge size_t.
+EMSCRIPTEN_KEEPALIVE
+int generate_batch(const double* requests,
+                   int count,
+                   double dt,
+                   double* states,
+                   int capacity,
+                   std::uint32_t* offsets) {
+  if (count < 0 || capacity < 0)
+    return -2;
+  return squiggles_generate_batch(
+    requests, count, dt, 1, states, capacity, offsets);
+}
 }
@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <numeric>
 #include <thread>
+#include <limits>
 
 
 using namespace std;
@@ -29,8 +30,15 @@ LaserProcessing::LaserProcessing(sensor_msgs::LaserScan laserScan):
 // Getter for distance and angle to the nearest obstacle
 std::pair<double, double> LaserProcessing::MinDistAngle() {
     std::pair<double, double> distAngle;
-    auto minElement = std::min_element(laserScan_.ranges.begin(), laserScan_.ranges.end());
-    distAngle.first = *minElement;
-    distAngle.second = std::distance(laserScan_.ranges.begin(), minElement) * laserScan_.angle_increment + laserScan_.angle_min;
+    // Every reading is considered, an empty scan reports no obstacle
+    scankernels::MinResult minElement = scankernels::maskedMin(laserScan_.ranges.data(), laserScan_.ranges.size(),
+                                                               -std::numeric_limits<float>::infinity());
+    if (minElement.index < 0) {
+        distAngle.first = std::numeric_limits<double>::infinity();
+        distAngle.second = 0.0;
+        return distAngle;
+    }
+    distAngle.first = minElement.value;
+    distAngle.second = minElement.index * laserScan_.angle_increment + laserScan_.angle_min;
     return distAngle;
 }
\ No newline at end of file
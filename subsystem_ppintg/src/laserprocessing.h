@@ -6,6 +6,7 @@
 #include <math.h>
 #include <iostream>
 #include <geometry_msgs/Twist.h>
+#include "scankernels.h"
 
 /*!
  *  \brief     Laser Processing Class
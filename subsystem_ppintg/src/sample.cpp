@@ -5,12 +5,16 @@
 #include <chrono>
 #include <time.h>
 #include <random>
+#include <boost/make_shared.hpp>
   
 //Default constructor of the sample class
-Sample::Sample(ros::NodeHandle nh) :
+Sample::Sample(ros::NodeHandle nh, ros::NodeHandle pnh) :
     //Setting the default value for some variables
-    nh_(nh), laserProcessingPtr_(nullptr), world_x(0.0), world_y(0.0)
+    nh_(nh), laserProcessingPtr_(nullptr), stopping_(false), threshold_distance_(0.15), numGoals_(5)
 {
+    pnh.param("num_goals", numGoals_, 5);
+    pnh.param("threshold_distance", threshold_distance_, 0.15);
+
     //Subscribing to the laser sensor
     sub_scan = nh_.subscribe("/scan", 100, &Sample::laserCallback,this);
     //Subscribing to odometry of the robot
@@ -18,11 +22,12 @@ Sample::Sample(ros::NodeHandle nh) :
     map_sub_ = nh_.subscribe("/map", 100, &Sample::mapCallback, this);
 
     goal_pub_ = nh_.advertise<geometry_msgs::PoseStamped>("/move_base_simple/goal", 1);
-    custompath_pub_ = nh_.advertise<geometry_msgs::Point>("/thepath", 10);
+    //The whole tour is one latched message, so a follower started later still receives it
+    custompath_pub_ = nh_.advertise<nav_msgs::Path>("/thepath", 1, true);
 
     //goals_pub_ = nh_.advertise<geometry_msgs::PoseStamped>("/randomgoals", 5);
 
-    make_plan_ = nh.serviceClient<nav_msgs::GetPlan>("/move_base/NavfnROS/make_plan");
+    navfn_ = NavfnPlanner(nh_, threshold_distance_);
   
   }
 
@@ -33,6 +38,11 @@ Sample::~Sample(){
     }
 }
 
+void Sample::stop()
+{
+    stopping_ = true;
+}
+
 //A callback for the laser scanner
 void Sample::laserCallback(const sensor_msgs::LaserScanConstPtr& msg)
 {
@@ -51,231 +61,67 @@ void Sample::odomCallback(const nav_msgs::OdometryConstPtr &msg)
 //A callback for map
 void Sample::mapCallback(const nav_msgs::OccupancyGrid::ConstPtr& msg)
 {
-         // Parse the map data
-        map_width_ = msg->info.width;
-        //std::cout << "Map Width: " << map_width_ << std::endl;
-        map_height_ = msg->info.height;
-        //std::cout << "Map Height: " << map_height_ << std::endl;
-        map_resolution_ = msg->info.resolution;
-        //std::cout << "Map Resolution: " << map_resolution_ << std::endl;
-        map_origin_x_ = msg->info.origin.position.x;
-        //std::cout << "Map Origin X: " << map_origin_x_ << std::endl;
-        map_origin_y_ = msg->info.origin.position.y;
-        //std::cout << "Map Origin Y: " << map_origin_y_ << std::endl;
-        map_data_ = msg->data;
-        //std::cout << "Map data provided." << std::endl;
-        // Generate a random goal point
+    // Keep the shared message, the grid is only parsed when goals are generated
+    std::unique_lock<std::mutex> lck(mapMtx_);
+    map_ = msg;
 }
 
 void Sample::generateRandomGoals()
 {
-    unordered_goals_.clear();
-    
-    geometry_msgs::Point start;
-    geometry_msgs::Point end;
-    std::vector<geometry_msgs::Point> waypts_simplified; // the vector created by plan between two Goals
-    for (int i=0; i<5; i++)
+    // Goals can only be generated once a map has been received
+    nav_msgs::OccupancyGrid::ConstPtr map;
+    while (ros::ok() && !stopping_)
     {
-        // push a random goal into the unordered_goals_ vector
-        generateRandomGoal();
-        //start = unordered_goals_[i].pose.position;
-        //std::cout << "unordered_goals_[ " << i << " ]: {" << start.x << " , " << start.y << "}." << std::endl; 
-        if(i==0)
         {
-            start.x = robotPose_.position.x; start.y = robotPose_.position.x; // as starting point is always (0,0)
-            end = unordered_goals_[i].pose.position;
+            std::unique_lock<std::mutex> lck(mapMtx_);
+            map = map_;
         }
-        else
-        {
-            start = unordered_goals_[i-1].pose.position;
-            end = unordered_goals_[i].pose.position;
-        }
-        
-        // for error checking
-        std::cout << "Start set: {" << start.x << " , " << start.y << "}." << std::endl; 
-        std::cout << "End set : {" << end.x << " , " << end.y << "}." << std::endl; 
-        
-        // find simplified path
-        waypts_simplified = planBetweenTwoGoals(start, end);
-        // publish to rostopic 'thepath'
-        publishPath(waypts_simplified);
-        std::cout << "Waypoints from Goal " << i << " to Goal " << (i+1) << " published to ROS Topic /thepath." << std::endl; 
+        if (map) break;
+        ROS_INFO_STREAM_THROTTLE(1.0, "Waiting for the map...");
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
+    if (!map || stopping_) return;
 
-            
-  
-        // // making vector of point msgs from start and end
- 
-
-
-
-    //  ADD TRAVELLING SALESMAN 
-
-        // geometry_msgs::PoseStamped goal_msg;
-        // goal_msg.pose.position.x = goal_point.x; // Set the goal position x-coordinate
-        // goal_msg.pose.position.y = goal_point.y; // Set the goal position y-coordinate
-        // goal_msg.pose.orientation.w = 1.0;
-        // goal_msg.header.stamp = ros::Time::now();
-        // goal_msg.header.frame_id = "map";
-        // //std::cout << "Goal about to be published." << std::endl;
-        // goal_pub_.publish(goal_msg);
-        // std::cout << "Goal published." << std::endl;
-
-}
-
-
-void Sample::publishPath(std::vector<geometry_msgs::Point> vec_of_simplified_waypts)
-{
-   for (const auto &point : vec_of_simplified_waypts)
+    geometry_msgs::Pose robotPose;
     {
-        custompath_pub_.publish(point);
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
+        std::unique_lock<std::mutex> lck(robotPoseMtx_);
+        robotPose = robotPose_;
     }
-    // wait half a sec
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-}
 
-
-
-std::vector<geometry_msgs::Point> Sample::planBetweenTwoGoals(geometry_msgs::Point st, geometry_msgs::Point en)
-{
-    std::vector<geometry_msgs::Point> points;
-  // Create a request message for the service
-    nav_msgs::GetPlan srv;
-    srv.request.start.header.frame_id = "map";
-    srv.request.start.pose.position.x = st.x;
-    srv.request.start.pose.position.y = st.y;
-    srv.request.start.pose.orientation.w = 1.0;
-
-    srv.request.goal.header.frame_id = "map";
-    srv.request.goal.pose.position.x = en.x;
-    srv.request.goal.pose.position.y = en.y;
-    srv.request.goal.pose.orientation.w = 1.0;
-
-    // Call the service - the statement within the if() calls the service with srv
-    if (make_plan_.call(srv)) {
-        if (!srv.response.plan.poses.empty())
-        {
-            ROS_INFO("Plan received with %ld poses", srv.response.plan.poses.size());
-            for (size_t i = 0; i < srv.response.plan.poses.size(); i += 10)
-            {   
-                points.push_back(srv.response.plan.poses[i].pose.position);
-                double x = srv.response.plan.poses[i].pose.position.x;
-                double y = srv.response.plan.poses[i].pose.position.y;
-                //std::cout << "Position: (" << x << " , " << y << ")." << std::endl; 
-            }
-            // if last point is not end point / goal
-            if(!(points.back()==en))
-            {
-                //std::cout << "Since point vector doesn't have end goal as last point, pushing it back." << std::endl; 
-                points.push_back(en);
-                //std::cout << "Position: (" << en.x << " , " << en.y << ")." << std::endl; 
-            }
-
-        } 
-        else 
-        {
-            ROS_WARN("Received an empty plan so removing last random goal. Generating new goal...");
-            unordered_goals_.pop_back();
-            generateRandomGoal();
-
-        }
-    } 
-    else
+    // The same goal sampling and planning as artbot_code, sharing its clearance when both are in one manager
+    PathPlanning pathPlanning(map, threshold_distance_, 0.0, 0.0, std::random_device{}());
+    std::vector<geometry_msgs::Point> goals;
+    std::vector<geometry_msgs::Point> waypts_simplified;
+    if (!pathPlanning.planRandomTour(robotPose, numGoals_, &navfn_, goals, waypts_simplified))
     {
-        ROS_ERROR("Failed to call service make_plan");
+        ROS_WARN("No goal on the map can be reached, nothing is published on /thepath");
+        return;
+    }
+    for (size_t i = 0; i < goals.size(); i++)
+    {
+        std::cout << "Goal " << i << ": {" << goals[i].x << " , " << goals[i].y << "}." << std::endl;
     }
 
-    std::cout << "Number of elements in the simplified points vector is: " << points.size() << std::endl;
-    return points;
-}
-
-
-void Sample::generateRandomGoal()
-{
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    uint32_t idx;
-
-        while (true) {
-            std::random_device rd;
-            std::mt19937 gen(rd());
-            std::uniform_real_distribution<> grid_x(10, map_width_-10); // 5
-            std::uniform_real_distribution<> grid_y(10, map_height_-10);
-            double map_x = grid_x(gen);
-            double map_y = grid_y(gen);
-
-            if (Sample::isGoalValid(map_x, map_y))
-            {   
-                //std::cout << "map_x: " << map_x << ", map_y: " << map_y << "} is a valid goal." << std::endl;
-                //std::cout << " Random Goal { " << world_x << " , " << world_y << " } is valid." << std::endl;
-                break;
-            }
-        }
-
-        // Put the goal point in PoseStamped format
-        currentgoal_.pose.position.x = world_x; // Set the goal position x-coordinate
-        currentgoal_.pose.position.y = world_y; // Set the goal position y-coordinate
-        currentgoal_.pose.orientation.w = 1.0;
-        currentgoal_.header.stamp = ros::Time::now();
-        currentgoal_.header.frame_id = "map";
-
-        // Push goal message into vector
-        unordered_goals_.push_back(currentgoal_);
-        std::cout << "Goal {" << world_x << " , " << world_y << " } has been pushed into unordered vector." << std::endl;
+    // publish to rostopic 'thepath'
+    publishPath(waypts_simplified);
+    std::cout << "Tour of " << goals.size() << " goals with " << waypts_simplified.size()
+              << " waypoints published to ROS Topic /thepath." << std::endl;
 }
 
-bool Sample::isGoalValid(double x, double y)
+void Sample::publishPath(const std::vector<geometry_msgs::Point>& vec_of_simplified_waypts)
 {
-    world_x = map_origin_x_ + (x) * map_resolution_; // (x+ 0.5)
-    world_y = map_origin_y_ + (y) * map_resolution_;
-    // Check if the goal point is a threshold distance away from obstacles
-        //int map_x = (x - map_origin_x_) / map_resolution_;
-        //int map_y = (y - map_origin_y_) / map_resolution_;
-        uint32_t idx = x + y * map_width_;
-        // std::cout << "Index is: " << idx << std::endl;
-        //int index = map_y * map_width_ + map_x;
-        if (idx >= 0 && idx < map_data_.size()) 
-        {
-            bool withinBounds = false;
-            bool freeSpace = false;
-            bool neighboursUnoccupied = true; // assume unoccupied 
-            bool withinThreshold = false; // TO ADD
-            if(world_x >= 0 && world_x <= 10 && world_y >= -9 && world_y <= 0)
-            {
-                withinBounds = true;
-            }
-            if (map_data_[idx] == 0)
-            {
-                freeSpace = true;
-            }
-            for (int i = idx-100; i <= idx+100; ++i) // for data 100 to right and 100 to left
-            {
-                if(!(map_data_[idx] == 0))
-                {
-                    neighboursUnoccupied = false;
-                    break;
-                }
-            }
-            if(DistanceToGoal(world_x, world_y, robotPose_) > 0.75)
-            {
-                withinThreshold = true;
-            }
-
-
-            if(withinBounds && freeSpace && neighboursUnoccupied && withinThreshold)
-            {
-                //std::cout <<  "If 0, free space: " << map_data_[idx] << std::endl; 
-                //std::cout << "Goal VALID as free space, within bounds and distance threshold and neighbours cells are unoccupied." << std::endl;
-                return true;
-            }
-            else
-            {
-                //std::cout << "Goal inside obstacle, out of bounds or distance threshold, unknown, or neigbouring cells occupied." << std::endl;
-                return false; // Goal point is inside an obstacle
-                generateRandomGoal(); // generate another random goal
-            }
-        }
+    // Published as a shared pointer, so a subscriber in the same nodelet manager gets this message without a copy
+    nav_msgs::PathPtr path = boost::make_shared<nav_msgs::Path>();
+    path->header.stamp = ros::Time::now();
+    path->header.frame_id = "map";
+    path->poses.resize(vec_of_simplified_waypts.size());
+    for (size_t i = 0; i < vec_of_simplified_waypts.size(); i++)
+    {
+        path->poses[i].header = path->header;
+        path->poses[i].pose.position = vec_of_simplified_waypts[i];
+        path->poses[i].pose.orientation.w = 1.0;
+    }
+    custompath_pub_.publish(nav_msgs::PathConstPtr(path));
 }
 
 //Gets the distance from the goal to the robot
@@ -296,13 +142,13 @@ double Sample::DistanceBetweenGoals(geometry_msgs::Point goal1, geometry_msgs::P
 
 void Sample::seperateThread() {
     //Waits for the data to be populated from ROS
-    while(laserData_.range_min+laserData_.range_max == 0.0);//||
+    while(!stopping_ && laserData_.range_min+laserData_.range_max == 0.0);//||
         //   robotPose_.orientation.w+robotPose_.orientation.x+
         //   robotPose_.orientation.y+robotPose_.orientation.z == 0.0);
 
     //Limits the execution of this code to 5Hz
     ros::Rate rate_limiter(5.0);
-    while (ros::ok()) {
+    while (ros::ok() && !stopping_) {
         //Locks all of the data with mutexes
         std::unique_lock<std::mutex> lck1 (laserDataMtx_);
         std::unique_lock<std::mutex> lck2 (robotPoseMtx_);
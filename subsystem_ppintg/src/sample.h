@@ -18,11 +18,13 @@
 #include "nav_msgs/OccupancyGrid.h"
 #include "std_msgs/Header.h"
 #include "nav_msgs/MapMetaData.h"
-#include <nav_msgs/GetPlan.h>
+#include "nav_msgs/Path.h"
 
 
 //We include header of another class we are developing
 #include "laserprocessing.h"
+//The planning library shared with artbot_code
+#include "pathplanning.h"
 
 
 class Sample
@@ -32,29 +34,26 @@ public:
   ///
   /// Sets the default values of variables such as the robot position, the goals, the running_ boolean, etc.
   /// Requires the NodeHandle input to communicate with ROS.
-  Sample(ros::NodeHandle nh);
+  /// Reads the private parameters ~num_goals (default 5) and ~threshold_distance (default 0.15 m, the clearance
+  /// goals and paths keep from obstacles).
+  Sample(ros::NodeHandle nh, ros::NodeHandle pnh = ros::NodeHandle("~"));
 
   /// @brief Destructor of the Sample class.
   ///
   /// Deletes the object pointers for laserprocessing and imageprocessing classes.
   ~Sample();
 
-  std::vector<geometry_msgs::Point> planBetweenTwoGoals(geometry_msgs::Point st, geometry_msgs::Point en);
-  
-  /// @brief seperate thread.
-  void generateRandomGoals();
-  
+  /// @brief Makes the goal and processing threads return, for a nodelet being unloaded while ROS keeps running
+  void stop();
 
   /// @brief seperate thread.
-  void generateRandomGoal();
-  
-  /// The MAIN PROCESSING THREAD that will run continously and utilise the data.
-  /// When data needs to be combined then running a thread seperate to callback will guarantee data is processed.
-  /// The data is then used to publish input to move the TurtleBot, causing new data to be generated on its updated position and perspective.
-  bool isGoalValid(double x, double y);
-
+  ///
+  /// Waits for the map, then plans a tour of random goals with the shared planning library and publishes it.
+  void generateRandomGoals();
 
-  void publishPath(std::vector<geometry_msgs::Point> vec_of_simplified_waypts);
+  /// @brief Publishes every waypoint of a tour at once on /thepath
+  /// @param [in] vec_of_simplified_waypts - the waypoints in order
+  void publishPath(const std::vector<geometry_msgs::Point>& vec_of_simplified_waypts);
 
   /// The MAIN PROCESSING THREAD that will run continously and utilise the data.
   /// When data needs to be combined then running a thread seperate to callback will guarantee data is processed.
@@ -95,13 +94,16 @@ private:
   ros::Subscriber sub_odom;
   //! Map subscribe
   ros::Subscriber map_sub_;
-  //! Make Plan
-  ros::ServiceClient make_plan_;
+  //! Plans the legs the grid planner cannot with move_base
+  NavfnPlanner navfn_;
   
   //! Pointer to Laser Object
   LaserProcessing* laserProcessingPtr_;
 
-  nav_msgs::OccupancyGrid current_map;
+  //! Latest occupancy grid, shared with the subscriber and never modified
+  nav_msgs::OccupancyGrid::ConstPtr map_;
+  //! Mutex to lock map_
+  std::mutex mapMtx_;
   //! Stores the laser data from the LIDAR scanner
   sensor_msgs::LaserScan laserData_;
   //! Mutex to lock laserData_
@@ -110,20 +112,14 @@ private:
   geometry_msgs::Pose robotPose_;
   //! Mutex to lock robotPose_
   std::mutex robotPoseMtx_;
+  //! Flag set by stop() to end the threads
+  std::atomic<bool> stopping_;
 
 
-    double threshold_distance_;
-    int map_width_;
-    int map_height_;
-    double map_resolution_;
-    double map_origin_x_;
-    double map_origin_y_;
-    std::vector<int8_t> map_data_;
-    double world_x;
-    double world_y;
-    std::vector<geometry_msgs::PoseStamped> unordered_goals_;
-    std::vector<geometry_msgs::PoseStamped> ordered_goals_;
-    geometry_msgs::PoseStamped currentgoal_;
+  //! The clearance goals and paths keep from obstacles [m]
+  double threshold_distance_;
+  //! Number of random goals in a tour
+  int numGoals_;
 
   //! Stores a goal for the robot to move towards
   geometry_msgs::Point goal_;
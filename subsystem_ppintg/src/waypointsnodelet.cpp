@@ -0,0 +1,41 @@
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "sample.h"
+
+namespace subsystem_ppintg
+{
+// Runs the waypoints producer inside a nodelet manager, so /thepath reaches an artbot_code nodelet in the
+// same manager, and the map and scans from other nodelets arrive here, without being serialised
+class WaypointsNodelet : public nodelet::Nodelet
+{
+public:
+  // stop the goal and processing threads of the unloaded nodelet
+  ~WaypointsNodelet()
+  {
+    if (sample_) sample_->stop();
+    if (goalsThread_.joinable()) goalsThread_.join();
+    if (processThread_.joinable()) processThread_.join();
+  }
+
+private:
+  // same threads as the waypoints_producer node
+  void onInit() override
+  {
+    sample_ = std::make_shared<Sample>(getNodeHandle(), getPrivateNodeHandle());
+    goalsThread_ = std::thread(&Sample::generateRandomGoals, sample_);
+    processThread_ = std::thread([this]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(500)); // wait for connection
+      sample_->seperateThread();
+    });
+  }
+
+  std::shared_ptr<Sample> sample_;
+  std::thread goalsThread_;
+  std::thread processThread_;
+};
+}  // namespace subsystem_ppintg
+
+PLUGINLIB_EXPORT_CLASS(subsystem_ppintg::WaypointsNodelet, nodelet::Nodelet)